@@ -1,6 +1,11 @@
 // 基础配置
 const SERVER_URL = "http://192.168.4.1";
+const STATUS_WS_URL = SERVER_URL.replace(/^http/, 'ws') + "/ws/status";
 let statusUpdateTimer = null;
+let statusSocket = null;
+let statusReconnectTimer = null;
+// 当前设备状态（推送通道只发送变化的字段，在此合并）
+let deviceStatus = {};
 
 // 页面加载完成初始化
 document.addEventListener('DOMContentLoaded', function() {
@@ -9,7 +14,13 @@ document.addEventListener('DOMContentLoaded', function() {
     const nextYear = new Date(now.setFullYear(now.getFullYear() + 1)).toISOString().split('T')[0];
     document.getElementById('cardExpire').value = nextYear;
 
-    // 初始化标签页切换
+    // 告警码(与固件 ALARM_CODE_xxx 一致)
+const ALARM_CODE_TEXT = {
+    1: '异常打开',
+    2: '正常关闭',
+};
+
+// 初始化标签页切换
     initTabs();
     
     // 初始化功能模块
@@ -70,10 +81,55 @@ function initConnectionStatus() {
         });
 }
 
-// 启动状态更新
+// 启动状态更新：优先使用 WebSocket 推送，不可用时退回到轮询
 function startStatusUpdate() {
     updateDeviceStatus();
-    statusUpdateTimer = setInterval(updateDeviceStatus, 3000);
+    connectStatusSocket();
+}
+
+function startStatusPolling() {
+    if (!statusUpdateTimer) {
+        statusUpdateTimer = setInterval(updateDeviceStatus, 3000);
+    }
+}
+
+function stopStatusPolling() {
+    if (statusUpdateTimer) {
+        clearInterval(statusUpdateTimer);
+        statusUpdateTimer = null;
+    }
+}
+
+function connectStatusSocket() {
+    if (!('WebSocket' in window)) {
+        startStatusPolling();
+        return;
+    }
+
+    statusSocket = new WebSocket(STATUS_WS_URL);
+    statusSocket.onopen = function() {
+        // 推送通道可用，停止轮询
+        stopStatusPolling();
+    };
+    statusSocket.onmessage = function(event) {
+        try {
+            Object.assign(deviceStatus, JSON.parse(event.data));
+            renderDeviceStatus(deviceStatus);
+        } catch (err) {
+            console.error("解析状态推送失败：", err);
+        }
+    };
+    statusSocket.onclose = function() {
+        // 连接断开期间退回轮询，并定时重连
+        statusSocket = null;
+        startStatusPolling();
+        if (!statusReconnectTimer) {
+            statusReconnectTimer = setTimeout(function() {
+                statusReconnectTimer = null;
+                connectStatusSocket();
+            }, 5000);
+        }
+    };
 }
 
 function updateDeviceStatus() {
@@ -87,71 +143,8 @@ function updateDeviceStatus() {
             return response.json();
         })
         .then(data => {
-            // 格式化浮点型数据的工具函数
-            // 处理null/undefined，保留1位小数，0值正常显示
-            const formatFloatValue = (value) => {
-                // 仅当值存在且为有效数字时才格式化
-                if (value === null || value === undefined || isNaN(value)) {
-                    return '--';
-                }
-                // 保留1位小数（可根据需求调整位数）
-                return parseFloat(value).toFixed(1);
-            };
-
-            // 更新电压显示
-            const voltageEl = document.getElementById('voltage');
-            voltageEl.textContent = `${formatFloatValue(data.voltage)} V`;
-
-            // 更新电流显示
-            const currentEl = document.getElementById('current');
-            currentEl.textContent = `${formatFloatValue(data.current)} A`;
-
-            // 更新功率显示
-            const powerEl = document.getElementById('power');
-            powerEl.textContent = `${formatFloatValue(data.power)} W`;
-
-            // 更新充电状态（数字枚举转文本+样式）
-            const chargeEl = document.getElementById('chargeStatus');
-            const chargeStateMap = {
-                0: "启动中",         // EVSE_REBOOT
-                1: "空闲",           // EVSE_IDLE
-                2: "等待刷卡",       // EVSE_plugWaitSwipe
-                3: "等待插枪",       // EVSE_swipeWaitPlug
-                4: "准备就绪",       // EVSE_swipePlugReady
-                5: "充电中",         // EVSE_CHARGING
-                6: "充电暂停",       // EVSE_CHARGE_PAUSE
-                7: "充电停止",       // EVSE_CHARGE_STOP
-                8: "充电完成",       // EVSE_CHARGE_DONE
-                9: "充电故障"        // EVSE_FAULT
-            };
-            // 获取状态文本（默认未知状态）
-            const chargeStateText = chargeStateMap[data.charge_status] || "未知状态";
-            chargeEl.textContent = chargeStateText;
-            // 设置状态样式
-            switch(data.charge_status) {
-                case 9:  // 故障状态
-                    chargeEl.className = "param-value text-danger";
-                    break;
-                case 5:  // 充电中
-                    chargeEl.className = "param-value text-info";
-                    break;
-                default:  // 其他状态
-                    chargeEl.className = "param-value text-success";
-            }
-
-            // 更新网络状态
-            const networkEl = document.getElementById('wifiStatus');
-            const networkStateMap = {
-                0: "断开",
-                1: "已连接"
-            };
-            const networkStateText = networkStateMap[data.net_status] || "未知网络状态";
-            networkEl.textContent = networkStateText;
-            // 设置网络状态样式
-            networkEl.className = data.net_status === 1
-                ? "param-value text-success" 
-                : "param-value text-warning";
-
+            deviceStatus = data;
+            renderDeviceStatus(deviceStatus);
         })
         .catch(err => {
             console.error("更新设备状态失败：", err);
@@ -169,6 +162,74 @@ function updateDeviceStatus() {
         });
 }
 
+// 把状态数据渲染到页面
+function renderDeviceStatus(data) {
+    // 格式化浮点型数据的工具函数
+    // 处理null/undefined，保留1位小数，0值正常显示
+    const formatFloatValue = (value) => {
+        // 仅当值存在且为有效数字时才格式化
+        if (value === null || value === undefined || isNaN(value)) {
+            return '--';
+        }
+        // 保留1位小数（可根据需求调整位数）
+        return parseFloat(value).toFixed(1);
+    };
+
+    // 更新电压显示
+    const voltageEl = document.getElementById('voltage');
+    voltageEl.textContent = `${formatFloatValue(data.voltage)} V`;
+
+    // 更新电流显示
+    const currentEl = document.getElementById('current');
+    currentEl.textContent = `${formatFloatValue(data.current)} A`;
+
+    // 更新功率显示
+    const powerEl = document.getElementById('power');
+    powerEl.textContent = `${formatFloatValue(data.power)} W`;
+
+    // 更新充电状态（数字枚举转文本+样式）
+    const chargeEl = document.getElementById('chargeStatus');
+    const chargeStateMap = {
+        0: "启动中",         // EVSE_REBOOT
+        1: "空闲",           // EVSE_IDLE
+        2: "等待刷卡",       // EVSE_plugWaitSwipe
+        3: "等待插枪",       // EVSE_swipeWaitPlug
+        4: "准备就绪",       // EVSE_swipePlugReady
+        5: "充电中",         // EVSE_CHARGING
+        6: "充电暂停",       // EVSE_CHARGE_PAUSE
+        7: "充电停止",       // EVSE_CHARGE_STOP
+        8: "充电完成",       // EVSE_CHARGE_DONE
+        9: "充电故障"        // EVSE_FAULT
+    };
+    // 获取状态文本（默认未知状态）
+    const chargeStateText = chargeStateMap[data.charge_status] || "未知状态";
+    chargeEl.textContent = chargeStateText;
+    // 设置状态样式
+    switch(data.charge_status) {
+        case 9:  // 故障状态
+            chargeEl.className = "param-value text-danger";
+            break;
+        case 5:  // 充电中
+            chargeEl.className = "param-value text-info";
+            break;
+        default:  // 其他状态
+            chargeEl.className = "param-value text-success";
+    }
+
+    // 更新网络状态
+    const networkEl = document.getElementById('wifiStatus');
+    const networkStateMap = {
+        0: "断开",
+        1: "已连接"
+    };
+    const networkStateText = networkStateMap[data.net_status] || "未知网络状态";
+    networkEl.textContent = networkStateText;
+    // 设置网络状态样式
+    networkEl.className = data.net_status === 1
+        ? "param-value text-success" 
+        : "param-value text-warning";
+}
+
 // 加载配置
 function loadConfig() {
     fetch(`${SERVER_URL}/api/config`)
@@ -218,23 +279,25 @@ function loadCardList() {
 // 加载告警记录
 function loadAlarmList() {
     const alarmListEl = document.getElementById('alarmList');
-    fetch(`${SERVER_URL}/api/alarms`)
+    // 服务端已按从新到旧排序，只取最新一页
+    fetch(`${SERVER_URL}/api/alarms?limit=50`)
         .then(response => response.json())
-        .then(alarms => {
+        .then(data => {
+            const alarms = data.alarms;
             if (alarms.length === 0) {
                 alarmListEl.innerHTML = '<tr><td colspan="4" class="text-center">暂无告警记录</td></tr>';
                 return;
             }
             
             let html = '';
-            alarms.reverse().forEach((alarm, index) => {
+            alarms.forEach((alarm, index) => {
                 const statusText = alarm.handled ? '已处理' : '未处理';
                 const statusClass = alarm.handled ? 'text-success' : 'text-warning';
                 html += `
                     <tr>
                         <td>${index + 1}</td>
-                        <td>${alarm.time}</td>
-                        <td>${alarm.coverStatus === 'open' ? '异常打开' : '正常关闭'}</td>
+                        <td>${new Date(alarm.time * 1000).toLocaleString()}</td>
+                        <td>${ALARM_CODE_TEXT[alarm.code] || ('告警 ' + alarm.code)}</td>
                         <td class="${statusClass}">${statusText}</td>
                     </tr>
                 `;
@@ -252,12 +315,13 @@ function bindFormEvents() {
     document.getElementById('configForm').addEventListener('submit', function(e) {
         e.preventDefault();
         const configData = {
-            voltageDeviation: parseInt(document.getElementById('voltageDeviation').value),
-            maxCurrent: parseInt(document.getElementById('maxCurrent').value),
-            cpDeviation: parseInt(document.getElementById('cpDeviation').value),
-            leakageAC: parseInt(document.getElementById('leakageAC').value),
-            leakageDC: parseInt(document.getElementById('leakageDC').value)
+            ov_threshold: parseFloat(document.getElementById('OV_threshold').value),
+            uv_threshold: parseFloat(document.getElementById('UV_threshold').value),
+            leakagedc: parseInt(document.getElementById('leakageDC').value),
+            leakageac: parseInt(document.getElementById('leakageAC').value),
+            maxcc: parseInt(document.getElementById('maxChargeCurrent').value)
         };
+        const msgEl = document.getElementById('configMsg');
 
         fetch(`${SERVER_URL}/api/config`, {
             method: 'POST',
@@ -267,11 +331,15 @@ function bindFormEvents() {
         .then(response => response.json())
         .then(res => {
             if (res.success) {
-                const msgEl = document.getElementById('configMsg');
-                msgEl.textContent = "配置保存成功！";
-                msgEl.classList.remove('d-none');
-                setTimeout(() => msgEl.classList.add('d-none'), 3000);
+                // 主控板确认应用后才返回成功
+                msgEl.textContent = `配置保存成功！主控板已确认(${res.latency_ms} ms)`;
+                msgEl.className = "mt-2 text-success";
+            } else {
+                msgEl.textContent = "保存失败：" + res.msg + (res.field ? `(${res.field})` : "");
+                msgEl.className = "mt-2 text-danger";
             }
+            msgEl.classList.remove('d-none');
+            setTimeout(() => msgEl.classList.add('d-none'), 3000);
         })
         .catch(err => console.error("保存配置失败：", err));
     });
@@ -279,11 +347,11 @@ function bindFormEvents() {
     // 恢复默认配置
     document.getElementById('resetConfigBtn').addEventListener('click', function() {
         if (confirm("确定要恢复默认配置吗？")) {
-            document.getElementById('voltageDeviation').value = 5;
-            document.getElementById('maxCurrent').value = 32;
-            document.getElementById('cpDeviation').value = 10;
+            document.getElementById('OV_threshold').value = 286.0;
+            document.getElementById('UV_threshold').value = 154.0;
+            document.getElementById('leakageDC').value = 30;
             document.getElementById('leakageAC').value = 30;
-            document.getElementById('leakageDC').value = 6;
+            document.getElementById('maxChargeCurrent').value = 32;
         }
     });
 
@@ -328,6 +396,43 @@ function bindFormEvents() {
         });
     });
 
+    // 批量导入授权卡（.csv 或 .bin 文件整体上传，由服务器分块解析）
+    document.getElementById('cardExportBtn').href = `${SERVER_URL}/api/cards/export?format=csv`;
+    document.getElementById('cardImportBtn').addEventListener('click', function() {
+        document.getElementById('cardImportFile').click();
+    });
+    document.getElementById('cardImportFile').addEventListener('change', function() {
+        const file = this.files[0];
+        const msgEl = document.getElementById('cardImportMsg');
+        if (!file) return;
+        const isCsv = file.name.toLowerCase().endsWith('.csv');
+        fetch(`${SERVER_URL}/api/cards/bulk`, {
+            method: 'POST',
+            headers: { 'Content-Type': isCsv ? 'text/csv' : 'application/octet-stream' },
+            body: file
+        })
+        .then(response => response.json())
+        .then(res => {
+            if (res.success) {
+                msgEl.textContent = `导入完成：新增 ${res.inserted}，重复 ${res.duplicate}，无效 ${res.invalid}`;
+                msgEl.className = "mb-2 text-success";
+                loadCardList();
+            } else {
+                msgEl.textContent = "导入失败：" + res.msg;
+                msgEl.className = "mb-2 text-danger";
+            }
+        })
+        .catch(err => {
+            msgEl.textContent = "导入失败，请重试！";
+            msgEl.className = "mb-2 text-danger";
+        })
+        .finally(() => {
+            this.value = "";
+            msgEl.classList.remove('d-none');
+            setTimeout(() => msgEl.classList.add('d-none'), 5000);
+        });
+    });
+
     // 清空告警记录
     document.getElementById('clearAlarmBtn').addEventListener('click', function() {
         if (confirm("确定要清空所有告警记录吗？")) {
@@ -358,5 +463,10 @@ function bindDeleteCardEvents() {
 
 // 页面关闭清理
 window.addEventListener('beforeunload', function() {
-    if (statusUpdateTimer) clearInterval(statusUpdateTimer);
+    stopStatusPolling();
+    if (statusReconnectTimer) clearTimeout(statusReconnectTimer);
+    if (statusSocket) {
+        statusSocket.onclose = null;
+        statusSocket.close();
+    }
 });
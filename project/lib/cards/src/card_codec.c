@@ -0,0 +1,378 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdio.h>
+#include <string.h>
+#include "card_codec.h"
+
+#define CARD_DAY_MAX                    0xFFFFu         // expire_day 的最大值(2149-06-06)
+
+/* private function protypes -------------------------------------------------*/
+static void _card_decoder_emit(card_decoder_t *dec, const card_record_t *card);
+static void _card_decoder_wire(card_decoder_t *dec);
+static void _card_decoder_line(card_decoder_t *dec);
+static bool _card_is_space(char c);
+static bool _card_parse_digits(const char *text, size_t len, uint32_t *value);
+static void _card_put_digits(char *buf, uint32_t value, size_t len);
+static int32_t _card_days_from_civil(int32_t y, uint32_t m, uint32_t d);
+
+/**
+ * @brief  初始化解码器
+ * @param  dec    解码器
+ * @param  format 数据格式
+ * @param  cb     每解出一条合法记录调用一次
+ * @param  ctx    回调参数
+ * @return 无
+ */
+void card_decoder_init(card_decoder_t *dec, card_format_t format, card_record_cb_t cb, void *ctx)
+{
+    memset(dec, 0, sizeof(*dec));
+    dec->format = format;
+    dec->cb = cb;
+    dec->ctx = ctx;
+}
+
+/**
+ * @brief  输入一段数据
+ * @param  dec 解码器
+ * @param  buf 数据，可以在任意位置断开
+ * @param  len 数据长度
+ * @return false - 回调要求停止，之后的输入被忽略
+ */
+bool card_decoder_feed(card_decoder_t *dec, const void *buf, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    size_t i;
+
+    for(i = 0; i < len && !dec->aborted; i ++) {
+        if(CARD_FORMAT_BIN == dec->format) {
+            dec->buf[dec->len ++] = p[i];
+            if(CARD_WIRE_LEN == dec->len) {
+                _card_decoder_wire(dec);
+                dec->len = 0;
+            }
+            continue;
+        }
+
+        if('\n' == p[i]) {
+            _card_decoder_line(dec);
+            dec->len = 0;
+            dec->overflow = false;
+        } else if(dec->len < CARD_CSV_LINE_LEN) {
+            dec->buf[dec->len ++] = p[i];
+        } else {
+            dec->overflow = true;
+        }
+    }
+    return !dec->aborted;
+}
+
+/**
+ * @brief  输入结束，处理末尾不完整的记录
+ * @param  dec 解码器
+ * @return false - 回调要求停止
+ * @note   CSV 最后一行可以没有换行；二进制末尾不足一条记录时计为非法
+ */
+bool card_decoder_finish(card_decoder_t *dec)
+{
+    if(dec->aborted) {
+        return false;
+    }
+    if(CARD_FORMAT_BIN == dec->format) {
+        if(dec->len > 0) {
+            dec->lines ++;
+            dec->invalid ++;
+        }
+    } else if(dec->len > 0 || dec->overflow) {
+        _card_decoder_line(dec);
+    }
+    dec->len = 0;
+    dec->overflow = false;
+    return !dec->aborted;
+}
+
+/**
+ * @brief  编码一条二进制记录
+ * @param  card 卡片
+ * @param  buf  输出缓冲区，至少 CARD_WIRE_LEN 字节
+ * @return 写入的长度
+ */
+size_t card_wire_encode(const card_record_t *card, uint8_t *buf)
+{
+    buf[0] = (uint8_t)(card->id);
+    buf[1] = (uint8_t)(card->id >> 8);
+    buf[2] = (uint8_t)(card->id >> 16);
+    buf[3] = (uint8_t)(card->id >> 24);
+    buf[4] = (uint8_t)(card->expire_day);
+    buf[5] = (uint8_t)(card->expire_day >> 8);
+    return CARD_WIRE_LEN;
+}
+
+/**
+ * @brief  编码一行 CSV(含换行)
+ * @param  card 卡片
+ * @param  buf  输出缓冲区
+ * @param  size 缓冲区大小
+ * @return 写入的长度(不含结束符)，缓冲区不足时返回 0
+ */
+int card_csv_encode(const card_record_t *card, char *buf, size_t size)
+{
+    char id[CARD_ID_STR_LEN + 1];
+    char date[CARD_DATE_STR_LEN + 1];
+    int len;
+
+    card_id_format(card->id, id);
+    card_date_format(card->expire_day, date);
+    len = snprintf(buf, size, "%s,%s\n", id, date);
+    return (len < 0 || (size_t)len >= size) ? 0 : len;
+}
+
+/**
+ * @brief  解析8位数字卡号
+ * @param  text 文本(不要求结束符)
+ * @param  len  文本长度，必须为 CARD_ID_STR_LEN
+ * @param  id   输出卡号
+ * @return 是否合法
+ */
+bool card_id_parse(const char *text, size_t len, uint32_t *id)
+{
+    if(CARD_ID_STR_LEN != len) {
+        return false;
+    }
+    return _card_parse_digits(text, len, id);
+}
+
+/**
+ * @brief  卡号转为8位数字文本(高位补0)
+ * @param  id  卡号
+ * @param  buf 输出缓冲区，至少 CARD_ID_STR_LEN + 1 字节
+ * @return 无
+ */
+void card_id_format(uint32_t id, char *buf)
+{
+    _card_put_digits(buf, id, CARD_ID_STR_LEN);
+    buf[CARD_ID_STR_LEN] = '\0';
+}
+
+/**
+ * @brief  解析 YYYY-MM-DD 日期
+ * @param  text 文本(不要求结束符)
+ * @param  len  文本长度，必须为 CARD_DATE_STR_LEN
+ * @param  day  输出 1970-01-01 起的天数
+ * @return 是否为 1970-01-01 ~ 2149-06-06 之间的合法日期
+ */
+bool card_date_parse(const char *text, size_t len, uint16_t *day)
+{
+    static const uint8_t mdays[12] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    uint32_t y, m, d;
+    int32_t days;
+
+    if(CARD_DATE_STR_LEN != len || '-' != text[4] || '-' != text[7]) {
+        return false;
+    }
+    if(!_card_parse_digits(text, 4, &y) || !_card_parse_digits(text + 5, 2, &m) ||
+       !_card_parse_digits(text + 8, 2, &d)) {
+        return false;
+    }
+    if(m < 1 || m > 12 || d < 1 || d > mdays[m - 1]) {
+        return false;
+    }
+    if(2 == m && 29 == d && !((0 == y % 4 && 0 != y % 100) || 0 == y % 400)) {
+        return false;
+    }
+
+    days = _card_days_from_civil((int32_t)y, m, d);
+    if(days < 0 || days > (int32_t)CARD_DAY_MAX) {
+        return false;
+    }
+    *day = (uint16_t)days;
+    return true;
+}
+
+/**
+ * @brief  天数转为 YYYY-MM-DD 文本
+ * @param  day 1970-01-01 起的天数
+ * @param  buf 输出缓冲区，至少 CARD_DATE_STR_LEN + 1 字节
+ * @return 无
+ */
+void card_date_format(uint16_t day, char *buf)
+{
+    /* 公历与天数的换算，以 3 月 1 日为年首，使闰日落在年末 */
+    uint32_t z = (uint32_t)day + 719468u;
+    uint32_t era = z / 146097u;
+    uint32_t doe = z - era * 146097u;
+    uint32_t yoe = (doe - doe / 1460u + doe / 36524u - doe / 146096u) / 365u;
+    uint32_t doy = doe - (365u * yoe + yoe / 4u - yoe / 100u);
+    uint32_t mp = (5u * doy + 2u) / 153u;
+    uint32_t d = doy - (153u * mp + 2u) / 5u + 1u;
+    uint32_t m = mp < 10u ? mp + 3u : mp - 9u;
+    uint32_t y = yoe + era * 400u + (m <= 2u ? 1u : 0u);
+
+    _card_put_digits(buf, y, 4);
+    buf[4] = '-';
+    _card_put_digits(buf + 5, m, 2);
+    buf[7] = '-';
+    _card_put_digits(buf + 8, d, 2);
+    buf[CARD_DATE_STR_LEN] = '\0';
+}
+
+/**
+ * @brief  交给回调一条合法记录
+ * @param  dec  解码器
+ * @param  card 卡片
+ * @return 无
+ */
+static void _card_decoder_emit(card_decoder_t *dec, const card_record_t *card)
+{
+    dec->records ++;
+    if(NULL != dec->cb && !dec->cb(dec->ctx, card)) {
+        dec->aborted = true;
+    }
+}
+
+/**
+ * @brief  处理一条完整的二进制记录
+ * @param  dec 解码器
+ * @return 无
+ */
+static void _card_decoder_wire(card_decoder_t *dec)
+{
+    card_record_t card;
+
+    dec->lines ++;
+    card.id = (uint32_t)dec->buf[0] | ((uint32_t)dec->buf[1] << 8) |
+              ((uint32_t)dec->buf[2] << 16) | ((uint32_t)dec->buf[3] << 24);
+    card.expire_day = (uint16_t)(dec->buf[4] | (dec->buf[5] << 8));
+    if(card.id > CARD_ID_MAX) {
+        dec->invalid ++;
+        return;
+    }
+    _card_decoder_emit(dec, &card);
+}
+
+/**
+ * @brief  处理一行 CSV
+ * @param  dec 解码器
+ * @return 无
+ * @note   忽略空行和首尾空白(含 '\r')；第一行不以数字开头时视为表头
+ */
+static void _card_decoder_line(card_decoder_t *dec)
+{
+    const char *line = (const char *)dec->buf;
+    size_t begin = 0;
+    size_t end = dec->len;
+    size_t comma, id_end, date_begin;
+    card_record_t card;
+
+    dec->lines ++;
+    if(dec->overflow) {
+        dec->invalid ++;
+        return;
+    }
+
+    while(begin < end && _card_is_space(line[begin])) {
+        begin ++;
+    }
+    while(end > begin && _card_is_space(line[end - 1])) {
+        end --;
+    }
+    if(begin == end) {
+        dec->lines --;
+        return;
+    }
+    if(1 == dec->lines && (line[begin] < '0' || line[begin] > '9')) {
+        return;
+    }
+
+    for(comma = begin; comma < end && ',' != line[comma]; comma ++) {
+    }
+    if(comma == end) {
+        dec->invalid ++;
+        return;
+    }
+    id_end = comma;
+    while(id_end > begin && _card_is_space(line[id_end - 1])) {
+        id_end --;
+    }
+    date_begin = comma + 1;
+    while(date_begin < end && _card_is_space(line[date_begin])) {
+        date_begin ++;
+    }
+
+    if(!card_id_parse(line + begin, id_end - begin, &card.id) ||
+       !card_date_parse(line + date_begin, end - date_begin, &card.expire_day)) {
+        dec->invalid ++;
+        return;
+    }
+    _card_decoder_emit(dec, &card);
+}
+
+/**
+ * @brief  是否为行内空白
+ * @param  c 字符
+ * @return 是否为空白
+ */
+static bool _card_is_space(char c)
+{
+    return ' ' == c || '\t' == c || '\r' == c;
+}
+
+/**
+ * @brief  解析定长的十进制数字串
+ * @param  text  文本
+ * @param  len   长度(不超过9位)
+ * @param  value 输出数值
+ * @return 是否全为数字
+ */
+static bool _card_parse_digits(const char *text, size_t len, uint32_t *value)
+{
+    uint32_t v = 0;
+    size_t i;
+
+    for(i = 0; i < len; i ++) {
+        if(text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        v = v * 10 + (uint32_t)(text[i] - '0');
+    }
+    *value = v;
+    return true;
+}
+
+/**
+ * @brief  写入定长的十进制数字串(高位补0，不写结束符)
+ * @param  buf   输出缓冲区
+ * @param  value 数值
+ * @param  len   位数
+ * @return 无
+ */
+static void _card_put_digits(char *buf, uint32_t value, size_t len)
+{
+    while(len > 0) {
+        buf[-- len] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+/**
+ * @brief  公历日期转为 1970-01-01 起的天数
+ * @param  y 年
+ * @param  m 月(1-12)
+ * @param  d 日(1-31)
+ * @return 天数，1970 年以前为负数
+ */
+static int32_t _card_days_from_civil(int32_t y, uint32_t m, uint32_t d)
+{
+    uint32_t yoe, doy, doe;
+    int32_t era;
+
+    y -= m <= 2 ? 1 : 0;
+    era = (y >= 0 ? y : y - 399) / 400;
+    yoe = (uint32_t)(y - era * 400);
+    doy = (153u * (m > 2 ? m - 3 : m + 9) + 2u) / 5u + d - 1u;
+    doe = yoe * 365u + yoe / 4u - yoe / 100u + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
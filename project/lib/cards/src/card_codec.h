@@ -0,0 +1,74 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __CARD_CODEC_H__
+#define __CARD_CODEC_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CARD_ID_STR_LEN                 8               // 卡号文本长度(8位数字)
+#define CARD_ID_MAX                     99999999u       // 8位数字卡号的最大值
+#define CARD_DATE_STR_LEN               10              // 日期文本长度 YYYY-MM-DD
+#define CARD_WIRE_LEN                   6               // 二进制记录长度: 卡号4 + 有效期2(小端)
+#define CARD_CSV_LINE_LEN               32              // CSV 单行最大长度(不含换行)
+
+/**
+ * @brief   批量导入/导出的卡片记录
+ * @note    expire_day 为 1970-01-01 起的天数，16位可表示到 2149 年
+ */
+typedef struct card_record{
+    uint32_t id;                    // 卡号
+    uint16_t expire_day;            // 有效期(含当天)
+}card_record_t;
+
+/**
+ * @brief   批量数据格式
+ */
+typedef enum{
+    CARD_FORMAT_BIN = 0,            // 紧凑二进制，每条 CARD_WIRE_LEN 字节，无头部
+    CARD_FORMAT_CSV,                // 每行 "卡号,YYYY-MM-DD"，首行可以是表头
+}card_format_t;
+
+/**
+ * @brief   解码出一条合法记录时的回调
+ * @retval  false - 停止解码(例如目标已满)，之后的输入被忽略
+ */
+typedef bool (*card_record_cb_t)(void *ctx, const card_record_t *card);
+
+/**
+ * @brief   可分块输入的批量卡片解码器
+ * @note    数据可以在任意位置断开；格式错误的记录计入 invalid 后跳过，不影响其余记录。
+ *          只使用结构体内的定长缓冲区，不申请堆内存
+ */
+typedef struct card_decoder{
+    uint8_t format;                 // card_format_t
+    card_record_cb_t cb;            // 记录回调
+    void *ctx;                      // 回调参数
+    uint8_t len;                    // buf 中已缓存的字节数
+    bool overflow;                  // 当前 CSV 行超长，丢弃到行尾
+    bool aborted;                   // 回调要求停止
+    uint32_t lines;                 // 已处理的记录数(CSV 为行数)
+    uint32_t records;               // 合法记录数
+    uint32_t invalid;               // 非法记录数
+    uint8_t buf[CARD_CSV_LINE_LEN]; // 未完整的记录或行
+}card_decoder_t;
+
+/* public function protypes ------------------------------------------------- */
+void card_decoder_init(card_decoder_t *dec, card_format_t format, card_record_cb_t cb, void *ctx);
+bool card_decoder_feed(card_decoder_t *dec, const void *buf, size_t len);
+bool card_decoder_finish(card_decoder_t *dec);
+
+size_t card_wire_encode(const card_record_t *card, uint8_t *buf);
+int card_csv_encode(const card_record_t *card, char *buf, size_t size);
+
+bool card_id_parse(const char *text, size_t len, uint32_t *id);
+void card_id_format(uint32_t id, char *buf);
+bool card_date_parse(const char *text, size_t len, uint16_t *day);
+void card_date_format(uint16_t day, char *buf);
+
+#endif /* __CARD_CODEC_H__ */
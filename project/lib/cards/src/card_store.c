@@ -0,0 +1,308 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdlib.h>
+#include <string.h>
+#include "card_store.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+/* 让出 CPU 一个节拍: 写者(HTTP 服务任务)优先级比串口任务低，taskYIELD 不会让它运行 */
+#define CARD_STORE_BACKOFF()            vTaskDelay(1)
+#else
+#include <sched.h>
+#define CARD_STORE_BACKOFF()            sched_yield()
+#endif
+
+/* 查找连续遇到写者修改的次数上限，超过后让出 CPU 等写者完成 */
+#define CARD_STORE_FIND_SPINS           16
+
+_Static_assert(sizeof(card_entry_t) == 8, "card_entry_t must stay packed into 8 bytes");
+
+/* 全局授权卡表 */
+card_store_t g_card_store;
+
+/* private function protypes -------------------------------------------------*/
+static uint32_t _card_store_lower_bound(const card_entry_t *cards, uint32_t count, uint32_t id);
+static void _card_store_write_begin(card_store_t *store);
+static void _card_store_write_end(card_store_t *store);
+static int _card_store_compare(const void *a, const void *b);
+
+/**
+ * @brief  初始化(清空)授权卡表
+ * @param  store 授权卡表
+ * @return 无
+ */
+void card_store_init(card_store_t *store)
+{
+    _card_store_write_begin(store);
+    store->count = 0;
+    _card_store_write_end(store);
+}
+
+/**
+ * @brief  添加一张卡片
+ * @param  store 授权卡表
+ * @param  card  卡片
+ * @return CARD_STORE_OK / CARD_STORE_DUPLICATE / CARD_STORE_FULL
+ */
+card_store_status_t card_store_add(card_store_t *store, const card_entry_t *card)
+{
+    uint32_t pos = _card_store_lower_bound(store->cards, store->count, card->id);
+
+    if(pos < store->count && store->cards[pos].id == card->id) {
+        return CARD_STORE_DUPLICATE;
+    }
+    if(store->count >= CARD_STORE_CAPACITY) {
+        return CARD_STORE_FULL;
+    }
+
+    _card_store_write_begin(store);
+    memmove(&store->cards[pos + 1], &store->cards[pos], (store->count - pos) * sizeof(card_entry_t));
+    store->cards[pos] = *card;
+    store->count ++;
+    _card_store_write_end(store);
+    return CARD_STORE_OK;
+}
+
+/**
+ * @brief  删除一张卡片
+ * @param  store 授权卡表
+ * @param  id    卡号
+ * @return CARD_STORE_OK / CARD_STORE_NOT_FOUND
+ */
+card_store_status_t card_store_remove(card_store_t *store, uint32_t id)
+{
+    uint32_t pos = _card_store_lower_bound(store->cards, store->count, id);
+
+    if(pos >= store->count || store->cards[pos].id != id) {
+        return CARD_STORE_NOT_FOUND;
+    }
+
+    _card_store_write_begin(store);
+    memmove(&store->cards[pos], &store->cards[pos + 1], (store->count - pos - 1) * sizeof(card_entry_t));
+    store->count --;
+    _card_store_write_end(store);
+    return CARD_STORE_OK;
+}
+
+/**
+ * @brief  整表替换
+ * @param  dst 目标表
+ * @param  src 源表(与 dst 在同一个写者任务中修改)
+ * @return 无
+ * @note   用于批量导入: 先在副本上修改，成功后一次替换，读者不会看到只改了一半的表
+ */
+void card_store_copy(card_store_t *dst, const card_store_t *src)
+{
+    _card_store_write_begin(dst);
+    memcpy(dst->cards, src->cards, src->count * sizeof(card_entry_t));
+    dst->count = src->count;
+    _card_store_write_end(dst);
+}
+
+/**
+ * @brief  整表排序并去除重复卡号
+ * @param  store 授权卡表，cards/count 已被直接填充(如从闪存载入)
+ * @return 无
+ * @note   直接填充和本函数都必须在读者开始查找之前完成
+ */
+void card_store_sort(card_store_t *store)
+{
+    uint32_t i, n = 0;
+
+    _card_store_write_begin(store);
+    if(store->count > CARD_STORE_CAPACITY) {
+        store->count = CARD_STORE_CAPACITY;
+    }
+    qsort(store->cards, store->count, sizeof(card_entry_t), _card_store_compare);
+    for(i = 0; i < store->count; i ++) {
+        if(0 == n || store->cards[n - 1].id != store->cards[i].id) {
+            store->cards[n ++] = store->cards[i];
+        }
+    }
+    store->count = n;
+    _card_store_write_end(store);
+}
+
+/**
+ * @brief  获取卡号在表中的下标
+ * @param  store 授权卡表
+ * @param  id    卡号
+ * @return 下标，不存在时返回 -1
+ * @note   只能在写者任务中调用(不核对修改序号)
+ */
+int32_t card_store_index(const card_store_t *store, uint32_t id)
+{
+    uint32_t pos = _card_store_lower_bound(store->cards, store->count, id);
+
+    if(pos < store->count && store->cards[pos].id == id) {
+        return (int32_t)pos;
+    }
+    return -1;
+}
+
+/**
+ * @brief  按卡号查找
+ * @param  store 授权卡表
+ * @param  id    卡号
+ * @param  out   找到时输出表项，可以为 NULL
+ * @return 是否找到
+ * @note   可在任意任务中调用，不加锁；与写者冲突时重查，连续 CARD_STORE_FIND_SPINS 次
+ *         冲突后让出 CPU，避免高优先级的读者在同一核上空转、写者永远完成不了修改
+ */
+bool card_store_find(card_store_t *store, uint32_t id, card_entry_t *out)
+{
+    card_entry_t entry;
+    uint32_t seq, count, pos;
+    uint32_t spins = 0;
+    bool found = false;
+
+    for(;;) {
+        seq = atomic_load_explicit(&store->seq, memory_order_acquire);
+        if(0 == (seq & 1)) {
+            /* 写者可能正在修改，count 只作为下标上限使用，读到的内容稍后按 seq 核对 */
+            count = store->count;
+            if(count > CARD_STORE_CAPACITY) {
+                count = CARD_STORE_CAPACITY;
+            }
+            pos = _card_store_lower_bound(store->cards, count, id);
+            found = (pos < count && store->cards[pos].id == id);
+            if(found) {
+                entry = store->cards[pos];
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if(atomic_load_explicit(&store->seq, memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+        if(++ spins >= CARD_STORE_FIND_SPINS) {
+            CARD_STORE_BACKOFF();
+            spins = 0;
+        }
+    }
+
+    if(found && NULL != out) {
+        *out = entry;
+    }
+    return found;
+}
+
+/**
+ * @brief  刷卡鉴权
+ * @param  store 授权卡表
+ * @param  id    卡号
+ * @param  today 当天，1970-01-01 起的天数
+ * @return 鉴权结果
+ */
+card_auth_t card_store_authorize(card_store_t *store, uint32_t id, uint16_t today)
+{
+    card_entry_t entry;
+
+    if(!card_store_find(store, id, &entry)) {
+        return CARD_AUTH_UNKNOWN;
+    }
+    if(entry.flags & CARD_FLAG_DISABLED) {
+        return CARD_AUTH_DISABLED;
+    }
+    if(today > entry.expire_day) {
+        return CARD_AUTH_EXPIRED;
+    }
+    return CARD_AUTH_OK;
+}
+
+/**
+ * @brief  在全局授权卡表中鉴权
+ * @param  id    卡号
+ * @param  today 当天，1970-01-01 起的天数
+ * @return 鉴权结果
+ * @note   供串口任务在主控板上报刷卡时调用
+ */
+card_auth_t card_authorize(uint32_t id, uint16_t today)
+{
+    return card_store_authorize(&g_card_store, id, today);
+}
+
+/**
+ * @brief  获取鉴权结果的文字描述
+ * @param  result 鉴权结果
+ * @return 描述文字
+ */
+const char *card_auth_strerror(card_auth_t result)
+{
+    switch(result) {
+        case CARD_AUTH_OK:              return "ok";
+        case CARD_AUTH_UNKNOWN:         return "未授权";
+        case CARD_AUTH_EXPIRED:         return "已过期";
+        case CARD_AUTH_DISABLED:        return "已停用";
+        default:                        return "未知错误";
+    }
+}
+
+/**
+ * @brief  二分查找第一个卡号不小于 id 的位置
+ * @param  cards 有序表
+ * @param  count 表项个数
+ * @param  id    卡号
+ * @return 位置，所有卡号都小于 id 时返回 count
+ */
+static uint32_t _card_store_lower_bound(const card_entry_t *cards, uint32_t count, uint32_t id)
+{
+    uint32_t lo = 0;
+    uint32_t hi = count;
+    uint32_t mid;
+
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if(cards[mid].id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief  开始修改，seq 变为奇数
+ * @param  store 授权卡表
+ * @return 无
+ */
+static void _card_store_write_begin(card_store_t *store)
+{
+    uint32_t seq = atomic_load_explicit(&store->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&store->seq, seq + 1, memory_order_relaxed);
+    /* 读者看到任何修改之前必然先看到奇数的 seq */
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief  修改完成，seq 恢复为偶数
+ * @param  store 授权卡表
+ * @return 无
+ */
+static void _card_store_write_end(card_store_t *store)
+{
+    uint32_t seq = atomic_load_explicit(&store->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&store->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * @brief  按卡号比较，供 qsort 使用
+ * @param  a 表项
+ * @param  b 表项
+ * @return 比较结果
+ */
+static int _card_store_compare(const void *a, const void *b)
+{
+    uint32_t ia = ((const card_entry_t *)a)->id;
+    uint32_t ib = ((const card_entry_t *)b)->id;
+
+    return (ia > ib) - (ia < ib);
+}
@@ -0,0 +1,81 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __CARD_STORE_H__
+#define __CARD_STORE_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* 最大卡片数量，每张 8 字节(1024 张占 8 KB)，可在编译选项中调整 */
+#ifndef CARD_STORE_CAPACITY
+#define CARD_STORE_CAPACITY             1024
+#endif
+
+#define CARD_FLAG_DISABLED              0x0001          // 已停用，刷卡时拒绝
+
+/**
+ * @brief   紧凑的授权卡表项(8 字节)
+ */
+typedef struct card_entry{
+    uint32_t id;                    // 卡号(8位数字)
+    uint16_t expire_day;            // 有效期，1970-01-01 起的天数(含当天)
+    uint16_t flags;                 // CARD_FLAG_xxx
+}card_entry_t;
+
+/**
+ * @brief   刷卡鉴权结果
+ */
+typedef enum{
+    CARD_AUTH_OK = 0,               // 授权通过
+    CARD_AUTH_UNKNOWN,              // 卡号不在授权表中
+    CARD_AUTH_EXPIRED,              // 已过有效期
+    CARD_AUTH_DISABLED,             // 已停用
+}card_auth_t;
+
+/**
+ * @brief   修改授权表的结果
+ */
+typedef enum{
+    CARD_STORE_OK = 0,
+    CARD_STORE_DUPLICATE,           // 卡号已存在
+    CARD_STORE_FULL,                // 已达 CARD_STORE_CAPACITY
+    CARD_STORE_NOT_FOUND,           // 卡号不存在
+}card_store_status_t;
+
+/**
+ * @brief   按卡号升序排列的授权卡表(单写者/多读者)
+ * @note    查找为二分查找 O(log n)，增删为有序插入 O(n)。
+ *          写者修改前后各递增一次 seq(奇数表示正在修改)；查找不加锁，
+ *          读完后 seq 有变化则重查，多次冲突后让出 CPU 等写者完成(写者的
+ *          一次修改最多搬移 CARD_STORE_CAPACITY 项，只有几微秒)。
+ *          增删改和按下标遍历只能在同一个任务中进行(HTTP 服务任务)
+ */
+typedef struct card_store{
+    atomic_uint seq;                // 修改序号
+    uint32_t count;                 // 卡片数量
+    card_entry_t cards[CARD_STORE_CAPACITY];
+}card_store_t;
+
+/* 全局授权卡表 */
+extern card_store_t g_card_store;
+
+/* public function protypes ------------------------------------------------- */
+void card_store_init(card_store_t *store);
+card_store_status_t card_store_add(card_store_t *store, const card_entry_t *card);
+card_store_status_t card_store_remove(card_store_t *store, uint32_t id);
+void card_store_copy(card_store_t *dst, const card_store_t *src);
+void card_store_sort(card_store_t *store);
+int32_t card_store_index(const card_store_t *store, uint32_t id);
+bool card_store_find(card_store_t *store, uint32_t id, card_entry_t *out);
+card_auth_t card_store_authorize(card_store_t *store, uint32_t id, uint16_t today);
+const char *card_auth_strerror(card_auth_t result);
+
+card_auth_t card_authorize(uint32_t id, uint16_t today);
+
+#endif /* __CARD_STORE_H__ */
@@ -0,0 +1,113 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdatomic.h>
+#include "mem_stats.h"
+
+/**
+ * @brief   计数器(分配钩子中调用，只做原子加法)
+ */
+typedef struct mem_counters{
+    atomic_uint allocs;
+    atomic_uint frees;
+    atomic_uint bytes;
+    atomic_uint failed;
+}mem_counters_t;
+
+static mem_counters_t s_counters[MEM_SUBSYS_COUNT];
+
+static const char *const s_subsys_names[MEM_SUBSYS_COUNT] = {
+    [MEM_SUBSYS_OTHER]   = "other",
+    [MEM_SUBSYS_HTTP]    = "http",
+    [MEM_SUBSYS_JSON]    = "json",
+    [MEM_SUBSYS_UART]    = "uart",
+    [MEM_SUBSYS_STORAGE] = "storage",
+};
+
+/**
+ * @brief  记录一次成功的分配
+ * @param  subsys 子系统
+ * @param  size 字节数
+ * @return 无
+ */
+void mem_stats_alloc(mem_subsys_t subsys, size_t size)
+{
+    if(subsys >= MEM_SUBSYS_COUNT) {
+        subsys = MEM_SUBSYS_OTHER;
+    }
+    atomic_fetch_add_explicit(&s_counters[subsys].allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_counters[subsys].bytes, (unsigned)size, memory_order_relaxed);
+}
+
+/**
+ * @brief  记录一次失败的分配
+ * @param  subsys 子系统
+ * @return 无
+ */
+void mem_stats_alloc_failed(mem_subsys_t subsys)
+{
+    if(subsys >= MEM_SUBSYS_COUNT) {
+        subsys = MEM_SUBSYS_OTHER;
+    }
+    atomic_fetch_add_explicit(&s_counters[subsys].failed, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief  记录一次释放
+ * @param  subsys 子系统
+ * @return 无
+ */
+void mem_stats_free(mem_subsys_t subsys)
+{
+    if(subsys >= MEM_SUBSYS_COUNT) {
+        subsys = MEM_SUBSYS_OTHER;
+    }
+    atomic_fetch_add_explicit(&s_counters[subsys].frees, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief  读取所有子系统的计数
+ * @param  stats 输出，MEM_SUBSYS_COUNT 项
+ * @return 无
+ */
+void mem_stats_get(mem_subsys_stats_t stats[MEM_SUBSYS_COUNT])
+{
+    uint8_t i;
+
+    for(i = 0; i < MEM_SUBSYS_COUNT; i ++) {
+        stats[i].allocs = atomic_load_explicit(&s_counters[i].allocs, memory_order_relaxed);
+        stats[i].frees = atomic_load_explicit(&s_counters[i].frees, memory_order_relaxed);
+        stats[i].bytes = atomic_load_explicit(&s_counters[i].bytes, memory_order_relaxed);
+        stats[i].failed = atomic_load_explicit(&s_counters[i].failed, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief  清零所有计数
+ * @param  无
+ * @return 无
+ */
+void mem_stats_reset(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < MEM_SUBSYS_COUNT; i ++) {
+        atomic_store(&s_counters[i].allocs, 0);
+        atomic_store(&s_counters[i].frees, 0);
+        atomic_store(&s_counters[i].bytes, 0);
+        atomic_store(&s_counters[i].failed, 0);
+    }
+}
+
+/**
+ * @brief  获取子系统名称
+ * @param  subsys 子系统
+ * @return 名称
+ */
+const char *mem_subsys_name(mem_subsys_t subsys)
+{
+    return (subsys < MEM_SUBSYS_COUNT) ? s_subsys_names[subsys] : "?";
+}
@@ -0,0 +1,49 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __MEM_STATS_H__
+#define __MEM_STATS_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief   内存分配的归属子系统
+ */
+typedef enum{
+    MEM_SUBSYS_OTHER = 0,           // 未归属(系统任务等)
+    MEM_SUBSYS_HTTP,                // HTTP 服务、工作任务、WebSocket 推送
+    MEM_SUBSYS_JSON,                // JSON 读写(作用域)
+    MEM_SUBSYS_UART,                // 主控板串口任务
+    MEM_SUBSYS_STORAGE,             // NVS/闪存持久化(作用域)
+    MEM_SUBSYS_COUNT,
+}mem_subsys_t;
+
+/**
+ * @brief   一个子系统的分配计数
+ */
+typedef struct mem_subsys_stats{
+    uint32_t allocs;                // 成功分配次数
+    uint32_t frees;                 // 释放次数(按释放时所在的子系统统计)
+    uint32_t bytes;                 // 累计分配字节数
+    uint32_t failed;                // 分配失败次数
+}mem_subsys_stats_t;
+
+/* public function protypes ------------------------------------------------- */
+void mem_stats_alloc(mem_subsys_t subsys, size_t size);
+void mem_stats_alloc_failed(mem_subsys_t subsys);
+void mem_stats_free(mem_subsys_t subsys);
+void mem_stats_get(mem_subsys_stats_t stats[MEM_SUBSYS_COUNT]);
+void mem_stats_reset(void);
+const char *mem_subsys_name(mem_subsys_t subsys);
+
+/* 作用域: 把当前任务(线程)之后的分配记到 subsys，返回原来的子系统，用 mem_stats_scope_exit 恢复；
+   目标板上由 src/mem_diag.c 实现，主机构建由 mem_stats_wrap.c 实现 */
+mem_subsys_t mem_stats_scope_enter(mem_subsys_t subsys);
+void mem_stats_scope_exit(mem_subsys_t prev);
+
+#endif /* __MEM_STATS_H__ */
@@ -0,0 +1,106 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/*
+ * 主机构建: 用链接器的 --wrap 把 malloc/calloc/realloc/free 接到计数器上，
+ * 单元测试可以在调用被测函数前后比较 mem_stats_get 的结果，断言热路径上没有分配：
+ *
+ *   cc -DMEM_STATS_WRAP -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free ...
+ *
+ * 目标板上不定义 MEM_STATS_WRAP，本文件为空，分配由 ESP-IDF 的堆钩子统计(src/mem_diag.c)
+ */
+#ifdef MEM_STATS_WRAP
+
+/* include ------------------------------------------------------------------ */
+#include <stdlib.h>
+#include "mem_stats.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+/* 当前线程的归属子系统 */
+static _Thread_local mem_subsys_t s_scope = MEM_SUBSYS_OTHER;
+
+/**
+ * @brief  进入作用域
+ * @param  subsys 子系统
+ * @return 原来的子系统
+ */
+mem_subsys_t mem_stats_scope_enter(mem_subsys_t subsys)
+{
+    mem_subsys_t prev = s_scope;
+
+    s_scope = subsys;
+    return prev;
+}
+
+/**
+ * @brief  退出作用域
+ * @param  prev mem_stats_scope_enter 的返回值
+ * @return 无
+ */
+void mem_stats_scope_exit(mem_subsys_t prev)
+{
+    s_scope = prev;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+
+    if(NULL != ptr) {
+        mem_stats_alloc(s_scope, size);
+    } else {
+        mem_stats_alloc_failed(s_scope);
+    }
+    return ptr;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    void *ptr = __real_calloc(n, size);
+
+    if(NULL != ptr) {
+        mem_stats_alloc(s_scope, n * size);
+    } else {
+        mem_stats_alloc_failed(s_scope);
+    }
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    void *p = __real_realloc(ptr, size);
+
+    if(NULL != p) {
+        mem_stats_alloc(s_scope, size);
+        if(NULL != ptr) {
+            mem_stats_free(s_scope);
+        }
+    } else if(size > 0) {
+        mem_stats_alloc_failed(s_scope);
+    } else if(NULL != ptr) {
+        /* realloc(ptr, 0) 返回 NULL 时(glibc)已经释放了 ptr */
+        mem_stats_free(s_scope);
+    }
+    return p;
+}
+
+void __wrap_free(void *ptr)
+{
+    if(NULL != ptr) {
+        mem_stats_free(s_scope);
+    }
+    __real_free(ptr);
+}
+
+#else
+
+/* 没有定义 MEM_STATS_WRAP 时保留一个声明，ISO C 不允许空的翻译单元 */
+typedef int mem_stats_wrap_unused_t;
+
+#endif /* MEM_STATS_WRAP */
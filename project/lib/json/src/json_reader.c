@@ -0,0 +1,468 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdlib.h>
+#include <string.h>
+#include "json_reader.h"
+
+/**
+ * @brief   解析状态
+ */
+typedef enum{
+    JR_OBJECT_START = 0,            // 等待 '{'
+    JR_KEY_FIRST,                   // 等待第一个键或 '}'
+    JR_KEY_NEXT,                    // ',' 之后，等待下一个键
+    JR_KEY,                         // 键名字符串内
+    JR_COLON,                       // 等待 ':'
+    JR_VALUE,                       // 等待值
+    JR_STRING,                      // 字符串值内
+    JR_LITERAL,                     // 数字或 true/false/null
+    JR_AFTER_VALUE,                 // 等待 ',' 或 '}'
+    JR_DONE,                        // 对象已结束，只允许空白
+}json_reader_state_t;
+
+/* private function protypes -------------------------------------------------*/
+static json_read_status_t _json_reader_byte(json_reader_t *rd, char c);
+static json_read_status_t _json_reader_string_byte(json_reader_t *rd, char c, char *dest, uint8_t *len, uint8_t size);
+static json_read_status_t _json_reader_key_done(json_reader_t *rd);
+static json_read_status_t _json_reader_value_done(json_reader_t *rd);
+static json_read_status_t _json_parse_uint(const char *text, uint32_t *value);
+static bool _json_is_space(char c);
+
+/**
+ * @brief  初始化解析器
+ * @param  rd     解析器
+ * @param  fields 字段表(不超过 JSON_READER_MAX_FIELDS 项)
+ * @param  count  字段个数
+ * @param  obj    目标结构体，校验通过的值直接写入，未出现的字段保持原值
+ * @return 无
+ */
+void json_reader_init(json_reader_t *rd, const json_field_t *fields, uint8_t count, void *obj)
+{
+    memset(rd, 0, sizeof(*rd));
+    rd->fields = fields;
+    rd->count = count > JSON_READER_MAX_FIELDS ? JSON_READER_MAX_FIELDS : count;
+    rd->obj = obj;
+    rd->state = JR_OBJECT_START;
+    rd->field = -1;
+    rd->status = JSON_READ_OK;
+}
+
+/**
+ * @brief  输入一段数据
+ * @param  rd  解析器
+ * @param  buf 数据，可以在任意位置断开
+ * @param  len 数据长度
+ * @return JSON_READ_OK 表示目前为止没有错误，其他为错误码(之后的输入被忽略)
+ */
+json_read_status_t json_reader_feed(json_reader_t *rd, const char *buf, size_t len)
+{
+    size_t i;
+
+    for(i = 0; i < len && JSON_READ_OK == rd->status; i ++) {
+        rd->status = _json_reader_byte(rd, buf[i]);
+    }
+    return (json_read_status_t)rd->status;
+}
+
+/**
+ * @brief  输入结束，检查对象是否完整以及必需字段是否齐全
+ * @param  rd 解析器
+ * @return 解析结果
+ */
+json_read_status_t json_reader_finish(json_reader_t *rd)
+{
+    uint8_t i;
+
+    if(JSON_READ_OK != rd->status) {
+        return (json_read_status_t)rd->status;
+    }
+    if(JR_DONE != rd->state) {
+        rd->status = JSON_READ_ERR_INCOMPLETE;
+        return JSON_READ_ERR_INCOMPLETE;
+    }
+    for(i = 0; i < rd->count; i ++) {
+        if((rd->fields[i].flags & JSON_FIELD_REQUIRED) && !(rd->seen & (1u << i))) {
+            rd->field = (int8_t)i;
+            rd->status = JSON_READ_ERR_MISSING;
+            return JSON_READ_ERR_MISSING;
+        }
+    }
+    return JSON_READ_OK;
+}
+
+/**
+ * @brief  查询某个字段是否出现在输入中
+ * @param  rd   解析器
+ * @param  name 键名
+ * @return 是否出现过
+ */
+bool json_reader_has(const json_reader_t *rd, const char *name)
+{
+    uint8_t i;
+
+    for(i = 0; i < rd->count; i ++) {
+        if(0 == strcmp(rd->fields[i].name, name)) {
+            return (rd->seen & (1u << i)) != 0;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief  获取出错时对应的字段名
+ * @param  rd 解析器
+ * @return 字段名，错误与具体字段无关时返回 NULL
+ */
+const char *json_reader_error_field(const json_reader_t *rd)
+{
+    if(JSON_READ_OK == rd->status || rd->field < 0) {
+        return NULL;
+    }
+    return rd->fields[rd->field].name;
+}
+
+/**
+ * @brief  获取错误码的文字描述
+ * @param  status 错误码
+ * @return 描述文字
+ */
+const char *json_read_strerror(json_read_status_t status)
+{
+    switch(status) {
+        case JSON_READ_OK:              return "ok";
+        case JSON_READ_ERR_SYNTAX:      return "JSON格式错误";
+        case JSON_READ_ERR_TOO_LONG:    return "字段过长";
+        case JSON_READ_ERR_UNKNOWN:     return "未知字段";
+        case JSON_READ_ERR_DUPLICATE:   return "字段重复";
+        case JSON_READ_ERR_TYPE:        return "字段类型错误";
+        case JSON_READ_ERR_RANGE:       return "字段超出范围";
+        case JSON_READ_ERR_MISSING:     return "缺少必需字段";
+        case JSON_READ_ERR_INCOMPLETE:  return "数据不完整";
+        default:                        return "未知错误";
+    }
+}
+
+/**
+ * @brief  状态机处理一个字节
+ * @param  rd 解析器
+ * @param  c  输入字节
+ * @return 处理结果
+ */
+static json_read_status_t _json_reader_byte(json_reader_t *rd, char c)
+{
+    json_read_status_t ret;
+
+    switch(rd->state) {
+        case JR_OBJECT_START:
+        if(_json_is_space(c)) {
+            return JSON_READ_OK;
+        }
+        if('{' != c) {
+            return JSON_READ_ERR_SYNTAX;
+        }
+        rd->state = JR_KEY_FIRST;
+        return JSON_READ_OK;
+
+        case JR_KEY_FIRST:
+        case JR_KEY_NEXT:
+        if(_json_is_space(c)) {
+            return JSON_READ_OK;
+        }
+        if('}' == c && JR_KEY_FIRST == rd->state) {
+            rd->state = JR_DONE;
+            return JSON_READ_OK;
+        }
+        if('"' != c) {
+            return JSON_READ_ERR_SYNTAX;
+        }
+        rd->key_len = 0;
+        rd->escape = false;
+        rd->state = JR_KEY;
+        return JSON_READ_OK;
+
+        case JR_KEY:
+        if('"' == c && !rd->escape) {
+            rd->key[rd->key_len] = '\0';
+            rd->state = JR_COLON;
+            return _json_reader_key_done(rd);
+        }
+        return _json_reader_string_byte(rd, c, rd->key, &rd->key_len, JSON_READER_KEY_LEN);
+
+        case JR_COLON:
+        if(_json_is_space(c)) {
+            return JSON_READ_OK;
+        }
+        if(':' != c) {
+            return JSON_READ_ERR_SYNTAX;
+        }
+        rd->state = JR_VALUE;
+        return JSON_READ_OK;
+
+        case JR_VALUE:
+        if(_json_is_space(c)) {
+            return JSON_READ_OK;
+        }
+        rd->value_len = 0;
+        rd->escape = false;
+        if('"' == c) {
+            rd->is_string = true;
+            rd->state = JR_STRING;
+            return JSON_READ_OK;
+        }
+        if(('-' == c) || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')) {
+            rd->is_string = false;
+            rd->state = JR_LITERAL;
+            rd->value[rd->value_len ++] = c;
+            return JSON_READ_OK;
+        }
+        /* 只支持扁平对象，嵌套的对象/数组视为格式错误 */
+        return JSON_READ_ERR_SYNTAX;
+
+        case JR_STRING:
+        if('"' == c && !rd->escape) {
+            rd->value[rd->value_len] = '\0';
+            rd->state = JR_AFTER_VALUE;
+            return _json_reader_value_done(rd);
+        }
+        return _json_reader_string_byte(rd, c, rd->value, &rd->value_len, JSON_READER_VALUE_LEN);
+
+        case JR_LITERAL:
+        if((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           '.' == c || '+' == c || '-' == c) {
+            if(rd->value_len >= JSON_READER_VALUE_LEN) {
+                return JSON_READ_ERR_TOO_LONG;
+            }
+            rd->value[rd->value_len ++] = c;
+            return JSON_READ_OK;
+        }
+        /* 字面量没有结束符，遇到其他字符时提交，再按 JR_AFTER_VALUE 处理该字符 */
+        rd->value[rd->value_len] = '\0';
+        rd->state = JR_AFTER_VALUE;
+        ret = _json_reader_value_done(rd);
+        if(JSON_READ_OK != ret) {
+            return ret;
+        }
+        return _json_reader_byte(rd, c);
+
+        case JR_AFTER_VALUE:
+        if(_json_is_space(c)) {
+            return JSON_READ_OK;
+        }
+        rd->field = -1;
+        if(',' == c) {
+            rd->state = JR_KEY_NEXT;
+            return JSON_READ_OK;
+        }
+        if('}' == c) {
+            rd->state = JR_DONE;
+            return JSON_READ_OK;
+        }
+        return JSON_READ_ERR_SYNTAX;
+
+        case JR_DONE:
+        default:
+        return _json_is_space(c) ? JSON_READ_OK : JSON_READ_ERR_SYNTAX;
+    }
+}
+
+/**
+ * @brief  处理字符串(键名或值)中的一个字节，包括转义
+ * @param  rd   解析器
+ * @param  c    输入字节
+ * @param  dest 目标缓冲区
+ * @param  len  已写入的长度
+ * @param  size 最大长度(不含结束符)
+ * @return 处理结果
+ * @note   不支持 \uXXXX 转义，配置项和卡号中不会出现
+ */
+static json_read_status_t _json_reader_string_byte(json_reader_t *rd, char c, char *dest, uint8_t *len, uint8_t size)
+{
+    if((uint8_t)c < 0x20) {
+        return JSON_READ_ERR_SYNTAX;
+    }
+    if(rd->escape) {
+        rd->escape = false;
+        switch(c) {
+            case '"':
+            case '\\':
+            case '/': break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            default:
+            return JSON_READ_ERR_SYNTAX;
+        }
+    } else if('\\' == c) {
+        rd->escape = true;
+        return JSON_READ_OK;
+    }
+
+    if(*len >= size) {
+        return JSON_READ_ERR_TOO_LONG;
+    }
+    dest[(*len) ++] = c;
+    return JSON_READ_OK;
+}
+
+/**
+ * @brief  键名结束，在字段表中查找
+ * @param  rd 解析器
+ * @return 处理结果
+ */
+static json_read_status_t _json_reader_key_done(json_reader_t *rd)
+{
+    uint8_t i;
+
+    for(i = 0; i < rd->count; i ++) {
+        if(0 == strcmp(rd->fields[i].name, rd->key)) {
+            rd->field = (int8_t)i;
+            if(rd->seen & (1u << i)) {
+                return JSON_READ_ERR_DUPLICATE;
+            }
+            rd->seen |= 1u << i;
+            return JSON_READ_OK;
+        }
+    }
+    rd->field = -1;
+    return JSON_READ_ERR_UNKNOWN;
+}
+
+/**
+ * @brief  值结束，按字段描述校验并写入目标结构体
+ * @param  rd 解析器
+ * @return 处理结果
+ */
+static json_read_status_t _json_reader_value_done(json_reader_t *rd)
+{
+    const json_field_t *f = &rd->fields[rd->field];
+    uint8_t *member = (uint8_t *)rd->obj + f->offset;
+    json_read_status_t ret;
+    uint32_t u32;
+    uint16_t u16;
+    uint8_t u8;
+    float value;
+    char *end;
+    uint8_t i;
+
+    if(JSON_FIELD_STRING == f->type) {
+        if(!rd->is_string) {
+            return JSON_READ_ERR_TYPE;
+        }
+        if(rd->value_len < f->min || rd->value_len > f->max || rd->value_len >= f->size) {
+            return JSON_READ_ERR_RANGE;
+        }
+        memcpy(member, rd->value, rd->value_len + 1);
+        return JSON_READ_OK;
+    }
+    if(rd->is_string) {
+        return JSON_READ_ERR_TYPE;
+    }
+
+    if(JSON_FIELD_BOOL == f->type) {
+        if(0 == strcmp(rd->value, "true")) {
+            *(bool *)member = true;
+        } else if(0 == strcmp(rd->value, "false")) {
+            *(bool *)member = false;
+        } else {
+            return JSON_READ_ERR_TYPE;
+        }
+        return JSON_READ_OK;
+    }
+
+    if(JSON_FIELD_FLOAT == f->type) {
+        /* strtof 还接受 inf/nan/十六进制，先按 JSON 数字的字符集过滤 */
+        for(i = 0; i < rd->value_len; i ++) {
+            if(NULL == strchr("0123456789.eE+-", rd->value[i])) {
+                return JSON_READ_ERR_TYPE;
+            }
+        }
+        value = strtof(rd->value, &end);
+        if(end == rd->value || '\0' != *end) {
+            return JSON_READ_ERR_TYPE;
+        }
+        if(!(value >= f->min && value <= f->max)) {
+            return JSON_READ_ERR_RANGE;
+        }
+        memcpy(member, &value, sizeof(value));
+        return JSON_READ_OK;
+    }
+
+    ret = _json_parse_uint(rd->value, &u32);
+    if(JSON_READ_OK != ret) {
+        return ret;
+    }
+    if((float)u32 < f->min || (float)u32 > f->max) {
+        return JSON_READ_ERR_RANGE;
+    }
+    switch(f->type) {
+        case JSON_FIELD_U8:
+        if(u32 > UINT8_MAX) {
+            return JSON_READ_ERR_RANGE;
+        }
+        u8 = (uint8_t)u32;
+        memcpy(member, &u8, sizeof(u8));
+        break;
+
+        case JSON_FIELD_U16:
+        if(u32 > UINT16_MAX) {
+            return JSON_READ_ERR_RANGE;
+        }
+        u16 = (uint16_t)u32;
+        memcpy(member, &u16, sizeof(u16));
+        break;
+
+        case JSON_FIELD_U32:
+        default:
+        memcpy(member, &u32, sizeof(u32));
+        break;
+    }
+    return JSON_READ_OK;
+}
+
+/**
+ * @brief  解析 JSON 非负整数
+ * @param  text  文本
+ * @param  value 输出数值
+ * @return 处理结果，小数/指数形式为类型错误，负数或超过32位为范围错误
+ */
+static json_read_status_t _json_parse_uint(const char *text, uint32_t *value)
+{
+    uint32_t v = 0;
+    bool neg = false;
+
+    if('-' == *text) {
+        neg = true;
+        text ++;
+    }
+    if('\0' == *text) {
+        return JSON_READ_ERR_TYPE;
+    }
+    for(; '\0' != *text; text ++) {
+        if(*text < '0' || *text > '9') {
+            return JSON_READ_ERR_TYPE;
+        }
+        if(v > (UINT32_MAX - (uint32_t)(*text - '0')) / 10) {
+            return JSON_READ_ERR_RANGE;
+        }
+        v = v * 10 + (uint32_t)(*text - '0');
+    }
+    if(neg && v) {
+        return JSON_READ_ERR_RANGE;
+    }
+    *value = v;
+    return JSON_READ_OK;
+}
+
+/**
+ * @brief  JSON 空白字符
+ */
+static bool _json_is_space(char c)
+{
+    return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+}
@@ -0,0 +1,98 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __JSON_READER_H__
+#define __JSON_READER_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_READER_KEY_LEN             24              // 键名最大长度
+#define JSON_READER_VALUE_LEN           32              // 单个值文本的最大长度
+#define JSON_READER_MAX_FIELDS          32              // 字段表最大项数(已出现字段用位图记录)
+
+/**
+ * @brief   字段类型
+ */
+typedef enum{
+    JSON_FIELD_U8 = 0,              // uint8_t，JSON 整数
+    JSON_FIELD_U16,                 // uint16_t，JSON 整数
+    JSON_FIELD_U32,                 // uint32_t，JSON 整数
+    JSON_FIELD_FLOAT,               // float，JSON 数字
+    JSON_FIELD_BOOL,                // bool，true/false
+    JSON_FIELD_STRING,              // char[]，JSON 字符串，min/max 限制长度
+}json_field_type_t;
+
+#define JSON_FIELD_REQUIRED             0x01            // 缺少该字段时解析失败
+
+/**
+ * @brief   字段描述，编译期确定，解析时按名称查表并校验后直接写入结构体
+ */
+typedef struct json_field{
+    const char *name;               // 键名
+    uint8_t type;                   // 字段类型 json_field_type_t
+    uint8_t flags;                  // JSON_FIELD_REQUIRED 等
+    uint16_t offset;                // 成员在结构体中的偏移
+    uint16_t size;                  // 成员大小(字符串含结束符)
+    float min;                      // 数值下限 / 字符串最短长度
+    float max;                      // 数值上限 / 字符串最长长度
+}json_field_t;
+
+#define JSON_FIELD_NUM(kind, type, member, lo, hi, fl) \
+    { #member, kind, fl, offsetof(type, member), sizeof(((type *)0)->member), lo, hi }
+#define JSON_FIELD_UINT8(type, member, lo, hi, fl)      JSON_FIELD_NUM(JSON_FIELD_U8, type, member, lo, hi, fl)
+#define JSON_FIELD_UINT16(type, member, lo, hi, fl)     JSON_FIELD_NUM(JSON_FIELD_U16, type, member, lo, hi, fl)
+#define JSON_FIELD_UINT32(type, member, lo, hi, fl)     JSON_FIELD_NUM(JSON_FIELD_U32, type, member, lo, hi, fl)
+#define JSON_FIELD_FLOAT32(type, member, lo, hi, fl)    JSON_FIELD_NUM(JSON_FIELD_FLOAT, type, member, lo, hi, fl)
+#define JSON_FIELD_BOOLEAN(type, member, fl)            JSON_FIELD_NUM(JSON_FIELD_BOOL, type, member, 0, 1, fl)
+#define JSON_FIELD_STR(type, member, lo, hi, fl)        JSON_FIELD_NUM(JSON_FIELD_STRING, type, member, lo, hi, fl)
+
+/**
+ * @brief   解析结果
+ */
+typedef enum{
+    JSON_READ_OK = 0,               // 目前为止格式正确(feed)，或解析完成(finish)
+    JSON_READ_ERR_SYNTAX,           // 不是合法的 JSON 或不是扁平对象
+    JSON_READ_ERR_TOO_LONG,         // 键名或值超出长度限制
+    JSON_READ_ERR_UNKNOWN,          // 字段表中没有的键
+    JSON_READ_ERR_DUPLICATE,        // 同一个键出现多次
+    JSON_READ_ERR_TYPE,             // 值的类型与字段不符
+    JSON_READ_ERR_RANGE,            // 值超出范围
+    JSON_READ_ERR_MISSING,          // 缺少必需字段
+    JSON_READ_ERR_INCOMPLETE,       // 数据在对象结束前截止
+}json_read_status_t;
+
+/**
+ * @brief   可分块输入的扁平 JSON 对象解析器
+ * @note    逐字节的状态机，数据可以在任意位置断开并在下一次 feed 中继续；
+ *          只使用结构体内的定长缓冲区，不申请堆内存，耗时与输入长度成正比
+ */
+typedef struct json_reader{
+    const json_field_t *fields;     // 字段表
+    uint8_t count;                  // 字段个数
+    void *obj;                      // 目标结构体
+    uint8_t state;                  // 解析状态
+    uint8_t key_len;
+    uint8_t value_len;
+    bool escape;                    // 字符串中遇到了 '\'
+    bool is_string;                 // 当前值是字符串
+    int8_t field;                   // 当前键对应的字段下标，-1 表示无
+    uint8_t status;                 // json_read_status_t，出错后不再接受输入
+    uint32_t seen;                  // 已出现字段的位图
+    char key[JSON_READER_KEY_LEN + 1];
+    char value[JSON_READER_VALUE_LEN + 1];
+}json_reader_t;
+
+/* public function protypes ------------------------------------------------- */
+void json_reader_init(json_reader_t *rd, const json_field_t *fields, uint8_t count, void *obj);
+json_read_status_t json_reader_feed(json_reader_t *rd, const char *buf, size_t len);
+json_read_status_t json_reader_finish(json_reader_t *rd);
+bool json_reader_has(const json_reader_t *rd, const char *name);
+const char *json_reader_error_field(const json_reader_t *rd);
+const char *json_read_strerror(json_read_status_t status);
+
+#endif /* __JSON_READER_H__ */
@@ -0,0 +1,479 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdio.h>
+#include <string.h>
+#include "json_writer.h"
+
+static const uint32_t s_pow10[JSON_FLOAT_MAX_PREC + 1] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000
+};
+
+/* private function protypes -------------------------------------------------*/
+static void _json_put(json_writer_t *w, const char *src, size_t len);
+static void _json_putc(json_writer_t *w, char c);
+static void _json_value_prefix(json_writer_t *w);
+static void _json_container_begin(json_writer_t *w, char c);
+static void _json_container_end(json_writer_t *w, char c);
+
+/**
+ * @brief  初始化写入器
+ * @param  w     写入器
+ * @param  buf   输出缓冲区
+ * @param  size  缓冲区大小
+ * @param  flush 输出回调，为 NULL 时所有内容必须放进缓冲区
+ * @param  ctx   回调的用户参数
+ * @return 无
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_flush_t flush, void *ctx)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->flushed = 0;
+    w->flush = flush;
+    w->ctx = ctx;
+    w->comma = 0;
+    w->depth = 0;
+    w->after_key = false;
+    w->error = (NULL == buf) || (0 == size);
+}
+
+/**
+ * @brief  通过回调输出缓冲区中的全部内容
+ * @param  w 写入器
+ * @return 写入器是否仍处于正常状态
+ */
+bool json_writer_flush(json_writer_t *w)
+{
+    if(w->error || 0 == w->len) {
+        return !w->error;
+    }
+    if((NULL == w->flush) || !w->flush(w->ctx, w->buf, w->len)) {
+        w->error = true;
+        return false;
+    }
+    w->flushed += w->len;
+    w->len = 0;
+    return true;
+}
+
+/**
+ * @brief  检查写入器状态
+ * @param  w 写入器
+ * @return 未出错且所有容器都已闭合时返回 true
+ */
+bool json_writer_ok(const json_writer_t *w)
+{
+    return !w->error && (0 == w->depth);
+}
+
+/**
+ * @brief  开始一个对象 '{'
+ * @param  w 写入器
+ * @return 无
+ */
+void json_object_begin(json_writer_t *w)
+{
+    _json_container_begin(w, '{');
+}
+
+/**
+ * @brief  结束当前对象 '}'
+ * @param  w 写入器
+ * @return 无
+ */
+void json_object_end(json_writer_t *w)
+{
+    _json_container_end(w, '}');
+}
+
+/**
+ * @brief  开始一个数组 '['
+ * @param  w 写入器
+ * @return 无
+ */
+void json_array_begin(json_writer_t *w)
+{
+    _json_container_begin(w, '[');
+}
+
+/**
+ * @brief  结束当前数组 ']'
+ * @param  w 写入器
+ * @return 无
+ */
+void json_array_end(json_writer_t *w)
+{
+    _json_container_end(w, ']');
+}
+
+/**
+ * @brief  写入对象的键名，之后必须紧跟一个值
+ * @param  w   写入器
+ * @param  key 键名(按字符串转义)
+ * @return 无
+ */
+void json_key(json_writer_t *w, const char *key)
+{
+    json_string(w, key);
+    _json_putc(w, ':');
+    w->after_key = true;
+}
+
+/**
+ * @brief  写入字符串值，按 JSON 规则转义
+ * @param  w   写入器
+ * @param  str 字符串，为 NULL 时写入 null
+ * @return 无
+ */
+void json_string(json_writer_t *w, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run;
+    char esc[6];
+    uint8_t c;
+
+    if(NULL == str) {
+        json_null(w);
+        return;
+    }
+
+    _json_value_prefix(w);
+    _json_putc(w, '"');
+    run = str;
+    while(0 != (c = (uint8_t)*str)) {
+        if(c >= 0x20 && c != '"' && c != '\\') {
+            str ++;
+            continue;
+        }
+
+        /* 不需要转义的连续字符一次写入 */
+        _json_put(w, run, str - run);
+        esc[0] = '\\';
+        switch(c) {
+            case '"':  esc[1] = '"';  _json_put(w, esc, 2); break;
+            case '\\': esc[1] = '\\'; _json_put(w, esc, 2); break;
+            case '\n': esc[1] = 'n';  _json_put(w, esc, 2); break;
+            case '\r': esc[1] = 'r';  _json_put(w, esc, 2); break;
+            case '\t': esc[1] = 't';  _json_put(w, esc, 2); break;
+            default:
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0x0F];
+            _json_put(w, esc, 6);
+            break;
+        }
+        run = ++ str;
+    }
+    _json_put(w, run, str - run);
+    _json_putc(w, '"');
+}
+
+/**
+ * @brief  写入有符号整数
+ * @param  w     写入器
+ * @param  value 数值
+ * @return 无
+ */
+void json_int(json_writer_t *w, int32_t value)
+{
+    char num[JSON_NUM_BUF_LEN];
+    size_t len = 0;
+
+    _json_value_prefix(w);
+    if(value < 0) {
+        num[len ++] = '-';
+        len += json_format_uint(num + len, 0u - (uint32_t)value);
+    } else {
+        len += json_format_uint(num + len, (uint32_t)value);
+    }
+    _json_put(w, num, len);
+}
+
+/**
+ * @brief  写入无符号整数
+ * @param  w     写入器
+ * @param  value 数值
+ * @return 无
+ */
+void json_uint(json_writer_t *w, uint32_t value)
+{
+    char num[JSON_NUM_BUF_LEN];
+
+    _json_value_prefix(w);
+    _json_put(w, num, json_format_uint(num, value));
+}
+
+/**
+ * @brief  按固定小数位数写入浮点数
+ * @param  w     写入器
+ * @param  value 数值，NaN/无穷大写入 null
+ * @param  prec  小数位数，超过 JSON_FLOAT_MAX_PREC 时按 JSON_FLOAT_MAX_PREC 处理
+ * @return 无
+ */
+void json_float(json_writer_t *w, float value, uint8_t prec)
+{
+    char num[JSON_NUM_BUF_LEN];
+
+    _json_value_prefix(w);
+    _json_put(w, num, json_format_float(num, value, prec));
+}
+
+/**
+ * @brief  写入布尔值
+ * @param  w     写入器
+ * @param  value 数值
+ * @return 无
+ */
+void json_bool(json_writer_t *w, bool value)
+{
+    _json_value_prefix(w);
+    if(value) {
+        _json_put(w, "true", 4);
+    } else {
+        _json_put(w, "false", 5);
+    }
+}
+
+/**
+ * @brief  写入 null
+ * @param  w 写入器
+ * @return 无
+ */
+void json_null(json_writer_t *w)
+{
+    _json_value_prefix(w);
+    _json_put(w, "null", 4);
+}
+
+/**
+ * @brief  写入"键:字符串"
+ */
+void json_kv_string(json_writer_t *w, const char *key, const char *str)
+{
+    json_key(w, key);
+    json_string(w, str);
+}
+
+/**
+ * @brief  写入"键:有符号整数"
+ */
+void json_kv_int(json_writer_t *w, const char *key, int32_t value)
+{
+    json_key(w, key);
+    json_int(w, value);
+}
+
+/**
+ * @brief  写入"键:无符号整数"
+ */
+void json_kv_uint(json_writer_t *w, const char *key, uint32_t value)
+{
+    json_key(w, key);
+    json_uint(w, value);
+}
+
+/**
+ * @brief  写入"键:浮点数"
+ */
+void json_kv_float(json_writer_t *w, const char *key, float value, uint8_t prec)
+{
+    json_key(w, key);
+    json_float(w, value, prec);
+}
+
+/**
+ * @brief  写入"键:布尔值"
+ */
+void json_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_key(w, key);
+    json_bool(w, value);
+}
+
+/**
+ * @brief  把无符号整数格式化为十进制文本
+ * @param  buf   目标地址，至少 10 字节，不写结束符
+ * @param  value 数值
+ * @return 文本长度
+ */
+size_t json_format_uint(char *buf, uint32_t value)
+{
+    char tmp[10];
+    size_t n = 0;
+    size_t i;
+
+    do {
+        tmp[n ++] = (char)('0' + value % 10);
+        value /= 10;
+    } while(value);
+
+    for(i = 0; i < n; i ++) {
+        buf[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+/**
+ * @brief  按固定小数位数格式化浮点数
+ * @param  buf   目标地址，至少 JSON_NUM_BUF_LEN 字节，不写结束符
+ * @param  value 数值，NaN/无穷大输出 null
+ * @param  prec  小数位数，超过 JSON_FLOAT_MAX_PREC 时按 JSON_FLOAT_MAX_PREC 处理
+ * @return 文本长度
+ * @note   整数部分和小数部分分开用单精度运算后转成整数输出，不经过 printf 的
+ *         双精度路径；超出 32 位整数范围的数值很少见，退回 snprintf
+ */
+size_t json_format_float(char *buf, float value, uint8_t prec)
+{
+    uint32_t ipart;
+    uint32_t fpart;
+    uint32_t scale;
+    size_t len = 0;
+    size_t i;
+    bool neg;
+
+    if(value != value || value > 3.4e38f || value < -3.4e38f) {
+        memcpy(buf, "null", 4);
+        return 4;
+    }
+    if(prec > JSON_FLOAT_MAX_PREC) {
+        prec = JSON_FLOAT_MAX_PREC;
+    }
+
+    neg = value < 0.0f;
+    if(neg) {
+        value = -value;
+    }
+    if(value >= 4294967040.0f) {
+        return (size_t)snprintf(buf, JSON_NUM_BUF_LEN, "%s%.9g", neg ? "-" : "", (double)value);
+    }
+
+    scale = s_pow10[prec];
+    ipart = (uint32_t)value;
+    fpart = (uint32_t)((value - (float)ipart) * (float)scale + 0.5f);
+    if(fpart >= scale) {
+        /* 小数部分进位，例如 0.96 保留1位 */
+        ipart ++;
+        fpart -= scale;
+    }
+
+    /* 舍入后为零时不输出 "-0" */
+    if(neg && (ipart || fpart)) {
+        buf[len ++] = '-';
+    }
+    len += json_format_uint(buf + len, ipart);
+    if(prec) {
+        buf[len ++] = '.';
+        /* 从低位开始填，固定 prec 位，高位自然补零 */
+        for(i = prec; i > 0; i --) {
+            buf[len + i - 1] = (char)('0' + fpart % 10);
+            fpart /= 10;
+        }
+        len += prec;
+    }
+    return len;
+}
+
+/**
+ * @brief  写入原始文本，缓冲区满时通过回调输出
+ * @param  w   写入器
+ * @param  src 文本
+ * @param  len 长度
+ * @return 无
+ */
+static void _json_put(json_writer_t *w, const char *src, size_t len)
+{
+    size_t n;
+
+    /* 常见情况: 缓冲区放得下，直接拷贝 */
+    if(!w->error && len <= w->size - w->len) {
+        memcpy(w->buf + w->len, src, len);
+        w->len += len;
+        return;
+    }
+    while(len && !w->error) {
+        if(w->len == w->size && !json_writer_flush(w)) {
+            return;
+        }
+        n = w->size - w->len;
+        if(n > len) {
+            n = len;
+        }
+        memcpy(w->buf + w->len, src, n);
+        w->len += n;
+        src += n;
+        len -= n;
+    }
+}
+
+/**
+ * @brief  写入单个字符
+ */
+static void _json_putc(json_writer_t *w, char c)
+{
+    if(!w->error && w->len < w->size) {
+        w->buf[w->len ++] = c;
+        return;
+    }
+    _json_put(w, &c, 1);
+}
+
+/**
+ * @brief  在值之前按需写入逗号，并标记当前层已有元素
+ * @param  w 写入器
+ * @return 无
+ */
+static void _json_value_prefix(json_writer_t *w)
+{
+    uint32_t bit = 1u << w->depth;
+
+    if(w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    if(w->comma & bit) {
+        _json_putc(w, ',');
+    }
+    w->comma |= bit;
+}
+
+/**
+ * @brief  开始一个容器
+ * @param  w 写入器
+ * @param  c '{' 或 '['
+ * @return 无
+ */
+static void _json_container_begin(json_writer_t *w, char c)
+{
+    if(w->depth >= JSON_WRITER_MAX_DEPTH) {
+        w->error = true;
+        return;
+    }
+    _json_value_prefix(w);
+    _json_putc(w, c);
+    w->depth ++;
+    w->comma &= ~(1u << w->depth);
+}
+
+/**
+ * @brief  结束当前容器
+ * @param  w 写入器
+ * @param  c '}' 或 ']'
+ * @return 无
+ */
+static void _json_container_end(json_writer_t *w, char c)
+{
+    if(0 == w->depth || w->after_key) {
+        w->error = true;
+        return;
+    }
+    w->depth --;
+    _json_putc(w, c);
+}
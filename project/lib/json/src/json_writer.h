@@ -0,0 +1,72 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_WRITER_MAX_DEPTH           31              // 最大嵌套层数
+#define JSON_FLOAT_MAX_PREC             6               // 浮点数最多保留的小数位数
+#define JSON_NUM_BUF_LEN                32              // 单个数字格式化后的最大长度
+
+/**
+ * @brief   输出回调，缓冲区写满或结束时调用
+ * @param   ctx 用户参数
+ * @param   buf 待输出的数据
+ * @param   len 数据长度
+ * @return  是否输出成功，失败后写入器进入错误状态
+ */
+typedef bool (*json_flush_t)(void *ctx, const char *buf, size_t len);
+
+/**
+ * @brief   流式 JSON 写入器
+ * @note    直接把文本写入调用者提供的缓冲区(栈或静态区)，写满时通过 flush 回调
+ *          输出并复用缓冲区，整个过程不申请堆内存；flush 为 NULL 时缓冲区写满即出错
+ */
+typedef struct json_writer{
+    char *buf;                      // 输出缓冲区
+    size_t size;                    // 缓冲区大小
+    size_t len;                     // 缓冲区中尚未输出的字节数
+    size_t flushed;                 // 已经通过回调输出的字节数
+    json_flush_t flush;             // 输出回调
+    void *ctx;                      // 回调的用户参数
+    uint32_t comma;                 // 按层记录：该层已有元素，下一个元素前需要逗号
+    uint8_t depth;                  // 当前嵌套层数
+    bool after_key;                 // 刚写完键名，下一个值不需要逗号
+    bool error;                     // 出错标志(缓冲区不足、回调失败、嵌套错误)
+}json_writer_t;
+
+/* public function protypes ------------------------------------------------- */
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_flush_t flush, void *ctx);
+bool json_writer_flush(json_writer_t *w);
+bool json_writer_ok(const json_writer_t *w);
+
+void json_object_begin(json_writer_t *w);
+void json_object_end(json_writer_t *w);
+void json_array_begin(json_writer_t *w);
+void json_array_end(json_writer_t *w);
+void json_key(json_writer_t *w, const char *key);
+
+void json_string(json_writer_t *w, const char *str);
+void json_int(json_writer_t *w, int32_t value);
+void json_uint(json_writer_t *w, uint32_t value);
+void json_float(json_writer_t *w, float value, uint8_t prec);
+void json_bool(json_writer_t *w, bool value);
+void json_null(json_writer_t *w);
+
+void json_kv_string(json_writer_t *w, const char *key, const char *str);
+void json_kv_int(json_writer_t *w, const char *key, int32_t value);
+void json_kv_uint(json_writer_t *w, const char *key, uint32_t value);
+void json_kv_float(json_writer_t *w, const char *key, float value, uint8_t prec);
+void json_kv_bool(json_writer_t *w, const char *key, bool value);
+
+size_t json_format_uint(char *buf, uint32_t value);
+size_t json_format_float(char *buf, float value, uint8_t prec);
+
+#endif /* __JSON_WRITER_H__ */
@@ -13,18 +13,26 @@
 
 static const char *TAG = "api_spiffs.c";
 
-void api_spiffs_init(void)
+/**
+ * @brief  挂载 SPIFFS
+ * @param  inconsistent 输出，分区信息不一致(已用 > 总大小)时为 true，需要检查
+ * @return ESP_OK - 成功，其他失败
+ * @note   不做 esp_spiffs_check()，整片扫描很慢，由调用者决定是否需要检查
+ */
+esp_err_t api_spiffs_mount(bool *inconsistent)
 {
     ESP_LOGI(TAG, "Initializing SPIFFS ......");
 
     esp_vfs_spiffs_conf_t conf = 
     {
-      .base_path = "/spiffs",
-      .partition_label = "spiffs",
+      .base_path = API_SPIFFS_BASE_PATH,
+      .partition_label = API_SPIFFS_LABEL,
       .max_files = 5,
       .format_if_mount_failed = true
     };
     
+    *inconsistent = false;
+
     // Use settings defined above to initialize and mount SPIFFS filesystem.
     // Note: esp_vfs_spiffs_register is an all-in-one convenience function.
     esp_err_t ret = esp_vfs_spiffs_register(&conf);
@@ -43,16 +51,7 @@ void api_spiffs_init(void)
         {
             ESP_LOGE(TAG, "Failed to initialize SPIFFS (%s)", esp_err_to_name(ret));
         }
-        return;
-    }
-
-    ESP_LOGI(TAG, "Performing SPIFFS_check() .....");
-    ret = esp_spiffs_check(conf.partition_label);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "SPIFFS_check() failed (%s)", esp_err_to_name(ret));
-        return;
-    } else {
-        ESP_LOGI(TAG, "SPIFFS_check() successful");
+        return ret;
     }
 
     size_t total = 0, used = 0;
@@ -60,8 +59,7 @@ void api_spiffs_init(void)
     if (ret != ESP_OK) 
     {
         ESP_LOGE(TAG, "Failed to get SPIFFS partition information (%s). Formatting...", esp_err_to_name(ret));
-        esp_spiffs_format(conf.partition_label);
-        return;
+        return esp_spiffs_format(conf.partition_label);
     } 
     else 
     {
@@ -70,17 +68,29 @@ void api_spiffs_init(void)
 
     // Check consistency of reported partition size info.
     if (used > total) {
-        ESP_LOGW(TAG, "Number of used bytes cannot be larger than total. Performing SPIFFS_check().");
-        ret = esp_spiffs_check(conf.partition_label);
-        // Could be also used to mend broken files, to clean unreferenced pages, etc.
-        // More info at https://github.com/pellepl/spiffs/wiki/FAQ#powerlosses-contd-when-should-i-run-spiffs_check
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "SPIFFS_check() failed (%s)", esp_err_to_name(ret));
-            return;
-        } else {
-            ESP_LOGI(TAG, "SPIFFS_check() successful");
-        }
+        ESP_LOGW(TAG, "Number of used bytes cannot be larger than total.");
+        *inconsistent = true;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief  检查并修复 SPIFFS
+ * @return ESP_OK - 成功，其他失败
+ * @note   扫描整个分区，耗时与分区大小成正比；检查期间其它文件操作等待
+ */
+esp_err_t api_spiffs_check(void)
+{
+    ESP_LOGI(TAG, "Performing SPIFFS_check() .....");
+    // Could be also used to mend broken files, to clean unreferenced pages, etc.
+    // More info at https://github.com/pellepl/spiffs/wiki/FAQ#powerlosses-contd-when-should-i-run-spiffs_check
+    esp_err_t ret = esp_spiffs_check(API_SPIFFS_LABEL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "SPIFFS_check() failed (%s)", esp_err_to_name(ret));
+    } else {
+        ESP_LOGI(TAG, "SPIFFS_check() successful");
     }
+    return ret;
 }
 
 bool spiffs_readfile(const char *path, uint16_t size, char *buffer)
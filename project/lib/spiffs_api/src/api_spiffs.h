@@ -2,9 +2,15 @@
 #define __API_SPIFFS_H__
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define API_SPIFFS_BASE_PATH    "/spiffs"
+#define API_SPIFFS_LABEL        "spiffs"
 
 /* public function protypes ------------------------------------------------- */
-void api_spiffs_init(void);
+esp_err_t api_spiffs_mount(bool *inconsistent);
+esp_err_t api_spiffs_check(void);
 bool spiffs_readfile(const char *path, uint16_t size, char *buffer);
 
-#endif /* __API_SPIFFS_H__ */
\ No newline at end of file
+#endif /* __API_SPIFFS_H__ */
@@ -0,0 +1,356 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "alarm_log.h"
+#include "persist.h"
+
+#define ALARM_LOG_MAGIC                 0x474F4C41u     // "ALOG"
+#define ALARM_LOG_READ_BATCH            32              // 倒序读取时每次读出的记录数
+
+/* private function protypes -------------------------------------------------*/
+static uint32_t _alarm_sector_addr(const alarm_log_t *log, uint32_t seq);
+static bool _alarm_head_read(const alarm_log_t *log, uint32_t sector, uint32_t *seq, uint32_t *clear_seq);
+static bool _alarm_sector_open(alarm_log_t *log, uint32_t seq);
+static bool _alarm_slot_empty(const uint8_t *buf);
+static uint8_t _alarm_check(const uint8_t *buf);
+static void _alarm_put_u32(uint8_t *buf, uint32_t value);
+static uint32_t _alarm_get_u32(const uint8_t *buf);
+
+/**
+ * @brief  挂载告警日志
+ * @param  log   日志
+ * @param  flash 闪存区域(大小至少 ALARM_LOG_MIN_SECTORS 个扇区)
+ * @return 是否成功
+ * @note   读取每个扇区头找到序号最大的扇区，再在其中二分查找第一个空槽位；
+ *         耗时与记录数无关。掉电时写了一半的记录占用槽位但校验不通过，读取时跳过
+ */
+bool alarm_log_mount(alarm_log_t *log, const alarm_flash_t *flash)
+{
+    uint8_t slot[ALARM_RECORD_LEN];
+    uint32_t i, seq, clear_seq, lo, hi, mid, base;
+    bool found = false;
+
+    memset(log, 0, sizeof(*log));
+    log->flash = flash;
+    log->sectors = flash->size / ALARM_LOG_SECTOR_SIZE;
+    if(log->sectors < ALARM_LOG_MIN_SECTORS) {
+        return false;
+    }
+
+    for(i = 0; i < log->sectors; i ++) {
+        if(_alarm_head_read(log, i, &seq, &clear_seq) && (!found || seq > log->head_seq)) {
+            log->head_seq = seq;
+            log->clear_seq = clear_seq;
+            found = true;
+        }
+    }
+
+    if(!found) {
+        /* 空白或无法识别的分区，从序号 0 开始 */
+        log->clear_seq = 0;
+        if(!_alarm_sector_open(log, 0)) {
+            return false;
+        }
+        log->mounted = true;
+        return true;
+    }
+
+    /* 已写入的槽位总是连续排在扇区开头 */
+    base = _alarm_sector_addr(log, log->head_seq) + ALARM_LOG_HEAD_LEN;
+    lo = 0;
+    hi = ALARM_LOG_PER_SECTOR;
+    while(lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if(!flash->read(flash->ctx, base + mid * ALARM_RECORD_LEN, slot, sizeof(slot))) {
+            return false;
+        }
+        if(_alarm_slot_empty(slot)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    log->head_fill = lo;
+    log->mounted = true;
+    return true;
+}
+
+/**
+ * @brief  追加一条记录
+ * @param  log   日志
+ * @param  rec   记录
+ * @param  index 输出记录编号，可以为 NULL
+ * @return 是否成功
+ * @note   当前扇区写满时擦除最旧的扇区作为新扇区(一次扇区擦除)，其余情况只写 8 字节
+ */
+bool alarm_log_append(alarm_log_t *log, const alarm_record_t *rec, uint32_t *index)
+{
+    uint8_t buf[ALARM_RECORD_LEN];
+    uint32_t addr;
+
+    if(!log->mounted) {
+        return false;
+    }
+    if(log->head_fill >= ALARM_LOG_PER_SECTOR && !_alarm_sector_open(log, log->head_seq + 1)) {
+        return false;
+    }
+
+    _alarm_put_u32(buf, rec->time);
+    buf[4] = (uint8_t)rec->code;
+    buf[5] = (uint8_t)(rec->code >> 8);
+    buf[6] = rec->flags;
+    buf[7] = _alarm_check(buf);
+
+    addr = _alarm_sector_addr(log, log->head_seq) + ALARM_LOG_HEAD_LEN + log->head_fill * ALARM_RECORD_LEN;
+    if(NULL != index) {
+        *index = log->head_seq * ALARM_LOG_PER_SECTOR + log->head_fill;
+    }
+    /* 写失败的槽位也可能已被部分写入，不再复用 */
+    log->head_fill ++;
+    return log->flash->write(log->flash->ctx, addr, buf, sizeof(buf));
+}
+
+/**
+ * @brief  清空日志
+ * @param  log 日志
+ * @return 是否成功
+ * @note   切换到一个新扇区并在扇区头记录清空点，之前的记录全部不可见；只擦除一个扇区
+ */
+bool alarm_log_clear(alarm_log_t *log)
+{
+    uint32_t clear_seq = log->clear_seq;
+
+    if(!log->mounted) {
+        return false;
+    }
+    log->clear_seq = log->head_seq + 1;
+    if(!_alarm_sector_open(log, log->head_seq + 1)) {
+        log->clear_seq = clear_seq;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief  获取下一条记录的编号(即最新记录编号 + 1)
+ * @param  log 日志
+ * @return 编号
+ */
+uint32_t alarm_log_end(const alarm_log_t *log)
+{
+    return log->head_seq * ALARM_LOG_PER_SECTOR + log->head_fill;
+}
+
+/**
+ * @brief  获取最旧的可见记录编号
+ * @param  log 日志
+ * @return 编号，等于 alarm_log_end 时日志为空
+ */
+uint32_t alarm_log_begin(const alarm_log_t *log)
+{
+    uint32_t seq = 0;
+
+    if(log->head_seq + 1 > log->sectors) {
+        seq = log->head_seq + 1 - log->sectors;
+    }
+    if(log->clear_seq > seq) {
+        seq = log->clear_seq;
+    }
+    return seq * ALARM_LOG_PER_SECTOR;
+}
+
+/**
+ * @brief  从新到旧读取一页记录
+ * @param  log    日志
+ * @param  before 只读取编号小于该值的记录(分页游标，从 alarm_log_end 开始)
+ * @param  since  只读取编号不小于该值的记录(0 表示不限)
+ * @param  recs   输出记录
+ * @param  index  输出记录编号，可以为 NULL
+ * @param  max    最多读取的条数
+ * @param  next   输出下一页的 before 游标，没有更多记录时为 0
+ * @return 读到的条数
+ * @note   按扇区成批倒序读取，只读需要的部分，不把整个日志载入内存；校验不通过的记录被跳过
+ */
+size_t alarm_log_read_back(alarm_log_t *log, uint32_t before, uint32_t since,
+                           alarm_record_t *recs, uint32_t *index, size_t max, uint32_t *next)
+{
+    uint8_t buf[ALARM_LOG_READ_BATCH * ALARM_RECORD_LEN];
+    const uint8_t *p;
+    uint32_t lower = alarm_log_begin(log);
+    uint32_t cur = alarm_log_end(log);
+    uint32_t seq, head_seq, clear_seq, slot, count, i;
+    size_t n = 0;
+
+    if(before < cur) {
+        cur = before;
+    }
+    if(since > lower) {
+        lower = since;
+    }
+
+    while(cur > lower && n < max) {
+        seq = (cur - 1) / ALARM_LOG_PER_SECTOR;
+        slot = (cur - 1) % ALARM_LOG_PER_SECTOR;
+
+        /* 扇区头不符(如挂载后被擦除又掉电)时跳过整个扇区 */
+        if(!_alarm_head_read(log, seq % log->sectors, &head_seq, &clear_seq) || head_seq != seq) {
+            cur = seq * ALARM_LOG_PER_SECTOR;
+            continue;
+        }
+
+        count = slot + 1;
+        if(count > ALARM_LOG_READ_BATCH) {
+            count = ALARM_LOG_READ_BATCH;
+        }
+        if(cur - count < lower) {
+            count = cur - lower;
+        }
+        if(!log->flash->read(log->flash->ctx,
+                             _alarm_sector_addr(log, seq) + ALARM_LOG_HEAD_LEN + (slot + 1 - count) * ALARM_RECORD_LEN,
+                             buf, count * ALARM_RECORD_LEN)) {
+            break;
+        }
+
+        for(i = count; i > 0 && n < max; i --) {
+            p = buf + (i - 1) * ALARM_RECORD_LEN;
+            cur --;
+            if(_alarm_slot_empty(p) || p[7] != _alarm_check(p)) {
+                continue;
+            }
+            recs[n].time = _alarm_get_u32(p);
+            recs[n].code = (uint16_t)(p[4] | (p[5] << 8));
+            recs[n].flags = p[6];
+            if(NULL != index) {
+                index[n] = cur;
+            }
+            n ++;
+        }
+    }
+
+    if(NULL != next) {
+        *next = (cur > lower) ? cur : 0;
+    }
+    return n;
+}
+
+/**
+ * @brief  扇区序号对应的物理地址
+ * @param  log 日志
+ * @param  seq 扇区序号
+ * @return 扇区起始地址
+ */
+static uint32_t _alarm_sector_addr(const alarm_log_t *log, uint32_t seq)
+{
+    return (seq % log->sectors) * ALARM_LOG_SECTOR_SIZE;
+}
+
+/**
+ * @brief  读取并校验扇区头
+ * @param  log       日志
+ * @param  sector    物理扇区号
+ * @param  seq       输出扇区序号
+ * @param  clear_seq 输出清空点
+ * @return 扇区头是否有效(魔数、CRC 正确且序号与物理位置一致)
+ */
+static bool _alarm_head_read(const alarm_log_t *log, uint32_t sector, uint32_t *seq, uint32_t *clear_seq)
+{
+    uint8_t head[ALARM_LOG_HEAD_LEN];
+
+    if(!log->flash->read(log->flash->ctx, sector * ALARM_LOG_SECTOR_SIZE, head, sizeof(head))) {
+        return false;
+    }
+    if(ALARM_LOG_MAGIC != _alarm_get_u32(head) ||
+       _alarm_get_u32(head + 12) != persist_crc32(0, head, 12)) {
+        return false;
+    }
+    *seq = _alarm_get_u32(head + 4);
+    *clear_seq = _alarm_get_u32(head + 8);
+    return (*seq % log->sectors) == sector;
+}
+
+/**
+ * @brief  擦除并启用一个新扇区
+ * @param  log 日志
+ * @param  seq 新扇区的序号
+ * @return 是否成功
+ * @note   擦除后掉电时新扇区头无效，重新挂载仍以上一个扇区为当前扇区
+ */
+static bool _alarm_sector_open(alarm_log_t *log, uint32_t seq)
+{
+    uint8_t head[ALARM_LOG_HEAD_LEN];
+    uint32_t addr = _alarm_sector_addr(log, seq);
+
+    _alarm_put_u32(head, ALARM_LOG_MAGIC);
+    _alarm_put_u32(head + 4, seq);
+    _alarm_put_u32(head + 8, log->clear_seq);
+    _alarm_put_u32(head + 12, persist_crc32(0, head, 12));
+
+    if(!log->flash->erase(log->flash->ctx, addr) ||
+       !log->flash->write(log->flash->ctx, addr, head, sizeof(head))) {
+        return false;
+    }
+    log->head_seq = seq;
+    log->head_fill = 0;
+    return true;
+}
+
+/**
+ * @brief  判断槽位是否未写入(全为 0xFF)
+ * @param  buf 槽位数据
+ * @return 是否为空
+ */
+static bool _alarm_slot_empty(const uint8_t *buf)
+{
+    uint8_t i;
+
+    for(i = 0; i < ALARM_RECORD_LEN; i ++) {
+        if(0xFF != buf[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief  计算记录的校验字节
+ * @param  buf 记录数据(前 7 字节)
+ * @return 校验字节，合法记录不会全为 0xFF
+ */
+static uint8_t _alarm_check(const uint8_t *buf)
+{
+    uint8_t x = 0;
+    uint8_t i;
+
+    for(i = 0; i < ALARM_RECORD_LEN - 1; i ++) {
+        x = (uint8_t)((x << 1) | (x >> 7)) ^ buf[i];
+    }
+    return (uint8_t)~x;
+}
+
+/**
+ * @brief  写入小端32位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+static void _alarm_put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief  读取小端32位无符号数
+ * @param  buf 数据地址
+ * @return 数值
+ */
+static uint32_t _alarm_get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
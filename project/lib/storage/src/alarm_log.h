@@ -0,0 +1,73 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __ALARM_LOG_H__
+#define __ALARM_LOG_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ALARM_LOG_SECTOR_SIZE           4096            // 擦除单位
+#define ALARM_LOG_HEAD_LEN              16              // 扇区头: 魔数4 + 序号4 + 清空序号4 + CRC32 4
+#define ALARM_RECORD_LEN                8               // 时间4 + 告警码2 + 标志1 + 校验1
+#define ALARM_LOG_PER_SECTOR            ((ALARM_LOG_SECTOR_SIZE - ALARM_LOG_HEAD_LEN) / ALARM_RECORD_LEN)
+#define ALARM_LOG_MIN_SECTORS           2               // 至少两个扇区(切换扇区时擦除最旧的一个)
+
+/* 告警码 */
+#define ALARM_CODE_COVER_OPEN           0x0001          // 箱盖异常打开
+#define ALARM_CODE_COVER_CLOSED         0x0002          // 箱盖恢复关闭
+
+/* 告警标志 */
+#define ALARM_FLAG_HANDLED              0x01            // 已处理
+
+/**
+ * @brief   告警记录
+ */
+typedef struct alarm_record{
+    uint32_t time;                  // 发生时间，Unix 时间戳(秒)
+    uint16_t code;                  // 告警码 ALARM_CODE_xxx
+    uint8_t flags;                  // ALARM_FLAG_xxx
+}alarm_record_t;
+
+/**
+ * @brief   日志所在的闪存区域(目标板上为一个数据分区)
+ * @note    地址相对于区域起点；erase 每次擦除一个扇区
+ */
+typedef struct alarm_flash{
+    bool (*read)(void *ctx, uint32_t addr, void *buf, size_t len);
+    bool (*write)(void *ctx, uint32_t addr, const void *buf, size_t len);
+    bool (*erase)(void *ctx, uint32_t addr);
+    void *ctx;
+    uint32_t size;                  // 区域大小
+}alarm_flash_t;
+
+/**
+ * @brief   只追加的循环告警日志
+ * @note    每条记录有一个全局递增的编号 = 扇区序号 * ALARM_LOG_PER_SECTOR + 扇区内下标，
+ *          扇区序号 seq 总是写在物理扇区 seq % sectors 上，编号可以直接换算为闪存地址。
+ *          写满后擦除最旧的扇区继续写；清空只是切换到新扇区并在扇区头记下清空点，
+ *          不需要擦除整个分区。挂载只读各扇区头并在最新扇区内二分查找写入位置
+ */
+typedef struct alarm_log{
+    const alarm_flash_t *flash;     // 闪存区域
+    uint32_t sectors;               // 扇区数
+    uint32_t head_seq;              // 当前写入扇区的序号
+    uint32_t clear_seq;             // 序号小于该值的扇区已被清空
+    uint32_t head_fill;             // 当前扇区已写入的记录数
+    bool mounted;
+}alarm_log_t;
+
+/* public function protypes ------------------------------------------------- */
+bool alarm_log_mount(alarm_log_t *log, const alarm_flash_t *flash);
+bool alarm_log_append(alarm_log_t *log, const alarm_record_t *rec, uint32_t *index);
+bool alarm_log_clear(alarm_log_t *log);
+uint32_t alarm_log_end(const alarm_log_t *log);
+uint32_t alarm_log_begin(const alarm_log_t *log);
+size_t alarm_log_read_back(alarm_log_t *log, uint32_t before, uint32_t since,
+                           alarm_record_t *recs, uint32_t *index, size_t max, uint32_t *next);
+
+#endif /* __ALARM_LOG_H__ */
@@ -0,0 +1,377 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdio.h>
+#include <string.h>
+#include "persist.h"
+
+/* 组帧/解帧缓冲区，persist 的接口只在一个任务中调用 */
+static uint8_t s_blob_buf[PERSIST_BLOB_HEAD_LEN + PERSIST_BLOB_MAX_LEN];
+static persist_stats_t s_stats;
+
+/* private function protypes -------------------------------------------------*/
+static void _persist_card_key(char *key, uint32_t page);
+static void _persist_put_u16(uint8_t *buf, uint16_t value);
+static void _persist_put_u32(uint8_t *buf, uint32_t value);
+static uint16_t _persist_get_u16(const uint8_t *buf);
+static uint32_t _persist_get_u32(const uint8_t *buf);
+static bool _persist_card_page_write(persist_cards_t *pc, const persist_backend_t *be, uint32_t page);
+static int32_t _persist_free_slot(const persist_cards_t *pc);
+
+/**
+ * @brief  计算 CRC-32(IEEE 802.3，反射，初值/结果异或 0xFFFFFFFF)
+ * @param  crc 上一段的结果，首段传 0
+ * @param  buf 数据
+ * @param  len 数据长度
+ * @return CRC
+ * @note   半字节查表，16 项表只占 64 字节
+ */
+uint32_t persist_crc32(uint32_t crc, const void *buf, size_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t *p = (const uint8_t *)buf;
+    size_t i;
+
+    crc = ~crc;
+    for(i = 0; i < len; i ++) {
+        crc = table[(crc ^ p[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (p[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief  读取并校验一个 blob
+ * @param  be      存储后端
+ * @param  key     键名
+ * @param  version 期望的格式版本
+ * @param  buf     数据输出缓冲区
+ * @param  size    缓冲区大小
+ * @param  len     输出数据长度，可以为 NULL
+ * @return 读取结果，只有 PERSIST_OK 时 buf 有效
+ */
+persist_status_t persist_blob_read(const persist_backend_t *be, const char *key, uint8_t version,
+                                   void *buf, size_t size, size_t *len)
+{
+    int ret;
+    uint16_t data_len;
+
+    ret = be->read(be->ctx, key, s_blob_buf, sizeof(s_blob_buf));
+    if(-1 == ret) {
+        return PERSIST_ERR_NOT_FOUND;
+    }
+    if(ret < 0) {
+        return PERSIST_ERR_IO;
+    }
+
+    data_len = _persist_get_u16(s_blob_buf + 4);
+    if(ret < PERSIST_BLOB_HEAD_LEN || PERSIST_BLOB_MAGIC != _persist_get_u16(s_blob_buf) ||
+       (size_t)ret != (size_t)PERSIST_BLOB_HEAD_LEN + data_len ||
+       _persist_get_u32(s_blob_buf + 6) != persist_crc32(0, s_blob_buf + PERSIST_BLOB_HEAD_LEN, data_len)) {
+        s_stats.corrupt ++;
+        return PERSIST_ERR_CORRUPT;
+    }
+    if(version != s_blob_buf[2] || data_len > size) {
+        return PERSIST_ERR_VERSION;
+    }
+
+    memcpy(buf, s_blob_buf + PERSIST_BLOB_HEAD_LEN, data_len);
+    if(NULL != len) {
+        *len = data_len;
+    }
+    return PERSIST_OK;
+}
+
+/**
+ * @brief  写入一个 blob(加上魔数、版本、长度和 CRC)
+ * @param  be      存储后端
+ * @param  key     键名
+ * @param  version 格式版本
+ * @param  buf     数据
+ * @param  len     数据长度，不超过 PERSIST_BLOB_MAX_LEN
+ * @return 写入结果
+ * @note   只写入后端的缓存，需要调用 persist_commit 落盘
+ */
+persist_status_t persist_blob_write(const persist_backend_t *be, const char *key, uint8_t version,
+                                    const void *buf, size_t len)
+{
+    if(len > PERSIST_BLOB_MAX_LEN) {
+        return PERSIST_ERR_IO;
+    }
+
+    _persist_put_u16(s_blob_buf, PERSIST_BLOB_MAGIC);
+    s_blob_buf[2] = version;
+    s_blob_buf[3] = 0;
+    _persist_put_u16(s_blob_buf + 4, (uint16_t)len);
+    _persist_put_u32(s_blob_buf + 6, persist_crc32(0, buf, len));
+    memcpy(s_blob_buf + PERSIST_BLOB_HEAD_LEN, buf, len);
+
+    if(!be->write(be->ctx, key, s_blob_buf, PERSIST_BLOB_HEAD_LEN + len)) {
+        return PERSIST_ERR_IO;
+    }
+    s_stats.blob_writes ++;
+    s_stats.bytes_written += PERSIST_BLOB_HEAD_LEN + len;
+    return PERSIST_OK;
+}
+
+/**
+ * @brief  提交之前写入的所有 blob
+ * @param  be 存储后端
+ * @return 是否成功
+ */
+bool persist_commit(const persist_backend_t *be)
+{
+    if(!be->commit(be->ctx)) {
+        return false;
+    }
+    s_stats.commits ++;
+    return true;
+}
+
+/**
+ * @brief  启动时载入卡片表
+ * @param  pc    持久化镜像(静态分配，初始为全 0)
+ * @param  be    存储后端
+ * @param  store 授权卡表，载入后按卡号排序
+ * @return 载入的卡片数
+ * @note   每页只读一次；损坏或版本不符的页被丢弃(并标记为待重写)，不影响其他页。
+ *         必须在读者开始查找之前调用
+ */
+uint32_t persist_cards_load(persist_cards_t *pc, const persist_backend_t *be, card_store_t *store)
+{
+    uint8_t page_buf[PERSIST_CARD_PAGE_LEN];
+    const uint8_t *p;
+    card_entry_t *slot;
+    persist_status_t ret;
+    char key[PERSIST_KEY_LEN + 1];
+    uint32_t page, i;
+    size_t len;
+
+    memset(pc, 0, sizeof(*pc));
+    store->count = 0;
+
+    for(page = 0; page < PERSIST_CARD_PAGES; page ++) {
+        _persist_card_key(key, page);
+        ret = persist_blob_read(be, key, PERSIST_CARDS_VERSION, page_buf, sizeof(page_buf), &len);
+        if(PERSIST_ERR_NOT_FOUND == ret) {
+            continue;
+        }
+        if(PERSIST_OK != ret || PERSIST_CARD_PAGE_LEN != len) {
+            pc->dirty |= 1u << page;
+            continue;
+        }
+
+        pc->used[page] = (uint64_t)_persist_get_u32(page_buf) | ((uint64_t)_persist_get_u32(page_buf + 4) << 32);
+        for(i = 0; i < PERSIST_CARDS_PER_PAGE; i ++) {
+            if(!(pc->used[page] & (1ull << i))) {
+                continue;
+            }
+            p = page_buf + 8 + i * PERSIST_CARD_WIRE_LEN;
+            slot = &pc->slots[page * PERSIST_CARDS_PER_PAGE + i];
+            slot->id = _persist_get_u32(p);
+            slot->expire_day = _persist_get_u16(p + 4);
+            slot->flags = _persist_get_u16(p + 6);
+            if(store->count < CARD_STORE_CAPACITY) {
+                store->cards[store->count ++] = *slot;
+            }
+        }
+    }
+
+    card_store_sort(store);
+    return store->count;
+}
+
+/**
+ * @brief  把授权卡表同步到闪存
+ * @param  pc    持久化镜像
+ * @param  be    存储后端
+ * @param  store 授权卡表
+ * @return 写入的页数
+ * @note   1. 镜像中已有的卡: 已删除则释放槽位，内容变化则更新槽位
+ *         2. 表中新增的卡: 放入第一个空闲槽位
+ *         3. 只重写槽位有变化的页；写入失败的页保持待写入，下次同步重试。
+ *         必须在修改授权卡表的任务中调用，调用后仍需 persist_commit
+ */
+uint32_t persist_cards_sync(persist_cards_t *pc, const persist_backend_t *be, const card_store_t *store)
+{
+    card_entry_t *slot;
+    uint32_t page, i, s, written = 0;
+    int32_t pos;
+
+    memset(pc->seen, 0, sizeof(pc->seen));
+
+    for(s = 0; s < PERSIST_CARD_PAGES * PERSIST_CARDS_PER_PAGE; s ++) {
+        page = s / PERSIST_CARDS_PER_PAGE;
+        if(!(pc->used[page] & (1ull << (s % PERSIST_CARDS_PER_PAGE)))) {
+            continue;
+        }
+        slot = &pc->slots[s];
+        pos = card_store_index(store, slot->id);
+        if(pos < 0) {
+            pc->used[page] &= ~(1ull << (s % PERSIST_CARDS_PER_PAGE));
+            pc->dirty |= 1u << page;
+            continue;
+        }
+        if(pc->seen[pos / 32] & (1u << (pos % 32))) {
+            /* 同一卡号占了两个槽位(只可能来自损坏的数据)，释放后一个 */
+            pc->used[page] &= ~(1ull << (s % PERSIST_CARDS_PER_PAGE));
+            pc->dirty |= 1u << page;
+            continue;
+        }
+        pc->seen[pos / 32] |= 1u << (pos % 32);
+        if(slot->expire_day != store->cards[pos].expire_day || slot->flags != store->cards[pos].flags) {
+            *slot = store->cards[pos];
+            pc->dirty |= 1u << page;
+        }
+    }
+
+    for(i = 0; i < store->count; i ++) {
+        if(pc->seen[i / 32] & (1u << (i % 32))) {
+            continue;
+        }
+        pos = _persist_free_slot(pc);
+        if(pos < 0) {
+            break;
+        }
+        page = (uint32_t)pos / PERSIST_CARDS_PER_PAGE;
+        pc->slots[pos] = store->cards[i];
+        pc->used[page] |= 1ull << (pos % PERSIST_CARDS_PER_PAGE);
+        pc->dirty |= 1u << page;
+    }
+
+    for(page = 0; page < PERSIST_CARD_PAGES; page ++) {
+        if((pc->dirty & (1u << page)) && _persist_card_page_write(pc, be, page)) {
+            pc->dirty &= ~(1u << page);
+            written ++;
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief  获取读写统计
+ * @param  stats 输出
+ * @return 无
+ */
+void persist_stats_get(persist_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+/**
+ * @brief  编码并写入一页卡片
+ * @param  pc   持久化镜像
+ * @param  be   存储后端
+ * @param  page 页号
+ * @return 是否成功
+ */
+static bool _persist_card_page_write(persist_cards_t *pc, const persist_backend_t *be, uint32_t page)
+{
+    uint8_t page_buf[PERSIST_CARD_PAGE_LEN];
+    const card_entry_t *slot;
+    char key[PERSIST_KEY_LEN + 1];
+    uint8_t *p;
+    uint32_t i;
+
+    memset(page_buf, 0, sizeof(page_buf));
+    _persist_put_u32(page_buf, (uint32_t)pc->used[page]);
+    _persist_put_u32(page_buf + 4, (uint32_t)(pc->used[page] >> 32));
+    for(i = 0; i < PERSIST_CARDS_PER_PAGE; i ++) {
+        if(!(pc->used[page] & (1ull << i))) {
+            continue;
+        }
+        slot = &pc->slots[page * PERSIST_CARDS_PER_PAGE + i];
+        p = page_buf + 8 + i * PERSIST_CARD_WIRE_LEN;
+        _persist_put_u32(p, slot->id);
+        _persist_put_u16(p + 4, slot->expire_day);
+        _persist_put_u16(p + 6, slot->flags);
+    }
+
+    _persist_card_key(key, page);
+    return PERSIST_OK == persist_blob_write(be, key, PERSIST_CARDS_VERSION, page_buf, sizeof(page_buf));
+}
+
+/**
+ * @brief  查找第一个空闲槽位
+ * @param  pc 持久化镜像
+ * @return 槽位号，没有空闲槽位时返回 -1
+ */
+static int32_t _persist_free_slot(const persist_cards_t *pc)
+{
+    uint32_t page, i;
+
+    for(page = 0; page < PERSIST_CARD_PAGES; page ++) {
+        if(UINT64_MAX == pc->used[page]) {
+            continue;
+        }
+        for(i = 0; i < PERSIST_CARDS_PER_PAGE; i ++) {
+            if(!(pc->used[page] & (1ull << i))) {
+                return (int32_t)(page * PERSIST_CARDS_PER_PAGE + i);
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief  卡片页的键名
+ * @param  key  输出，至少 PERSIST_KEY_LEN + 1 字节
+ * @param  page 页号
+ * @return 无
+ */
+static void _persist_card_key(char *key, uint32_t page)
+{
+    snprintf(key, PERSIST_KEY_LEN + 1, "cards%02u", (unsigned)page);
+}
+
+/**
+ * @brief  写入小端16位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+static void _persist_put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief  写入小端32位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+static void _persist_put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief  读取小端16位无符号数
+ * @param  buf 数据地址
+ * @return 数值
+ */
+static uint16_t _persist_get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+/**
+ * @brief  读取小端32位无符号数
+ * @param  buf 数据地址
+ * @return 数值
+ */
+static uint32_t _persist_get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
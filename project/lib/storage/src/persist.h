@@ -0,0 +1,87 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __PERSIST_H__
+#define __PERSIST_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "card_store.h"
+
+#define PERSIST_BLOB_MAGIC              0x5042          // "PB"
+#define PERSIST_BLOB_HEAD_LEN           10              // 魔数2 + 版本1 + 保留1 + 长度2 + CRC32 4(小端)
+#define PERSIST_BLOB_MAX_LEN            600             // 单个 blob 数据的最大长度(不含头部)
+#define PERSIST_KEY_LEN                 15              // 键名最大长度(与 NVS 一致)
+
+#define PERSIST_CARDS_VERSION           1               // 卡片分页的格式版本
+#define PERSIST_CARDS_PER_PAGE          64              // 每页卡片数，一页对应一个 blob
+#define PERSIST_CARD_PAGES              ((CARD_STORE_CAPACITY + PERSIST_CARDS_PER_PAGE - 1) / PERSIST_CARDS_PER_PAGE)
+#define PERSIST_CARD_WIRE_LEN           8               // 卡号4 + 有效期2 + 标志2(小端)
+#define PERSIST_CARD_PAGE_LEN           (8 + PERSIST_CARDS_PER_PAGE * PERSIST_CARD_WIRE_LEN)  // 占用位图8 + 卡片
+
+/**
+ * @brief   读写结果
+ */
+typedef enum{
+    PERSIST_OK = 0,
+    PERSIST_ERR_NOT_FOUND,          // 没有该键(首次启动)
+    PERSIST_ERR_CORRUPT,            // 魔数/长度/CRC 不符
+    PERSIST_ERR_VERSION,            // 格式版本不符
+    PERSIST_ERR_IO,                 // 后端读写失败
+}persist_status_t;
+
+/**
+ * @brief   存储后端(目标板上为 NVS)
+ * @note    read 返回实际长度，键不存在返回 -1，其他错误返回 -2；
+ *          write 只写入缓存，commit 后才保证落盘
+ */
+typedef struct persist_backend{
+    int (*read)(void *ctx, const char *key, void *buf, size_t size);
+    bool (*write)(void *ctx, const char *key, const void *buf, size_t len);
+    bool (*commit)(void *ctx);
+    void *ctx;
+}persist_backend_t;
+
+/**
+ * @brief   读写统计，用于评估闪存磨损
+ */
+typedef struct persist_stats{
+    uint32_t blob_writes;           // 写入的 blob 数
+    uint32_t bytes_written;         // 写入的字节数(含头部)
+    uint32_t commits;               // 提交次数
+    uint32_t corrupt;               // 载入时发现损坏的 blob 数
+}persist_stats_t;
+
+/**
+ * @brief   卡片表的持久化镜像
+ * @note    闪存中每张卡占一个固定槽位，槽位按页存储；内存中的授权卡表按卡号排序，
+ *          两者在同步时按卡号比对，只有内容变化的页会被重写，增删一张卡只写一页
+ */
+typedef struct persist_cards{
+    card_entry_t slots[PERSIST_CARD_PAGES * PERSIST_CARDS_PER_PAGE];
+    uint64_t used[PERSIST_CARD_PAGES];              // 每页的槽位占用位图
+    uint32_t dirty;                                 // 待写入的页位图
+    uint32_t seen[(CARD_STORE_CAPACITY + 31) / 32]; // 同步时标记授权卡表中已有槽位的卡
+}persist_cards_t;
+
+_Static_assert(PERSIST_CARD_PAGES <= 32, "persist_cards_t.dirty holds at most 32 pages");
+_Static_assert(PERSIST_CARD_PAGE_LEN <= PERSIST_BLOB_MAX_LEN, "card page does not fit in one blob");
+
+/* public function protypes ------------------------------------------------- */
+uint32_t persist_crc32(uint32_t crc, const void *buf, size_t len);
+persist_status_t persist_blob_read(const persist_backend_t *be, const char *key, uint8_t version,
+                                   void *buf, size_t size, size_t *len);
+persist_status_t persist_blob_write(const persist_backend_t *be, const char *key, uint8_t version,
+                                    const void *buf, size_t len);
+bool persist_commit(const persist_backend_t *be);
+
+uint32_t persist_cards_load(persist_cards_t *pc, const persist_backend_t *be, card_store_t *store);
+uint32_t persist_cards_sync(persist_cards_t *pc, const persist_backend_t *be, const card_store_t *store);
+
+void persist_stats_get(persist_stats_t *stats);
+
+#endif /* __PERSIST_H__ */
@@ -0,0 +1,246 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "history.h"
+
+/* 各级分辨率的周期和点数 */
+static const uint32_t s_tier_period[HISTORY_TIERS] = {
+    HISTORY_TIER0_PERIOD, HISTORY_TIER1_PERIOD, HISTORY_TIER2_PERIOD,
+};
+static const uint32_t s_tier_slots[HISTORY_TIERS] = {
+    HISTORY_TIER0_SLOTS, HISTORY_TIER1_SLOTS, HISTORY_TIER2_SLOTS,
+};
+
+/* private function protypes -------------------------------------------------*/
+static void _history_acc_reset(history_acc_t *acc);
+static void _history_point_empty(history_point_t *p);
+static void _history_tier_close(history_tier_t *t, uint32_t bucket);
+
+/**
+ * @brief  初始化遥测历史
+ * @param  h 历史
+ * @return 无
+ */
+void history_init(history_t *h)
+{
+    history_point_t *points = h->points;
+    uint8_t i;
+
+    memset(h, 0, sizeof(*h));
+    for(i = 0; i < HISTORY_TIERS; i ++) {
+        h->tiers[i].period = s_tier_period[i];
+        h->tiers[i].slots = s_tier_slots[i];
+        h->tiers[i].points = points;
+        _history_acc_reset(&h->tiers[i].acc);
+        points += s_tier_slots[i];
+    }
+}
+
+/**
+ * @brief  把物理量量化为 16 位整数
+ * @param  value 物理量
+ * @param  scale 放大倍数(如 10 表示保留 1 位小数)
+ * @return 四舍五入后的量化值，超出范围时取边界
+ */
+int16_t history_quantize(float value, uint16_t scale)
+{
+    float q = value * scale;
+
+    if(q >= HISTORY_VALUE_MAX) {
+        return HISTORY_VALUE_MAX;
+    }
+    if(q <= -HISTORY_VALUE_MAX) {
+        return -HISTORY_VALUE_MAX;
+    }
+    return (int16_t)(q < 0 ? q - 0.5f : q + 0.5f);
+}
+
+/**
+ * @brief  插入一个采样
+ * @param  h 历史
+ * @param  time 采样时间(秒，单调递增)
+ * @param  value 各通道的量化值
+ * @return 是否插入(时间倒退的采样被丢弃)
+ * @note   同一秒内的多个采样合并到同一个点；没有采样的时间段记为 HISTORY_EMPTY
+ */
+bool history_add(history_t *h, uint32_t time, const int16_t value[HISTORY_CHANNELS])
+{
+    history_tier_t *t;
+    uint32_t bucket;
+    uint8_t i, c;
+
+    if(!h->started) {
+        for(i = 0; i < HISTORY_TIERS; i ++) {
+            t = &h->tiers[i];
+            t->first = time / t->period;
+            t->end = t->first;
+            t->acc_bucket = t->first;
+        }
+        h->started = true;
+    } else if(time / h->tiers[0].period < h->tiers[0].acc_bucket) {
+        return false;
+    }
+
+    for(i = 0; i < HISTORY_TIERS; i ++) {
+        t = &h->tiers[i];
+        bucket = time / t->period;
+        if(bucket != t->acc_bucket) {
+            _history_tier_close(t, bucket);
+        }
+        for(c = 0; c < HISTORY_CHANNELS; c ++) {
+            t->acc.sum[c] += value[c];
+            if(value[c] < t->acc.min[c]) {
+                t->acc.min[c] = value[c];
+            }
+            if(value[c] > t->acc.max[c]) {
+                t->acc.max[c] = value[c];
+            }
+        }
+        t->acc.count ++;
+    }
+    return true;
+}
+
+/**
+ * @brief  按周期查找分辨率
+ * @param  period 周期(秒)
+ * @return 级别，没有该周期时返回 -1
+ */
+int history_tier_find(uint32_t period)
+{
+    int i;
+
+    for(i = 0; i < HISTORY_TIERS; i ++) {
+        if(s_tier_period[i] == period) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief  获取某一级中可查询的时间段编号范围
+ * @param  h 历史
+ * @param  tier 级别
+ * @param  from 起始时间(秒)，更早的时间段不返回
+ * @param  first 输出第一个时间段的编号
+ * @param  end 输出最后一个时间段的编号 + 1，等于 first 时没有数据
+ * @return 无
+ */
+void history_range(const history_t *h, uint8_t tier, uint32_t from, uint32_t *first, uint32_t *end)
+{
+    const history_tier_t *t = &h->tiers[tier];
+    uint32_t lo = t->first;
+
+    if(t->end - lo > t->slots) {
+        lo = t->end - t->slots;
+    }
+    if(from / t->period > lo) {
+        lo = from / t->period;
+    }
+    *first = lo < t->end ? lo : t->end;
+    *end = t->end;
+}
+
+/**
+ * @brief  读取连续的时间段
+ * @param  h 历史
+ * @param  tier 级别
+ * @param  bucket 第一个时间段的编号
+ * @param  points 输出
+ * @param  n 个数
+ * @return 无
+ * @note   已被覆盖或尚未结束的时间段输出为 HISTORY_EMPTY，因此分批读取时点数固定
+ */
+void history_read(const history_t *h, uint8_t tier, uint32_t bucket, history_point_t *points, uint32_t n)
+{
+    const history_tier_t *t = &h->tiers[tier];
+    uint32_t i, b;
+
+    for(i = 0; i < n; i ++) {
+        b = bucket + i;
+        if(b >= t->end || t->end - b > t->slots || b < t->first) {
+            _history_point_empty(&points[i]);
+        } else {
+            points[i] = t->points[b % t->slots];
+        }
+    }
+}
+
+/**
+ * @brief  结束当前时间段并切换到新时间段
+ * @param  t 分辨率
+ * @param  bucket 新时间段的编号
+ * @return 无
+ * @note   中间没有采样的时间段(最多 slots 个)被标记为空
+ */
+static void _history_tier_close(history_tier_t *t, uint32_t bucket)
+{
+    history_point_t *p = &t->points[t->acc_bucket % t->slots];
+    uint32_t b;
+    uint8_t c;
+
+    if(t->acc.count == 0) {
+        _history_point_empty(p);
+    } else {
+        for(c = 0; c < HISTORY_CHANNELS; c ++) {
+            /* 四舍五入的整数平均值 */
+            if(t->acc.sum[c] >= 0) {
+                p->ch[c].avg = (int16_t)((t->acc.sum[c] + (int32_t)t->acc.count / 2) / (int32_t)t->acc.count);
+            } else {
+                p->ch[c].avg = (int16_t)((t->acc.sum[c] - (int32_t)t->acc.count / 2) / (int32_t)t->acc.count);
+            }
+            p->ch[c].min = t->acc.min[c];
+            p->ch[c].max = t->acc.max[c];
+        }
+    }
+
+    b = t->acc_bucket + 1;
+    if(bucket - b > t->slots) {
+        b = bucket - t->slots;
+    }
+    for(; b < bucket; b ++) {
+        _history_point_empty(&t->points[b % t->slots]);
+    }
+
+    t->end = bucket;
+    t->acc_bucket = bucket;
+    _history_acc_reset(&t->acc);
+}
+
+/**
+ * @brief  清空累加器
+ * @param  acc 累加器
+ * @return 无
+ */
+static void _history_acc_reset(history_acc_t *acc)
+{
+    uint8_t c;
+
+    for(c = 0; c < HISTORY_CHANNELS; c ++) {
+        acc->sum[c] = 0;
+        acc->min[c] = HISTORY_VALUE_MAX;
+        acc->max[c] = -HISTORY_VALUE_MAX;
+    }
+    acc->count = 0;
+}
+
+/**
+ * @brief  把点标记为没有采样
+ * @param  p 点
+ * @return 无
+ */
+static void _history_point_empty(history_point_t *p)
+{
+    uint8_t c;
+
+    for(c = 0; c < HISTORY_CHANNELS; c ++) {
+        p->ch[c].avg = HISTORY_EMPTY;
+        p->ch[c].min = HISTORY_EMPTY;
+        p->ch[c].max = HISTORY_EMPTY;
+    }
+}
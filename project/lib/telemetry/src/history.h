@@ -0,0 +1,88 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __HISTORY_H__
+#define __HISTORY_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HISTORY_CHANNELS                3               // 功率、电压、电流
+#define HISTORY_EMPTY                   INT16_MIN       // 该时间段没有采样
+#define HISTORY_VALUE_MAX               INT16_MAX       // 量化值范围 [-INT16_MAX, INT16_MAX]
+
+/* 各级分辨率: 周期(秒) x 点数，1 秒 10 分钟、10 秒 2 小时、1 分钟 24 小时 */
+#define HISTORY_TIERS                   3
+#define HISTORY_TIER0_PERIOD            1
+#define HISTORY_TIER0_SLOTS             600
+#define HISTORY_TIER1_PERIOD            10
+#define HISTORY_TIER1_SLOTS             720
+#define HISTORY_TIER2_PERIOD            60
+#define HISTORY_TIER2_SLOTS             1440
+#define HISTORY_TOTAL_SLOTS             (HISTORY_TIER0_SLOTS + HISTORY_TIER1_SLOTS + HISTORY_TIER2_SLOTS)
+
+/**
+ * @brief   一个通道在一个时间段内的统计(量化值)
+ */
+typedef struct history_stat{
+    int16_t avg;                    // 平均值，HISTORY_EMPTY 表示没有采样
+    int16_t min;
+    int16_t max;
+}history_stat_t;
+
+/**
+ * @brief   一个时间段的所有通道(18 字节)
+ */
+typedef struct history_point{
+    history_stat_t ch[HISTORY_CHANNELS];
+}history_point_t;
+
+/**
+ * @brief   当前未结束时间段的累加器，插入时更新，结束时直接得出统计
+ */
+typedef struct history_acc{
+    int32_t sum[HISTORY_CHANNELS];
+    int16_t min[HISTORY_CHANNELS];
+    int16_t max[HISTORY_CHANNELS];
+    uint32_t count;
+}history_acc_t;
+
+/**
+ * @brief   一级分辨率的环形缓冲区
+ * @note    时间段编号 bucket = 时间 / period，编号为 b 的点存放在 points[b % slots]；
+ *          已结束的时间段为 [end - slots, end) 与 [first, end) 的交集
+ */
+typedef struct history_tier{
+    uint32_t period;                // 周期(秒)
+    uint32_t slots;                 // 点数
+    history_point_t *points;        // 指向 history_t.points 中本级的区域
+    uint32_t first;                 // 第一个时间段的编号
+    uint32_t end;                   // 最后一个已结束时间段的编号 + 1
+    uint32_t acc_bucket;            // 累加器所属的时间段编号
+    history_acc_t acc;
+}history_tier_t;
+
+/**
+ * @brief   多分辨率遥测历史，占用固定内存
+ * @note    每个采样同时累加到各级的当前时间段，时间段结束时写入一个点；
+ *          查询只读已结束的点，不需要重新扫描原始采样
+ */
+typedef struct history{
+    history_tier_t tiers[HISTORY_TIERS];
+    history_point_t points[HISTORY_TOTAL_SLOTS];
+    bool started;                   // 是否已有采样
+}history_t;
+
+/* public function protypes ------------------------------------------------- */
+void history_init(history_t *h);
+int16_t history_quantize(float value, uint16_t scale);
+bool history_add(history_t *h, uint32_t time, const int16_t value[HISTORY_CHANNELS]);
+int history_tier_find(uint32_t period);
+void history_range(const history_t *h, uint8_t tier, uint32_t from, uint32_t *first, uint32_t *end);
+void history_read(const history_t *h, uint8_t tier, uint32_t bucket, history_point_t *points, uint32_t n);
+
+#endif /* __HISTORY_H__ */
@@ -0,0 +1,308 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "session.h"
+#include "system.h"
+
+#define SESSION_MJ_PER_WH               3600000u
+
+/* private function protypes -------------------------------------------------*/
+static bool _session_state_active(uint8_t state);
+static void _session_integrate(session_engine_t *e, uint32_t now_ms, int32_t power_w);
+static void _session_fill(const session_engine_t *e, session_record_t *rec);
+static void _session_put_u16(uint8_t *buf, uint16_t value);
+static void _session_put_u32(uint8_t *buf, uint32_t value);
+static uint16_t _session_get_u16(const uint8_t *buf);
+static uint32_t _session_get_u32(const uint8_t *buf);
+
+/**
+ * @brief  初始化充电计量引擎
+ * @param  e 引擎
+ * @param  next_seq 下一条记录的序号(从持久化的记录中恢复)
+ * @return 无
+ */
+void session_init(session_engine_t *e, uint32_t next_seq)
+{
+    memset(e, 0, sizeof(*e));
+    e->next_seq = next_seq;
+}
+
+/**
+ * @brief  记录一次授权通过的刷卡
+ * @param  e 引擎
+ * @param  card 卡号
+ * @param  day 当天(1970-01-01 起的天数)
+ * @return 无
+ * @note   充电前刷卡时归属到下一次充电；充电中且当前充电没有卡号时归属到当前充电
+ */
+void session_authorize(session_engine_t *e, uint32_t card, uint16_t day)
+{
+    if(e->active && 0 == e->cur.card) {
+        e->cur.card = card;
+        e->cur.day = day;
+        return;
+    }
+    if(!e->active) {
+        e->auth_card = card;
+        e->auth_day = day;
+    }
+}
+
+/**
+ * @brief  处理一帧运行参数
+ * @param  e 引擎
+ * @param  now_ms 帧到达时间(毫秒，单调递增，允许回绕)
+ * @param  state 充电桩状态 evse_state_t
+ * @param  power_w 功率(W)
+ * @param  done 充电结束时输出该次记录
+ * @return 本帧是否结束了一次充电
+ */
+bool session_feed(session_engine_t *e, uint32_t now_ms, uint8_t state, int32_t power_w, session_record_t *done)
+{
+    bool active = _session_state_active(state);
+
+    if(power_w < 0) {
+        power_w = 0;
+    }
+
+    if(!e->active) {
+        if(EVSE_IDLE == state) {
+            /* 拔枪且未刷卡，之前的授权作废 */
+            e->auth_card = 0;
+            e->auth_day = 0;
+        }
+        if(!active) {
+            return false;
+        }
+        e->active = true;
+        e->start_ms = now_ms;
+        e->last_ms = now_ms;
+        e->last_power_w = power_w;
+        e->energy_mj = 0;
+        memset(&e->cur, 0, sizeof(e->cur));
+        e->cur.seq = e->next_seq ++;
+        e->cur.card = e->auth_card;
+        e->cur.day = e->auth_day;
+        e->auth_card = 0;
+        e->auth_day = 0;
+        return false;
+    }
+
+    _session_integrate(e, now_ms, power_w);
+    if(active) {
+        return false;
+    }
+
+    e->active = false;
+    e->cur.end_state = state;
+    _session_fill(e, done);
+    done->flags &= ~SESSION_FLAG_ACTIVE;
+    return true;
+}
+
+/**
+ * @brief  获取当前充电的实时记录
+ * @param  e 引擎
+ * @param  rec 输出
+ * @return 是否正在充电
+ */
+bool session_current(const session_engine_t *e, session_record_t *rec)
+{
+    if(!e->active) {
+        return false;
+    }
+    _session_fill(e, rec);
+    rec->flags |= SESSION_FLAG_ACTIVE;
+    return true;
+}
+
+/**
+ * @brief  初始化充电记录
+ * @param  log 记录
+ * @return 无
+ */
+void session_log_init(session_log_t *log)
+{
+    memset(log, 0, sizeof(*log));
+}
+
+/**
+ * @brief  追加一条充电记录，满时覆盖最旧的一条
+ * @param  log 记录
+ * @param  rec 充电记录
+ * @return 无
+ */
+void session_log_push(session_log_t *log, const session_record_t *rec)
+{
+    log->recs[log->head] = *rec;
+    log->head = (log->head + 1) % SESSION_LOG_LEN;
+    if(log->count < SESSION_LOG_LEN) {
+        log->count ++;
+    }
+}
+
+/**
+ * @brief  按从新到旧的顺序读取充电记录
+ * @param  log 记录
+ * @param  i 序号，0 为最新
+ * @param  rec 输出
+ * @return 是否存在
+ */
+bool session_log_get(const session_log_t *log, uint32_t i, session_record_t *rec)
+{
+    if(i >= log->count) {
+        return false;
+    }
+    *rec = log->recs[(log->head + SESSION_LOG_LEN - 1 - i) % SESSION_LOG_LEN];
+    return true;
+}
+
+/**
+ * @brief  把充电记录编码为线上格式(从旧到新)
+ * @param  log 记录
+ * @param  buf 输出缓冲区
+ * @param  size 缓冲区大小，至少 SESSION_LOG_LEN * SESSION_RECORD_WIRE_LEN
+ * @return 编码长度
+ */
+size_t session_log_encode(const session_log_t *log, uint8_t *buf, size_t size)
+{
+    const session_record_t *rec;
+    uint8_t *p = buf;
+    uint32_t i;
+
+    for(i = log->count; i > 0 && (size_t)(p - buf) + SESSION_RECORD_WIRE_LEN <= size; i --) {
+        rec = &log->recs[(log->head + SESSION_LOG_LEN - i) % SESSION_LOG_LEN];
+        _session_put_u32(p, rec->seq);
+        _session_put_u32(p + 4, rec->card);
+        _session_put_u16(p + 8, rec->day);
+        p[10] = rec->end_state;
+        p[11] = rec->flags;
+        _session_put_u32(p + 12, rec->duration_s);
+        _session_put_u32(p + 16, rec->energy_wh);
+        p += SESSION_RECORD_WIRE_LEN;
+    }
+    return (size_t)(p - buf);
+}
+
+/**
+ * @brief  从线上格式恢复充电记录
+ * @param  log 记录(先被清空)
+ * @param  buf 数据(从旧到新)
+ * @param  len 数据长度
+ * @return 下一条记录的序号
+ */
+uint32_t session_log_decode(session_log_t *log, const uint8_t *buf, size_t len)
+{
+    session_record_t rec;
+    uint32_t next_seq = 0;
+
+    session_log_init(log);
+    for(; len >= SESSION_RECORD_WIRE_LEN; len -= SESSION_RECORD_WIRE_LEN, buf += SESSION_RECORD_WIRE_LEN) {
+        rec.seq = _session_get_u32(buf);
+        rec.card = _session_get_u32(buf + 4);
+        rec.day = _session_get_u16(buf + 8);
+        rec.end_state = buf[10];
+        rec.flags = buf[11];
+        rec.duration_s = _session_get_u32(buf + 12);
+        rec.energy_wh = _session_get_u32(buf + 16);
+        session_log_push(log, &rec);
+        if(rec.seq + 1 > next_seq) {
+            next_seq = rec.seq + 1;
+        }
+    }
+    return next_seq;
+}
+
+/**
+ * @brief  判断状态是否属于一次充电
+ * @param  state evse_state_t
+ * @return 充电中或暂停时返回 true
+ */
+static bool _session_state_active(uint8_t state)
+{
+    return EVSE_CHARGING == state || EVSE_CHARGE_PAUSE == state;
+}
+
+/**
+ * @brief  梯形法积分上一帧到本帧之间的电量
+ * @param  e 引擎
+ * @param  now_ms 本帧时间
+ * @param  power_w 本帧功率
+ * @return 无
+ * @note   间隔超过 SESSION_MAX_GAP_MS 时不积分并标记 SESSION_FLAG_GAP
+ */
+static void _session_integrate(session_engine_t *e, uint32_t now_ms, int32_t power_w)
+{
+    uint32_t dt = now_ms - e->last_ms;
+
+    if(dt > SESSION_MAX_GAP_MS) {
+        e->cur.flags |= SESSION_FLAG_GAP;
+    } else {
+        e->energy_mj += ((uint64_t)(uint32_t)e->last_power_w + (uint32_t)power_w) * dt / 2;
+    }
+    e->last_ms = now_ms;
+    e->last_power_w = power_w;
+}
+
+/**
+ * @brief  用累计值生成记录
+ * @param  e 引擎
+ * @param  rec 输出
+ * @return 无
+ */
+static void _session_fill(const session_engine_t *e, session_record_t *rec)
+{
+    *rec = e->cur;
+    rec->duration_s = (e->last_ms - e->start_ms) / 1000;
+    rec->energy_wh = (uint32_t)((e->energy_mj + SESSION_MJ_PER_WH / 2) / SESSION_MJ_PER_WH);
+}
+
+/**
+ * @brief  写入小端16位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+static void _session_put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief  写入小端32位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+static void _session_put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief  读取小端16位无符号数
+ * @param  buf 数据地址
+ * @return 数值
+ */
+static uint16_t _session_get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+/**
+ * @brief  读取小端32位无符号数
+ * @param  buf 数据地址
+ * @return 数值
+ */
+static uint32_t _session_get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
@@ -0,0 +1,73 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SESSION_LOG_LEN                 24              // 保留的最近充电记录数
+#define SESSION_RECORD_WIRE_LEN         20              // 序号4 + 卡号4 + 日期2 + 结束状态1 + 标志1 + 时长4 + 电量4(小端)
+#define SESSION_MAX_GAP_MS              10000           // 两帧间隔超过该值时不积分(主控板掉线)
+
+/* 充电记录标志 */
+#define SESSION_FLAG_ACTIVE             0x01            // 正在充电(尚未结束)
+#define SESSION_FLAG_GAP                0x02            // 期间有超过 SESSION_MAX_GAP_MS 的数据中断，电量偏小
+
+/**
+ * @brief   一次充电的记录
+ */
+typedef struct session_record{
+    uint32_t seq;                   // 记录序号，递增
+    uint32_t card;                  // 授权卡号，0 表示未刷卡(如重启后继续充电)
+    uint16_t day;                   // 刷卡当天(1970-01-01 起的天数)，0 表示未知
+    uint8_t end_state;              // 结束时的 evse_state_t
+    uint8_t flags;                  // SESSION_FLAG_xxx
+    uint32_t duration_s;            // 时长(秒)
+    uint32_t energy_wh;             // 电量(Wh)
+}session_record_t;
+
+/**
+ * @brief   充电计量引擎
+ * @note    每帧运行参数调用一次 session_feed，O(1)、不分配内存。进入充电/暂停状态时开始
+ *          一次充电，离开时结束；功率按梯形法在定点数(mJ)上积分
+ */
+typedef struct session_engine{
+    bool active;                    // 是否正在充电
+    uint32_t start_ms;              // 开始时间
+    uint32_t last_ms;               // 上一帧的时间
+    int32_t last_power_w;           // 上一帧的功率
+    uint64_t energy_mj;             // 累计电量(mJ = W*ms)
+    uint32_t next_seq;              // 下一条记录的序号
+    uint32_t auth_card;             // 最近一次授权通过的卡号，0 表示没有
+    uint16_t auth_day;              // 授权当天
+    session_record_t cur;           // 当前充电(active 时有效)
+}session_engine_t;
+
+/**
+ * @brief   最近的充电记录(环形)
+ */
+typedef struct session_log{
+    session_record_t recs[SESSION_LOG_LEN];
+    uint32_t count;                 // 记录数
+    uint32_t head;                  // 下一条写入的位置
+}session_log_t;
+
+/* public function protypes ------------------------------------------------- */
+void session_init(session_engine_t *e, uint32_t next_seq);
+void session_authorize(session_engine_t *e, uint32_t card, uint16_t day);
+bool session_feed(session_engine_t *e, uint32_t now_ms, uint8_t state, int32_t power_w, session_record_t *done);
+bool session_current(const session_engine_t *e, session_record_t *rec);
+
+void session_log_init(session_log_t *log);
+void session_log_push(session_log_t *log, const session_record_t *rec);
+bool session_log_get(const session_log_t *log, uint32_t i, session_record_t *rec);
+size_t session_log_encode(const session_log_t *log, uint8_t *buf, size_t size);
+uint32_t session_log_decode(session_log_t *log, const uint8_t *buf, size_t len);
+
+#endif /* __SESSION_H__ */
@@ -0,0 +1,219 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "capture.h"
+#include "wire_codec.h"
+
+/**
+ * @brief  初始化收发记录
+ * @param  cap 记录句柄
+ * @param  buf 存储区，NULL 表示不记录
+ * @param  size 存储区大小，必须为2的幂且不小于 CAPTURE_MIN_SIZE
+ * @param  clock 微秒时钟
+ * @return 是否启用
+ */
+bool capture_init(capture_t *cap, uint8_t *buf, uint32_t size, capture_clock_t clock)
+{
+    memset(cap, 0, sizeof(*cap));
+    if((NULL == buf) || (NULL == clock) || (size < CAPTURE_MIN_SIZE) || (size & (size - 1)) != 0) {
+        return false;
+    }
+
+    cap->mask = size - 1;
+    cap->clock = clock;
+    cap->buf = buf;
+    return true;
+}
+
+/**
+ * @brief  从存储区读出一个小端 uint32(可能回绕)
+ * @param  cap 记录句柄
+ * @param  pos 位置
+ * @return 数值
+ */
+static uint32_t _capture_get_u32(const capture_t *cap, uint32_t pos)
+{
+    uint8_t b[4];
+
+    for(uint32_t i = 0; i < 4; i ++) {
+        b[i] = cap->buf[(pos + i) & cap->mask];
+    }
+    return wire_get_u32(b);
+}
+
+/**
+ * @brief  复制到存储区(可能回绕)
+ * @param  cap 记录句柄
+ * @param  pos 位置
+ * @param  src 数据
+ * @param  len 长度
+ * @return 无
+ */
+static void _capture_put(capture_t *cap, uint32_t pos, const uint8_t *src, uint32_t len)
+{
+    uint32_t off = pos & cap->mask;
+    uint32_t first = cap->mask + 1 - off;
+
+    if(first > len) {
+        first = len;
+    }
+    memcpy(cap->buf + off, src, first);
+    memcpy(cap->buf, src + first, len - first);
+}
+
+/**
+ * @brief  从存储区复制出来(可能回绕)
+ * @param  cap 记录句柄
+ * @param  pos 位置
+ * @param  dest 输出
+ * @param  len 长度
+ * @return 无
+ */
+static void _capture_get(const capture_t *cap, uint32_t pos, uint8_t *dest, uint32_t len)
+{
+    uint32_t off = pos & cap->mask;
+    uint32_t first = cap->mask + 1 - off;
+
+    if(first > len) {
+        first = len;
+    }
+    memcpy(dest, cap->buf + off, first);
+    memcpy(dest + first, cap->buf, len - first);
+}
+
+/**
+ * @brief  记录一段收发数据
+ * @param  cap 记录句柄
+ * @param  dir CAPTURE_DIR_RX 或 CAPTURE_DIR_TX
+ * @param  data 数据
+ * @param  len 数据长度
+ * @return 无
+ * @note   同一句柄只允许一个写者(串口任务)；没有启用时只判断一次指针。
+ *         写满时覆盖最早的记录，不会失败
+ */
+void capture_record(capture_t *cap, uint8_t dir, const uint8_t *data, uint32_t len)
+{
+    uint8_t hdr[CAPTURE_RECORD_HEAD_LEN + 1];
+    uint32_t incl = (len < CAPTURE_SNAPLEN - 1) ? len + 1 : CAPTURE_SNAPLEN;
+    uint32_t need = CAPTURE_RECORD_HEAD_LEN + incl;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t overwritten = 0;
+    uint64_t us;
+
+    if(NULL == cap->buf) {
+        return;
+    }
+
+    us = cap->clock();
+    wire_put_u32(hdr, (uint32_t)(us / 1000000u));
+    wire_put_u32(hdr + 4, (uint32_t)(us % 1000000u));
+    wire_put_u32(hdr + 8, incl);
+    wire_put_u32(hdr + 12, len + 1);
+    hdr[CAPTURE_RECORD_HEAD_LEN] = dir;
+
+    /* 空出位置: 逐条丢弃最早的记录 */
+    head = atomic_load_explicit(&cap->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&cap->tail, memory_order_relaxed);
+    while(head + need - tail > cap->mask + 1) {
+        tail += CAPTURE_RECORD_HEAD_LEN + _capture_get_u32(cap, tail + 8);
+        overwritten ++;
+    }
+    if(overwritten > 0) {
+        atomic_store_explicit(&cap->tail, tail, memory_order_relaxed);
+        atomic_fetch_add_explicit(&cap->overwritten, overwritten, memory_order_relaxed);
+        /* tail 先于被覆盖的数据对读者可见 */
+        atomic_thread_fence(memory_order_release);
+    }
+
+    _capture_put(cap, head, hdr, sizeof(hdr));
+    _capture_put(cap, head + sizeof(hdr), data, incl - 1);
+    atomic_store_explicit(&cap->head, head + need, memory_order_release);
+    atomic_fetch_add_explicit(&cap->records, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief  开始读取当前所有记录
+ * @param  cap 记录句柄
+ * @param  pos 输出: 读取位置(最早一条记录)
+ * @param  end 输出: 结束位置(当前写位置)，之后写入的记录不读取
+ * @return 是否启用
+ */
+bool capture_begin(capture_t *cap, uint32_t *pos, uint32_t *end)
+{
+    if(NULL == cap->buf) {
+        return false;
+    }
+    *end = atomic_load_explicit(&cap->head, memory_order_acquire);
+    *pos = atomic_load_explicit(&cap->tail, memory_order_acquire);
+    return true;
+}
+
+/**
+ * @brief  读取完整的记录
+ * @param  cap 记录句柄
+ * @param  pos 读取位置，返回时指向下一条记录
+ * @param  end capture_begin 得到的结束位置
+ * @param  out 输出
+ * @param  max 输出缓冲区大小，至少 CAPTURE_RECORD_MAX_LEN
+ * @return 复制的字节数，0 表示读完
+ * @note   可以在任意任务中调用，不阻塞写者；读取期间被覆盖的记录跳过
+ */
+uint32_t capture_read(capture_t *cap, uint32_t *pos, uint32_t end, uint8_t *out, uint32_t max)
+{
+    uint32_t start;
+    uint32_t p;
+    uint32_t used;
+    uint32_t rec;
+
+    for(;;) {
+        start = *pos;
+        if((int32_t)(atomic_load_explicit(&cap->tail, memory_order_acquire) - start) > 0) {
+            start = atomic_load_explicit(&cap->tail, memory_order_acquire);
+        }
+
+        p = start;
+        used = 0;
+        while((int32_t)(end - p) > 0) {
+            rec = _capture_get_u32(cap, p + 8);
+            if((rec > CAPTURE_SNAPLEN) || (0 == rec)) {
+                break;              // 正在被改写，下面检查 tail 后重读
+            }
+            rec += CAPTURE_RECORD_HEAD_LEN;
+            if((rec > end - p) || (rec > max - used)) {
+                break;
+            }
+            _capture_get(cap, p, out + used, rec);
+            used += rec;
+            p += rec;
+        }
+
+        /* 复制期间 tail 没有越过起点，说明复制的数据没有被改写 */
+        atomic_thread_fence(memory_order_acquire);
+        if((int32_t)(atomic_load_explicit(&cap->tail, memory_order_relaxed) - start) <= 0) {
+            *pos = p;
+            return used;
+        }
+    }
+}
+
+/**
+ * @brief  生成 pcap 文件头
+ * @param  out 输出，CAPTURE_FILE_HEAD_LEN 字节
+ * @return 文件头长度
+ */
+uint32_t capture_file_header(uint8_t *out)
+{
+    wire_put_u32(out, CAPTURE_PCAP_MAGIC);
+    wire_put_u16(out + 4, 2);
+    wire_put_u16(out + 6, 4);
+    wire_put_u32(out + 8, 0);
+    wire_put_u32(out + 12, 0);
+    wire_put_u32(out + 16, CAPTURE_SNAPLEN);
+    wire_put_u32(out + 20, CAPTURE_LINKTYPE);
+    return CAPTURE_FILE_HEAD_LEN;
+}
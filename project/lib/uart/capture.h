@@ -0,0 +1,62 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * 串口收发记录，直接按 pcap 格式存放，下载时只需在前面加上文件头:
+ *
+ *   文件头(24): a1b2c3d4 0002 0004 0 0 CAPTURE_SNAPLEN CAPTURE_LINKTYPE
+ *   记录头(16): 秒4 + 微秒4 + 记录长度4 + 原始长度4(均为小端，时间为启动后的时间)
+ *   记录内容:   方向1(CAPTURE_DIR_xxx) + 数据
+ *
+ * 单次数据超过 CAPTURE_SNAPLEN - 1 字节时截断，记录长度小于原始长度
+ */
+#define CAPTURE_PCAP_MAGIC              0xA1B2C3D4
+#define CAPTURE_LINKTYPE                147             // LINKTYPE_USER0
+#define CAPTURE_SNAPLEN                 513             // 方向1 + 数据512
+#define CAPTURE_FILE_HEAD_LEN           24
+#define CAPTURE_RECORD_HEAD_LEN         16
+#define CAPTURE_RECORD_MAX_LEN          (CAPTURE_RECORD_HEAD_LEN + CAPTURE_SNAPLEN)
+#define CAPTURE_MIN_SIZE                1024
+
+#define CAPTURE_DIR_RX                  0x00            // 主控板 -> 面板
+#define CAPTURE_DIR_TX                  0x01            // 面板 -> 主控板
+
+/**
+ * @brief   微秒时钟
+ * @return  微秒数
+ */
+typedef uint64_t (*capture_clock_t)(void);
+
+/**
+ * @brief   收发记录环形缓冲区(单写者，读者不阻塞写者)
+ * @note    head/tail 为自由递增的字节位置；写满后覆盖最早的记录，tail 总指向最早一条完整记录。
+ *          写者先推进 tail 再改写数据，读者复制完再检查 tail，被改写的部分重新读取
+ */
+typedef struct capture{
+    uint8_t *buf;                   // 存储区，NULL 表示没有启用
+    uint32_t mask;                  // 容量-1
+    atomic_uint head;               // 写位置
+    atomic_uint tail;               // 最早一条完整记录的位置
+    atomic_uint records;            // 累计记录数
+    atomic_uint overwritten;        // 被覆盖的记录数
+    capture_clock_t clock;
+}capture_t;
+
+/* public function protypes ------------------------------------------------- */
+bool capture_init(capture_t *cap, uint8_t *buf, uint32_t size, capture_clock_t clock);
+void capture_record(capture_t *cap, uint8_t dir, const uint8_t *data, uint32_t len);
+bool capture_begin(capture_t *cap, uint32_t *pos, uint32_t *end);
+uint32_t capture_read(capture_t *cap, uint32_t *pos, uint32_t end, uint8_t *out, uint32_t max);
+uint32_t capture_file_header(uint8_t *out);
+
+#endif /* __CAPTURE_H__ */
@@ -0,0 +1,642 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "link.h"
+
+#define LINK_SLOT(link, seq)            (&(link)->window[(uint8_t)(seq) & (LINK_WINDOW - 1)])
+#define LINK_RX_SLOT(link, seq)         (&(link)->rx_hold[(uint8_t)(seq) & (LINK_SACK_BITS - 1)])
+
+/* CRC-16/CCITT-FALSE(多项式 0x1021)查表 */
+static const uint16_t s_crc16_table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+/**
+ * @brief  CRC-16 累加一个字节
+ * @param  crc 之前的 CRC，起始值为 0xFFFF
+ * @param  byte 数据
+ * @return 新的 CRC
+ * @note   帧解析时逐字节调用，不必等整帧收齐
+ */
+uint16_t link_crc16_byte(uint16_t crc, uint8_t byte)
+{
+    return (uint16_t)((crc << 8) ^ s_crc16_table[(uint8_t)(crc >> 8) ^ byte]);
+}
+
+/**
+ * @brief  计算 CRC-16
+ * @param  crc 之前的 CRC，起始值为 0xFFFF
+ * @param  buf 数据
+ * @param  len 数据长度
+ * @return 新的 CRC
+ */
+uint16_t link_crc16(uint16_t crc, const uint8_t *buf, uint32_t len)
+{
+    uint32_t i;
+
+    for(i = 0; i < len; i ++) {
+        crc = link_crc16_byte(crc, buf[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief  组一帧 v2 数据
+ * @param  frame 帧缓冲区，至少 PROTOCOL_HEAD_V2 + hdr->len + LINK_CRC_LEN 字节
+ * @param  hdr 帧头
+ * @param  value 数据内容
+ * @return 整帧长度
+ */
+uint16_t link_frame_pack(uint8_t *frame, const link_header_t *hdr, const uint8_t *value)
+{
+    uint16_t crc;
+
+    frame[HEAD_FIRST] = FRAME_FIRST;
+    frame[HEAD_SECOND] = FRAME_SECOND_V2;
+    frame[LINK_CTRL_POS] = hdr->ctrl;
+    frame[LINK_SEQ_POS] = hdr->seq;
+    frame[LINK_ACK_POS] = hdr->ack;
+    frame[LINK_SACK_POS] = hdr->sack;
+    frame[LINK_FN_POS] = hdr->fn;
+    frame[LINK_LEN_POS] = hdr->len;
+    if(hdr->len > 0) {
+        memcpy(frame + DATA_START_V2, value, hdr->len);
+    }
+
+    /* 帧头两字节不参与 CRC */
+    crc = link_crc16(0xFFFF, frame + LINK_CTRL_POS, PROTOCOL_HEAD_V2 - LINK_CTRL_POS + hdr->len);
+    frame[DATA_START_V2 + hdr->len] = (uint8_t)(crc & 0xFF);
+    frame[DATA_START_V2 + hdr->len + 1] = (uint8_t)(crc >> 8);
+    return DATA_START_V2 + hdr->len + LINK_CRC_LEN;
+}
+
+/**
+ * @brief  初始化链路
+ * @param  link 链路
+ * @param  max_version 本端支持的最高版本，LINK_VERSION_V1 表示不握手、只用 v1 帧
+ * @return 无
+ * @note   链路总是从 v1 开始，握手成功(或收到对端的 v2 帧)后才切换到 v2
+ */
+void link_init(uart_link_t *link, uint8_t max_version)
+{
+    memset(link, 0, sizeof(*link));
+    if(max_version < LINK_VERSION_V1) {
+        max_version = LINK_VERSION_V1;
+    } else if(max_version > LINK_VERSION_V2) {
+        max_version = LINK_VERSION_V2;
+    }
+    link->version = LINK_VERSION_V1;
+    link->max_version = max_version;
+    link->rto_ms = LINK_RTO_MS;
+    link->rx_unsynced = true;
+}
+
+/**
+ * @brief  放弃发送窗口中所有未确认的帧
+ * @param  link 链路
+ * @return 无
+ */
+static void _link_window_drop(uart_link_t *link)
+{
+    uint8_t seq;
+
+    for(seq = link->tx_base; seq != link->tx_next; seq ++) {
+        if(!LINK_SLOT(link, seq)->acked) {
+            link->stats.tx_failed ++;
+        }
+    }
+    link->tx_base = link->tx_next;
+}
+
+/**
+ * @brief  丢弃接收窗口中暂存的帧
+ * @param  link 链路
+ * @return 无
+ * @note   对端的序号重新开始(对端重启或重新同步)时调用，暂存的帧不再有机会按序号交付
+ */
+static void _link_rx_drop(uart_link_t *link)
+{
+    uint8_t i;
+
+    for(i = 0; i < LINK_SACK_BITS; i ++) {
+        link->rx_hold[i].held = false;
+    }
+}
+
+/**
+ * @brief  暂存提前到达的帧
+ * @param  link 链路
+ * @param  hdr 帧头
+ * @param  value 数据内容
+ * @return 无
+ */
+static void _link_rx_hold(uart_link_t *link, const link_header_t *hdr, const uint8_t *value)
+{
+    link_rx_slot_t *slot = LINK_RX_SLOT(link, hdr->seq);
+
+    slot->seq = hdr->seq;
+    slot->fn = hdr->fn;
+    slot->len = hdr->len;
+    slot->held = true;
+    if(hdr->len > 0) {
+        memcpy(slot->data, value, hdr->len);
+    }
+    link->stats.rx_reordered ++;
+}
+
+/**
+ * @brief  收到对端的版本握手(FN_PROTO_VERSION)
+ * @param  link 链路
+ * @param  value 数据内容: 最高版本 + 是否为回复
+ * @param  len 数据内容长度
+ * @return 无
+ * @note   对端的主动握手说明对端刚启动，它的序号从头开始，接收端重新同步
+ */
+void link_on_hello(uart_link_t *link, const uint8_t *value, uint8_t len)
+{
+    uint8_t version;
+
+    if(len < LINK_HELLO_LEN) {
+        return;
+    }
+
+    version = (value[0] < link->max_version) ? value[0] : link->max_version;
+    if(version < LINK_VERSION_V1) {
+        version = LINK_VERSION_V1;
+    }
+    if((version < LINK_VERSION_V2) && (link->version >= LINK_VERSION_V2)) {
+        _link_window_drop(link);
+    }
+    link->version = version;
+    link->hello_tries = LINK_HELLO_TRIES;
+
+    if(0 == value[1]) {
+        link->hello_reply = true;
+        link->rx_unsynced = true;
+        link->rx_sack = 0;
+        link->ack_pending = false;
+        link->nak_pending = false;
+        _link_rx_drop(link);
+    }
+}
+
+/**
+ * @brief  用一次往返时间更新重发超时
+ * @param  link 链路
+ * @param  rtt 往返时间(毫秒)
+ * @return 无
+ * @note   与 TCP 相同: RTO = SRTT + max(4 * RTTVAR, LINK_RTO_MIN_MS)，不超过 LINK_RTO_MAX_MS
+ */
+static void _link_rtt_sample(uart_link_t *link, uint32_t rtt)
+{
+    int32_t err;
+    uint32_t rto;
+
+    if(rtt > LINK_RTO_MAX_MS) {
+        rtt = LINK_RTO_MAX_MS;
+    }
+    if(0 == link->srtt8) {
+        link->srtt8 = (uint16_t)(rtt << 3);
+        link->rttvar4 = (uint16_t)(rtt << 1);
+    } else {
+        err = (int32_t)rtt - (link->srtt8 >> 3);
+        link->srtt8 = (uint16_t)(link->srtt8 + err);
+        if(err < 0) {
+            err = -err;
+        }
+        link->rttvar4 = (uint16_t)(link->rttvar4 + err - (link->rttvar4 >> 2));
+    }
+
+    /* 往返时间很稳定时 RTTVAR 趋近于 0，留出至少 LINK_RTO_MIN_MS 的余量，否则一点抖动就会误重发 */
+    rto = (link->srtt8 >> 3) + ((link->rttvar4 > LINK_RTO_MIN_MS) ? link->rttvar4 : LINK_RTO_MIN_MS);
+    link->rto_ms = (uint16_t)((rto > LINK_RTO_MAX_MS) ? LINK_RTO_MAX_MS : rto);
+}
+
+/**
+ * @brief  把发送窗口中的一帧标记为已确认
+ * @param  slot 帧
+ * @param  rtt 输出: 没有重发过的帧的往返时间(只取最后确认的一帧)
+ * @param  now 当前时间(毫秒)
+ * @return 无
+ * @note   重发过的帧不采样往返时间，无法区分确认的是哪一次发送
+ */
+static void _link_slot_ack(link_tx_slot_t *slot, int32_t *rtt, uint32_t now)
+{
+    if(slot->acked) {
+        return;
+    }
+    slot->acked = true;
+    if(0 == slot->retries) {
+        *rtt = (int32_t)(now - slot->sent_ms);
+    }
+}
+
+/**
+ * @brief  处理对端的确认
+ * @param  link 链路
+ * @param  hdr 帧头(带 LINK_CTRL_ACK)
+ * @param  now 当前时间(毫秒)
+ * @return 无
+ * @note   ACK 落在发送窗口之外的是过期的确认，直接忽略
+ */
+static void _link_on_ack(uart_link_t *link, const link_header_t *hdr, uint32_t now)
+{
+    uint8_t inflight = (uint8_t)(link->tx_next - link->tx_base);
+    uint8_t acked = (uint8_t)(hdr->ack - link->tx_base);
+    link_tx_slot_t *slot;
+    int32_t rtt = -1;
+    uint8_t i;
+
+    if(acked > inflight) {
+        return;
+    }
+
+    for(i = 0; i < acked; i ++) {
+        _link_slot_ack(LINK_SLOT(link, link->tx_base + i), &rtt, now);
+    }
+    for(i = 0; i < LINK_SACK_BITS; i ++) {
+        if((hdr->sack & (1u << i)) && (acked + 1 + i < inflight)) {
+            _link_slot_ack(LINK_SLOT(link, link->tx_base + acked + 1 + i), &rtt, now);
+        }
+    }
+    if(rtt >= 0) {
+        _link_rtt_sample(link, (uint32_t)rtt);
+    }
+    if((hdr->ctrl & LINK_CTRL_NAK) && (acked < inflight)) {
+        /* 刚重发过(不到一个往返时间)的帧，NAK 是在重发到达之前发出的，不再重发 */
+        slot = LINK_SLOT(link, hdr->ack);
+        if(now - slot->sent_ms >= (uint32_t)(link->srtt8 >> 3)) {
+            slot->resend = true;
+        }
+    }
+
+    while((link->tx_base != link->tx_next) && LINK_SLOT(link, link->tx_base)->acked) {
+        link->tx_base ++;
+    }
+}
+
+/**
+ * @brief  处理收到的 v2 帧(CRC 已校验通过)
+ * @param  link 链路
+ * @param  hdr 帧头
+ * @param  value 数据内容
+ * @param  now 当前时间(毫秒)
+ * @return 是否应立即交给功能码处理函数；重复的帧、单独的确认帧和提前到达而暂存的帧返回 false
+ * @note   帧按序号交付: 运行参数等帧带有状态，重发的旧帧晚于新帧交付会覆盖较新的数据。
+ *         提前到达的帧暂存在接收窗口中，缺失的帧到达(或对端用 SYN 放弃它)后，
+ *         调用者在处理完本帧之后用 link_rx_next 依次取出
+ */
+bool link_receive(uart_link_t *link, const link_header_t *hdr, const uint8_t *value, uint32_t now)
+{
+    link_tx_slot_t *slot;
+    int8_t d;
+    bool dup = false;
+    bool skipped = false;
+    bool deliver = false;
+    bool fresh = false;
+    uint8_t bit;
+
+    link->heard_ms = now;
+
+    /* 收到合法的 v2 帧，说明对端支持 v2 */
+    if((link->version < LINK_VERSION_V2) && (link->max_version >= LINK_VERSION_V2)) {
+        link->version = LINK_VERSION_V2;
+        link->hello_tries = LINK_HELLO_TRIES;
+    }
+
+    if(hdr->ctrl & LINK_CTRL_ACK) {
+        _link_on_ack(link, hdr, now);
+    } else if((hdr->ctrl & LINK_CTRL_NAK) && (link->tx_base != link->tx_next)) {
+        /* 对端还没有同步，请求重发最早的帧(带 SYN) */
+        slot = LINK_SLOT(link, link->tx_base);
+        if(now - slot->sent_ms >= (uint32_t)(link->srtt8 >> 3)) {
+            slot->resend = true;
+        }
+    }
+    if(0 == (hdr->ctrl & LINK_CTRL_DATA)) {
+        return false;
+    }
+
+    d = (int8_t)(hdr->seq - link->rx_base);
+    if(hdr->ctrl & LINK_CTRL_SYN) {
+        /* SYN: 对端不会再发送 seq 之前的帧，接收窗口可以直接移到 seq */
+        if(link->rx_unsynced || (d > LINK_SACK_BITS) || (d < -LINK_SACK_BITS)) {
+            link->rx_unsynced = false;
+            link->rx_base = hdr->seq;
+            link->rx_deliver = hdr->seq;
+            link->rx_sack = 0;
+            _link_rx_drop(link);
+            d = 0;
+        } else if(d > 0) {
+            /* 对端放弃了 seq 之前缺失的帧，之前暂存的帧和本帧按序号一起交付 */
+            dup = (link->rx_sack >> (d - 1)) & 1;
+            link->rx_sack = (uint8_t)((uint32_t)link->rx_sack >> d);
+            link->rx_base = hdr->seq;
+            skipped = true;
+            d = 0;
+        }
+    } else if(link->rx_unsynced) {
+        /* 不知道对端的序号，不能确认；发不带 ACK 的 NAK 请对端立即重发最早的帧(带 SYN)，
+           不必等对端超时(对端收不到确认会加倍超时)，每 LINK_RTO_MIN_MS 最多一次 */
+        if(now - link->nak_ms >= LINK_RTO_MIN_MS) {
+            link->nak_pending = true;
+            link->nak_ms = now;
+        }
+        return false;
+    }
+
+    link->ack_pending = true;
+    if(0 == d) {
+        fresh = !dup;
+        if(!skipped) {
+            deliver = true;
+            link->rx_deliver = (uint8_t)(hdr->seq + 1);
+        } else if(fresh) {
+            _link_rx_hold(link, hdr, value);
+        }
+        do {
+            link->rx_base ++;
+            bit = link->rx_sack & 1;
+            link->rx_sack >>= 1;
+        } while(bit);
+    } else if((d > 0) && (d <= LINK_SACK_BITS)) {
+        bit = (uint8_t)(1u << (d - 1));
+        fresh = (0 == (link->rx_sack & bit));
+        if(fresh) {
+            _link_rx_hold(link, hdr, value);
+        }
+        link->rx_sack |= bit;
+    }
+
+    if(fresh) {
+        link->stats.rx_frames ++;
+    } else {
+        link->stats.rx_duplicates ++;
+    }
+
+    /* rx_base 之后有帧先到，说明 rx_base 丢失，请求立即重发(同一序号每 LINK_RTO_MIN_MS 最多一次) */
+    if((0 != link->rx_sack) && ((link->nak_base != link->rx_base) || (now - link->nak_ms >= LINK_RTO_MIN_MS))) {
+        link->nak_pending = true;
+        link->nak_base = link->rx_base;
+        link->nak_ms = now;
+    } else if(0 == link->rx_sack) {
+        link->nak_pending = false;
+    }
+    return deliver;
+}
+
+/**
+ * @brief  取出下一个可以按序号交付的暂存帧
+ * @param  link 链路
+ * @return 暂存的帧，没有时返回 NULL
+ * @note   每次 link_receive 之后循环调用到返回 NULL；返回的帧在下一次 link_receive 之前有效。
+ *         对端放弃的序号没有暂存的帧，直接跳过
+ */
+const link_rx_slot_t *link_rx_next(uart_link_t *link)
+{
+    link_rx_slot_t *slot;
+    uint8_t seq;
+
+    while(link->rx_deliver != link->rx_base) {
+        seq = link->rx_deliver ++;
+        slot = LINK_RX_SLOT(link, seq);
+        if(slot->held && (slot->seq == seq)) {
+            slot->held = false;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief  收到 CRC 校验失败的 v2 帧
+ * @param  link 链路
+ * @param  now 当前时间(毫秒)
+ * @return 无
+ * @note   坏帧多半是对端最早未确认的帧，发 NAK 请对端立即重发，不必等对端超时；
+ *         对端收到 NAK 也就知道链路仍然连通，不会加倍超时。每 LINK_RTO_MIN_MS 最多一次
+ */
+void link_on_bad_frame(uart_link_t *link, uint32_t now)
+{
+    if((link->version < LINK_VERSION_V2) || (now - link->nak_ms < LINK_RTO_MIN_MS)) {
+        return;
+    }
+    link->nak_pending = true;
+    link->nak_base = link->rx_base;
+    link->nak_ms = now;
+}
+
+/**
+ * @brief  填写帧头中的确认信息
+ * @param  link 链路
+ * @param  hdr 帧头
+ * @return 无
+ * * @note   确认随数据帧捎带发出，清除待确认标志；还没有同步时不带 ACK，只带请求同步的 NAK
+ */
+static void _link_fill_ack(uart_link_t *link, link_header_t *hdr)
+{
+    hdr->ctrl = (uint8_t)(LINK_VERSION_V2 << 4);
+    hdr->ack = link->rx_base;
+    hdr->sack = link->rx_sack;
+    if(!link->rx_unsynced) {
+        hdr->ctrl |= LINK_CTRL_ACK;
+        link->ack_pending = false;
+    }
+    if(link->nak_pending) {
+        hdr->ctrl |= LINK_CTRL_NAK;
+        link->nak_pending = false;
+        link->stats.tx_naks ++;
+    }
+}
+
+/**
+ * @brief  发送(或重发)窗口中的一帧
+ * @param  link 链路
+ * @param  slot 帧
+ * @param  now 当前时间(毫秒)
+ * @param  backend 发送后端
+ * @return 无
+ */
+static void _link_transmit(uart_link_t *link, link_tx_slot_t *slot, uint32_t now, uart_tx_backend_t backend)
+{
+    link_header_t hdr;
+
+    _link_fill_ack(link, &hdr);
+    hdr.ctrl |= LINK_CTRL_DATA;
+    if(slot->seq == link->tx_base) {
+        hdr.ctrl |= LINK_CTRL_SYN;
+    }
+    hdr.seq = slot->seq;
+    hdr.fn = slot->fn;
+    hdr.len = slot->len;
+    backend(link->frame, link_frame_pack(link->frame, &hdr, slot->data));
+    slot->sent_ms = now;
+}
+
+/**
+ * @brief  发送一帧数据
+ * @param  link 链路
+ * @param  frame 发送队列中的 v1 帧(uart_frame_pack 组好的)
+ * @param  len 帧长度
+ * @param  now 当前时间(毫秒)
+ * @param  backend 发送后端
+ * @return 是否已发送，v2 发送窗口已满时返回 false，帧留在发送队列中
+ * @note   v1 链路原样发送；v2 链路取出功能码和数据内容，重新组成带序号的 v2 帧
+ */
+bool link_send(uart_link_t *link, const uint8_t *frame, uint16_t len, uint32_t now, uart_tx_backend_t backend)
+{
+    link_tx_slot_t *slot;
+
+    if(link->version < LINK_VERSION_V2) {
+        /* 对端回复握手(或发来 v2 帧)之前一直用 v1 帧发送，握手期间不积压数据帧 */
+        backend(frame, len);
+        return true;
+    }
+    if((uint8_t)(link->tx_next - link->tx_base) >= LINK_WINDOW) {
+        return false;
+    }
+
+    slot = LINK_SLOT(link, link->tx_next);
+    slot->seq = link->tx_next;
+    slot->fn = frame[FUNCTION_NUM];
+    slot->len = frame[LENGTH];
+    slot->retries = 0;
+    slot->acked = false;
+    slot->resend = false;
+    memcpy(slot->data, frame + DATA_START, slot->len);
+    link->tx_next ++;
+
+    _link_transmit(link, slot, now, backend);
+    link->stats.tx_frames ++;
+    return true;
+}
+
+/**
+ * @brief  发送版本握手
+ * @param  link 链路
+ * @param  reply 是否为回复
+ * @param  backend 发送后端
+ * @return 无
+ * @note   握手总是用 v1 帧，不支持 v2 的主控板按未知功能码丢弃
+ */
+static void _link_send_hello(uart_link_t *link, bool reply, uart_tx_backend_t backend)
+{
+    uint8_t value[LINK_HELLO_LEN];
+
+    value[0] = link->max_version;
+    value[1] = reply ? 1 : 0;
+    backend(link->frame, uart_frame_pack(link->frame, FN_PROTO_VERSION, value, sizeof(value)));
+}
+
+/**
+ * @brief  链路定时服务: 版本握手、超时和 NAK 重发
+ * @param  link 链路
+ * @param  now 当前时间(毫秒)
+ * @param  backend 发送后端
+ * @return 无
+ * @note   重发次数用尽时放弃窗口中的帧，退回 v1 并重新握手(对端可能已经换成 v1 固件)
+ */
+void link_poll(uart_link_t *link, uint32_t now, uart_tx_backend_t backend)
+{
+    link_tx_slot_t *slot;
+    bool backoff = false;
+    uint8_t seq;
+
+    if(link->hello_reply) {
+        link->hello_reply = false;
+        _link_send_hello(link, true, backend);
+    } else if((link->version < LINK_VERSION_V2) && (link->max_version >= LINK_VERSION_V2) &&
+              (link->hello_tries < LINK_HELLO_TRIES) &&
+              ((0 == link->hello_tries) || (now - link->hello_ms >= LINK_HELLO_INTERVAL_MS))) {
+        link->hello_tries ++;
+        link->hello_ms = now;
+        _link_send_hello(link, false, backend);
+    }
+
+    if(link->version < LINK_VERSION_V2) {
+        return;
+    }
+    for(seq = link->tx_base; seq != link->tx_next; seq ++) {
+        slot = LINK_SLOT(link, seq);
+        if(slot->acked || (!slot->resend && (now - slot->sent_ms < link->rto_ms))) {
+            continue;
+        }
+        if(slot->retries >= LINK_MAX_RETRIES) {
+            _link_window_drop(link);
+            link->version = LINK_VERSION_V1;
+            link->hello_tries = 0;
+            return;
+        }
+        if(!slot->resend && (seq == link->tx_base) && ((int32_t)(link->heard_ms - slot->sent_ms) < 0)) {
+            backoff = true;
+        }
+        slot->retries ++;
+        slot->resend = false;
+        link->stats.tx_retransmits ++;
+        _link_transmit(link, slot, now, backend);
+    }
+    if(backoff) {
+        /* 最早的帧超时且发出后没有收到对端的任何帧(对端忙或掉线): 超时加倍，等下一次有效采样再恢复。
+           期间收到过对端的帧说明只是误码丢了这一帧或它的确认，按原超时重发，不加倍 */
+        link->rto_ms = (link->rto_ms < LINK_RTO_MAX_MS / 2) ? (uint16_t)(link->rto_ms * 2) : LINK_RTO_MAX_MS;
+    }
+}
+
+/**
+ * @brief  发送单独的确认帧
+ * @param  link 链路
+ * @param  backend 发送后端
+ * @return 无
+ * @note   在处理完接收数据、发送完数据帧之后调用；已经随数据帧捎带确认时不再发送
+ */
+void link_flush_ack(uart_link_t *link, uart_tx_backend_t backend)
+{
+    link_header_t hdr;
+
+    if((link->version < LINK_VERSION_V2) || (!link->nak_pending && (link->rx_unsynced || !link->ack_pending))) {
+        return;
+    }
+
+    _link_fill_ack(link, &hdr);
+    hdr.seq = link->tx_next;
+    hdr.fn = 0;
+    hdr.len = 0;
+    backend(link->frame, link_frame_pack(link->frame, &hdr, NULL));
+    link->stats.tx_acks ++;
+}
@@ -0,0 +1,170 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __LINK_H__
+#define __LINK_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "protocol.h"
+
+/*
+ * v2 帧格式(帧头第二字节为 FRAME_SECOND_V2，与 v1 帧可以混合出现在同一条链路上):
+ *
+ *   AA 5A CTRL SEQ ACK SACK FN LEN DATA[LEN] CRC_L CRC_H
+ *
+ *   CTRL   高4位为版本号(2)，低4位为 LINK_CTRL_xxx
+ *   SEQ    本帧序号(带 LINK_CTRL_DATA 时有效)
+ *   ACK    累计确认: 对端下一个期望的序号，之前的帧都已收到
+ *   SACK   选择确认: 第 i 位表示序号 ACK+1+i 已收到
+ *   FN     功能码，单独的确认帧为 0
+ *   CRC    CRC-16/CCITT-FALSE，覆盖 CTRL 到 DATA，小端
+ *
+ * 版本协商: 双方用 v1 帧 FN_PROTO_VERSION [最高版本, 是否为回复] 交换版本，取较小值；
+ * 收到合法的 v2 帧也视为对端支持 v2。不支持该功能码的 v1 主控板忽略握手，链路保持 v1
+ */
+#define FRAME_SECOND_V2                 0x5A            // v2 帧头第二字节
+#define PROTOCOL_HEAD_V2                0x08            // v2 帧头长度(帧头2 + CTRL/SEQ/ACK/SACK/FN/LEN)
+#define LINK_CTRL_POS                   2
+#define LINK_SEQ_POS                    3
+#define LINK_ACK_POS                    4
+#define LINK_SACK_POS                   5
+#define LINK_FN_POS                     6
+#define LINK_LEN_POS                    7
+#define DATA_START_V2                   PROTOCOL_HEAD_V2
+#define LINK_CRC_LEN                    2
+#define LINK_FRAME_MAX_LEN              (PROTOCOL_HEAD_V2 + 255 + LINK_CRC_LEN)
+
+#define LINK_VERSION_V1                 1
+#define LINK_VERSION_V2                 2
+#define LINK_CTRL_DATA                  0x01            // 带序号的数据帧，需要确认
+#define LINK_CTRL_NAK                   0x02            // 请求立即重发序号为 ACK 的帧；不带 LINK_CTRL_ACK 时请求重发最早未确认的帧
+#define LINK_CTRL_SYN                   0x04            // SEQ 是发送方最早未确认的帧，之前的序号不会再发送
+#define LINK_CTRL_ACK                   0x08            // ACK/SACK 有效(接收端已与对端的序号同步)
+#define LINK_CTRL_VERSION(ctrl)         ((uint8_t)(ctrl) >> 4)
+
+#define FN_PROTO_VERSION                0x01            // 版本协商(始终用 v1 帧)
+#define LINK_HELLO_LEN                  2               // 最高版本1 + 是否为回复1
+
+#define LINK_WINDOW                     4               // 未确认帧的最大数目，必须为2的幂
+#define LINK_SACK_BITS                  8               // 接收窗口: ACK 之后可以提前收下的帧数
+#define LINK_RTO_MS                     200             // 初始重发超时，之后按往返时间调整
+#define LINK_RTO_MIN_MS                 30              // 重发超时比往返时间至少多出的余量(不小于系统节拍的几倍)
+#define LINK_RTO_MAX_MS                 1000            // 重发超时上限(超时后加倍)
+#define LINK_MAX_RETRIES                8               // 超过后放弃该帧，并退回 v1 重新握手
+#define LINK_HELLO_INTERVAL_MS          1000            // 握手重发间隔
+#define LINK_HELLO_TRIES                5               // 握手次数，对端不回复则保持 v1
+
+#if (LINK_WINDOW & (LINK_WINDOW - 1)) != 0
+#error "LINK_WINDOW must be a power of two"
+#endif
+#if (LINK_SACK_BITS & (LINK_SACK_BITS - 1)) != 0
+#error "LINK_SACK_BITS must be a power of two"
+#endif
+#if LINK_WINDOW > LINK_SACK_BITS
+#error "LINK_WINDOW must not exceed the receive window"
+#endif
+
+/**
+ * @brief   解析出的 v2 帧头
+ */
+typedef struct link_header{
+    uint8_t ctrl;
+    uint8_t seq;
+    uint8_t ack;
+    uint8_t sack;
+    uint8_t fn;
+    uint8_t len;
+}link_header_t;
+
+/**
+ * @brief   发送窗口中的一帧
+ */
+typedef struct link_tx_slot{
+    uint32_t sent_ms;               // 最近一次发送的时间
+    uint8_t seq;
+    uint8_t fn;
+    uint8_t len;
+    uint8_t retries;                // 已重发次数
+    bool acked;                     // 已被累计确认或选择确认
+    bool resend;                    // 收到 NAK，下次服务时立即重发
+    uint8_t data[255];
+}link_tx_slot_t;
+
+/**
+ * @brief   接收窗口中提前到达的一帧(等前面缺失的帧到齐后按序号交付)
+ */
+typedef struct link_rx_slot{
+    uint8_t seq;
+    uint8_t fn;
+    uint8_t len;
+    bool held;                      // 已收下，尚未交付
+    uint8_t data[255];
+}link_rx_slot_t;
+
+/**
+ * @brief   链路统计
+ */
+typedef struct link_stats{
+    uint32_t tx_frames;             // 首次发送的数据帧
+    uint32_t tx_retransmits;        // 重发次数
+    uint32_t tx_failed;             // 重发次数用尽被放弃的帧
+    uint32_t tx_acks;               // 单独发送的确认帧
+    uint32_t tx_naks;               // 发出的 NAK
+    uint32_t rx_frames;             // 收到的 v2 数据帧(交给处理函数)
+    uint32_t rx_duplicates;         // 重复收到而丢弃的帧
+    uint32_t rx_reordered;          // 提前到达、暂存后按序号交付的帧
+    uint32_t rx_bad_check;          // 校验失败的帧(v1 校验和、v2 CRC)
+}link_stats_t;
+
+/**
+ * @brief   链路状态(发送窗口、接收窗口、版本协商)
+ * @note    只在串口任务中使用，不加锁
+ */
+typedef struct uart_link{
+    uint8_t version;                // 当前使用的版本
+    uint8_t max_version;            // 本端支持的最高版本
+    /* 发送 */
+    uint8_t tx_base;                // 最早未确认的序号
+    uint8_t tx_next;                // 下一个新帧的序号
+    link_tx_slot_t window[LINK_WINDOW];
+    uint16_t srtt8;                 // 平滑往返时间 x8，0 表示还没有采样
+    uint16_t rttvar4;               // 往返时间偏差 x4
+    uint16_t rto_ms;                // 当前重发超时
+    uint32_t heard_ms;              // 最近一次收到对端合法 v2 帧的时间
+    /* 接收 */
+    bool rx_unsynced;               // 还没有收到对端的 SYN 帧，不知道对端的序号
+    uint8_t rx_base;                // 下一个期望的序号
+    uint8_t rx_sack;                // 第 i 位: 序号 rx_base+1+i 已收到
+    uint8_t rx_deliver;             // 下一个待交付的序号(之前的帧都已交付或被对端放弃)
+    link_rx_slot_t rx_hold[LINK_SACK_BITS];
+    bool ack_pending;               // 有数据帧待确认
+    bool nak_pending;               // 待发送 NAK(rx_base 缺失)
+    uint8_t nak_base;               // 最近一次 NAK 的序号
+    uint32_t nak_ms;                // 最近一次 NAK 的时间
+    /* 握手 */
+    bool hello_reply;               // 需要回复对端的握手
+    uint8_t hello_tries;            // 已发送的握手次数
+    uint32_t hello_ms;              // 最近一次握手的时间
+    link_stats_t stats;
+    uint8_t frame[LINK_FRAME_MAX_LEN];  // 组帧缓冲区
+}uart_link_t;
+
+/* public function protypes ------------------------------------------------- */
+uint16_t link_crc16(uint16_t crc, const uint8_t *buf, uint32_t len);
+uint16_t link_crc16_byte(uint16_t crc, uint8_t byte);
+uint16_t link_frame_pack(uint8_t *frame, const link_header_t *hdr, const uint8_t *value);
+
+void link_init(uart_link_t *link, uint8_t max_version);
+void link_on_hello(uart_link_t *link, const uint8_t *value, uint8_t len);
+bool link_receive(uart_link_t *link, const link_header_t *hdr, const uint8_t *value, uint32_t now);
+const link_rx_slot_t *link_rx_next(uart_link_t *link);
+void link_on_bad_frame(uart_link_t *link, uint32_t now);
+bool link_send(uart_link_t *link, const uint8_t *frame, uint16_t len, uint32_t now, uart_tx_backend_t backend);
+void link_poll(uart_link_t *link, uint32_t now, uart_tx_backend_t backend);
+void link_flush_ack(uart_link_t *link, uart_tx_backend_t backend);
+
+#endif /* __LINK_H__ */
@@ -3,6 +3,8 @@
  * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
  */
 #include "panel_uart_api.h"
+#include "link.h"
+#include "param_apply.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -10,29 +12,12 @@
  * @brief  串口接收数据暂存处理（单字节）
  * @param  value 串口收到的单字节数据
  * @return 无
- * @note   在串口中断服务函数中调用,将接收到的数据作为参数传入
+ * @note   在串口中断服务函数中调用,将接收到的数据作为参数传入；
+ *         逐字节输入不记入收发记录(记录只允许一个写者)
  */
 void uart_receive_input(uint8_t value)
 {
-    if(1 == rx_buf_out - rx_buf_in) 
-    {
-        //!!! 串口接收缓存已满，处理速度跟不上接收，需要考虑扩大rx_buffer
-        // log_error("rx_buffer_full!!!!");
-    }
-    else if((rx_buf_in > rx_buf_out) && ((rx_buf_in - rx_buf_out) >= sizeof(uart_rx_buf))) 
-    {
-        //!!! 串口接收缓存已满，处理速度跟不上接收，需要考虑扩大rx_buffer
-        // log_error("rx_buffer_full!!!!");
-    }else 
-    {
-        //串口接收缓存未满
-        //串口数据到达rx_buffer末尾，修改rx_buf_in至开头
-        if(rx_buf_in >= (uint8_t *)(uart_rx_buf + sizeof(uart_rx_buf))) 
-        {
-            rx_buf_in = (uint8_t *)(uart_rx_buf);
-        }
-        *rx_buf_in ++ = value;
-    }
+    ring_buffer_write(&uart_rx_ring, &value, 1);
 }
 
 /**
@@ -40,91 +25,381 @@ void uart_receive_input(uint8_t value)
  * @param  value 串口要接收的数据的源地址
  * @param  data_len 串口要接收的数据的数据长度
  * @return 无
- * @note   如需要支持一次多字节缓存，可调用该函数
+ * @note   驱动层一次读出一整块数据(如DMA/FIFO)时调用该函数，整块拷贝进接收队列；
+ *         队列放不下的字节会被丢弃并计入溢出计数；启用收发记录时整块记录一次
  */
 void uart_receive_buff_input(uint8_t value[], unsigned short data_len)
 {
-    unsigned short i = 0;
-    for(i = 0; i < data_len; i++) 
-    {
-        uart_receive_input(value[i]);
-    }
+    capture_record(&uart_capture, CAPTURE_DIR_RX, value, data_len);
+    ring_buffer_write(&uart_rx_ring, value, data_len);
+}
+
+/**
+ * @brief  获取串口接收队列溢出丢弃的累计字节数
+ * @param  无
+ * @return 丢弃的字节数
+ */
+uint32_t uart_rx_overflow_count(void)
+{
+    return ring_buffer_overflow_count(&uart_rx_ring);
 }
 
-bool is_valid_function_num(uint8_t data) {
+/* 未完成的帧超过该时间没有新数据则丢弃(同一帧的字节是连续发送的) */
+#define UART_RX_IDLE_MS                 20
+
+/* 帧解析状态 */
+typedef enum{
+    PARSE_HEAD_FIRST = 0,           // 等待帧头第一字节
+    PARSE_HEAD_SECOND,              // 等待帧头第二字节
+    PARSE_FUNCTION_NUM,             // 等待功能码
+    PARSE_LENGTH,                   // 等待数据长度
+    PARSE_DATA,                     // 接收数据内容
+    PARSE_CHECK_SUM,                // 等待校验和
+    PARSE_V2_CTRL,                  // v2: 等待控制字节
+    PARSE_V2_SEQ,                   // v2: 等待序号
+    PARSE_V2_ACK,                   // v2: 等待累计确认
+    PARSE_V2_SACK,                  // v2: 等待选择确认
+    PARSE_V2_FUNCTION_NUM,          // v2: 等待功能码
+    PARSE_V2_LENGTH,                // v2: 等待数据长度
+    PARSE_V2_DATA,                  // v2: 接收数据内容
+    PARSE_V2_CRC_LOW,               // v2: 等待 CRC 低字节
+    PARSE_V2_CRC_HIGH,              // v2: 等待 CRC 高字节
+}parse_state_t;
+
+/* 帧解析器上下文 */
+typedef struct frame_parser{
+    parse_state_t state;            // 当前解析状态
+    uint8_t function_num;           // 当前帧功能码
+    uint8_t data_len;               // 当前帧数据内容长度
+    uint8_t check_sum;              // 累加校验和
+    uint16_t crc;                   // v2: CRC-16(随接收计算)
+    link_header_t hdr;              // v2: 帧头
+    uint16_t data_count;            // 已接收的数据内容字节数
+    uint32_t scan;                  // 已扫描字节数(相对接收队列读指针，即当前帧头)
+    uint32_t rx_ms;                 // 最近一次收到新数据的时间
+}frame_parser_t;
 
-    return (data == 0x10)||(data == 0x11)||(data == 0x12)||(data == 0x14)||
-    (data == 0x15)||(data == 0x18)||(data == 0x20)||(data == 0x30);
+static frame_parser_t s_parser;
+static uart_tx_backend_t s_tx_backend = uart_transmit_output;
+static uart_clock_t s_clock = uart_clock_ms;
+static uint8_t s_link_max_version = LINK_VERSION_V1;
+/* 链路状态(序号、确认、重发窗口)，只在串口任务中使用 */
+static uart_link_t s_link;
+/* 参数配置下发状态，由 mcu_param_config_apply 开始，串口任务结束 */
+static param_apply_t s_param_apply;
+
+/**
+ * @brief  帧解析失败，从当前帧头的下一字节开始重新同步
+ * @param  无
+ * @return 无
+ * @note   当前帧头之后已扫描过的字节仍留在接收队列中，会被重新扫描，
+ *         因此坏帧中间夹带的合法帧不会被跳过；v2 帧 CRC 错误时通知链路发 NAK
+ */
+static void _frame_parser_resync(void)
+{
+    if(PARSE_CHECK_SUM == s_parser.state) {
+        s_link.stats.rx_bad_check ++;
+    } else if((PARSE_V2_CRC_LOW == s_parser.state) || (PARSE_V2_CRC_HIGH == s_parser.state)) {
+        s_link.stats.rx_bad_check ++;
+        link_on_bad_frame(&s_link, s_clock());
+    }
+    ring_buffer_skip(&uart_rx_ring, 1);
+    s_parser.scan = 0;
+    s_parser.state = PARSE_HEAD_FIRST;
 }
 
 /**
- * @brief  串口数据处理服务
+ * @brief  完整接收并校验通过一帧数据，交给数据帧处理
  * @param  无
  * @return 无
- * @note   在MCU主函数while循环中调用该函数，调用该函数时，不要加上任何判断条件
+ * @note   数据内容在接收队列中连续时直接传递队列内的地址；
+ *         只有回绕到队列开头时才拼接到 uart_data_process_buf；
+ *         v2 帧先交给链路处理确认、去重和排序，重复的帧和单独的确认帧不交给处理函数，
+ *         提前到达的帧由链路暂存，前面缺失的帧到齐后随之按序号交付
  */
-void mcu_uart_service(void)
+static void _frame_parser_dispatch(void)
 {
-    static uint16_t process_buf_in = 0;
-    uint8_t rx_value_len = 0;
-    uint16_t offset = 0;
-	uint8_t checksum = 0;
-    
-    while((process_buf_in < sizeof(uart_data_process_buf)) && with_data_rxbuff() > 0) 
-    {
-        uart_data_process_buf[process_buf_in ++] = take_byte_rxbuff();
+    const link_rx_slot_t *held;
+    const uint8_t *value = NULL;
+    uint8_t len = s_parser.data_len;
+    uint32_t start = (PARSE_V2_CRC_HIGH == s_parser.state) ? DATA_START_V2 : DATA_START;
+    bool deliver = true;
+
+    if(ring_buffer_span(&uart_rx_ring, start, &value) < len) {
+        ring_buffer_peek(&uart_rx_ring, start, uart_data_process_buf, len);
+        value = uart_data_process_buf;
     }
+    if(PARSE_V2_CRC_HIGH == s_parser.state) {
+        deliver = link_receive(&s_link, &s_parser.hdr, value, s_clock());
+    }
+    if(deliver) {
+        data_handle(s_parser.function_num, value, len);
+    }
+    while(NULL != (held = link_rx_next(&s_link))) {
+        data_handle(held->fn, held->data, held->len);
+    }
+
+    ring_buffer_skip(&uart_rx_ring, s_parser.scan);
+    s_parser.scan = 0;
+    s_parser.state = PARSE_HEAD_FIRST;
+}
 
-    if(process_buf_in < PROTOCOL_HEAD)
-    return;
-    
-    while((process_buf_in - offset) >= PROTOCOL_HEAD)
+/**
+ * @brief  数据内容中可以一次处理的字节数
+ * @param  avail 当前连续片段中剩余的字节数(至少 1)
+ * @return 字节数(至少 1)
+ */
+static inline uint32_t _frame_parser_data_run(uint32_t avail)
+{
+    uint32_t left = s_parser.data_len - s_parser.data_count;
+
+    return (left < avail) ? left : avail;
+}
+
+/**
+ * @brief  处理完 n 字节数据内容，数据内容收完时进入校验状态
+ * @param  n 字节数(已经计入 1 字节的扫描位置)
+ * @return 无
+ */
+static inline void _frame_parser_data_done(uint32_t n)
+{
+    s_parser.scan += n - 1;
+    s_parser.data_count += n;
+    if(s_parser.data_count >= s_parser.data_len) {
+        s_parser.state = (PARSE_DATA == s_parser.state) ? PARSE_CHECK_SUM : PARSE_V2_CRC_LOW;
+    }
+}
+
+/**
+ * @brief  扫描接收队列中的新数据
+ * @param  无
+ * @return 是否扫描了新的字节
+ * @note   帧头、功能码和长度逐字节驱动帧解析状态机，数据内容按连续片段整段累加；
+ *         直接扫描接收队列，校验和随接收累加，
+ *         未完成的帧保留在队列中，下次调用时从上次扫描的位置继续；
+ *         v1 帧(AA 55)和 v2 帧(AA 5A)可以混合出现
+ */
+static bool _frame_parser_scan(void)
+{
+    const uint8_t *span;
+    uint32_t span_len;
+    uint32_t i;
+    uint32_t n;
+    uint32_t k;
+    uint8_t byte;
+    uint8_t check_sum;
+    uint16_t crc;
+    bool resync;
+    bool scanned = false;
+
+    while((span_len = ring_buffer_span(&uart_rx_ring, s_parser.scan, &span)) > 0)
     {
-        if(uart_data_process_buf[offset + HEAD_FIRST] != FRAME_FIRST) 
-        {
-            offset ++;
-            continue;
-        }
-        
-        if(uart_data_process_buf[offset + HEAD_SECOND] != FRAME_SECOND) 
+        resync = false;
+        scanned = true;
+        for(i = 0; (i < span_len) && !resync; i++)
         {
-            offset ++;
-            continue;
-        }  
+            byte = span[i];
+            s_parser.scan ++;
 
-        if(!is_valid_function_num(uart_data_process_buf[offset + FUNCTION_NUM])) 
-        {
-            offset ++;
-            continue;
-        }      
+            switch(s_parser.state)
+            {
+                case PARSE_HEAD_FIRST:
+                if(byte == FRAME_FIRST) {
+                    s_parser.check_sum = byte;
+                    s_parser.state = PARSE_HEAD_SECOND;
+                } else {
+                    /* 帧头之前的杂散字节直接丢弃 */
+                    ring_buffer_skip(&uart_rx_ring, 1);
+                    s_parser.scan = 0;
+                }
+                break;
 
-        rx_value_len = uart_data_process_buf[offset + LENGTH];
-		
-        if((process_buf_in - offset) < PROTOCOL_HEAD + rx_value_len + 1) 
-        {
-            break;
-        }
-		
-		checksum = get_check_sum(   (uint8_t *)uart_data_process_buf + offset,
-                                    PROTOCOL_HEAD + rx_value_len  );
+                case PARSE_HEAD_SECOND:
+                if(byte == FRAME_SECOND) {
+                    s_parser.check_sum += byte;
+                    s_parser.state = PARSE_FUNCTION_NUM;
+                } else if((byte == FRAME_SECOND_V2) && (s_link.max_version >= LINK_VERSION_V2)) {
+                    s_parser.crc = 0xFFFF;
+                    s_parser.state = PARSE_V2_CTRL;
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
 
-        if(checksum != uart_data_process_buf[offset + PROTOCOL_HEAD + rx_value_len]) 
-        {
-            offset += rx_value_len + 1;
-            continue;
+                case PARSE_FUNCTION_NUM:
+                if(is_valid_function_num(byte)) {
+                    s_parser.function_num = byte;
+                    s_parser.check_sum += byte;
+                    s_parser.state = PARSE_LENGTH;
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+
+                case PARSE_LENGTH:
+                if(is_valid_data_len(s_parser.function_num, byte)) {
+                    s_parser.data_len = byte;
+                    s_parser.data_count = 0;
+                    s_parser.check_sum += byte;
+                    s_parser.state = (byte > 0) ? PARSE_DATA : PARSE_CHECK_SUM;
+                } else {
+                    /* 长度不符合功能码表约定，不必等待数据内容，直接重新同步 */
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+
+                case PARSE_DATA:
+                /* 数据内容在本段中的部分一次累加完，不逐字节经过状态机 */
+                n = _frame_parser_data_run(span_len - i);
+                check_sum = s_parser.check_sum;
+                for(k = 0; k < n; k ++) {
+                    check_sum += span[i + k];
+                }
+                s_parser.check_sum = check_sum;
+                _frame_parser_data_done(n);
+                i += n - 1;
+                break;
+
+                case PARSE_CHECK_SUM:
+                if(byte == s_parser.check_sum) {
+                    _frame_parser_dispatch();
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+
+                case PARSE_V2_CTRL:
+                if(LINK_CTRL_VERSION(byte) == LINK_VERSION_V2) {
+                    s_parser.hdr.ctrl = byte;
+                    s_parser.crc = link_crc16_byte(s_parser.crc, byte);
+                    s_parser.state = PARSE_V2_SEQ;
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+
+                case PARSE_V2_SEQ:
+                s_parser.hdr.seq = byte;
+                s_parser.crc = link_crc16_byte(s_parser.crc, byte);
+                s_parser.state = PARSE_V2_ACK;
+                break;
+
+                case PARSE_V2_ACK:
+                s_parser.hdr.ack = byte;
+                s_parser.crc = link_crc16_byte(s_parser.crc, byte);
+                s_parser.state = PARSE_V2_SACK;
+                break;
+
+                case PARSE_V2_SACK:
+                s_parser.hdr.sack = byte;
+                s_parser.crc = link_crc16_byte(s_parser.crc, byte);
+                s_parser.state = PARSE_V2_FUNCTION_NUM;
+                break;
+
+                case PARSE_V2_FUNCTION_NUM:
+                s_parser.hdr.fn = byte;
+                s_parser.function_num = byte;
+                s_parser.crc = link_crc16_byte(s_parser.crc, byte);
+                s_parser.state = PARSE_V2_LENGTH;
+                break;
+
+                case PARSE_V2_LENGTH:
+                /* 单独的确认帧没有数据；未知功能码的数据帧也要确认，长度交给 CRC 判断 */
+                if((0 == (s_parser.hdr.ctrl & LINK_CTRL_DATA)) ? (0 == byte) :
+                   (!is_valid_function_num(s_parser.function_num) ||
+                    is_valid_data_len(s_parser.function_num, byte))) {
+                    s_parser.hdr.len = byte;
+                    s_parser.data_len = byte;
+                    s_parser.data_count = 0;
+                    s_parser.crc = link_crc16_byte(s_parser.crc, byte);
+                    s_parser.state = (byte > 0) ? PARSE_V2_DATA : PARSE_V2_CRC_LOW;
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+
+                case PARSE_V2_DATA:
+                n = _frame_parser_data_run(span_len - i);
+                crc = s_parser.crc;
+                for(k = 0; k < n; k ++) {
+                    crc = link_crc16_byte(crc, span[i + k]);
+                }
+                s_parser.crc = crc;
+                _frame_parser_data_done(n);
+                i += n - 1;
+                break;
+
+                case PARSE_V2_CRC_LOW:
+                if(byte == (uint8_t)(s_parser.crc & 0xFF)) {
+                    s_parser.state = PARSE_V2_CRC_HIGH;
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+
+                case PARSE_V2_CRC_HIGH:
+                default:
+                if(byte == (uint8_t)(s_parser.crc >> 8)) {
+                    _frame_parser_dispatch();
+                } else {
+                    _frame_parser_resync();
+                    resync = true;
+                }
+                break;
+            }
         }
-        data_handle(offset);
+    }
+    return scanned;
+}
 
-        offset += PROTOCOL_HEAD + rx_value_len + 1;
-    }//end while
+/**
+ * @brief  串口数据处理服务
+ * @param  无
+ * @return 无
+ * @note   在MCU主函数while循环中调用该函数，调用该函数时，不要加上任何判断条件；
+ *         未完成的帧超过 UART_RX_IDLE_MS 没有收到新数据时，说明长度字节出错或帧尾丢失，
+ *         从帧头的下一字节重新同步，不必等后面的帧把错误的长度填满
+ */
+void mcu_uart_service(void)
+{
+    uint32_t now = s_clock();
 
-    process_buf_in -= offset;
-    if(process_buf_in > 0) 
-    {
-        memcpy(  (char *)uart_data_process_buf, 
-                    (const char *)uart_data_process_buf + offset, 
-                    process_buf_in  );
+    while(!_frame_parser_scan()) {
+        if((0 == s_parser.scan) || (now - s_parser.rx_ms < UART_RX_IDLE_MS)) {
+            return;
+        }
+        _frame_parser_resync();
     }
+    s_parser.rx_ms = now;
+}
+
+/**
+ * @brief  主控板的版本握手(FN_PROTO_VERSION)
+ * @param  value 数据内容: 最高版本 + 是否为回复
+ * @param  len 数据内容长度
+ * @return 无
+ */
+static void _proto_version_handle(const uint8_t *value, uint8_t len)
+{
+    link_on_hello(&s_link, value, len);
+}
+
+/**
+ * @brief  主控板对参数配置的回复(FN_UPDT_PRAM_CONFIG)
+ * @param  value 数据内容: 序号 + 结果
+ * @param  len 数据内容长度
+ * @return 无
+ */
+static void _param_config_ack(const uint8_t *value, uint8_t len)
+{
+    param_apply_on_ack(&s_param_apply, value, len, s_clock());
 }
 
 /**
@@ -135,18 +410,204 @@ void mcu_uart_service(void)
  */
 void mcu_uart_protocol_init(void)
 {
-    rx_buf_in = (unsigned char *)uart_rx_buf;
-    rx_buf_out = (unsigned char *)uart_rx_buf;
+    ring_buffer_init(&uart_rx_ring, uart_rx_buf, sizeof(uart_rx_buf));
+    memset(&s_parser, 0, sizeof(s_parser));
+    tx_queue_init(&uart_tx_queue);
+    link_init(&s_link, s_link_max_version);
+    fnum_table_register(FN_PROTO_VERSION, _proto_version_handle, LINK_HELLO_LEN, LINK_HELLO_LEN);
+    param_apply_init(&s_param_apply);
+    fnum_table_register(FN_UPDT_PRAM_CONFIG, _param_config_ack, PARAM_APPLY_ACK_LEN, PARAM_APPLY_ACK_LEN);
+}
+
+/**
+ * @brief  注册主控板上报功能码的处理函数
+ * @param  fnum 功能码
+ * @param  handler 处理函数，NULL 表示注销该功能码
+ * @param  min_len 数据内容最小长度
+ * @param  max_len 数据内容最大长度
+ * @return 是否注册成功
+ * @note   在串口任务启动之前调用
+ */
+bool mcu_fnum_handler_register(uint8_t fnum, fnum_handler_t handler, uint8_t min_len, uint8_t max_len)
+{
+    return fnum_table_register(fnum, handler, min_len, max_len);
+}
+
+/**
+ * @brief  注册串口整帧发送后端
+ * @param  backend 发送函数，NULL 时恢复默认的 uart_transmit_output
+ * @return 无
+ * @note   在串口任务启动之前调用
+ */
+void mcu_uart_tx_backend_register(uart_tx_backend_t backend)
+{
+    s_tx_backend = (NULL != backend) ? backend : uart_transmit_output;
+}
+
+/**
+ * @brief  注册串口时钟(用于 v2 链路的握手间隔和超时重发)
+ * @param  clock 毫秒时钟，NULL 时恢复默认的 uart_clock_ms
+ * @return 无
+ * @note   在串口任务启动之前调用
+ */
+void mcu_uart_clock_register(uart_clock_t clock)
+{
+    s_clock = (NULL != clock) ? clock : uart_clock_ms;
+}
+
+/**
+ * @brief  启用串口收发记录
+ * @param  buf 存储区(可以在 PSRAM 中)，NULL 表示不记录
+ * @param  size 存储区大小，必须为2的幂且不小于 CAPTURE_MIN_SIZE
+ * @param  clock 微秒时钟，NULL 时使用默认的 uart_clock_us
+ * @return 是否启用
+ * @note   在串口任务启动之前调用；记录 uart_receive_buff_input 收到的数据块和发送后端的每一帧，
+ *         写满后覆盖最早的记录
+ */
+bool mcu_uart_capture_init(uint8_t *buf, uint32_t size, capture_clock_t clock)
+{
+    return capture_init(&uart_capture, buf, size, (NULL != clock) ? clock : uart_clock_us);
+}
+
+/**
+ * @brief  设置本端支持的最高协议版本
+ * @param  version LINK_VERSION_V1 表示只用 v1 帧，LINK_VERSION_V2 表示握手后使用 v2 帧
+ * @return 无
+ * @note   在 mcu_uart_protocol_init 之前调用，默认为 LINK_VERSION_V1(现有主控板固件只支持 v1)；
+ *         启用 v2 时握手期间数据帧仍用 v1 发送，对端回复握手后才切换
+ */
+void mcu_uart_link_max_version_set(uint8_t version)
+{
+    s_link_max_version = version;
+}
+
+/**
+ * @brief  获取当前使用的协议版本
+ * @param  无
+ * @return LINK_VERSION_V1 或 LINK_VERSION_V2
+ */
+uint8_t mcu_uart_link_version(void)
+{
+    return s_link.version;
+}
+
+/**
+ * @brief  获取链路统计
+ * @param  stats 输出
+ * @return 无
+ * @note   统计只由串口任务写入，其它任务读到的各项可能不是同一时刻的
+ */
+void mcu_uart_link_stats_get(link_stats_t *stats)
+{
+    *stats = s_link.stats;
 }
 
-void mcu_fnum_data_update(uint8_t fnum, uint8_t value[], uint8_t len)
+/**
+ * @brief  向主控板发送一帧数据(非阻塞)
+ * @param  fnum 功能码
+ * @param  value 数据内容
+ * @param  len 数据内容长度
+ * @return 是否成功放入发送队列，队列已满时返回 false
+ * @note   任意任务都可以调用，只在自己申请的帧槽中组帧后立即返回，
+ *         实际发送由 mcu_uart_tx_service 完成
+ */
+bool mcu_fnum_data_update(uint8_t fnum, const uint8_t value[], uint8_t len)
+{
+    tx_slot_t *slot;
+    uint32_t ticket;
+
+    slot = tx_queue_claim(&uart_tx_queue, &ticket);
+    if(NULL == slot) {
+        return false;
+    }
+    slot->len = uart_frame_pack(slot->frame, fnum, value, len);
+    tx_queue_commit(&uart_tx_queue, slot, ticket);
+    return true;
+}
+
+/**
+ * @brief  向主控板下发参数配置(非阻塞)
+ * @param  config 完整的新配置(调用者已校验)
+ * @param  done 完成回调，在串口任务中调用
+ * @param  ctx 交给完成回调的参数
+ * @return PARAM_APPLY_STARTED 时结果通过 done 通知，其他返回值不会调用 done
+ * @note   任意任务都可以调用；只下发与 g_param_config 不同的字段，
+ *         主控板确认后才发布到 g_param_config，超时时间为 PARAM_APPLY_TIMEOUT_MS
+ */
+param_apply_start_t mcu_param_config_apply(const param_config_t *config, param_apply_done_t done, void *ctx)
 {
-    /* 添加功能码 */
-    set_uart_frame_function_num(fnum);
-    /* 添加数据 */
-    write_uart_fram_data_buff(value, len);
-    /* 添加所有数据帧通用的部分 */
-    wifi_uart_write_frame(len);
+    uint8_t frame[PARAM_APPLY_FRAME_MAX_LEN];
+    uint8_t len;
+    param_apply_start_t ret;
+
+    ret = param_apply_begin(&s_param_apply, config, s_clock(), done, ctx, frame, &len);
+    if(PARAM_APPLY_STARTED != ret) {
+        return ret;
+    }
+    if(!mcu_fnum_data_update(FN_UPDT_PRAM_CONFIG, frame, len)) {
+        param_apply_cancel(&s_param_apply);
+        return PARAM_APPLY_TX_FULL;
+    }
+    return PARAM_APPLY_STARTED;
 }
 
+/**
+ * @brief  获取参数配置下发的统计
+ * @param  applied 输出: 主控板确认的次数
+ * @param  rejected 输出: 主控板拒绝的次数
+ * @param  timeouts 输出: 超时的次数
+ * @return 无
+ */
+void mcu_param_config_stats_get(uint32_t *applied, uint32_t *rejected, uint32_t *timeouts)
+{
+    *applied = s_param_apply.applied;
+    *rejected = s_param_apply.rejected;
+    *timeouts = s_param_apply.timeouts;
+}
 
+/**
+ * @brief  发送一整帧并记入收发记录
+ * @param  buf 帧数据
+ * @param  len 帧长度
+ * @return 无
+ */
+static void _uart_tx_output(const uint8_t *buf, uint16_t len)
+{
+    capture_record(&uart_capture, CAPTURE_DIR_TX, buf, len);
+    s_tx_backend(buf, len);
+}
+
+/**
+ * @brief  串口发送服务
+ * @param  无
+ * @return 无
+ * @note   只能在一个任务中调用(通常与 mcu_uart_service 在同一任务)，
+ *         按入队顺序把整帧交给发送后端；v2 链路发送窗口已满时帧留在队列中，
+ *         同时处理握手、超时重发、单独的确认帧和参数配置下发的超时
+ */
+void mcu_uart_tx_service(void)
+{
+    tx_slot_t *slot;
+    uint32_t now = s_clock();
+
+    link_poll(&s_link, now, _uart_tx_output);
+    param_apply_poll(&s_param_apply, now);
+    while(NULL != (slot = tx_queue_front(&uart_tx_queue)))
+    {
+        if(!link_send(&s_link, slot->frame, slot->len, now, _uart_tx_output)) {
+            break;
+        }
+        tx_queue_pop(&uart_tx_queue);
+    }
+    link_flush_ack(&s_link, _uart_tx_output);
+}
+
+/**
+ * @brief  获取发送队列已满而丢弃的累计帧数
+ * @param  无
+ * @return 丢弃的帧数
+ */
+uint32_t uart_tx_dropped_count(void)
+{
+    return tx_queue_dropped(&uart_tx_queue);
+}
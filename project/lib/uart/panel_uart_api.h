@@ -10,15 +10,29 @@
 #include <stdint.h>
 #include "system.h"
 #include "protocol.h"
+#include "link.h"
+#include "param_apply.h"
 
 /* public function protypes ------------------------------------------------- */
 
 /* APP interface */
 void mcu_uart_protocol_init(void);
 void mcu_uart_service(void);
-void mcu_fnum_data_update(uint8_t fnum, uint8_t value[], uint8_t len);
+void mcu_uart_tx_service(void);
+void mcu_uart_tx_backend_register(uart_tx_backend_t backend);
+void mcu_uart_clock_register(uart_clock_t clock);
+bool mcu_uart_capture_init(uint8_t *buf, uint32_t size, capture_clock_t clock);
+void mcu_uart_link_max_version_set(uint8_t version);
+uint8_t mcu_uart_link_version(void);
+void mcu_uart_link_stats_get(link_stats_t *stats);
+bool mcu_fnum_data_update(uint8_t fnum, const uint8_t value[], uint8_t len);
+bool mcu_fnum_handler_register(uint8_t fnum, fnum_handler_t handler, uint8_t min_len, uint8_t max_len);
+param_apply_start_t mcu_param_config_apply(const param_config_t *config, param_apply_done_t done, void *ctx);
+void mcu_param_config_stats_get(uint32_t *applied, uint32_t *rejected, uint32_t *timeouts);
 /* Driver interface */
 void uart_receive_buff_input(uint8_t value[], unsigned short data_len);
 void uart_receive_input(uint8_t value);
+uint32_t uart_rx_overflow_count(void);
+uint32_t uart_tx_dropped_count(void);
 
 #endif /* __MAIN_BOARD_API_H__ */
@@ -0,0 +1,144 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "param_apply.h"
+
+/* 下发状态: 开始下发的任务负责 空闲->准备->等待，串口任务负责 等待->完成中->空闲 */
+#define PARAM_APPLY_STATE_IDLE          0
+#define PARAM_APPLY_STATE_ARMING        1               // 正在填写下发内容
+#define PARAM_APPLY_STATE_PENDING       2               // 已放入发送队列，等待回复
+#define PARAM_APPLY_STATE_COMPLETING    3               // 正在调用完成回调
+
+/**
+ * @brief  初始化下发状态
+ * @param  pa 下发状态
+ * @return 无
+ */
+void param_apply_init(param_apply_t *pa)
+{
+    memset(pa, 0, sizeof(*pa));
+    atomic_init(&pa->state, PARAM_APPLY_STATE_IDLE);
+}
+
+/**
+ * @brief  开始下发参数配置
+ * @param  pa 下发状态
+ * @param  config 完整的新配置(已校验)
+ * @param  now 当前时间(毫秒)
+ * @param  done 完成回调
+ * @param  ctx 交给完成回调的参数
+ * @param  frame 输出: 需要发送的数据内容，至少 PARAM_APPLY_FRAME_MAX_LEN 字节
+ * @param  len 输出: 数据内容长度
+ * @return 返回 PARAM_APPLY_STARTED 时调用者必须发送 frame，发送失败时调用 param_apply_cancel
+ * @note   可以在任意任务中调用；与 g_param_config 比较，只下发变化的字段
+ */
+param_apply_start_t param_apply_begin(param_apply_t *pa, const param_config_t *config, uint32_t now,
+                                      param_apply_done_t done, void *ctx, uint8_t *frame, uint8_t *len)
+{
+    param_config_t cur;
+    unsigned int idle = PARAM_APPLY_STATE_IDLE;
+    uint8_t n;
+
+    param_config_read(&cur);
+    n = param_config_delta_encode(config, &cur, frame + 1, PARAM_APPLY_FRAME_MAX_LEN - 1);
+    if(0 == n) {
+        return PARAM_APPLY_UNCHANGED;
+    }
+    if(!atomic_compare_exchange_strong(&pa->state, &idle, PARAM_APPLY_STATE_ARMING)) {
+        return PARAM_APPLY_BUSY;
+    }
+
+    pa->seq ++;
+    pa->config = *config;
+    pa->start_ms = now;
+    pa->done = done;
+    pa->ctx = ctx;
+    frame[0] = pa->seq;
+    *len = n + 1;
+    /* 先进入等待状态再发送，回复不会早于状态可见 */
+    atomic_store_explicit(&pa->state, PARAM_APPLY_STATE_PENDING, memory_order_release);
+    return PARAM_APPLY_STARTED;
+}
+
+/**
+ * @brief  撤销刚开始的下发(放入发送队列失败)
+ * @param  pa 下发状态
+ * @return 无
+ * @note   不调用完成回调；串口任务已经判定超时的情况下什么也不做
+ */
+void param_apply_cancel(param_apply_t *pa)
+{
+    unsigned int pending = PARAM_APPLY_STATE_PENDING;
+
+    atomic_compare_exchange_strong(&pa->state, &pending, PARAM_APPLY_STATE_IDLE);
+}
+
+/**
+ * @brief  结束当前下发并通知
+ * @param  pa 下发状态
+ * @param  result 最终结果
+ * @param  status 主控板回复的结果
+ * @param  now 当前时间(毫秒)
+ * @return 无
+ */
+static void _param_apply_finish(param_apply_t *pa, param_apply_result_t result, uint8_t status, uint32_t now)
+{
+    unsigned int pending = PARAM_APPLY_STATE_PENDING;
+
+    if(!atomic_compare_exchange_strong_explicit(&pa->state, &pending, PARAM_APPLY_STATE_COMPLETING,
+                                                memory_order_acquire, memory_order_relaxed)) {
+        return;
+    }
+
+    if(PARAM_APPLY_DONE_OK == result) {
+        param_config_publish(&pa->config);
+        pa->applied ++;
+    } else if(PARAM_APPLY_DONE_REJECTED == result) {
+        pa->rejected ++;
+    } else {
+        pa->timeouts ++;
+    }
+    if(NULL != pa->done) {
+        pa->done(pa->ctx, result, status, now - pa->start_ms);
+    }
+    atomic_store_explicit(&pa->state, PARAM_APPLY_STATE_IDLE, memory_order_release);
+}
+
+/**
+ * @brief  处理主控板的回复
+ * @param  pa 下发状态
+ * @param  value 数据内容: 序号 + 结果
+ * @param  len 数据内容长度，PARAM_APPLY_ACK_LEN
+ * @param  now 当前时间(毫秒)
+ * @return 无
+ * @note   在串口任务中调用；序号不一致(超时之后才到的回复)的直接丢弃
+ */
+void param_apply_on_ack(param_apply_t *pa, const uint8_t *value, uint8_t len, uint32_t now)
+{
+    if((len < PARAM_APPLY_ACK_LEN) ||
+       (atomic_load_explicit(&pa->state, memory_order_acquire) != PARAM_APPLY_STATE_PENDING) ||
+       (value[0] != pa->seq)) {
+        return;
+    }
+    _param_apply_finish(pa, (PARAM_APPLY_STATUS_OK == value[1]) ? PARAM_APPLY_DONE_OK : PARAM_APPLY_DONE_REJECTED,
+                        value[1], now);
+}
+
+/**
+ * @brief  检查下发是否超时
+ * @param  pa 下发状态
+ * @param  now 当前时间(毫秒)
+ * @return 无
+ * @note   在串口任务中周期调用
+ */
+void param_apply_poll(param_apply_t *pa, uint32_t now)
+{
+    if((atomic_load_explicit(&pa->state, memory_order_acquire) == PARAM_APPLY_STATE_PENDING) &&
+       (now - pa->start_ms >= PARAM_APPLY_TIMEOUT_MS)) {
+        _param_apply_finish(pa, PARAM_APPLY_DONE_TIMEOUT, PARAM_APPLY_STATUS_OK, now);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __PARAM_APPLY_H__
+#define __PARAM_APPLY_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "system.h"
+#include "wire_codec.h"
+
+/*
+ * 参数配置下发(FN_UPDT_PRAM_CONFIG):
+ *
+ *   面板 -> 主控板: 序号1 + 变化字段的记录(格式同增量帧，见 wire_codec.h)
+ *   主控板 -> 面板: 序号1 + 结果1(PARAM_APPLY_STATUS_OK 表示已应用，其他为拒绝原因)
+ *
+ * 同一时刻只有一次下发在等待回复；收到序号一致的回复或超时后结束，
+ * 主控板确认应用后才发布到 g_param_config
+ */
+#define PARAM_APPLY_TIMEOUT_MS          2000            // 等待主控板回复的时间(覆盖 v2 链路的多次重发)
+#define PARAM_APPLY_ACK_LEN             2               // 序号1 + 结果1
+#define PARAM_APPLY_FRAME_MAX_LEN       (1 + PARAM_CONFIG_DELTA_MAX_LEN)
+#define PARAM_APPLY_STATUS_OK           0x00
+
+/**
+ * @brief   开始下发的结果
+ */
+typedef enum{
+    PARAM_APPLY_STARTED = 0,        // 已开始，结果通过完成回调通知
+    PARAM_APPLY_UNCHANGED,          // 与当前配置相同，不需要下发
+    PARAM_APPLY_BUSY,               // 上一次下发还在等待回复
+    PARAM_APPLY_TX_FULL,            // 发送队列已满
+}param_apply_start_t;
+
+/**
+ * @brief   下发的最终结果
+ */
+typedef enum{
+    PARAM_APPLY_DONE_OK = 0,        // 主控板已应用，配置已发布
+    PARAM_APPLY_DONE_REJECTED,      // 主控板拒绝
+    PARAM_APPLY_DONE_TIMEOUT,       // 超时没有回复
+}param_apply_result_t;
+
+/**
+ * @brief   下发完成回调
+ * @param   ctx 开始下发时传入的参数
+ * @param   result 最终结果
+ * @param   status 主控板回复的结果(超时时为 PARAM_APPLY_STATUS_OK)
+ * @param   latency_ms 从开始下发到收到回复(或超时)的时间
+ * @note    在串口任务中调用，不能阻塞；回调返回后才能开始下一次下发
+ */
+typedef void (*param_apply_done_t)(void *ctx, param_apply_result_t result, uint8_t status, uint32_t latency_ms);
+
+/**
+ * @brief   下发状态(开始下发的任务与串口任务之间只通过 state 交接)
+ */
+typedef struct param_apply{
+    atomic_uint state;              // PARAM_APPLY_STATE_xxx
+    uint8_t seq;                    // 当前下发的序号
+    param_config_t config;          // 下发的完整配置，确认后发布
+    uint32_t start_ms;              // 开始下发的时间
+    param_apply_done_t done;
+    void *ctx;
+    uint32_t applied;               // 统计: 主控板确认的次数
+    uint32_t rejected;              // 统计: 主控板拒绝的次数
+    uint32_t timeouts;              // 统计: 超时的次数
+}param_apply_t;
+
+/* public function protypes ------------------------------------------------- */
+void param_apply_init(param_apply_t *pa);
+param_apply_start_t param_apply_begin(param_apply_t *pa, const param_config_t *config, uint32_t now,
+                                      param_apply_done_t done, void *ctx, uint8_t *frame, uint8_t *len);
+void param_apply_cancel(param_apply_t *pa);
+void param_apply_on_ack(param_apply_t *pa, const uint8_t *value, uint8_t len, uint32_t now);
+void param_apply_poll(param_apply_t *pa, uint32_t now);
+
+#endif /* __PARAM_APPLY_H__ */
@@ -3,19 +3,91 @@
  * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
  */
 
+#ifndef ESP_PLATFORM
+#define _POSIX_C_SOURCE 199309L        // clock_gettime
+#endif
 #include "protocol.h"
 
+#ifndef ESP_PLATFORM
+#include <time.h>
+#include <unistd.h>
+
+/* 非ESP平台(Linux主机)下的发送目标，可以是 pty、socketpair 或管道 */
+static int s_host_tx_fd = -1;
+
 /**
- * @brief  串口发送数据
- * @param[in] {value} 串口要发送的1字节数据
+ * @brief  设置主机构建时的串口发送目标
+ * @param[in] {fd} 已打开的文件描述符，-1 表示丢弃发送数据
  * @return Null
  */
-void uart_transmit_output(uint8_t value)
+void uart_transmit_set_fd(int fd)
 {
+    s_host_tx_fd = fd;
+}
+#endif
+
+/**
+ * @brief  串口发送一整帧数据(默认发送后端)
+ * @param[in] {buf} 帧数据
+ * @param[in] {len} 帧长度
+ * @return Null
+ * @note   也可以通过 mcu_uart_tx_backend_register 注册其它发送后端
+ */
+void uart_transmit_output(const uint8_t *buf, uint16_t len)
+{
+#ifndef ESP_PLATFORM
+    ssize_t ret;
+
+    while((s_host_tx_fd >= 0) && (len > 0)) {
+        ret = write(s_host_tx_fd, buf, len);
+        if(ret <= 0) {
+            break;
+        }
+        buf += ret;
+        len -= (uint16_t)ret;
+    }
+#endif
     //#error "请将MCU串口发送函数填入该函数,并删除该行"
 /*
     //Example:
-    extern void Uart_PutChar(unsigned char value);
-    Uart_PutChar(value);	                                //串口发送函数
+    extern void Uart_Write(const unsigned char *buf, unsigned short len);
+    Uart_Write(buf, len);	                                //串口整块发送函数(DMA/FIFO)
 */
 }
+
+/**
+ * @brief  串口时钟(默认时钟)
+ * @param  Null
+ * @return 毫秒数
+ * @note   主机构建使用单调时钟；MCU 上通过 mcu_uart_clock_register 注册系统节拍，
+ *         没有注册时返回 0，v2 链路只能靠 NAK 重发
+ */
+uint32_t uart_clock_ms(void)
+{
+#ifndef ESP_PLATFORM
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief  串口微秒时钟(默认时钟)
+ * @param  Null
+ * @return 微秒数
+ * @note   用于收发记录的时间戳；MCU 上通过 mcu_uart_capture_init 传入系统时钟，没有时返回 0
+ */
+uint64_t uart_clock_us(void)
+{
+#ifndef ESP_PLATFORM
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#else
+    return 0;
+#endif
+}
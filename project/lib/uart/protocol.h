@@ -10,7 +10,25 @@
 #include <stdint.h>
 #include "system.h"
 
+/**
+ * @brief   串口整帧发送后端
+ * @param   buf 帧数据
+ * @param   len 帧长度
+ */
+typedef void (*uart_tx_backend_t)(const uint8_t *buf, uint16_t len);
+
+/**
+ * @brief   串口时钟，用于重发超时
+ * @return  毫秒数(允许回绕)
+ */
+typedef uint32_t (*uart_clock_t)(void);
+
 /* public function protypes ------------------------------------------------- */
-void uart_transmit_output(uint8_t value);
+void uart_transmit_output(const uint8_t *buf, uint16_t len);
+uint32_t uart_clock_ms(void);
+uint64_t uart_clock_us(void);
+#ifndef ESP_PLATFORM
+void uart_transmit_set_fd(int fd);
+#endif
 
 #endif /* __PROTOCOL_H__ */
@@ -0,0 +1,177 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "ring_buffer.h"
+
+/**
+ * @brief  初始化环形缓冲区
+ * @param  rb   缓冲区句柄
+ * @param  buf  数据存储区
+ * @param  size 存储区大小，必须为2的幂
+ * @return 是否初始化成功
+ */
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *buf, uint32_t size)
+{
+    if((NULL == rb) || (NULL == buf) || (0 == size) || (size & (size - 1))) {
+        return false;
+    }
+
+    rb->buf = buf;
+    rb->mask = size - 1;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    atomic_init(&rb->overflow, 0);
+    return true;
+}
+
+/**
+ * @brief  写入数据(仅生产者调用)
+ * @param  rb   缓冲区句柄
+ * @param  src  数据源地址
+ * @param  len  数据长度
+ * @return 实际写入的字节数，放不下的部分计入溢出计数
+ * @note   最多分两段连续的 memcpy 完成，不逐字节搬运
+ */
+uint32_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *src, uint32_t len)
+{
+    uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    uint32_t space = (rb->mask + 1) - (head - tail);
+    uint32_t pos = head & rb->mask;
+    uint32_t first;
+
+    if(len > space) {
+        //!!! 串口接收缓存已满，处理速度跟不上接收，需要考虑扩大rx_buffer
+        atomic_fetch_add_explicit(&rb->overflow, len - space, memory_order_relaxed);
+        len = space;
+    }
+    if(0 == len) {
+        return 0;
+    }
+
+    first = (rb->mask + 1) - pos;
+    if(first > len) {
+        first = len;
+    }
+    memcpy(rb->buf + pos, src, first);
+    memcpy(rb->buf, src + first, len - first);
+
+    /* 数据写完后再发布 head，保证消费者看到的数据是完整的 */
+    atomic_store_explicit(&rb->head, head + len, memory_order_release);
+    return len;
+}
+
+/**
+ * @brief  读出数据(仅消费者调用)
+ * @param  rb   缓冲区句柄
+ * @param  dest 目标地址
+ * @param  len  最多读出的字节数
+ * @return 实际读出的字节数
+ */
+uint32_t ring_buffer_read(ring_buffer_t *rb, uint8_t *dest, uint32_t len)
+{
+    len = ring_buffer_peek(rb, 0, dest, len);
+    /* 数据读完后再释放空间，防止生产者覆盖尚未读出的数据 */
+    ring_buffer_skip(rb, len);
+    return len;
+}
+
+/**
+ * @brief  从读指针后 offset 处拷贝数据，但不移动读指针(仅消费者调用)
+ * @param  rb     缓冲区句柄
+ * @param  offset 相对读指针的偏移
+ * @param  dest   目标地址
+ * @param  len    最多拷贝的字节数
+ * @return 实际拷贝的字节数
+ */
+uint32_t ring_buffer_peek(ring_buffer_t *rb, uint32_t offset, uint8_t *dest, uint32_t len)
+{
+    uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    uint32_t used = head - tail;
+    uint32_t pos = (tail + offset) & rb->mask;
+    uint32_t first;
+
+    if(offset >= used) {
+        return 0;
+    }
+    if(len > used - offset) {
+        len = used - offset;
+    }
+
+    first = (rb->mask + 1) - pos;
+    if(first > len) {
+        first = len;
+    }
+    memcpy(dest, rb->buf + pos, first);
+    memcpy(dest + first, rb->buf, len - first);
+    return len;
+}
+
+/**
+ * @brief  获取读指针后 offset 处开始的一段连续可读数据(仅消费者调用)
+ * @param  rb     缓冲区句柄
+ * @param  offset 相对读指针的偏移
+ * @param  span   输出连续数据段的起始地址，直接指向缓冲区内部，不发生拷贝
+ * @return 连续数据段的长度，0 表示没有更多数据
+ * @note   返回的数据段在调用 ring_buffer_skip 越过它之前一直有效
+ */
+uint32_t ring_buffer_span(ring_buffer_t *rb, uint32_t offset, const uint8_t **span)
+{
+    uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    uint32_t used = head - tail;
+    uint32_t pos = (tail + offset) & rb->mask;
+    uint32_t len;
+
+    if(offset >= used) {
+        return 0;
+    }
+
+    len = used - offset;
+    if(len > (rb->mask + 1) - pos) {
+        len = (rb->mask + 1) - pos;
+    }
+    *span = rb->buf + pos;
+    return len;
+}
+
+/**
+ * @brief  丢弃已处理的数据，释放空间给生产者(仅消费者调用)
+ * @param  rb  缓冲区句柄
+ * @param  len 丢弃的字节数，不能超过待读取的字节数
+ * @return 无
+ */
+void ring_buffer_skip(ring_buffer_t *rb, uint32_t len)
+{
+    uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&rb->tail, tail + len, memory_order_release);
+}
+
+/**
+ * @brief  获取缓冲区中待读取的字节数(消费者视角)
+ * @param  rb 缓冲区句柄
+ * @return 待读取的字节数
+ */
+uint32_t ring_buffer_used(ring_buffer_t *rb)
+{
+    uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+/**
+ * @brief  获取因缓冲区满而丢弃的累计字节数
+ * @param  rb 缓冲区句柄
+ * @return 丢弃的字节数
+ */
+uint32_t ring_buffer_overflow_count(ring_buffer_t *rb)
+{
+    return atomic_load_explicit(&rb->overflow, memory_order_relaxed);
+}
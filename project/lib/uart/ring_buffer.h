@@ -0,0 +1,37 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/**
+ * @brief   单生产者/单消费者无锁环形缓冲区
+ * @note    head/tail 为自由递增的索引，取模由 mask 完成，因此容量必须为2的幂；
+ *          head 只由生产者写，tail 只由消费者写，两端通过 acquire/release 同步
+ */
+typedef struct ring_buffer{
+    uint8_t *buf;                   // 数据存储区
+    uint32_t mask;                  // 容量-1
+    atomic_uint head;               // 写索引(生产者)
+    atomic_uint tail;               // 读索引(消费者)
+    atomic_uint overflow;           // 缓冲区满时被丢弃的字节数
+}ring_buffer_t;
+
+/* public function protypes ------------------------------------------------- */
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *buf, uint32_t size);
+uint32_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *src, uint32_t len);
+uint32_t ring_buffer_read(ring_buffer_t *rb, uint8_t *dest, uint32_t len);
+uint32_t ring_buffer_peek(ring_buffer_t *rb, uint32_t offset, uint8_t *dest, uint32_t len);
+uint32_t ring_buffer_span(ring_buffer_t *rb, uint32_t offset, const uint8_t **span);
+void ring_buffer_skip(ring_buffer_t *rb, uint32_t len);
+uint32_t ring_buffer_used(ring_buffer_t *rb);
+uint32_t ring_buffer_overflow_count(ring_buffer_t *rb);
+
+#endif /* __RING_BUFFER_H__ */
@@ -0,0 +1,59 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "snapshot.h"
+
+/**
+ * @brief  发布一份新数据(同一快照只允许一个写者)
+ * @param  snap 快照句柄
+ * @param  data 新数据，大小为 snap->size
+ * @return 无
+ */
+void snapshot_publish(snapshot_t *snap, const void *data)
+{
+    uint32_t seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    uint8_t *slot = (uint8_t *)snap->slots + (((seq >> 1) + 1) & 1) * snap->size;
+
+    /* 这份缓冲是上上次发布的数据，读者可能正在读；开始写入的标记必须先于改写可见，
+     * 读者才能在核对序号时发现数据被改写(弱内存序的多核上写操作可能被重排) */
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(slot, data, snap->size);
+    /* 数据写完后再发布，读者看到新序号时必然看到完整数据 */
+    atomic_store_explicit(&snap->seq, seq + 2, memory_order_release);
+}
+
+/**
+ * @brief  读取一份内部一致的数据副本
+ * @param  snap 快照句柄
+ * @param  out 输出缓冲，大小为 snap->size
+ * @return 读到的数据版本号
+ * @note   读的是第 n 次发布的缓冲，只有第 n + 2 次发布开始写入时才会改写它；
+ *         读取期间写者只发布了一次(写的是另一份缓冲)时读到的数据仍然完整，不重读
+ */
+uint32_t snapshot_read(snapshot_t *snap, void *out)
+{
+    uint32_t seq;
+
+    do {
+        seq = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        memcpy(out, (const uint8_t *)snap->slots + ((seq >> 1) & 1) * snap->size, snap->size);
+        atomic_thread_fence(memory_order_acquire);
+    } while(atomic_load_explicit(&snap->seq, memory_order_relaxed) - (seq & ~1u) > 2);
+
+    return seq >> 1;
+}
+
+/**
+ * @brief  获取当前数据版本号，可用于判断数据是否有更新
+ * @param  snap 快照句柄
+ * @return 版本号
+ */
+uint32_t snapshot_version(snapshot_t *snap)
+{
+    return atomic_load_explicit(&snap->seq, memory_order_acquire) >> 1;
+}
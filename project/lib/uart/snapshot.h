@@ -0,0 +1,34 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/**
+ * @brief   双缓冲快照(单写者/多读者)
+ * @note    写者总是写入非当前的那一份缓冲: 开始写入时序号加1(奇数)，写完后再加1(偶数)发布；
+ *          读者读取当前缓冲，读完再核对序号，只有期间写者又开始了第二次发布(改写正在读的这份缓冲)
+ *          才重读，期间只发布了一次不必重读。读者从不等待写者，写者被抢占也不会阻塞读者
+ */
+typedef struct snapshot{
+    atomic_uint seq;                // 发布次数 x2，写入期间为奇数；当前数据位于 slots[(seq >> 1) & 1]
+    void *slots;                    // 两份缓冲，每份 size 字节
+    size_t size;                    // 单份数据大小
+}snapshot_t;
+
+/* 静态定义快照，slots 为两个元素的数组，slots[0] 为初始值 */
+#define SNAPSHOT_INITIALIZER(slots)     { 0, (slots), sizeof((slots)[0]) }
+
+/* public function protypes ------------------------------------------------- */
+void snapshot_publish(snapshot_t *snap, const void *data);
+uint32_t snapshot_read(snapshot_t *snap, void *out);
+uint32_t snapshot_version(snapshot_t *snap);
+
+#endif /* __SNAPSHOT_H__ */
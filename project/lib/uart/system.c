@@ -6,6 +6,7 @@
 /* include ------------------------------------------------------------------ */
 #include "system.h"
 #include "panel_uart_api.h"
+#include "wire_codec.h"
 
 #define DEFAULT_VALUE_RUNNING_INFO()                \
 {                                                   \
@@ -26,118 +27,181 @@
 }
 
 /* 串口数据处理缓冲区 */
-volatile uint8_t uart_data_process_buf[PROTOCOL_HEAD+UART_PROCESS_BUFF_LEN];
+uint8_t uart_data_process_buf[UART_PROCESS_BUFF_LEN];
 /* 串口接收数据缓冲区 */
-volatile uint8_t uart_rx_buf[PROTOCOL_HEAD+UART_RX_BUFF_LEN];   
-/* 串口发送数据缓冲区 */      
-volatile uint8_t uart_tx_buf[PROTOCOL_HEAD+UART_TX_BUFF_LEN];        
+uint8_t uart_rx_buf[UART_RX_BUFF_LEN];
+/* 串口接收环形队列 */
+ring_buffer_t uart_rx_ring;
+/* 串口发送帧队列 */
+tx_queue_t uart_tx_queue;
+/* 串口收发记录(没有调用 mcu_uart_capture_init 时不记录) */
+capture_t uart_capture;
 
-volatile uint8_t *rx_buf_in;
-volatile uint8_t *rx_buf_out;
+static running_info_t s_running_info_slots[2] = { DEFAULT_VALUE_RUNNING_INFO() };
+static param_config_t s_param_config_slots[2] = { DEFAULT_VALUE_PARAM_CONFIG() };
 
-volatile running_info_t g_running_info = DEFAULT_VALUE_RUNNING_INFO();
-volatile param_config_t g_param_config = DEFAULT_VALUE_PARAM_CONFIG();
+snapshot_t g_running_info = SNAPSHOT_INITIALIZER(s_running_info_slots);
+snapshot_t g_param_config = SNAPSHOT_INITIALIZER(s_param_config_slots);
+
+/* 串口任务的工作副本，增量帧直接在上面修改后发布 */
+static running_info_t s_running_info = DEFAULT_VALUE_RUNNING_INFO();
+/* 各字段最近一次变化时发布的版本号 */
+static atomic_uint s_running_info_field_version[RUN_INFO_FIELD_COUNT];
+
+/* 实时运行参数更新通知，NULL 表示没有 */
+static running_info_listener_t s_running_info_listener = NULL;
 
 /* private function protypes -------------------------------------------------*/
-static void _uart_write_data(uint8_t *in, unsigned short len);
-static void _update_all(void *value);
+static void _update_all(const uint8_t *value, uint8_t len);
+static void _update_delta(const uint8_t *value, uint8_t len);
+
+/* 功能码表，解析和分发都只做一次下标查表 */
+static fnum_entry_t s_fnum_table[256] = 
+{
+    [FN_UPDT_RUN_INFO_ALL]   = { _update_all, RUNNING_INFO_WIRE_LEN, RUNNING_INFO_WIRE_LEN },
+    /* 增量帧只限制到帧的最大长度，新版主控板追加的字段由 running_info_delta_apply 跳过 */
+    [FN_UPDT_RUN_INFO_DELTA] = { _update_delta, 1, UART_MAX_DATA_LEN },
+};
 
 /**
- * @brief  判断串口接收缓存中是否有数据
- * @param  Null
- * @return 是否有数据
+ * @brief  读取一份内部一致的实时运行参数
+ * @param  info 输出的实时运行参数
+ * @return 数据版本号
+ * @note   可在任意任务中调用，不会被串口任务的更新打断而读到新旧混合的数据
  */
-bool with_data_rxbuff(void)
+uint32_t running_info_read(running_info_t *info)
 {
-    if(rx_buf_in != rx_buf_out)
-        return true;
-    else
-        return false;
+    return snapshot_read(&g_running_info, info);
 }
 
 /**
- * @brief  读取队列1字节数据
+ * @brief  发布新的实时运行参数
+ * @param  info 实时运行参数
+ * @param  dirty 与上一次发布相比变化的字段(RUN_INFO_FIELD_BIT 位图)
+ * @return 无
+ * @note   只能由串口任务调用；字段版本号先于数据发布，读者看到新数据时必然看到对应的字段版本号
+ */
+void running_info_publish(const running_info_t *info, uint32_t dirty)
+{
+    uint32_t version = snapshot_version(&g_running_info) + 1;
+
+    for(uint8_t i = 0; i < RUN_INFO_FIELD_COUNT; i ++) {
+        if(dirty & RUN_INFO_FIELD_BIT(i)) {
+            atomic_store_explicit(&s_running_info_field_version[i], version, memory_order_relaxed);
+        }
+    }
+    snapshot_publish(&g_running_info, info);
+}
+
+/**
+ * @brief  获取实时运行参数的版本号，每次发布加1
  * @param  Null
- * @return Read the data
+ * @return 版本号
  */
-uint8_t take_byte_rxbuff(void)
+uint32_t running_info_version(void)
 {
-    uint8_t value = 0;
-    
-    if(rx_buf_out != rx_buf_in) {
-        //有数据
-        if(rx_buf_out >= (uint8_t *)(uart_rx_buf + sizeof(uart_rx_buf))) {
-            //数据已经到末尾
-            rx_buf_out = (uint8_t *)(uart_rx_buf);
+    return snapshot_version(&g_running_info);
+}
+
+/**
+ * @brief  查询某个版本之后变化过的字段
+ * @param  since 调用者上次处理的版本号(running_info_read 的返回值)
+ * @return 变化过的字段(RUN_INFO_FIELD_BIT 位图)，0 表示数据有更新但所有字段都没有变化
+ * @note   可在任意任务中调用；先读数据再调用本函数，期间有新的发布时结果可能多出字段，不会遗漏
+ */
+uint32_t running_info_changed(uint32_t since)
+{
+    uint32_t dirty = 0;
+
+    for(uint8_t i = 0; i < RUN_INFO_FIELD_COUNT; i ++) {
+        if((int32_t)(atomic_load_explicit(&s_running_info_field_version[i], memory_order_relaxed) - since) > 0) {
+            dirty |= RUN_INFO_FIELD_BIT(i);
         }
-        
-        value = *rx_buf_out ++; 
     }
-    
-    return value;
+    return dirty;
 }
 
 /**
- * @brief  向串口数据帧中的功能码写1字节数据
- * @param  function_num 功能码
- * @return 写入完成后的数据内容的总长度
+ * @brief  注册实时运行参数更新通知
+ * @param  listener 通知函数，NULL 表示注销
+ * @return 无
+ * @note   应在串口任务启动前调用；与版本号轮询不同，每一帧都会通知，不会合并
  */
-void set_uart_frame_function_num(uint8_t function_num)
+void running_info_listener_register(running_info_listener_t listener)
 {
-    uart_tx_buf[FUNCTION_NUM] = function_num;
+    s_running_info_listener = listener;
 }
 
 /**
- * @brief  向串口数据帧中的数据内容写1字节数据
- * @param  byte 写入字节值
- * @return 写入完成后的数据内容的总长度
+ * @brief  读取一份内部一致的参数配置
+ * @param  config 输出的参数配置
+ * @return 数据版本号
  */
-void write_uart_fram_data_byte(uint8_t byte)
+uint32_t param_config_read(param_config_t *config)
 {
-    uint8_t *obj = (uint8_t *)uart_tx_buf + DATA_START;
-    
-    *obj = byte;
+    return snapshot_read(&g_param_config, config);
 }
 
 /**
- * @brief  向串口数据帧中的数据内容写多字节数据
- * @param  src  数据源地址
- * @param  len  数据长度
- * @return 写入完成后的数据内容的总长度
+ * @brief  发布新的参数配置
+ * @param  config 参数配置
+ * @return 无
+ * @note   同一时刻只能有一个任务调用
  */
-void write_uart_fram_data_buff(uint8_t *src, unsigned short len)
+void param_config_publish(const param_config_t *config)
 {
-    unsigned char *obj = (uint8_t *)uart_tx_buf + DATA_START;
-    
-    my_memcpy(obj,src,len);
+    snapshot_publish(&g_param_config, config);
 }
 
 /**
- * @brief  向主控板串口发送一帧数据
- * @param  len 数据帧中的数据内容长度
- * @return 其实也可以直接写在每个特定的发送函数中，(但这是通用操作，所以写成函数)
+ * @brief  判断串口接收缓存中是否有数据
+ * @param  Null
+ * @return 是否有数据
  */
-void wifi_uart_write_frame(uint8_t len)
+bool with_data_rxbuff(void)
 {
-    /* 校验和，默认是0x00 */
-    uint8_t check_sum = 0x00;
+    return ring_buffer_used(&uart_rx_ring) > 0;
+}
+
+/**
+ * @brief  读取队列1字节数据
+ * @param  Null
+ * @return Read the data
+ */
+uint8_t take_byte_rxbuff(void)
+{
+    uint8_t value = 0;
     
-    /* 添加帧头 */
-    uart_tx_buf[HEAD_FIRST] = FRAME_FIRST;
-    uart_tx_buf[HEAD_SECOND] = FRAME_SECOND;
+    ring_buffer_read(&uart_rx_ring, &value, 1);
+    return value;
+}
 
-    /* 添加数据长度 */
-    uart_tx_buf[LENGTH] = len;
+/**
+ * @brief  组一帧发往主控板的数据
+ * @param  frame 帧缓冲区，至少 PROTOCOL_HEAD + len + 1 字节
+ * @param  function_num 功能码
+ * @param  value 数据内容
+ * @param  len 数据内容长度
+ * @return 整帧长度
+ * @note   各任务在自己申请的帧槽中组帧，不再共用同一个全局发送缓冲区
+ */
+uint16_t uart_frame_pack(uint8_t *frame, uint8_t function_num, const uint8_t *value, uint8_t len)
+{
+    /* 添加帧头、功能码和数据长度 */
+    frame[HEAD_FIRST] = FRAME_FIRST;
+    frame[HEAD_SECOND] = FRAME_SECOND;
+    frame[FUNCTION_NUM] = function_num;
+    frame[LENGTH] = len;
     
-    /* 计算校验和 */
-    /* 需校验的数据长度 = 帧头(2字节)+功能码(1字节)+数据长度(1字节)+数据(len) */  
-    len += PROTOCOL_HEAD;
-    check_sum = get_check_sum((uint8_t *)uart_tx_buf, len);
+    /* 添加数据 */
+    if(len > 0) {
+        my_memcpy(frame + DATA_START, value, len);
+    }
+
     /* 添加校验和 */
-    uart_tx_buf[len] = check_sum;
-    
-    /* 向主控板发送一帧数据 */
-    _uart_write_data((uint8_t *)uart_tx_buf, len + 1);
+    /* 需校验的数据长度 = 帧头(2字节)+功能码(1字节)+数据长度(1字节)+数据(len) */
+    frame[PROTOCOL_HEAD + len] = get_check_sum(frame, PROTOCOL_HEAD + len);
+    return PROTOCOL_HEAD + len + 1;
 }
 
 /**
@@ -189,58 +253,108 @@ void *my_memcpy(void *dest, const void *src, unsigned short count)
 }
 
 /**
- * @brief  数据帧处理
- * @param  offset 数据起始位
- * @return Null
+ * @brief  判断功能码是否受支持
+ * @param  function_num 功能码
+ * @return 是否受支持
  */
-void data_handle(unsigned short offset)
-{
-    /* 获取功能码 */
-    uint8_t function_num = uart_data_process_buf[offset + FUNCTION_NUM];
-    /* 获取value的起始地址 */
-    uint8_t *data_start = (uint8_t *)&uart_data_process_buf[offset + DATA_START];
-    /* 根据功能码选择对应的操作 */
-    switch (function_num)
-    {
-        /* 更新实时运行参数-全部 */
-        case FN_UPDT_RUN_INFO_ALL: 
-        _update_all(data_start);
-        break;
-
-        default:
-        //error
-        break;
+bool is_valid_function_num(uint8_t function_num)
+{
+    return s_fnum_table[function_num].handler != NULL;
+}
+
+/**
+ * @brief  判断数据内容长度是否符合功能码表的约定
+ * @param  function_num 功能码
+ * @param  len 数据内容长度
+ * @return 是否合法
+ */
+bool is_valid_data_len(uint8_t function_num, uint8_t len)
+{
+    const fnum_entry_t *entry = &s_fnum_table[function_num];
+
+    return (entry->handler != NULL) && (len >= entry->min_len) && (len <= entry->max_len);
+}
+
+/**
+ * @brief  注册(或替换)功能码处理函数
+ * @param  function_num 功能码
+ * @param  handler 处理函数，NULL 表示注销该功能码
+ * @param  min_len 数据内容最小长度
+ * @param  max_len 数据内容最大长度
+ * @return 是否注册成功
+ * @note   应在串口任务启动前调用，解析过程中不对功能码表加锁
+ */
+bool fnum_table_register(uint8_t function_num, fnum_handler_t handler, uint8_t min_len, uint8_t max_len)
+{
+    if(min_len > max_len) {
+        return false;
     }
+
+    s_fnum_table[function_num].handler = handler;
+    s_fnum_table[function_num].min_len = min_len;
+    s_fnum_table[function_num].max_len = max_len;
+    return true;
 }
 
 /**
- * @brief  串口发送一段数据
- * @param[in] {in} 发送缓存指针
- * @param[in] {len} 数据发送长度
+ * @brief  数据帧处理
+ * @param  function_num 功能码
+ * @param  value 数据内容起始地址
+ * @param  len 数据内容长度
  * @return Null
+ * @note   长度不符合功能码表约定的数据帧不会交给处理函数
  */
-static void _uart_write_data(uint8_t *in, unsigned short len)
+void data_handle(uint8_t function_num, const uint8_t *value, uint8_t len)
 {
-    if((NULL == in) || (0 == len)) {
+    if(!is_valid_data_len(function_num, len)) {
         return;
     }
-    
-    while(len --) {
-        uart_transmit_output(*in);
-        in ++;
-    }
+
+    s_fnum_table[function_num].handler(value, len);
 }
 
 /**
  * @brief   更新-充电状态
  * @param   vaule 接收到的数据内容起始地址
+ * @param   len 数据内容长度
  * @return  无
  * @note    以下是测试序列：
  * 
  */
-static void _update_all(void *value)
+static void _update_all(const uint8_t *value, uint8_t len)
 {
-    //TODO 更新所有状态
-    g_running_info = *((running_info_t *)value);
-    return;
+    running_info_t info;
+    uint32_t dirty;
+
+    /* 按固定的小端线上格式逐字段解码，不直接把数据内容当作结构体访问 */
+    if(!running_info_decode(value, len, &info)) {
+        return;
+    }
+    dirty = running_info_diff(&s_running_info, &info);
+    s_running_info = info;
+    running_info_publish(&s_running_info, dirty);
+    if(NULL != s_running_info_listener) {
+        s_running_info_listener(&s_running_info);
+    }
+}
+
+/**
+ * @brief   更新-变化的字段
+ * @param   vaule 接收到的数据内容起始地址(若干条 TLV 字段记录)
+ * @param   len 数据内容长度
+ * @return  无
+ * @note    在工作副本上就地修改，只有值真正改变的字段计入脏字段位图；
+ *          格式错误的帧整帧丢弃，工作副本不变
+ */
+static void _update_delta(const uint8_t *value, uint8_t len)
+{
+    uint32_t dirty;
+
+    if(!running_info_delta_apply(value, len, &s_running_info, &dirty)) {
+        return;
+    }
+    running_info_publish(&s_running_info, dirty);
+    if(NULL != s_running_info_listener) {
+        s_running_info_listener(&s_running_info);
+    }
 }
@@ -9,6 +9,10 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "ring_buffer.h"
+#include "snapshot.h"
+#include "tx_queue.h"
+#include "capture.h"
 
 /* 数据帧中各功能字节的位序 */
 #define HEAD_FIRST                      0
@@ -22,7 +26,8 @@
 #define FRAME_SECOND                    0x55            // 帧头第二字节
 /* 功能码 */
 #define FN_UPDT_RUN_INFO_ALL            0x10            // 更新实时运行参数-全部
-#define FN_UPDT_PRAM_CONFIG             0x16            // 参数配置
+#define FN_UPDT_RUN_INFO_DELTA          0x11            // 更新实时运行参数-变化的字段(TLV)
+#define FN_UPDT_PRAM_CONFIG             0x16            // 参数配置(下发: 序号+变化的字段，回复: 序号+结果)
 #define FN_UPDT_RFID_CARD               0x17            // 卡片管理
 #define FN_UPDT_ALARM_RECORD            0x18            // 告警记录
 
@@ -58,6 +63,46 @@ typedef struct running_info{
     uint8_t net_status;             // 网络状态
 }running_info_t;
 
+/**
+ * @brief   实时运行参数的字段编号(增量帧中的字段ID，也是脏字段位图中的位号)
+ * @note    编号写在线上，只能在末尾追加，不能调整顺序
+ */
+typedef enum{
+    RUN_INFO_FIELD_CHARGE_STATUS = 0,
+    RUN_INFO_FIELD_POWER,
+    RUN_INFO_FIELD_VOLTAGE,
+    RUN_INFO_FIELD_CURRENT,
+    RUN_INFO_FIELD_NET_STATUS,
+    RUN_INFO_FIELD_COUNT,
+}running_info_field_t;
+
+#define RUN_INFO_FIELD_BIT(field)       (1u << (field))
+#define RUN_INFO_FIELDS_ALL             (RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_COUNT) - 1)
+
+/**
+ * @brief   功能码处理函数
+ * @param   value 数据内容起始地址
+ * @param   len 数据内容长度(已按功能码表校验)
+ */
+typedef void (*fnum_handler_t)(const uint8_t *value, uint8_t len);
+
+/**
+ * @brief   实时运行参数更新通知
+ * @param   info 刚发布的实时运行参数
+ * @note    在串口任务中对每一帧 FN_UPDT_RUN_INFO_ALL 调用，不能阻塞
+ */
+typedef void (*running_info_listener_t)(const running_info_t *info);
+
+/**
+ * @brief   功能码表项(以功能码为下标，共256项)
+ * @note    handler 为 NULL 表示不支持该功能码；min_len == max_len 时为定长数据
+ */
+typedef struct fnum_entry{
+    fnum_handler_t handler;         // 处理函数
+    uint8_t min_len;                // 数据内容最小长度
+    uint8_t max_len;                // 数据内容最大长度
+}fnum_entry_t;
+
 typedef struct param_config{
     float ov_threshold;             // 过压阈值
     float uv_threshold;             // 欠压阈值
@@ -66,34 +111,65 @@ typedef struct param_config{
     uint8_t maxcc;                  // 最大充电电流
 }param_config_t;
 
+/**
+ * @brief   参数配置的字段编号(下发帧中的字段ID)
+ * @note    编号写在线上，只能在末尾追加，不能调整顺序
+ */
+typedef enum{
+    PARAM_FIELD_OV_THRESHOLD = 0,
+    PARAM_FIELD_UV_THRESHOLD,
+    PARAM_FIELD_LEAKAGE_DC,
+    PARAM_FIELD_LEAKAGE_AC,
+    PARAM_FIELD_MAXCC,
+    PARAM_FIELD_COUNT,
+}param_config_field_t;
+
+/* 数据内容的最大长度(LENGTH字段为1字节) */
+#define UART_MAX_DATA_LEN               255
+
 /* 串口数据缓冲区大小设置，如果RAM不够，可按需修改大小 */
-#define UART_PROCESS_BUFF_LEN           32
-#define UART_RX_BUFF_LEN                32
-#define UART_TX_BUFF_LEN                32
+#define UART_PROCESS_BUFF_LEN           UART_MAX_DATA_LEN
+#define UART_RX_BUFF_LEN                1024            // 必须为2的幂
 
-/* 串口数据处理缓冲区 */
-extern volatile uint8_t uart_data_process_buf[PROTOCOL_HEAD+UART_PROCESS_BUFF_LEN];
-/* 串口接收数据缓冲区 */
-extern volatile uint8_t uart_rx_buf[PROTOCOL_HEAD+UART_RX_BUFF_LEN];   
-/* 串口发送数据缓冲区 */      
-extern volatile uint8_t uart_tx_buf[PROTOCOL_HEAD+UART_TX_BUFF_LEN];        
+#if (UART_RX_BUFF_LEN & (UART_RX_BUFF_LEN - 1)) != 0
+#error "UART_RX_BUFF_LEN must be a power of two"
+#endif
+#if UART_RX_BUFF_LEN < (PROTOCOL_HEAD + UART_MAX_DATA_LEN + 1)
+#error "UART_RX_BUFF_LEN must hold at least one maximum-length frame"
+#endif
 
-extern volatile uint8_t *rx_buf_in;
-extern volatile uint8_t *rx_buf_out;
+/* 串口数据处理缓冲区(数据内容在接收队列中回绕时，拼接成连续数据) */
+extern uint8_t uart_data_process_buf[UART_PROCESS_BUFF_LEN];
+/* 串口接收数据缓冲区 */
+extern uint8_t uart_rx_buf[UART_RX_BUFF_LEN];
+/* 串口接收环形队列 */
+extern ring_buffer_t uart_rx_ring;
+/* 串口发送帧队列 */
+extern tx_queue_t uart_tx_queue;
+/* 串口收发记录 */
+extern capture_t uart_capture;
 
-extern volatile running_info_t g_running_info;
-extern volatile param_config_t g_param_config;
+/* 实时运行参数/参数配置快照(串口任务发布，HTTP等任务读取) */
+extern snapshot_t g_running_info;
+extern snapshot_t g_param_config;
 
 /* public function protypes ------------------------------------------------- */
 
+uint32_t running_info_read(running_info_t *info);
+void running_info_publish(const running_info_t *info, uint32_t dirty);
+uint32_t running_info_version(void);
+uint32_t running_info_changed(uint32_t since);
+void running_info_listener_register(running_info_listener_t listener);
+uint32_t param_config_read(param_config_t *config);
+void param_config_publish(const param_config_t *config);
 bool with_data_rxbuff(void);
 uint8_t take_byte_rxbuff(void);
-void set_uart_frame_function_num(uint8_t function_num);
-void write_uart_fram_data_byte(uint8_t byte);
-void write_uart_fram_data_buff(uint8_t *src, unsigned short len);
-void wifi_uart_write_frame(uint8_t len);
+uint16_t uart_frame_pack(uint8_t *frame, uint8_t function_num, const uint8_t *value, uint8_t len);
 uint8_t get_check_sum(uint8_t pack[], uint16_t pack_len);
 void *my_memcpy(void *dest, const void *src, unsigned short count);
-void data_handle(unsigned short offset);
+bool is_valid_function_num(uint8_t function_num);
+bool is_valid_data_len(uint8_t function_num, uint8_t len);
+bool fnum_table_register(uint8_t function_num, fnum_handler_t handler, uint8_t min_len, uint8_t max_len);
+void data_handle(uint8_t function_num, const uint8_t *value, uint8_t len);
 
 #endif /* __SYSTEM_H__ */
@@ -0,0 +1,111 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include "tx_queue.h"
+
+/**
+ * @brief  初始化发送队列
+ * @param  q 队列句柄
+ * @return 无
+ */
+void tx_queue_init(tx_queue_t *q)
+{
+    uint32_t i;
+
+    for(i = 0; i < TX_QUEUE_LEN; i ++) {
+        atomic_init(&q->slots[i].seq, i);
+        q->slots[i].len = 0;
+    }
+    atomic_init(&q->enqueue_pos, 0);
+    q->dequeue_pos = 0;
+    atomic_init(&q->dropped, 0);
+}
+
+/**
+ * @brief  申请一个空闲帧槽(任意任务可调用，不阻塞)
+ * @param  q 队列句柄
+ * @param  ticket 输出入队序号，提交时原样传回
+ * @return 帧槽，队列已满时返回 NULL 并计入丢弃计数
+ */
+tx_slot_t *tx_queue_claim(tx_queue_t *q, uint32_t *ticket)
+{
+    uint32_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    tx_slot_t *slot;
+    int32_t diff;
+
+    while(1) {
+        slot = &q->slots[pos & (TX_QUEUE_LEN - 1)];
+        diff = (int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if(0 == diff) {
+            /* 槽空闲，抢占该入队序号 */
+            if(atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                     memory_order_relaxed, memory_order_relaxed)) {
+                *ticket = pos;
+                return slot;
+            }
+        } else if(diff < 0) {
+            /* 槽还未被写者发送完，队列已满 */
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            return NULL;
+        } else {
+            /* 该序号已被其它生产者抢走 */
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief  提交已填好的帧槽，交给写者发送
+ * @param  q 队列句柄
+ * @param  slot tx_queue_claim 返回的帧槽
+ * @param  ticket tx_queue_claim 输出的入队序号
+ * @return 无
+ */
+void tx_queue_commit(tx_queue_t *q, tx_slot_t *slot, uint32_t ticket)
+{
+    (void)q;
+    atomic_store_explicit(&slot->seq, ticket + 1, memory_order_release);
+}
+
+/**
+ * @brief  获取队首待发送的帧(仅写者调用)
+ * @param  q 队列句柄
+ * @return 帧槽，没有待发送的帧时返回 NULL
+ * @note   队首的帧可能已申请但尚未提交，此时同样返回 NULL，保证按入队顺序发送
+ */
+tx_slot_t *tx_queue_front(tx_queue_t *q)
+{
+    tx_slot_t *slot = &q->slots[q->dequeue_pos & (TX_QUEUE_LEN - 1)];
+
+    if(atomic_load_explicit(&slot->seq, memory_order_acquire) != q->dequeue_pos + 1) {
+        return NULL;
+    }
+    return slot;
+}
+
+/**
+ * @brief  释放队首帧槽(仅写者调用，发送完成后)
+ * @param  q 队列句柄
+ * @return 无
+ */
+void tx_queue_pop(tx_queue_t *q)
+{
+    tx_slot_t *slot = &q->slots[q->dequeue_pos & (TX_QUEUE_LEN - 1)];
+
+    atomic_store_explicit(&slot->seq, q->dequeue_pos + TX_QUEUE_LEN, memory_order_release);
+    q->dequeue_pos ++;
+}
+
+/**
+ * @brief  获取队列满时被丢弃的累计帧数
+ * @param  q 队列句柄
+ * @return 丢弃的帧数
+ */
+uint32_t tx_queue_dropped(tx_queue_t *q)
+{
+    return atomic_load_explicit(&q->dropped, memory_order_relaxed);
+}
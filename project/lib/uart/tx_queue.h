@@ -0,0 +1,53 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __TX_QUEUE_H__
+#define __TX_QUEUE_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* 发送队列帧槽数，必须为2的幂 */
+#define TX_QUEUE_LEN                    8
+/* 单帧最大长度: 帧头(2)+功能码(1)+长度(1)+数据(255)+校验(1) */
+#define TX_FRAME_MAX_LEN                260
+
+#if (TX_QUEUE_LEN & (TX_QUEUE_LEN - 1)) != 0
+#error "TX_QUEUE_LEN must be a power of two"
+#endif
+
+/**
+ * @brief   预分配的发送帧槽
+ * @note    seq 为槽的状态序号: 等于入队序号时空闲可写，等于入队序号+1时已填好待发送
+ */
+typedef struct tx_slot{
+    atomic_uint seq;                // 槽状态序号
+    uint16_t len;                   // 帧长度
+    uint8_t frame[TX_FRAME_MAX_LEN];// 完整帧数据
+}tx_slot_t;
+
+/**
+ * @brief   多生产者/单消费者有界帧队列
+ * @note    任意任务都可以并发申请帧槽并在槽内组帧，互不干扰；
+ *          只有一个写者按入队顺序取出整帧交给发送后端
+ */
+typedef struct tx_queue{
+    tx_slot_t slots[TX_QUEUE_LEN];  // 帧槽
+    atomic_uint enqueue_pos;        // 下一个入队序号(生产者)
+    uint32_t dequeue_pos;           // 下一个出队序号(消费者)
+    atomic_uint dropped;            // 队列满时被丢弃的帧数
+}tx_queue_t;
+
+/* public function protypes ------------------------------------------------- */
+void tx_queue_init(tx_queue_t *q);
+tx_slot_t *tx_queue_claim(tx_queue_t *q, uint32_t *ticket);
+void tx_queue_commit(tx_queue_t *q, tx_slot_t *slot, uint32_t ticket);
+tx_slot_t *tx_queue_front(tx_queue_t *q);
+void tx_queue_pop(tx_queue_t *q);
+uint32_t tx_queue_dropped(tx_queue_t *q);
+
+#endif /* __TX_QUEUE_H__ */
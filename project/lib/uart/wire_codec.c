@@ -0,0 +1,470 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "wire_codec.h"
+
+#define ARRAY_SIZE(a)                   (sizeof(a) / sizeof((a)[0]))
+
+/* 字段的线上位置: 旧布局按字段大小(1/2/4)对齐，与主控板直接发送结构体时的填充一致 */
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_LEGACY
+#define WIRE_ALIGN(pos, n)              ((uint8_t)(((pos) + (n) - 1) & ~((n) - 1)))
+_Static_assert(RUNNING_INFO_WIRE_LEN == sizeof(running_info_t), "legacy layout must match the struct");
+_Static_assert(PARAM_CONFIG_WIRE_LEN == sizeof(param_config_t), "legacy layout must match the struct");
+#else
+#define WIRE_ALIGN(pos, n)              ((uint8_t)(pos))
+#endif
+
+/* 实时运行参数的线上格式(下标即增量帧中的字段ID) */
+static const wire_field_t s_running_info_fields[RUN_INFO_FIELD_COUNT] =
+{
+    [RUN_INFO_FIELD_CHARGE_STATUS] = WIRE_FIELD_U8(running_info_t, charge_status),
+    [RUN_INFO_FIELD_POWER]         = WIRE_FIELD_FLOAT(running_info_t, power, WIRE_SCALE_POWER),
+    [RUN_INFO_FIELD_VOLTAGE]       = WIRE_FIELD_FLOAT(running_info_t, voltage, WIRE_SCALE_VOLTAGE),
+    [RUN_INFO_FIELD_CURRENT]       = WIRE_FIELD_FLOAT(running_info_t, current, WIRE_SCALE_CURRENT),
+    [RUN_INFO_FIELD_NET_STATUS]    = WIRE_FIELD_U8(running_info_t, net_status),
+};
+
+/* 参数配置的线上格式(下标即下发帧中的字段ID) */
+static const wire_field_t s_param_config_fields[PARAM_FIELD_COUNT] =
+{
+    [PARAM_FIELD_OV_THRESHOLD] = WIRE_FIELD_FLOAT(param_config_t, ov_threshold, WIRE_SCALE_VOLTAGE),
+    [PARAM_FIELD_UV_THRESHOLD] = WIRE_FIELD_FLOAT(param_config_t, uv_threshold, WIRE_SCALE_VOLTAGE),
+    [PARAM_FIELD_LEAKAGE_DC]   = WIRE_FIELD_U8(param_config_t, leakagedc),
+    [PARAM_FIELD_LEAKAGE_AC]   = WIRE_FIELD_U8(param_config_t, leakageac),
+    [PARAM_FIELD_MAXCC]        = WIRE_FIELD_U8(param_config_t, maxcc),
+};
+
+/* private function protypes -------------------------------------------------*/
+static bool _wire_decode(const wire_field_t *fields, uint8_t count, const uint8_t *buf, uint8_t len, void *obj);
+static uint8_t _wire_encode(const wire_field_t *fields, uint8_t count, const void *obj, uint8_t *buf, uint8_t size);
+static uint32_t _wire_diff(const wire_field_t *fields, uint8_t count, const void *a, const void *b);
+static uint8_t _wire_tlv_encode(const wire_field_t *fields, uint8_t count, const void *obj, const void *prev, uint8_t *buf, uint8_t size);
+static bool _wire_tlv_apply(const wire_field_t *fields, uint8_t count, const uint8_t *buf, uint8_t len, void *obj, uint32_t *dirty);
+
+/**
+ * @brief  读取小端16位无符号数(无对齐要求)
+ * @param  buf 数据地址
+ * @return 数值
+ */
+uint16_t wire_get_u16(const uint8_t *buf)
+{
+    return (uint16_t)buf[0] | ((uint16_t)buf[1] << 8);
+}
+
+/**
+ * @brief  读取小端32位无符号数(无对齐要求)
+ * @param  buf 数据地址
+ * @return 数值
+ */
+uint32_t wire_get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/**
+ * @brief  写入小端16位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+void wire_put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * @brief  写入小端32位无符号数
+ * @param  buf 目标地址
+ * @param  value 数值
+ * @return 无
+ */
+void wire_put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)value;
+    buf[1] = (uint8_t)(value >> 8);
+    buf[2] = (uint8_t)(value >> 16);
+    buf[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief  获取字段在线上占用的字节数
+ * @param  field 字段描述
+ * @return 字节数
+ */
+uint8_t wire_field_size(const wire_field_t *field)
+{
+    switch (field->type)
+    {
+        case WIRE_FIX16:
+        return 2;
+
+        case WIRE_F32:
+        return 4;
+
+        case WIRE_U8:
+        default:
+        return 1;
+    }
+}
+
+/**
+ * @brief  从线上数据解码一个字段到结构体
+ * @param  field 字段描述
+ * @param  buf 线上数据地址(长度由调用者保证)
+ * @param  obj 结构体地址
+ * @return 消耗的字节数
+ */
+uint8_t wire_field_decode(const wire_field_t *field, const uint8_t *buf, void *obj)
+{
+    uint8_t *member = (uint8_t *)obj + field->offset;
+    uint32_t bits;
+    float value;
+
+    switch (field->type)
+    {
+        case WIRE_FIX16:
+        value = (float)wire_get_u16(buf) / field->scale;
+        memcpy(member, &value, sizeof(value));
+        break;
+
+        case WIRE_F32:
+        /* 按字节拼出位模式后再拷贝，避免非对齐的浮点访问 */
+        bits = wire_get_u32(buf);
+        memcpy(member, &bits, sizeof(bits));
+        break;
+
+        case WIRE_U8:
+        default:
+        *member = buf[0];
+        break;
+    }
+    return wire_field_size(field);
+}
+
+/**
+ * @brief  把结构体中的一个字段编码为线上数据
+ * @param  field 字段描述
+ * @param  obj 结构体地址
+ * @param  buf 目标地址(长度由调用者保证)
+ * @return 写入的字节数
+ * @note   定点数超出范围时饱和到 0 或 0xFFFF
+ */
+uint8_t wire_field_encode(const wire_field_t *field, const void *obj, uint8_t *buf)
+{
+    const uint8_t *member = (const uint8_t *)obj + field->offset;
+    uint32_t bits;
+    float value;
+
+    switch (field->type)
+    {
+        case WIRE_FIX16:
+        memcpy(&value, member, sizeof(value));
+        value = value * field->scale + 0.5f;
+        if(!(value > 0.0f)) {
+            wire_put_u16(buf, 0);
+        } else if(value >= 65535.0f) {
+            wire_put_u16(buf, 0xFFFF);
+        } else {
+            wire_put_u16(buf, (uint16_t)value);
+        }
+        break;
+
+        case WIRE_F32:
+        memcpy(&bits, member, sizeof(bits));
+        wire_put_u32(buf, bits);
+        break;
+
+        case WIRE_U8:
+        default:
+        buf[0] = *member;
+        break;
+    }
+    return wire_field_size(field);
+}
+
+/**
+ * @brief  解码实时运行参数
+ * @param  buf 数据内容地址
+ * @param  len 数据内容长度，必须等于 RUNNING_INFO_WIRE_LEN
+ * @param  info 输出的实时运行参数
+ * @return 是否解码成功
+ */
+bool running_info_decode(const uint8_t *buf, uint8_t len, running_info_t *info)
+{
+    return _wire_decode(s_running_info_fields, ARRAY_SIZE(s_running_info_fields), buf, len, info);
+}
+
+/**
+ * @brief  编码实时运行参数
+ * @param  info 实时运行参数
+ * @param  buf 目标地址
+ * @param  size 目标缓冲区大小
+ * @return 编码后的长度，缓冲区不足时返回0
+ */
+uint8_t running_info_encode(const running_info_t *info, uint8_t *buf, uint8_t size)
+{
+    return _wire_encode(s_running_info_fields, ARRAY_SIZE(s_running_info_fields), info, buf, size);
+}
+
+/**
+ * @brief  比较两份实时运行参数
+ * @param  a 实时运行参数
+ * @param  b 实时运行参数
+ * @return 不同的字段(RUN_INFO_FIELD_BIT 位图)
+ */
+uint32_t running_info_diff(const running_info_t *a, const running_info_t *b)
+{
+    return _wire_diff(s_running_info_fields, RUN_INFO_FIELD_COUNT, a, b);
+}
+
+/**
+ * @brief  编码实时运行参数的增量帧
+ * @param  info 当前的实时运行参数
+ * @param  prev 上次发送的实时运行参数，NULL 表示发送全部字段
+ * @param  buf 目标地址
+ * @param  size 目标缓冲区大小，不小于 RUNNING_INFO_DELTA_MAX_LEN 时不会不足
+ * @return 编码后的长度，没有字段变化或缓冲区不足时返回0
+ * @note   按线上编码比较，定点数量化后相同的值不发送
+ */
+uint8_t running_info_delta_encode(const running_info_t *info, const running_info_t *prev, uint8_t *buf, uint8_t size)
+{
+    return _wire_tlv_encode(s_running_info_fields, RUN_INFO_FIELD_COUNT, info, prev, buf, size);
+}
+
+/**
+ * @brief  把增量帧应用到实时运行参数上
+ * @param  buf 数据内容地址
+ * @param  len 数据内容长度
+ * @param  info 被就地修改的实时运行参数
+ * @param  dirty 输出: 值发生变化的字段(RUN_INFO_FIELD_BIT 位图)
+ * @return 是否应用成功，失败时 info 不变
+ */
+bool running_info_delta_apply(const uint8_t *buf, uint8_t len, running_info_t *info, uint32_t *dirty)
+{
+    return _wire_tlv_apply(s_running_info_fields, RUN_INFO_FIELD_COUNT, buf, len, info, dirty);
+}
+
+/**
+ * @brief  解码参数配置
+ * @param  buf 数据内容地址
+ * @param  len 数据内容长度，必须等于 PARAM_CONFIG_WIRE_LEN
+ * @param  config 输出的参数配置
+ * @return 是否解码成功
+ */
+bool param_config_decode(const uint8_t *buf, uint8_t len, param_config_t *config)
+{
+    return _wire_decode(s_param_config_fields, ARRAY_SIZE(s_param_config_fields), buf, len, config);
+}
+
+/**
+ * @brief  编码参数配置
+ * @param  config 参数配置
+ * @param  buf 目标地址
+ * @param  size 目标缓冲区大小
+ * @return 编码后的长度，缓冲区不足时返回0
+ */
+uint8_t param_config_encode(const param_config_t *config, uint8_t *buf, uint8_t size)
+{
+    return _wire_encode(s_param_config_fields, ARRAY_SIZE(s_param_config_fields), config, buf, size);
+}
+
+/**
+ * @brief  编码参数配置中变化的字段(格式与实时运行参数的增量帧相同)
+ * @param  config 新的参数配置
+ * @param  prev 当前的参数配置，NULL 表示全部字段
+ * @param  buf 目标地址
+ * @param  size 目标缓冲区大小，不小于 PARAM_CONFIG_DELTA_MAX_LEN 时不会不足
+ * @return 编码后的长度，没有字段变化或缓冲区不足时返回0
+ */
+uint8_t param_config_delta_encode(const param_config_t *config, const param_config_t *prev, uint8_t *buf, uint8_t size)
+{
+    return _wire_tlv_encode(s_param_config_fields, PARAM_FIELD_COUNT, config, prev, buf, size);
+}
+
+/**
+ * @brief  把字段记录应用到参数配置上
+ * @param  buf 数据内容地址
+ * @param  len 数据内容长度
+ * @param  config 被就地修改的参数配置
+ * @param  dirty 输出: 值发生变化的字段位图
+ * @return 是否应用成功，失败时 config 不变
+ */
+bool param_config_delta_apply(const uint8_t *buf, uint8_t len, param_config_t *config, uint32_t *dirty)
+{
+    return _wire_tlv_apply(s_param_config_fields, PARAM_FIELD_COUNT, buf, len, config, dirty);
+}
+
+/**
+ * @brief  按字段描述依次解码
+ * @param  fields 字段描述数组
+ * @param  count 字段个数
+ * @param  buf 线上数据
+ * @param  len 线上数据长度，必须与字段总长度一致
+ * @param  obj 输出结构体
+ * @return 是否解码成功
+ */
+static bool _wire_decode(const wire_field_t *fields, uint8_t count, const uint8_t *buf, uint8_t len, void *obj)
+{
+    uint8_t i;
+    uint8_t n;
+    uint8_t align = 1;
+    uint8_t pos = 0;
+
+    for(i = 0; i < count; i ++) {
+        n = wire_field_size(&fields[i]);
+        pos = WIRE_ALIGN(pos, n);
+        if(pos + n > len) {
+            return false;
+        }
+        pos += wire_field_decode(&fields[i], buf + pos, obj);
+        align = (n > align) ? n : align;
+    }
+    return WIRE_ALIGN(pos, align) == len;
+}
+
+/**
+ * @brief  按字段描述依次编码
+ * @param  fields 字段描述数组
+ * @param  count 字段个数
+ * @param  obj 结构体
+ * @param  buf 目标地址
+ * @param  size 目标缓冲区大小
+ * @return 编码后的长度，缓冲区不足时返回0
+ */
+static uint8_t _wire_encode(const wire_field_t *fields, uint8_t count, const void *obj, uint8_t *buf, uint8_t size)
+{
+    uint8_t i;
+    uint8_t n;
+    uint8_t align = 1;
+    uint8_t end;
+    uint8_t pos = 0;
+
+    for(i = 0; i <= count; i ++) {
+        /* 最后一轮只补齐结构体末尾的填充 */
+        n = (i < count) ? wire_field_size(&fields[i]) : 0;
+        end = (i < count) ? WIRE_ALIGN(pos, n) : WIRE_ALIGN(pos, align);
+        if(end + n > size) {
+            return 0;
+        }
+        memset(buf + pos, 0, end - pos);
+        pos = end;
+        if(i < count) {
+            pos += wire_field_encode(&fields[i], obj, buf + pos);
+            align = (n > align) ? n : align;
+        }
+    }
+    return pos;
+}
+
+/**
+ * @brief  获取字段在结构体中占用的字节数
+ * @param  field 字段描述
+ * @return 字节数
+ */
+static uint8_t _wire_member_size(const wire_field_t *field)
+{
+    return (field->type == WIRE_U8) ? 1 : sizeof(float);
+}
+
+/**
+ * @brief  逐字段比较两个结构体
+ * @param  fields 字段描述数组
+ * @param  count 字段个数(不超过32)
+ * @param  a 结构体
+ * @param  b 结构体
+ * @return 不同的字段位图(第 i 位对应 fields[i])
+ */
+static uint32_t _wire_diff(const wire_field_t *fields, uint8_t count, const void *a, const void *b)
+{
+    uint32_t diff = 0;
+    uint8_t i;
+
+    for(i = 0; i < count; i ++) {
+        if(memcmp((const uint8_t *)a + fields[i].offset, (const uint8_t *)b + fields[i].offset,
+                  _wire_member_size(&fields[i])) != 0) {
+            diff |= 1u << i;
+        }
+    }
+    return diff;
+}
+
+/**
+ * @brief  按字段描述编码线上编码发生变化的字段记录
+ * @param  fields 字段描述数组(下标为字段ID，不超过16个)
+ * @param  count 字段个数
+ * @param  obj 结构体
+ * @param  prev 上次发送的结构体，NULL 表示全部字段
+ * @param  buf 目标地址
+ * @param  size 目标缓冲区大小
+ * @return 编码后的长度，没有字段变化或缓冲区不足时返回0
+ */
+static uint8_t _wire_tlv_encode(const wire_field_t *fields, uint8_t count, const void *obj, const void *prev, uint8_t *buf, uint8_t size)
+{
+    uint8_t old[4];
+    uint8_t i;
+    uint8_t n;
+    uint8_t pos = 0;
+
+    for(i = 0; i < count; i ++) {
+        n = wire_field_size(&fields[i]);
+        if(pos + 1 + n > size) {
+            return 0;
+        }
+        wire_field_encode(&fields[i], obj, buf + pos + 1);
+        if((NULL != prev) && (wire_field_encode(&fields[i], prev, old) == n) && (memcmp(old, buf + pos + 1, n) == 0)) {
+            continue;
+        }
+        buf[pos] = WIRE_TLV_HEAD(i, n);
+        pos += 1 + n;
+    }
+    return pos;
+}
+
+/**
+ * @brief  按字段描述就地应用字段记录
+ * @param  fields 字段描述数组(下标为字段ID)
+ * @param  count 字段个数
+ * @param  buf 线上数据
+ * @param  len 线上数据长度
+ * @param  obj 被修改的结构体
+ * @param  dirty 输出: 值发生变化的字段位图
+ * @return 是否应用成功
+ * @note   先检查整帧再修改，格式错误时 obj 不变；不认识的字段ID按长度跳过
+ */
+static bool _wire_tlv_apply(const wire_field_t *fields, uint8_t count, const uint8_t *buf, uint8_t len, void *obj, uint32_t *dirty)
+{
+    uint8_t old[4];
+    uint8_t *member;
+    uint8_t id;
+    uint8_t n;
+    uint8_t pos;
+
+    for(pos = 0; pos < len; pos += 1 + n) {
+        id = WIRE_TLV_ID(buf[pos]);
+        n = WIRE_TLV_LEN(buf[pos]);
+        if((pos + 1 + n > len) || ((id < count) && (n != wire_field_size(&fields[id])))) {
+            return false;
+        }
+    }
+
+    *dirty = 0;
+    for(pos = 0; pos < len; pos += 1 + n) {
+        id = WIRE_TLV_ID(buf[pos]);
+        n = WIRE_TLV_LEN(buf[pos]);
+        if(id >= count) {
+            continue;
+        }
+        member = (uint8_t *)obj + fields[id].offset;
+        memcpy(old, member, _wire_member_size(&fields[id]));
+        wire_field_decode(&fields[id], buf + pos + 1, obj);
+        if(memcmp(old, member, _wire_member_size(&fields[id])) != 0) {
+            *dirty |= 1u << id;
+        }
+    }
+    return true;
+}
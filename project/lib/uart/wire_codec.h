@@ -0,0 +1,110 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __WIRE_CODEC_H__
+#define __WIRE_CODEC_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "system.h"
+
+/*
+ * 线上布局(PROTOCOL_WIRE_LAYOUT):
+ *
+ *   WIRE_LAYOUT_LEGACY   与旧固件相同(默认): 主控板直接发送结构体，每个字段按自身大小对齐，
+ *                        总长按最大字段对齐，浮点为 IEEE754 单精度，填充字节发送时为0、接收时忽略
+ *   WIRE_LAYOUT_PACKED   紧凑排列，浮点为 IEEE754 单精度
+ *   WIRE_LAYOUT_FIXED16  紧凑排列，浮点为16位无符号定点数(帧更短；接收端仍换算为 float)
+ *
+ * 布局决定了帧长，两块板子的固件必须使用相同的布局，改为非默认布局时必须同时升级
+ */
+#define WIRE_LAYOUT_LEGACY              0
+#define WIRE_LAYOUT_PACKED              1
+#define WIRE_LAYOUT_FIXED16             2
+
+#ifndef PROTOCOL_WIRE_LAYOUT
+#define PROTOCOL_WIRE_LAYOUT            WIRE_LAYOUT_LEGACY
+#endif
+
+/* 定点数的比例(原始值 = 实际值 * 比例) */
+#define WIRE_SCALE_POWER                1               // 1 W
+#define WIRE_SCALE_VOLTAGE              10              // 0.1 V
+#define WIRE_SCALE_CURRENT              100             // 0.01 A
+
+/* 各数据内容在线上的固定长度(小端) */
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+#define RUNNING_INFO_WIRE_LEN           8               // 状态1+功率2+电压2+电流2+网络1
+#define PARAM_CONFIG_WIRE_LEN           7               // 过压2+欠压2+dc漏电1+ac漏电1+最大电流1
+#elif PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_PACKED
+#define RUNNING_INFO_WIRE_LEN           14              // 状态1+功率4+电压4+电流4+网络1
+#define PARAM_CONFIG_WIRE_LEN           11              // 过压4+欠压4+dc漏电1+ac漏电1+最大电流1
+#else
+#define RUNNING_INFO_WIRE_LEN           20              // 状态1+填充3+功率4+电压4+电流4+网络1+填充3
+#define PARAM_CONFIG_WIRE_LEN           12              // 过压4+欠压4+dc漏电1+ac漏电1+最大电流1+填充1
+#endif
+
+/*
+ * 增量帧(FN_UPDT_RUN_INFO_DELTA)的数据内容由若干条字段记录紧凑排列而成:
+ *
+ *   记录头1(高4位字段ID running_info_field_t，低4位值长度) + 值(与全量帧中该字段的编码相同)
+ *
+ * 发送端只发送线上编码发生变化的字段；接收端跳过不认识的字段ID，已知字段的长度不符时整帧丢弃。
+ * 增量帧不比全量帧短时(几个模拟量同时变化)应直接发送全量帧；v1 链路不重发，
+ * 发送端应定期发送全量帧，让丢帧后的接收端重新同步
+ */
+#define WIRE_TLV_HEAD(id, len)          ((uint8_t)(((id) << 4) | (len)))
+#define WIRE_TLV_ID(head)               ((uint8_t)(head) >> 4)
+#define WIRE_TLV_LEN(head)              ((uint8_t)(head) & 0x0F)
+/* 本端编码增量帧的最大长度(用于发送缓冲区)；接收时不以此为上限，对端可能带有本端不认识的字段 */
+#define RUNNING_INFO_DELTA_MAX_LEN      (RUN_INFO_FIELD_COUNT + RUNNING_INFO_WIRE_LEN)
+#define PARAM_CONFIG_DELTA_MAX_LEN      (PARAM_FIELD_COUNT + PARAM_CONFIG_WIRE_LEN)
+
+/**
+ * @brief   线上字段类型
+ */
+typedef enum{
+    WIRE_U8 = 0,                    // uint8_t  <-> 1字节
+    WIRE_FIX16,                     // float    <-> 2字节小端无符号定点数
+    WIRE_F32,                       // float    <-> 4字节小端IEEE754
+}wire_type_t;
+
+/**
+ * @brief   线上字段描述，按数组顺序依次排列(WIRE_LAYOUT_LEGACY 时按字段大小对齐)
+ */
+typedef struct wire_field{
+    uint8_t type;                   // 字段类型 wire_type_t
+    uint16_t offset;                // 字段在结构体中的偏移
+    uint16_t scale;                 // WIRE_FIX16 的比例
+}wire_field_t;
+
+#define WIRE_FIELD_U8(type, member)             { WIRE_U8, offsetof(type, member), 1 }
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+#define WIRE_FIELD_FLOAT(type, member, scale)   { WIRE_FIX16, offsetof(type, member), scale }
+#else
+#define WIRE_FIELD_FLOAT(type, member, scale)   { WIRE_F32, offsetof(type, member), scale }
+#endif
+
+/* public function protypes ------------------------------------------------- */
+uint16_t wire_get_u16(const uint8_t *buf);
+uint32_t wire_get_u32(const uint8_t *buf);
+void wire_put_u16(uint8_t *buf, uint16_t value);
+void wire_put_u32(uint8_t *buf, uint32_t value);
+uint8_t wire_field_size(const wire_field_t *field);
+uint8_t wire_field_decode(const wire_field_t *field, const uint8_t *buf, void *obj);
+uint8_t wire_field_encode(const wire_field_t *field, const void *obj, uint8_t *buf);
+
+bool running_info_decode(const uint8_t *buf, uint8_t len, running_info_t *info);
+uint8_t running_info_encode(const running_info_t *info, uint8_t *buf, uint8_t size);
+uint32_t running_info_diff(const running_info_t *a, const running_info_t *b);
+uint8_t running_info_delta_encode(const running_info_t *info, const running_info_t *prev, uint8_t *buf, uint8_t size);
+bool running_info_delta_apply(const uint8_t *buf, uint8_t len, running_info_t *info, uint32_t *dirty);
+bool param_config_decode(const uint8_t *buf, uint8_t len, param_config_t *config);
+uint8_t param_config_encode(const param_config_t *config, uint8_t *buf, uint8_t size);
+uint8_t param_config_delta_encode(const param_config_t *config, const param_config_t *prev, uint8_t *buf, uint8_t size);
+bool param_config_delta_apply(const uint8_t *buf, uint8_t len, param_config_t *config, uint32_t *dirty);
+
+#endif /* __WIRE_CODEC_H__ */
@@ -0,0 +1,281 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "boot.h"
+#include "api_spiffs.h"
+
+/**
+ * @brief   阶段时间(多个任务写入，HTTP 工作任务读取)
+ */
+typedef struct boot_stage_slot{
+    atomic_uint start_us;
+    atomic_uint end_us;
+    atomic_int result;
+}boot_stage_slot_t;
+
+static const char *TAG = "boot";
+
+static const char *const s_stage_names[BOOT_STAGE_COUNT] = {
+    [BOOT_STAGE_NVS]      = "nvs",
+    [BOOT_STAGE_WIFI]     = "wifi",
+    [BOOT_STAGE_STORAGE]  = "storage",
+    [BOOT_STAGE_HTTPD]    = "httpd",
+    [BOOT_STAGE_UART]     = "uart",
+    [BOOT_STAGE_FS_MOUNT] = "fs_mount",
+    [BOOT_STAGE_FS_CHECK] = "fs_check",
+};
+
+static boot_stage_slot_t s_stages[BOOT_STAGE_COUNT];
+static uint32_t s_app_main_us = 0;
+static atomic_uint s_first_ping_us = 0;
+static esp_reset_reason_t s_reset_reason = ESP_RST_UNKNOWN;
+static bool s_unclean = false;
+static atomic_bool s_fs_ready = false;
+static void (*s_on_mounted)(void) = NULL;
+
+/**
+  * @brief  启动后的微秒数
+  * @param  无
+  * @retval 微秒数，至少为 1(0 表示没有发生)
+  */
+static uint32_t boot_now_us(void)
+{
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    return (now != 0) ? now : 1;
+}
+
+/**
+  * @brief  记录进入 app_main 的时间和复位原因
+  * @param  无
+  * @retval 无
+  * @note   在 app_main 开头调用
+  */
+void boot_init(void)
+{
+    s_app_main_us = boot_now_us();
+    s_reset_reason = esp_reset_reason();
+    switch (s_reset_reason)
+    {
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_BROWNOUT:
+        s_unclean = true;
+        break;
+    default:
+        /* 上电和软件复位: 运行中不写 SPIFFS，断电不会损坏文件系统 */
+        s_unclean = false;
+        break;
+    }
+    ESP_LOGI(TAG, "reset: %s%s", boot_reset_reason_name(s_reset_reason), s_unclean ? " (unclean)" : "");
+}
+
+/**
+  * @brief  阶段开始
+  * @param  stage 阶段
+  * @retval 无
+  */
+void boot_stage_begin(boot_stage_t stage)
+{
+    atomic_store(&s_stages[stage].end_us, 0);
+    atomic_store(&s_stages[stage].start_us, boot_now_us());
+}
+
+/**
+  * @brief  阶段结束
+  * @param  stage 阶段
+  * @param  result 结果
+  * @retval 无
+  * @note   每个阶段只记录第一次结束(Wi-Fi 的 AP 启动事件可能重复)
+  */
+void boot_stage_end(boot_stage_t stage, esp_err_t result)
+{
+    boot_stage_slot_t *slot = &s_stages[stage];
+    unsigned int expected = 0;
+    uint32_t start = atomic_load(&slot->start_us);
+    uint32_t now = boot_now_us();
+
+    if (start == 0)
+    {
+        return;
+    }
+    atomic_store(&slot->result, result);
+    if (atomic_compare_exchange_strong(&slot->end_us, &expected, now))
+    {
+        ESP_LOGI(TAG, "%s: %lu ms%s", s_stage_names[stage], (unsigned long)((now - start) / 1000),
+                 (result == ESP_OK) ? "" : " (failed)");
+    }
+}
+
+/**
+  * @brief  记录第一次响应 /api/ping 的时间
+  * @param  无
+  * @retval 无
+  * @note   现场断电重启后从上电到第一次 ping 成功的时间是主要指标
+  */
+void boot_first_ping(void)
+{
+    unsigned int expected = 0;
+    uint32_t now = boot_now_us();
+
+    if (atomic_load_explicit(&s_first_ping_us, memory_order_relaxed) == 0 &&
+        atomic_compare_exchange_strong(&s_first_ping_us, &expected, now))
+    {
+        ESP_LOGI(TAG, "first ping at %lu ms", (unsigned long)(now / 1000));
+    }
+}
+
+/**
+  * @brief  后台挂载和检查 SPIFFS 的任务
+  * @param  arg 未使用
+  * @retval 无
+  * @note   挂载完成后调用 on_mounted 并允许访问网页文件；只在异常复位、分区信息不一致
+  *         或上次检查被中断时，降到最低优先级做整片检查，完成后任务删除自身
+  */
+static void boot_fs_task(void *arg)
+{
+    nvs_handle_t nvs = 0;
+    uint8_t pending = 0;
+    bool inconsistent = false;
+    esp_err_t ret;
+
+    (void)arg;
+    boot_stage_begin(BOOT_STAGE_FS_MOUNT);
+    ret = api_spiffs_mount(&inconsistent);
+    if (ret == ESP_OK && s_on_mounted != NULL)
+    {
+        s_on_mounted();
+    }
+    boot_stage_end(BOOT_STAGE_FS_MOUNT, ret);
+    if (ret != ESP_OK)
+    {
+        vTaskDelete(NULL);
+        return;
+    }
+    atomic_store(&s_fs_ready, true);
+
+    if (nvs_open(BOOT_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK)
+    {
+        nvs = 0;
+    }
+    else if (nvs_get_u8(nvs, BOOT_NVS_FS_CHECK_KEY, &pending) != ESP_OK)
+    {
+        pending = 0;
+    }
+
+    if (s_unclean || inconsistent || pending != 0)
+    {
+        ESP_LOGW(TAG, "fs check needed (unclean %d, inconsistent %d, interrupted %d)", s_unclean, inconsistent,
+                 pending != 0);
+        vTaskPrioritySet(NULL, BOOT_FS_CHECK_PRIO);
+        if (nvs != 0)
+        {
+            nvs_set_u8(nvs, BOOT_NVS_FS_CHECK_KEY, 1);
+            nvs_commit(nvs);
+        }
+        boot_stage_begin(BOOT_STAGE_FS_CHECK);
+        ret = api_spiffs_check();
+        boot_stage_end(BOOT_STAGE_FS_CHECK, ret);
+        if (nvs != 0)
+        {
+            nvs_erase_key(nvs, BOOT_NVS_FS_CHECK_KEY);
+            nvs_commit(nvs);
+        }
+    }
+    if (nvs != 0)
+    {
+        nvs_close(nvs);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+  * @brief  启动后台文件系统任务
+  * @param  on_mounted 挂载成功后调用(在后台任务中)，可以为 NULL
+  * @retval ESP_OK - 成功，其他失败
+  * @note   在 nvs_flash_init 之后调用，与 Wi-Fi、HTTP 服务的启动并行
+  */
+esp_err_t boot_fs_start(void (*on_mounted)(void))
+{
+    s_on_mounted = on_mounted;
+    if (xTaskCreate(boot_fs_task, "boot_fs", BOOT_FS_TASK_STACK, NULL, BOOT_FS_MOUNT_PRIO, NULL) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+  * @brief  网页文件是否可以访问
+  * @param  无
+  * @retval true - SPIFFS 已挂载
+  */
+bool boot_fs_ready(void)
+{
+    return atomic_load(&s_fs_ready);
+}
+
+/**
+  * @brief  读取启动时间线
+  * @param  timeline 输出
+  * @retval 无
+  */
+void boot_timeline_get(boot_timeline_t *timeline)
+{
+    timeline->app_main_us = s_app_main_us;
+    timeline->first_ping_us = atomic_load(&s_first_ping_us);
+    timeline->reset_reason = (uint8_t)s_reset_reason;
+    timeline->unclean = s_unclean;
+    timeline->fs_ready = boot_fs_ready();
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        timeline->stages[i].start_us = atomic_load(&s_stages[i].start_us);
+        timeline->stages[i].end_us = atomic_load(&s_stages[i].end_us);
+        timeline->stages[i].result = atomic_load(&s_stages[i].result);
+    }
+}
+
+/**
+  * @brief  获取阶段名称
+  * @param  stage 阶段
+  * @retval 名称
+  */
+const char *boot_stage_name(boot_stage_t stage)
+{
+    return (stage < BOOT_STAGE_COUNT) ? s_stage_names[stage] : "?";
+}
+
+/**
+  * @brief  获取复位原因名称
+  * @param  reason esp_reset_reason_t
+  * @retval 名称
+  */
+const char *boot_reset_reason_name(uint8_t reason)
+{
+    switch ((esp_reset_reason_t)reason)
+    {
+    case ESP_RST_POWERON:   return "poweron";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "int_wdt";
+    case ESP_RST_TASK_WDT:  return "task_wdt";
+    case ESP_RST_WDT:       return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deepsleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    default:                return "other";
+    }
+}
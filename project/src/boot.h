@@ -0,0 +1,66 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __BOOT_H__
+#define __BOOT_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define BOOT_FS_TASK_STACK              (4096)
+#define BOOT_FS_MOUNT_PRIO              (4)     // 挂载: 低于 HTTP 服务任务，不拖慢接口
+#define BOOT_FS_CHECK_PRIO              (1)     // 检查: 只在空闲时运行
+#define BOOT_NVS_NAMESPACE              "boot"
+#define BOOT_NVS_FS_CHECK_KEY           "fs_check"  // 检查开始时置位，完成后清除，断电中断的检查下次重做
+
+/**
+ * @brief   启动阶段
+ */
+typedef enum{
+    BOOT_STAGE_NVS = 0,             // nvs_flash_init
+    BOOT_STAGE_WIFI,                // 初始化 Wi-Fi 到 AP 启动(WIFI_EVENT_AP_START)
+    BOOT_STAGE_STORAGE,             // 载入授权卡表、参数配置、充电记录，挂载告警日志
+    BOOT_STAGE_HTTPD,               // 工作任务、HTTP 服务、推送任务
+    BOOT_STAGE_UART,                // 主控板串口
+    BOOT_STAGE_FS_MOUNT,            // 挂载 SPIFFS(后台任务)
+    BOOT_STAGE_FS_CHECK,            // 检查 SPIFFS(后台任务，只在异常复位后)
+    BOOT_STAGE_COUNT,
+}boot_stage_t;
+
+/**
+ * @brief   一个阶段的时间(启动后的微秒数)，start_us 为 0 表示没有执行
+ */
+typedef struct boot_stage_time{
+    uint32_t start_us;
+    uint32_t end_us;                // 0 表示还没有完成
+    esp_err_t result;
+}boot_stage_time_t;
+
+/**
+ * @brief   启动时间线
+ */
+typedef struct boot_timeline{
+    uint32_t app_main_us;           // 进入 app_main 的时间
+    uint32_t first_ping_us;         // 第一次响应 /api/ping 的时间，0 表示还没有
+    uint8_t reset_reason;           // esp_reset_reason_t
+    bool unclean;                   // 上次是异常复位(崩溃、看门狗、掉电检测)
+    bool fs_ready;                  // 网页文件可以访问
+    boot_stage_time_t stages[BOOT_STAGE_COUNT];
+}boot_timeline_t;
+
+/* public function protypes ------------------------------------------------- */
+void boot_init(void);
+void boot_stage_begin(boot_stage_t stage);
+void boot_stage_end(boot_stage_t stage, esp_err_t result);
+void boot_first_ping(void);
+esp_err_t boot_fs_start(void (*on_mounted)(void));
+bool boot_fs_ready(void);
+void boot_timeline_get(boot_timeline_t *timeline);
+const char *boot_stage_name(boot_stage_t stage);
+const char *boot_reset_reason_name(uint8_t reason);
+
+#endif /* __BOOT_H__ */
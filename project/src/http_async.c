@@ -0,0 +1,233 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "http_async.h"
+#include "mem_diag.h"
+
+/**
+ * @brief   队列中的一个请求
+ */
+typedef struct http_async_job{
+    httpd_req_t *req;                       // httpd_req_async_handler_begin 复制的请求
+    const http_async_route_t *route;
+    void *user_ctx;                         // 交给处理函数的 user_ctx
+}http_async_job_t;
+
+static const char *TAG = "http_async";
+
+static QueueHandle_t s_queue[2] = {NULL, NULL};     // 以 http_async_lane_t 为下标
+static SemaphoreHandle_t s_pending = NULL;          // 两个队列中的请求总数
+static TaskHandle_t s_workers[HTTP_ASYNC_WORKERS];
+static atomic_uint s_queued = 0;
+static atomic_uint s_rejected = 0;
+static atomic_uint s_peak[2] = {0, 0};
+
+/**
+  * @brief  判断当前是否在工作任务中
+  * @param  无
+  * @retval true - 是
+  */
+static bool http_async_on_worker(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    for (int i = 0; i < HTTP_ASYNC_WORKERS; i++)
+    {
+        if (s_workers[i] == self)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+  * @brief  执行一个请求并结束异步处理
+  * @param  job 请求
+  * @retval 无
+  */
+static void http_async_run(const http_async_job_t *job)
+{
+    job->req->user_ctx = job->user_ctx;
+    job->route->handler(job->req);
+    httpd_req_async_handler_complete(job->req);
+}
+
+/**
+  * @brief  接口专用工作任务
+  * @param  arg 未使用
+  * @retval 无
+  * @note   只处理接口队列，接口请求不会排在读闪存的静态文件后面
+  */
+static void http_async_high_worker(void *arg)
+{
+    http_async_job_t job;
+
+    while (1)
+    {
+        if (xQueueReceive(s_queue[HTTP_ASYNC_LANE_HIGH], &job, portMAX_DELAY) == pdTRUE)
+        {
+            http_async_run(&job);
+        }
+    }
+}
+
+/**
+  * @brief  通用工作任务
+  * @param  arg 未使用
+  * @retval 无
+  * @note   先取接口队列，接口队列为空时才处理静态文件。s_pending 的计数不小于两个队列中
+  *         的请求数(接口专用任务取走请求时不减计数)，取到空时直接进入下一轮
+  */
+static void http_async_worker(void *arg)
+{
+    http_async_job_t job;
+
+    while (1)
+    {
+        xSemaphoreTake(s_pending, portMAX_DELAY);
+        if (xQueueReceive(s_queue[HTTP_ASYNC_LANE_HIGH], &job, 0) == pdTRUE ||
+            xQueueReceive(s_queue[HTTP_ASYNC_LANE_LOW], &job, 0) == pdTRUE)
+        {
+            http_async_run(&job);
+        }
+    }
+}
+
+/**
+  * @brief  回复 503，提示客户端稍后重试
+  * @param  r http请求句柄
+  * @retval ESP_OK
+  */
+static esp_err_t http_async_reject(httpd_req_t *r)
+{
+    atomic_fetch_add(&s_rejected, 1);
+    httpd_resp_set_status(r, "503 Service Unavailable");
+    httpd_resp_set_hdr(r, "Retry-After", HTTP_ASYNC_RETRY_AFTER_S);
+    httpd_resp_set_type(r, "text/plain");
+    httpd_resp_sendstr(r, "busy");
+    return ESP_OK;
+}
+
+/**
+  * @brief  启动工作任务
+  * @param  无
+  * @retval ESP_OK - 成功，其他失败
+  * @note   在 HTTP 服务启动之前调用；第一个工作任务只处理接口请求，其余的两种都处理
+  */
+esp_err_t http_async_start(void)
+{
+    s_queue[HTTP_ASYNC_LANE_HIGH] = xQueueCreate(HTTP_ASYNC_HIGH_QUEUE_LEN, sizeof(http_async_job_t));
+    s_queue[HTTP_ASYNC_LANE_LOW] = xQueueCreate(HTTP_ASYNC_LOW_QUEUE_LEN, sizeof(http_async_job_t));
+    s_pending = xSemaphoreCreateCounting(HTTP_ASYNC_HIGH_QUEUE_LEN + HTTP_ASYNC_LOW_QUEUE_LEN, 0);
+    if (s_queue[0] == NULL || s_queue[1] == NULL || s_pending == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < HTTP_ASYNC_WORKERS; i++)
+    {
+        if (xTaskCreate(i == 0 ? http_async_high_worker : http_async_worker, "http_worker", HTTP_ASYNC_WORKER_STACK, NULL,
+                        HTTP_ASYNC_WORKER_PRIO, &s_workers[i]) != pdPASS)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+        mem_diag_task_register(s_workers[i], HTTP_ASYNC_WORKER_STACK, MEM_SUBSYS_HTTP);
+    }
+    ESP_LOGI(TAG, "%d workers started", HTTP_ASYNC_WORKERS);
+    return ESP_OK;
+}
+
+/**
+  * @brief  异步路由的处理函数(httpd_uri_t.handler)
+  * @param  r http请求句柄，user_ctx 指向 http_async_route_t
+  * @retval ESP_OK - 成功，其他失败
+  * @note   在 HTTP 服务任务中只复制请求并放入对应队列，立即返回处理下一个连接；
+  *         队列满时回复 503 + Retry-After，不让慢请求在服务任务中堆积。
+  *         工作任务未启动时退化为同步处理
+  */
+esp_err_t http_async_dispatch(httpd_req_t *r)
+{
+    const http_async_route_t *route = (const http_async_route_t *)r->user_ctx;
+    http_async_job_t job = { .route = route, .user_ctx = route->user_ctx };
+    QueueHandle_t queue = s_queue[route->lane];
+    uint32_t depth;
+    uint32_t peak;
+
+    if (queue == NULL || http_async_on_worker())
+    {
+        r->user_ctx = route->user_ctx;
+        return route->handler(r);
+    }
+
+    if (uxQueueSpacesAvailable(queue) == 0)
+    {
+        return http_async_reject(r);
+    }
+    if (httpd_req_async_handler_begin(r, &job.req) != ESP_OK)
+    {
+        return http_async_reject(r);
+    }
+    /* http_async_resume 可能在检查空位之后占满队列，此时同样回复 503 */
+    if (xQueueSend(queue, &job, 0) != pdTRUE)
+    {
+        httpd_req_async_handler_complete(job.req);
+        return http_async_reject(r);
+    }
+    xSemaphoreGive(s_pending);
+
+    atomic_fetch_add(&s_queued, 1);
+    depth = (uint32_t)uxQueueMessagesWaiting(queue);
+    peak = atomic_load(&s_peak[route->lane]);
+    while (depth > peak && !atomic_compare_exchange_weak(&s_peak[route->lane], &peak, depth))
+    {
+    }
+    return ESP_OK;
+}
+
+/**
+  * @brief  把已经脱离 HTTP 服务任务的请求交给工作任务继续处理
+  * @param  req httpd_req_async_handler_begin 复制的请求
+  * @param  route 继续处理的路由(只使用 handler 和 lane)
+  * @param  user_ctx 交给处理函数的 user_ctx
+  * @retval ESP_OK - 已放入队列，处理函数返回后自动结束异步处理；
+  *         其他 - 队列已满或工作任务未启动，请求仍由调用者负责回复并结束
+  * @note   可以在任意任务中调用，不阻塞；用于等待其它模块(如串口应答)的请求
+  *         在结果到达时回复，回复的网络发送不占用调用者的任务
+  */
+esp_err_t http_async_resume(httpd_req_t *req, const http_async_route_t *route, void *user_ctx)
+{
+    http_async_job_t job = { .req = req, .route = route, .user_ctx = user_ctx };
+    QueueHandle_t queue = s_queue[route->lane];
+
+    if (queue == NULL || xQueueSend(queue, &job, 0) != pdTRUE)
+    {
+        return ESP_FAIL;
+    }
+    xSemaphoreGive(s_pending);
+    atomic_fetch_add(&s_queued, 1);
+    return ESP_OK;
+}
+
+/**
+  * @brief  获取运行统计
+  * @param  stats 输出
+  * @retval 无
+  */
+void http_async_stats_get(http_async_stats_t *stats)
+{
+    stats->queued = atomic_load(&s_queued);
+    stats->rejected = atomic_load(&s_rejected);
+    stats->high_peak = atomic_load(&s_peak[HTTP_ASYNC_LANE_HIGH]);
+    stats->low_peak = atomic_load(&s_peak[HTTP_ASYNC_LANE_LOW]);
+}
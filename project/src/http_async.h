@@ -0,0 +1,56 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __HTTP_ASYNC_H__
+#define __HTTP_ASYNC_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#define HTTP_ASYNC_WORKERS              (2)     // 工作任务数(第一个只处理接口请求)
+#define HTTP_ASYNC_WORKER_STACK         (8192)  // 与 HTTP 服务任务一致(静态文件分块缓冲区在栈上)
+#define HTTP_ASYNC_WORKER_PRIO          (5)     // 与 HTTP 服务任务一致
+#define HTTP_ASYNC_HIGH_QUEUE_LEN       (6)     // 接口请求队列长度
+#define HTTP_ASYNC_LOW_QUEUE_LEN        (4)     // 静态文件请求队列长度
+#define HTTP_ASYNC_RETRY_AFTER_S        "1"     // 队列满时 503 响应的 Retry-After
+
+/**
+ * @brief   队列优先级
+ */
+typedef enum{
+    HTTP_ASYNC_LANE_HIGH = 0,       // 轻量的只读接口，优先处理
+    HTTP_ASYNC_LANE_LOW,            // 静态文件等读闪存的请求
+}http_async_lane_t;
+
+/**
+ * @brief   异步处理的路由，作为 httpd_uri_t.user_ctx，处理函数为 http_async_dispatch
+ * @note    handler 在工作任务中执行，只能访问线程安全的数据(快照、带锁的模块)；
+ *          修改授权卡表等只允许 HTTP 服务任务写入的处理函数不能异步
+ */
+typedef struct http_async_route{
+    esp_err_t (*handler)(httpd_req_t *r);   // 实际的处理函数
+    void *user_ctx;                         // 交给实际处理函数的 user_ctx
+    http_async_lane_t lane;                 // 队列优先级
+}http_async_route_t;
+
+/**
+ * @brief   运行统计
+ */
+typedef struct http_async_stats{
+    uint32_t queued;                // 进入队列的请求数
+    uint32_t rejected;              // 队列满被拒绝(503)的请求数
+    uint32_t high_peak;             // 接口队列的最大深度
+    uint32_t low_peak;              // 静态文件队列的最大深度
+}http_async_stats_t;
+
+/* public function protypes ------------------------------------------------- */
+esp_err_t http_async_start(void);
+esp_err_t http_async_dispatch(httpd_req_t *r);
+esp_err_t http_async_resume(httpd_req_t *req, const http_async_route_t *route, void *user_ctx);
+void http_async_stats_get(http_async_stats_t *stats);
+
+#endif /* __HTTP_ASYNC_H__ */
@@ -1,42 +1,66 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_err.h"
 #include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_mac.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_http_server.h"
+#include "driver/uart.h"
 
 #include "nvs_flash.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
-#include "cJSON.h"
 
 #include "api_spiffs.h"
+#include "boot.h"
+#include "card_codec.h"
+#include "card_store.h"
+#include "http_async.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "mem_diag.h"
+#include "web_assets.h"
+#include "status_push.h"
+#include "storage.h"
 #include "system.h"
+#include "telemetry.h"
+#include "panel_uart_api.h"
+#include "sessions.h"
+#include "wire_codec.h"
 
 
 
 static const char *TAG = "main";
-static char http_req_handler_buf[20480];
 
 static esp_err_t handler_ping(httpd_req_t *r);
-static esp_err_t handler_get_index_page(httpd_req_t *r);
-static esp_err_t handler_get_favicon(httpd_req_t *r);
-static esp_err_t handler_get_css(httpd_req_t *r);
-static esp_err_t handler_get_js(httpd_req_t *r);
+#ifdef WEB_ASSETS_EMBEDDED
+static esp_err_t handler_get_embedded(httpd_req_t *r);
+#else
+static esp_err_t handler_get_static(httpd_req_t *r);
+#endif
 static esp_err_t handler_get_api_status(httpd_req_t *r);
 static esp_err_t handler_get_api_config(httpd_req_t *r);
 static esp_err_t handler_post_api_config(httpd_req_t *r);
 static esp_err_t handler_api_cards_get(httpd_req_t *r);
 static esp_err_t handler_api_cards_post(httpd_req_t *r);
 static esp_err_t handler_api_cards_delete(httpd_req_t *r);
+static esp_err_t handler_api_cards_bulk_post(httpd_req_t *r);
+static esp_err_t handler_api_cards_export(httpd_req_t *r);
 static esp_err_t handler_api_alarms_get(httpd_req_t *r);
 static esp_err_t handler_api_alarms_delete(httpd_req_t *r);
+static esp_err_t handler_api_history(httpd_req_t *r);
+static esp_err_t handler_api_sessions(httpd_req_t *r);
+static esp_err_t handler_api_diag_mem(httpd_req_t *r);
+static esp_err_t handler_api_diag_boot(httpd_req_t *r);
+static esp_err_t handler_api_diag_uart_capture(httpd_req_t *r);
 
 /* The examples use WiFi configuration that you can set via project configuration menu.
 
@@ -48,37 +72,131 @@ static esp_err_t handler_api_alarms_delete(httpd_req_t *r);
 #define EXAMPLE_ESP_WIFI_CHANNEL   (5)
 #define EXAMPLE_MAX_STA_CONN       (5)
 
+/* 与主控板通信的串口配置 */
+#define PANEL_UART_NUM             UART_NUM_1
+#define PANEL_UART_BAUD_RATE       (115200)
+#define PANEL_UART_TX_PIN          (17)
+#define PANEL_UART_RX_PIN          (18)
+#define PANEL_UART_DRV_BUF_LEN     (2048)   // 驱动层收/发缓冲区
+#define PANEL_UART_RX_CHUNK        (256)    // 单次从驱动读出的最大字节数
+#define PANEL_UART_TASK_STACK      (4096)
+#define PANEL_UART_CAPTURE_LEN     (256 * 1024) // 收发记录(PSRAM)，115200bps 双向满载约 10 秒
+#define PANEL_UART_CAPTURE_MIN_LEN (16 * 1024)  // 没有 PSRAM 时改用内部 RAM 的大小
+
+/* 刷卡鉴权(FN_UPDT_RFID_CARD)的数据内容长度 */
+#define RFID_SWIPE_LEN             (6)      // 上报: 卡号4 + 当天2
+#define RFID_RESULT_LEN            (5)      // 回复: 卡号4 + 结果1
+
+/* 告警记录(FN_UPDT_ALARM_RECORD)的数据内容长度: 时间4 + 告警码2 + 标志1 */
+#define ALARM_REPORT_LEN           (7)
+#define ALARM_PAGE_DEFAULT         (50)     // GET /api/alarms 默认每页条数
+#define ALARM_PAGE_MAX             (200)    // GET /api/alarms 每页最大条数
+#define ALARM_READ_BATCH           (25)     // 每次从闪存读出的条数
+
+#define HISTORY_READ_BATCH         (16)     // GET /api/history 每次拷贝的点数
+#define HISTORY_BIN_MAGIC          (0x4854) // 二进制历史数据的魔数 "TH"
+#define HISTORY_BIN_VERSION        (1)
+#define HISTORY_BIN_HEAD_LEN       (16 + 2 * HISTORY_CHANNELS)  // 魔数2 + 版本1 + 通道数1 + 周期4 + 起始时间4 + 点数4 + 量化倍数
+
+#define DIAG_MEM_BIN_MAGIC         (0x4D4D) // 二进制内存快照的魔数 "MM"
+#define DIAG_MEM_BIN_VERSION       (1)
+#define DIAG_MEM_BIN_HEAD_LEN      (12)     // 魔数2 + 版本1 + 标志1 + 运行时间4 + 子系统数1 + 任务数1 + 静态块数1 + 保留1
+#define DIAG_MEM_BIN_HEAP_LEN      (16)     // 总大小4 + 空闲4 + 最低空闲4 + 最大空闲块4
+#define DIAG_MEM_BIN_SUBSYS_LEN    (16)     // 分配4 + 释放4 + 字节4 + 失败4
+#define DIAG_MEM_BIN_TASK_LEN      (MEM_DIAG_NAME_LEN + 9)  // 名称 + 子系统1 + 栈大小4 + 栈最低剩余4
+#define DIAG_MEM_BIN_STATIC_LEN    (MEM_DIAG_NAME_LEN + 4)  // 名称 + 字节数4
+#define DIAG_MEM_BIN_MAX_LEN       (DIAG_MEM_BIN_HEAD_LEN + 2 * DIAG_MEM_BIN_HEAP_LEN + \
+                                    MEM_SUBSYS_COUNT * DIAG_MEM_BIN_SUBSYS_LEN + \
+                                    MEM_DIAG_MAX_TASKS * DIAG_MEM_BIN_TASK_LEN + \
+                                    MEM_DIAG_MAX_STATICS * DIAG_MEM_BIN_STATIC_LEN)
+
+#define HTTP_SERVER_STACK_SIZE     (8192)   // 静态文件分块发送使用栈上缓冲区
+#define HTTP_STATIC_CHUNK_LEN      (1024)   // 静态文件分块发送的块大小
+#define HTTP_ETAG_LEN              (24)     // ETag 最大长度(含引号)
+#define HTTP_JSON_BUF_LEN          (512)    // JSON 响应的输出缓冲区，写满后分块发送
+#define HTTP_RECV_CHUNK_LEN        (128)    // 请求体分块接收的块大小
+#define HTTP_JSON_BODY_MAX_LEN     (1024)   // JSON 请求体的最大长度
+#define HTTP_CARD_BULK_MAX_LEN     (32 * 1024)  // 批量导入请求体的最大长度
+
+#define ARRAY_SIZE(a)              (sizeof(a) / sizeof((a)[0]))
+
+/**
+ * @brief   SPIFFS 中的静态资源
+ * @note    构建时 tools/web_assets.py 为每个资源生成 <path>.gz 和 <path>.etag
+ */
+typedef struct static_asset{
+    const char *path;                       // 文件路径
+    const char *type;                       // Content-Type
+    char etag[HTTP_ETAG_LEN];               // 内容哈希，首次请求时从 .etag 文件载入
+    bool etag_loaded;                       // 是否已尝试载入 etag
+}static_asset_t;
+
+#ifdef WEB_ASSETS_EMBEDDED
+/* 网页资源编译进固件，由一个通配符处理程序在常量表中查找(必须最后注册) */
+static const httpd_uri_t get_embedded_asset = 
+{
+    .uri        = "/*",
+    .method     = HTTP_GET,
+    .handler    = handler_get_embedded,
+    .user_ctx   = NULL,
+};
+#else
+static static_asset_t s_asset_index   = { .path = "/spiffs/index.html",    .type = "text/html" };
+static static_asset_t s_asset_favicon = { .path = "/spiffs/favicon.ico",   .type = "image/x-icon" };
+static static_asset_t s_asset_css     = { .path = "/spiffs/css/style.css", .type = "text/css" };
+static static_asset_t s_asset_js      = { .path = "/spiffs/js/script.js",  .type = "application/javascript" };
+static static_asset_t *const s_static_assets[] = { &s_asset_index, &s_asset_favicon, &s_asset_css, &s_asset_js };
+
+/* 静态文件读 SPIFFS，放入低优先级队列由工作任务发送 */
+static const http_async_route_t s_route_index   = { handler_get_static, &s_asset_index,   HTTP_ASYNC_LANE_LOW };
+static const http_async_route_t s_route_favicon = { handler_get_static, &s_asset_favicon, HTTP_ASYNC_LANE_LOW };
+static const http_async_route_t s_route_css     = { handler_get_static, &s_asset_css,     HTTP_ASYNC_LANE_LOW };
+static const http_async_route_t s_route_js      = { handler_get_static, &s_asset_js,      HTTP_ASYNC_LANE_LOW };
+
 static const httpd_uri_t get_index_page = 
 {
     .uri        = "/",
     .method     = HTTP_GET,
-    .handler    = handler_get_index_page,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_index,
 };
 
 static const httpd_uri_t get_favicon = 
 {
     .uri        = "/favicon.ico",
     .method     = HTTP_GET,
-    .handler    = handler_get_favicon,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_favicon,
 };
 
 static const httpd_uri_t get_css = 
 {
     .uri        = "/css/style.css",
     .method     = HTTP_GET,
-    .handler    = handler_get_css,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_css,
 };
 
 static const httpd_uri_t get_js = 
 {
     .uri        = "/js/script.js",
     .method     = HTTP_GET,
-    .handler    = handler_get_js,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_js,
 };
+#endif
+
+/* 只读、线程安全(快照或带锁的模块)的接口，放入高优先级队列由工作任务处理；
+   授权卡表只允许 HTTP 服务任务写入和遍历，卡片相关的处理函数仍在服务任务中同步执行 */
+static const http_async_route_t s_route_status    = { handler_get_api_status, NULL, HTTP_ASYNC_LANE_HIGH };
+static const http_async_route_t s_route_config    = { handler_get_api_config, NULL, HTTP_ASYNC_LANE_HIGH };
+static const http_async_route_t s_route_alarms    = { handler_api_alarms_get, NULL, HTTP_ASYNC_LANE_HIGH };
+static const http_async_route_t s_route_history   = { handler_api_history, NULL, HTTP_ASYNC_LANE_HIGH };
+static const http_async_route_t s_route_sessions  = { handler_api_sessions, NULL, HTTP_ASYNC_LANE_HIGH };
+static const http_async_route_t s_route_diag_mem  = { handler_api_diag_mem, NULL, HTTP_ASYNC_LANE_HIGH };
+static const http_async_route_t s_route_diag_boot = { handler_api_diag_boot, NULL, HTTP_ASYNC_LANE_HIGH };
+/* 下载收发记录要发送几百 KB，放入低优先级队列 */
+static const http_async_route_t s_route_diag_uart_capture = { handler_api_diag_uart_capture, NULL, HTTP_ASYNC_LANE_LOW };
 
 static const httpd_uri_t get_api_ping = {
     .uri        = "/api/ping",
@@ -90,15 +208,15 @@ static const httpd_uri_t get_api_ping = {
 static const httpd_uri_t get_api_status = {
     .uri        = "/api/status",
     .method     = HTTP_GET,
-    .handler    = handler_get_api_status,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_status,
 };
 
 static const httpd_uri_t get_api_config_get = {
     .uri        = "/api/config",
     .method     = HTTP_GET,
-    .handler    = handler_get_api_config,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_config,
 };
 
 static const httpd_uri_t post_api_config_post = {
@@ -129,11 +247,25 @@ static const httpd_uri_t get_api_cards_delete = {
     .user_ctx   = NULL,
 };
 
+static const httpd_uri_t post_api_cards_bulk = {
+    .uri        = "/api/cards/bulk",
+    .method     = HTTP_POST,
+    .handler    = handler_api_cards_bulk_post,
+    .user_ctx   = NULL,
+};
+
+static const httpd_uri_t get_api_cards_export = {
+    .uri        = "/api/cards/export",  // ?format=bin(默认) 或 ?format=csv
+    .method     = HTTP_GET,
+    .handler    = handler_api_cards_export,
+    .user_ctx   = NULL,
+};
+
 static const httpd_uri_t get_api_alarms_get = {
     .uri        = "/api/alarms",
     .method     = HTTP_GET,
-    .handler    = handler_api_alarms_get,
-    .user_ctx   = NULL,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_alarms,
 };
 
 static const httpd_uri_t get_api_alarms_delete = {
@@ -143,11 +275,48 @@ static const httpd_uri_t get_api_alarms_delete = {
     .user_ctx   = NULL,
 };
 
+static const httpd_uri_t get_api_history = {
+    .uri        = "/api/history",
+    .method     = HTTP_GET,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_history,
+};
+
+static const httpd_uri_t get_api_sessions = {
+    .uri        = "/api/sessions",
+    .method     = HTTP_GET,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_sessions,
+};
+
+static const httpd_uri_t get_api_diag_mem = {
+    .uri        = "/api/diag/mem",
+    .method     = HTTP_GET,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_diag_mem,
+};
+
+static const httpd_uri_t get_api_diag_boot = {
+    .uri        = "/api/diag/boot",
+    .method     = HTTP_GET,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_diag_boot,
+};
+
+static const httpd_uri_t get_api_diag_uart_capture = {
+    .uri        = "/api/diag/uart-capture",
+    .method     = HTTP_GET,
+    .handler    = http_async_dispatch,
+    .user_ctx   = (void *)&s_route_diag_uart_capture,
+};
+
 static const httpd_uri_t *http_uri_array[] = {
+#ifndef WEB_ASSETS_EMBEDDED
     &get_index_page,
     &get_favicon,
     &get_css,
     &get_js,
+#endif
     &get_api_ping,
     &get_api_status,
     &get_api_config_get,
@@ -155,150 +324,352 @@ static const httpd_uri_t *http_uri_array[] = {
     &get_api_cards_get,
     &get_api_cards_post,
     &get_api_cards_delete,
+    &post_api_cards_bulk,
+    &get_api_cards_export,
     &get_api_alarms_get,
     &get_api_alarms_delete,
+    &get_api_history,
+    &get_api_sessions,
+    &get_api_diag_mem,
+    &get_api_diag_boot,
+    &get_api_diag_uart_capture,
+    &ws_status,
+#ifdef WEB_ASSETS_EMBEDDED
+    &get_embedded_asset,
+#endif
     NULL
 };
 
-static esp_err_t handler_get_index_page(httpd_req_t *r)
+/**
+  * @brief  设置缓存相关的响应头，并处理协商缓存
+  * @param  r http请求句柄
+  * @param  etag 资源的 ETag(含引号)，为空时不做协商
+  * @retval true - 客户端缓存仍然有效，已回复 304
+  */
+static bool http_etag_not_modified(httpd_req_t *r, const char *etag)
 {
-    char*  buf;         //request的缓存数据buffer
-    size_t buf_len;     //request的缓存数据length
-    int response;
-    /* 解析请求 */
-    /* 1.获取HOST字段的长度，分配空间，加入缓存 */
-    buf_len = httpd_req_get_hdr_value_len(r, "Host") + 1;
-    if (buf_len > 1) 
+    char inm[HTTP_ETAG_LEN];
+
+    if (etag == NULL || etag[0] == '\0')
     {
-        buf = malloc(buf_len);
-        ESP_RETURN_ON_FALSE(buf, ESP_ERR_NO_MEM, TAG, "buffer alloc failed");
-        /* Copy null terminated value string into buffer */
-        if (httpd_req_get_hdr_value_str(r, "Host", buf, buf_len) == ESP_OK) 
-        {
-            ESP_LOGI(TAG, "Requset -> Host: %s", buf);
-        }
-        free(buf);
+        return false;
     }
 
-    /* 编码响应 */
-    /* 发送html页面 */ 
-    memset(http_req_handler_buf,0,sizeof(http_req_handler_buf));
-    spiffs_readfile("/spiffs/index.html", 20480, http_req_handler_buf);
-    response = httpd_send(r, http_req_handler_buf, strlen(http_req_handler_buf));
+    httpd_resp_set_hdr(r, "ETag", etag);
+    httpd_resp_set_hdr(r, "Cache-Control", "no-cache");
+    if (httpd_req_get_hdr_value_str(r, "If-None-Match", inm, sizeof(inm)) == ESP_OK &&
+        strcmp(inm, etag) == 0)
+    {
+        httpd_resp_set_status(r, "304 Not Modified");
+        httpd_resp_send(r, NULL, 0);
+        return true;
+    }
+    return false;
+}
 
-    return response;
+/**
+  * @brief  JSON 写入器的输出回调，把缓冲区作为一个 HTTP 分块发送
+  * @param  ctx http请求句柄
+  * @param  buf 数据
+  * @param  len 数据长度
+  * @retval true - 发送成功
+  */
+static bool http_json_flush(void *ctx, const char *buf, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, buf, len) == ESP_OK;
 }
 
-static esp_err_t handler_get_favicon(httpd_req_t *r) {
-    // 1. 设置正确的响应类型（图标文件）
-    httpd_resp_set_type(r, "image/x-icon");
+/**
+  * @brief  开始一个 JSON 响应
+  * @param  r http请求句柄
+  * @param  w JSON 写入器
+  * @param  buf 输出缓冲区(一般在处理函数的栈上)
+  * @param  size 缓冲区大小
+  * @retval 无
+  */
+static void http_json_begin(httpd_req_t *r, json_writer_t *w, char *buf, size_t size)
+{
+    httpd_resp_set_type(r, "application/json");
+    json_writer_init(w, buf, size, http_json_flush, r);
+}
 
-    // 2. 打开文件获取信息（大小）
-    FILE *f = fopen("/spiffs/favicon.ico", "rb");
-    if (!f) {
-        ESP_LOGE(TAG, "无法打开favicon.ico");
-        httpd_resp_set_status(r, "404 Not Found");
-        httpd_resp_sendstr(r, "favicon not found");
+/**
+  * @brief  结束 JSON 响应，发送缓冲区中剩余的内容
+  * @param  r http请求句柄
+  * @param  w JSON 写入器
+  * @retval ESP_OK - 成功，其他失败
+  * @note   整个响应能放进缓冲区时一次发送(带 Content-Length)，否则以空分块结束分块传输
+  */
+static esp_err_t http_json_end(httpd_req_t *r, json_writer_t *w)
+{
+    if (!json_writer_ok(w))
+    {
+        ESP_LOGE(TAG, "json response failed after %u bytes", (unsigned)w->flushed);
+        if (w->flushed == 0)
+        {
+            httpd_resp_send_500(r);
+        }
         return ESP_FAIL;
     }
+    if (w->flushed == 0)
+    {
+        return httpd_resp_send(r, w->buf, w->len);
+    }
+    if (!json_writer_flush(w))
+    {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(r, NULL, 0);
+}
+
+/**
+  * @brief  分块接收 JSON 请求体并交给解析器
+  * @param  r http请求句柄
+  * @param  rd 已初始化的解析器
+  * @retval 解析结果
+  * @note   每次只接收 HTTP_RECV_CHUNK_LEN 字节，请求体长度不受栈上缓冲区限制，
+  *         但超过 HTTP_JSON_BODY_MAX_LEN 时直接拒绝
+  */
+static json_read_status_t http_recv_json(httpd_req_t *r, json_reader_t *rd)
+{
+    char chunk[HTTP_RECV_CHUNK_LEN];
+    size_t remaining = r->content_len;
+    json_read_status_t ret;
+    mem_subsys_t scope;
+    int len;
+
+    if (remaining > HTTP_JSON_BODY_MAX_LEN)
+    {
+        return JSON_READ_ERR_TOO_LONG;
+    }
 
-    // 3. 获取文件大小
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);  // 回到文件开头
+    scope = mem_stats_scope_enter(MEM_SUBSYS_JSON);
 
-    if (file_size <= 0 || file_size > 1024 * 1024) {  // 限制最大1MB，防止内存溢出
-        fclose(f);
-        ESP_LOGE(TAG, "无效的favicon大小: %ld", file_size);
-        httpd_resp_set_status(r, "500 Internal Error");
-        httpd_resp_sendstr(r, "invalid favicon");
-        return ESP_FAIL;
+    while (remaining > 0)
+    {
+        len = httpd_req_recv(r, chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+        if (len == HTTPD_SOCK_ERR_TIMEOUT)
+        {
+            continue;
+        }
+        if (len <= 0)
+        {
+            mem_stats_scope_exit(scope);
+            return JSON_READ_ERR_INCOMPLETE;
+        }
+        remaining -= len;
+        if (json_reader_feed(rd, chunk, len) != JSON_READ_OK)
+        {
+            break;
+        }
+    }
+    ret = json_reader_finish(rd);
+    mem_stats_scope_exit(scope);
+    return ret;
+}
+
+/**
+  * @brief  回复 400 及错误原因
+  * @param  r http请求句柄
+  * @param  msg 错误描述
+  * @param  field 出错的字段，为 NULL 时省略
+  * @retval ESP_FAIL
+  */
+static esp_err_t http_json_bad_request(httpd_req_t *r, const char *msg, const char *field)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    json_writer_t w;
+
+    httpd_resp_set_status(r, "400 Bad Request");
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_bool(&w, "success", false);
+    json_kv_string(&w, "msg", msg);
+    if (field != NULL)
+    {
+        json_kv_string(&w, "field", field);
     }
+    json_object_end(&w);
+    http_json_end(r, &w);
+    return ESP_FAIL;
+}
+
+#ifndef WEB_ASSETS_EMBEDDED
+/**
+  * @brief  载入静态资源的 ETag
+  * @param  asset 静态资源
+  * @retval 无
+  * @note   只在第一次请求时读取一次 .etag 文件，之后直接使用内存中的值
+  */
+static void static_asset_load_etag(static_asset_t *asset)
+{
+    char path[64];
+    FILE *f;
+    size_t len;
 
-    // 4. 动态分配缓冲区（或使用栈缓冲区，根据实际大小调整）
-    uint8_t *buf = malloc(file_size);
-    if (!buf) {
-        fclose(f);
-        ESP_LOGE(TAG, "内存分配失败");
-        httpd_resp_set_status(r, "500 Internal Error");
-        httpd_resp_sendstr(r, "memory error");
-        return ESP_ERR_NO_MEM;
+    if (asset->etag_loaded)
+    {
+        return;
     }
+    asset->etag_loaded = true;
 
-    // 5. 读取文件内容
-    size_t bytes_read = fread(buf, 1, file_size, f);
+    snprintf(path, sizeof(path), "%s.etag", asset->path);
+    f = fopen(path, "r");
+    if (f == NULL)
+    {
+        return;
+    }
+    len = fread(asset->etag, 1, sizeof(asset->etag) - 1, f);
     fclose(f);
+    asset->etag[len] = '\0';
+}
 
-    if (bytes_read != file_size) {
-        free(buf);
-        ESP_LOGE(TAG, "文件读取不完整: %zu/%ld", bytes_read, file_size);
-        httpd_resp_set_status(r, "500 Internal Error");
-        httpd_resp_sendstr(r, "read error");
-        return ESP_FAIL;
+/**
+  * @brief  预先载入所有静态资源的 ETag
+  * @param  无
+  * @retval 无
+  * @note   静态文件由多个工作任务并发发送，启动时一次载入后 static_asset_t 只读
+  */
+static void static_assets_preload(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_static_assets); i++)
+    {
+        static_asset_load_etag(s_static_assets[i]);
     }
+}
 
-    // 6. 发送完整的二进制数据（使用实际文件大小）
-    esp_err_t response = httpd_resp_send(r, (const char*)buf, file_size);
-    free(buf);  // 释放缓冲区
+/**
+  * @brief  判断客户端是否接受 gzip 编码
+  * @param  r http请求句柄
+  * @retval true - 接受
+  */
+static bool http_accepts_gzip(httpd_req_t *r)
+{
+    char buf[128];
+    esp_err_t ret = httpd_req_get_hdr_value_str(r, "Accept-Encoding", buf, sizeof(buf));
 
-    return response;
+    /* 头部过长时返回截断的内容，仍可用于匹配 */
+    if (ret != ESP_OK && ret != ESP_ERR_HTTPD_RESULT_TRUNC)
+    {
+        return false;
+    }
+    return strstr(buf, "gzip") != NULL;
 }
 
-static esp_err_t handler_get_css(httpd_req_t *r)
+/**
+  * @brief  通用静态文件处理
+  * @param  r http请求句柄，user_ctx 指向 static_asset_t
+  * @retval ESP_OK - 成功，其他失败
+  * @note   0. SPIFFS 在后台挂载，挂载完成之前回复 503 + Retry-After
+  *         1. If-None-Match 与构建时的 ETag 一致时直接回复 304
+  *         2. 客户端接受 gzip 且存在 .gz 文件时发送预压缩版本
+  *         3. 按固定大小分块读取和发送，不受文件大小限制，也不共用全局缓冲区
+  */
+static esp_err_t handler_get_static(httpd_req_t *r)
 {
-    char*  buf;         //request的缓存数据buffer
-    size_t buf_len;     //request的缓存数据length
-    int response;
-    /* 解析请求 */
-    /* 1.获取HOST字段的长度，分配空间，加入缓存 */
-    buf_len = httpd_req_get_hdr_value_len(r, "Host") + 1;
-    if (buf_len > 1) 
+    static_asset_t *asset = (static_asset_t *)r->user_ctx;
+    char chunk[HTTP_STATIC_CHUNK_LEN];
+    char path[64];
+    bool gzip = false;
+    FILE *f = NULL;
+    size_t len;
+
+    /* 0. 文件系统还没有挂载 */
+    if (!boot_fs_ready())
+    {
+        httpd_resp_set_status(r, "503 Service Unavailable");
+        httpd_resp_set_hdr(r, "Retry-After", HTTP_ASYNC_RETRY_AFTER_S);
+        httpd_resp_set_type(r, "text/plain");
+        return httpd_resp_sendstr(r, "starting");
+    }
+
+    /* 1. 协商缓存 */
+    static_asset_load_etag(asset);
+    if (http_etag_not_modified(r, asset->etag))
+    {
+        return ESP_OK;
+    }
+
+    /* 2. 优先选择预压缩版本 */
+    if (http_accepts_gzip(r))
+    {
+        snprintf(path, sizeof(path), "%s.gz", asset->path);
+        f = fopen(path, "rb");
+        gzip = (f != NULL);
+    }
+    if (f == NULL)
+    {
+        f = fopen(asset->path, "rb");
+    }
+    if (f == NULL)
+    {
+        ESP_LOGE(TAG, "无法打开%s", asset->path);
+        return httpd_resp_send_404(r);
+    }
+
+    httpd_resp_set_type(r, asset->type);
+    httpd_resp_set_hdr(r, "Vary", "Accept-Encoding");
+    if (gzip)
     {
-        buf = malloc(buf_len);
-        ESP_RETURN_ON_FALSE(buf, ESP_ERR_NO_MEM, TAG, "buffer alloc failed");
-        /* Copy null terminated value string into buffer */
-        if (httpd_req_get_hdr_value_str(r, "Host", buf, buf_len) == ESP_OK) 
+        httpd_resp_set_hdr(r, "Content-Encoding", "gzip");
+    }
+
+    /* 3. 分块发送 */
+    while ((len = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        if (httpd_resp_send_chunk(r, chunk, len) != ESP_OK)
         {
-            ESP_LOGI(TAG, "Requset -> Host: %s", buf);
+            fclose(f);
+            ESP_LOGW(TAG, "发送%s中断", asset->path);
+            return ESP_FAIL;
         }
-        free(buf);
     }
+    fclose(f);
 
-    /* 编码响应 */
-    memset(http_req_handler_buf,0,sizeof(http_req_handler_buf));
-    spiffs_readfile("/spiffs/css/style.css", 20480, http_req_handler_buf);
-    response = httpd_send(r, http_req_handler_buf, strlen(http_req_handler_buf));
-
-    return response;
+    return httpd_resp_send_chunk(r, NULL, 0);
 }
+#endif
 
-static esp_err_t handler_get_js(httpd_req_t *r)
+#ifdef WEB_ASSETS_EMBEDDED
+/**
+  * @brief  内嵌网页资源处理
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   在按路径排序的常量表中二分查找，直接从映射到地址空间的 flash 发送；
+  *         文本资源只内嵌了 gzip 版本，所有现代浏览器均支持
+  */
+static esp_err_t handler_get_embedded(httpd_req_t *r)
 {
-    char*  buf;         //request的缓存数据buffer
-    size_t buf_len;     //request的缓存数据length
-    int response;
-    /* 解析请求 */
-    /* 1.获取HOST字段的长度，分配空间，加入缓存 */
-    buf_len = httpd_req_get_hdr_value_len(r, "Host") + 1;
-    if (buf_len > 1) 
+    const web_asset_t *asset;
+    size_t len = strcspn(r->uri, "?#");
+
+    if (len == 1)
     {
-        buf = malloc(buf_len);
-        ESP_RETURN_ON_FALSE(buf, ESP_ERR_NO_MEM, TAG, "buffer alloc failed");
-        /* Copy null terminated value string into buffer */
-        if (httpd_req_get_hdr_value_str(r, "Host", buf, buf_len) == ESP_OK) 
-        {
-            ESP_LOGI(TAG, "Requset -> Host: %s", buf);
-        }
-        free(buf);
+        asset = web_asset_find("/index.html", strlen("/index.html"));
+    }
+    else
+    {
+        asset = web_asset_find(r->uri, len);
+    }
+    if (asset == NULL)
+    {
+        return httpd_resp_send_404(r);
     }
 
-    /* 编码响应 */
-    memset(http_req_handler_buf,0,sizeof(http_req_handler_buf));
-    spiffs_readfile("/spiffs/js/script.js", 20480, http_req_handler_buf);
-    response = httpd_send(r, http_req_handler_buf, strlen(http_req_handler_buf));
+    if (http_etag_not_modified(r, asset->etag))
+    {
+        return ESP_OK;
+    }
 
-    return response;
+    httpd_resp_set_type(r, asset->type);
+    if (asset->gzip)
+    {
+        httpd_resp_set_hdr(r, "Vary", "Accept-Encoding");
+        httpd_resp_set_hdr(r, "Content-Encoding", "gzip");
+    }
+    return httpd_resp_send(r, (const char *)asset->data, asset->len);
 }
+#endif
 
 /**
   * @brief  http_handler_ping
@@ -308,6 +679,7 @@ static esp_err_t handler_get_js(httpd_req_t *r)
   * 鉴别与服务器的连接状态
   */
 static esp_err_t handler_ping(httpd_req_t *r) {
+    boot_first_ping();
     // 设置响应状态码为 200（成功），确保 response.ok 为 true
     httpd_resp_set_status(r, "200 OK");
     // 设置响应类型（纯文本）
@@ -321,296 +693,1085 @@ static esp_err_t handler_ping(httpd_req_t *r) {
 
 
 static esp_err_t handler_get_api_status(httpd_req_t *r) {
-    // 1. 创建根JSON对象
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_500(r);  // 内存分配失败时返回500错误
-        return ESP_FAIL;
-    }
-
-    // 2. 从全局变量读取数据并添加到JSON对象
-    // 注意：volatile变量访问需确保线程安全（必要时加锁）
-    cJSON_AddNumberToObject(root, "charge_status", g_running_info.charge_status);
-    cJSON_AddNumberToObject(root, "power", g_running_info.power);
-    cJSON_AddNumberToObject(root, "voltage", g_running_info.voltage);
-    cJSON_AddNumberToObject(root, "current", g_running_info.current);
-    cJSON_AddNumberToObject(root, "net_status", g_running_info.net_status);
+    char buf[HTTP_JSON_BUF_LEN];
+    json_writer_t w;
+    running_info_t info;
+
+    // 读取一份一致的快照（串口任务同时更新也不会读到混合数据）
+    running_info_read(&info);
+
+    // 直接写入栈上的缓冲区，不申请堆内存
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_uint(&w, "charge_status", info.charge_status);
+    json_kv_float(&w, "power", info.power, 1);
+    json_kv_float(&w, "voltage", info.voltage, 1);
+    json_kv_float(&w, "current", info.current, 2);
+    json_kv_uint(&w, "net_status", info.net_status);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
 
-    // 3. 将JSON对象转换为字符串
-    char *json_str = cJSON_PrintUnformatted(root);  // 无格式（紧凑）输出
-    if (json_str == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_500(r);
-        return ESP_FAIL;
-    }
 
-    // 4. 发送HTTP响应
-    httpd_resp_set_status(r, "200 OK");
-    httpd_resp_set_type(r, "application/json");
-    httpd_resp_send(r, json_str, HTTPD_RESP_USE_STRLEN);
+static esp_err_t handler_get_api_config(httpd_req_t *r) {
+    char buf[HTTP_JSON_BUF_LEN];
+    json_writer_t w;
+    param_config_t config;
+
+    // 读取一份一致的快照
+    param_config_read(&config);
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_float(&w, "ov_threshold", config.ov_threshold, 1);
+    json_kv_float(&w, "uv_threshold", config.uv_threshold, 1);
+    json_kv_uint(&w, "leakagedc", config.leakagedc);
+    json_kv_uint(&w, "leakageac", config.leakageac);
+    json_kv_uint(&w, "maxcc", config.maxcc);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
 
-    // 5. 释放cJSON分配的内存（避免内存泄漏）
-    cJSON_Delete(root);
-    free(json_str);  // cJSON_Print系列函数返回的字符串需手动释放
+/* 配置请求体的字段及取值范围，与网页输入框的限制一致 */
+static const json_field_t s_param_config_json[] =
+{
+    JSON_FIELD_FLOAT32(param_config_t, ov_threshold, 0.0f, 400.0f, 0),
+    JSON_FIELD_FLOAT32(param_config_t, uv_threshold, 0.0f, 400.0f, 0),
+    JSON_FIELD_UINT8(param_config_t, leakagedc, 10, 50, 0),
+    JSON_FIELD_UINT8(param_config_t, leakageac, 10, 50, 0),
+    JSON_FIELD_UINT8(param_config_t, maxcc, 0, 64, 0),
+};
 
-    return ESP_OK;
-}
+/**
+ * @brief   等待主控板确认的配置请求
+ */
+typedef struct config_apply_ctx{
+    httpd_req_t *req;                       // 脱离 HTTP 服务任务的请求
+    param_apply_start_t start;              // 开始下发的结果
+    param_apply_result_t result;            // 下发的最终结果(start 为 PARAM_APPLY_STARTED 时有效)
+    uint8_t status;                         // 主控板回复的结果
+    uint32_t latency_ms;                    // 从开始下发到收到回复的时间
+}config_apply_ctx_t;
 
+static esp_err_t handler_config_apply_reply(httpd_req_t *r);
 
-static esp_err_t handler_get_api_config(httpd_req_t *r) {
-    // 1. 创建根JSON对象
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_500(r);  // 内存分配失败时返回500错误
-        return ESP_FAIL;
-    }
+/* 主控板回复后在工作任务中回复请求，不占用串口任务 */
+static const http_async_route_t s_route_config_apply = { handler_config_apply_reply, NULL, HTTP_ASYNC_LANE_HIGH };
 
-    // 2. 从全局变量读取数据并添加到JSON对象
-    // 注意：volatile变量访问需确保线程安全（必要时加锁）
-    cJSON_AddNumberToObject(root, "ov_threshold", g_param_config.ov_threshold);
-    cJSON_AddNumberToObject(root, "uv_threshold", g_param_config.uv_threshold);
-    cJSON_AddNumberToObject(root, "leakagedc", g_param_config.leakagedc);
-    cJSON_AddNumberToObject(root, "leakageac", g_param_config.leakageac);
-    cJSON_AddNumberToObject(root, "maxcc", g_param_config.maxcc);
+/**
+  * @brief  回复配置请求并释放上下文
+  * @param  r 脱离 HTTP 服务任务的请求，user_ctx 指向 config_apply_ctx_t
+  * @retval ESP_OK - 成功，其他失败
+  */
+static esp_err_t handler_config_apply_reply(httpd_req_t *r)
+{
+    config_apply_ctx_t *ctx = (config_apply_ctx_t *)r->user_ctx;
+    char buf[HTTP_JSON_BUF_LEN];
+    json_writer_t w;
+    const char *msg = NULL;
+    esp_err_t ret;
 
-    // 3. 将JSON对象转换为字符串
-    char *json_str = cJSON_PrintUnformatted(root);  // 无格式（紧凑）输出
-    if (json_str == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_send_500(r);
-        return ESP_FAIL;
+    if (ctx->start == PARAM_APPLY_BUSY)
+    {
+        httpd_resp_set_status(r, "409 Conflict");
+        msg = "上一次配置还在下发";
+    }
+    else if (ctx->start == PARAM_APPLY_TX_FULL)
+    {
+        httpd_resp_set_status(r, "503 Service Unavailable");
+        httpd_resp_set_hdr(r, "Retry-After", HTTP_ASYNC_RETRY_AFTER_S);
+        msg = "串口发送队列已满";
+    }
+    else if (ctx->start == PARAM_APPLY_STARTED && ctx->result == PARAM_APPLY_DONE_TIMEOUT)
+    {
+        httpd_resp_set_status(r, "504 Gateway Timeout");
+        msg = "主控板没有响应";
+    }
+    else if (ctx->start == PARAM_APPLY_STARTED && ctx->result == PARAM_APPLY_DONE_REJECTED)
+    {
+        httpd_resp_set_status(r, "502 Bad Gateway");
+        msg = "主控板拒绝了配置";
     }
 
-    // 4. 发送HTTP响应
-    httpd_resp_set_status(r, "200 OK");
-    httpd_resp_set_type(r, "application/json");
-    httpd_resp_send(r, json_str, HTTPD_RESP_USE_STRLEN);
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_bool(&w, "success", msg == NULL);
+    if (msg != NULL)
+    {
+        json_kv_string(&w, "msg", msg);
+    }
+    if (ctx->start == PARAM_APPLY_STARTED && ctx->result == PARAM_APPLY_DONE_REJECTED)
+    {
+        json_kv_uint(&w, "code", ctx->status);
+    }
+    if (msg == NULL)
+    {
+        json_kv_uint(&w, "latency_ms", ctx->latency_ms);
+    }
+    json_object_end(&w);
+    ret = http_json_end(r, &w);
+    free(ctx);
+    return ret;
+}
 
-    // 5. 释放cJSON分配的内存（避免内存泄漏）
-    cJSON_Delete(root);
-    free(json_str);  // cJSON_Print系列函数返回的字符串需手动释放
+/**
+  * @brief  在 HTTP 服务任务中回复配置请求并结束异步处理
+  * @param  arg 脱离 HTTP 服务任务的请求，user_ctx 指向 config_apply_ctx_t
+  * @retval 无
+  * @note   工作队列已满时由 httpd_queue_work 调用
+  */
+static void config_apply_reply_work(void *arg)
+{
+    httpd_req_t *req = (httpd_req_t *)arg;
 
-    return ESP_OK;
+    handler_config_apply_reply(req);
+    httpd_req_async_handler_complete(req);
 }
 
-static esp_err_t handler_post_api_config(httpd_req_t *r) {
-    // 1. 读取前端发送的 JSON 数据
-    char buf[1024];
-    ssize_t len = httpd_req_recv(r, buf, sizeof(buf)-1);
-    if (len <= 0) {
-        // 读取失败，返回 400 错误（手动设置状态码）
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_set_type(r, "application/json");
-        const char *error_resp = "{\"success\": false, \"msg\": \"读取请求数据失败\"}";
-        httpd_resp_send(r, error_resp, HTTPD_RESP_USE_STRLEN);
-        return ESP_FAIL;
+/**
+  * @brief  配置下发完成回调
+  * @param  arg config_apply_ctx_t
+  * @param  result 下发的最终结果
+  * @param  status 主控板回复的结果
+  * @param  latency_ms 从开始下发到收到回复(或超时)的时间
+  * @retval 无
+  * @note   在串口任务中调用；确认时配置已经发布到 g_param_config。
+  *         回复交给工作任务或 HTTP 服务任务，串口任务不做网络发送
+  */
+static void config_apply_done(void *arg, param_apply_result_t result, uint8_t status, uint32_t latency_ms)
+{
+    config_apply_ctx_t *ctx = (config_apply_ctx_t *)arg;
+    httpd_req_t *req = ctx->req;
+    param_config_t config;
+
+    ctx->result = result;
+    ctx->status = status;
+    ctx->latency_ms = latency_ms;
+    if (result == PARAM_APPLY_DONE_OK)
+    {
+        param_config_read(&config);
+        storage_mark_dirty(STORAGE_DIRTY_CONFIG);
+        ESP_LOGI(TAG, "配置已应用(%lu ms): ov=%.1f uv=%.1f dc=%u ac=%u maxcc=%u", (unsigned long)latency_ms,
+                 config.ov_threshold, config.uv_threshold, config.leakagedc, config.leakageac, config.maxcc);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "配置下发失败: result=%d status=0x%02x (%lu ms)", result, status, (unsigned long)latency_ms);
     }
-    buf[len] = '\0'; // 确保字符串结束
-    ESP_LOGI(TAG, "收到配置数据: %s", buf);
-
-    // 2. 解析 JSON 并保存到存储（实际应用中补充）
 
-    // 3. 返回成功响应（200 状态码）
-    const char *resp = "{\"success\": true}";
-    httpd_resp_set_status(r, "200 OK");
-    httpd_resp_set_type(r, "application/json");
-    httpd_resp_send(r, resp, HTTPD_RESP_USE_STRLEN);
-    return ESP_OK;
+    if (http_async_resume(req, &s_route_config_apply, ctx) == ESP_OK)
+    {
+        return;
+    }
+    // 工作队列已满，改由 HTTP 服务任务回复
+    req->user_ctx = ctx;
+    if (httpd_queue_work(req->handle, config_apply_reply_work, req) != ESP_OK)
+    {
+        // 两个任务都无法接收，放弃回复，客户端等到超时；只结束异步处理并释放上下文
+        ESP_LOGE(TAG, "配置请求无法回复");
+        free(ctx);
+        httpd_req_async_handler_complete(req);
+    }
 }
 
-// 示例：删除卡片失败时的响应
-static esp_err_t handler_api_cards_delete(httpd_req_t *r) {
-    // 解析卡片 ID（省略）
-    const char *card_id = "12345678"; // 示例 ID
-
-    // 假设删除失败（如卡片不存在）
-    bool delete_success = false; 
-    if (!delete_success) {
-        // 返回 400 错误（Bad Request）
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_set_type(r, "application/json");
-        const char *resp = "{\"success\": false, \"msg\": \"卡片不存在\"}";
-        httpd_resp_send(r, resp, HTTPD_RESP_USE_STRLEN);
-        return ESP_FAIL;
+static esp_err_t handler_post_api_config(httpd_req_t *r) {
+    param_config_t config;
+    json_reader_t rd;
+    json_read_status_t ret;
+    config_apply_ctx_t *ctx;
+    mem_subsys_t scope;
+    httpd_req_t *req;
+    param_apply_start_t start;
+
+    // 1. 以当前配置为底稿，请求中只出现的字段才会被修改
+    param_config_read(&config);
+
+    // 2. 分块接收并按字段表校验，校验通过的值直接写入底稿
+    json_reader_init(&rd, s_param_config_json, ARRAY_SIZE(s_param_config_json), &config);
+    ret = http_recv_json(r, &rd);
+    if (ret != JSON_READ_OK) {
+        return http_json_bad_request(r, json_read_strerror(ret), json_reader_error_field(&rd));
+    }
+    if (config.uv_threshold >= config.ov_threshold) {
+        return http_json_bad_request(r, "欠压阈值必须小于过压阈值", "uv_threshold");
     }
 
-    // 成功删除（返回 200）
-    const char *resp = "{\"success\": true}";
-    httpd_resp_set_status(r, "200 OK");
-    httpd_resp_set_type(r, "application/json");
-    httpd_resp_send(r, resp, HTTPD_RESP_USE_STRLEN);
+    // 3. 脱离 HTTP 服务任务，等主控板确认后再回复，服务任务不阻塞
+    scope = mem_stats_scope_enter(MEM_SUBSYS_HTTP);
+    ctx = calloc(1, sizeof(*ctx));
+    mem_stats_scope_exit(scope);
+    if (ctx == NULL || httpd_req_async_handler_begin(r, &req) != ESP_OK) {
+        free(ctx);
+        httpd_resp_set_status(r, "503 Service Unavailable");
+        httpd_resp_set_hdr(r, "Retry-After", HTTP_ASYNC_RETRY_AFTER_S);
+        httpd_resp_sendstr(r, "busy");
+        return ESP_OK;
+    }
+    ctx->req = req;
+
+    // 4. 只下发变化的字段；主控板确认后才整体发布，读者不会看到主控板没有接受的配置。
+    //    开始下发后 ctx 归串口任务所有(回复后释放)，之后不能再访问
+    ctx->start = PARAM_APPLY_STARTED;
+    start = mcu_param_config_apply(&config, config_apply_done, ctx);
+    if (start != PARAM_APPLY_STARTED) {
+        // 没有变化、上一次还在下发或发送队列已满，不会调用完成回调，立即回复
+        ctx->start = start;
+        req->user_ctx = ctx;
+        handler_config_apply_reply(req);
+        httpd_req_async_handler_complete(req);
+    }
     return ESP_OK;
 }
 
-#include <cJSON.h>
-#include <string.h>
+/**
+ * @brief   添加卡片的请求体
+ */
+typedef struct card_json{
+    char id[CARD_ID_STR_LEN + 1];           // 8位卡号
+    char expireDate[CARD_DATE_STR_LEN + 1]; // YYYY-MM-DD
+}card_json_t;
+
+/* 添加卡片请求体的字段 */
+static const json_field_t s_card_json[] =
+{
+    JSON_FIELD_STR(card_json_t, id, CARD_ID_STR_LEN, CARD_ID_STR_LEN, JSON_FIELD_REQUIRED),
+    JSON_FIELD_STR(card_json_t, expireDate, CARD_DATE_STR_LEN, CARD_DATE_STR_LEN, JSON_FIELD_REQUIRED),
+};
 
-// 假设使用全局数组模拟卡片存储（实际应使用 NVS 或文件系统持久化）
-typedef struct {
-    char id[9];         // 8位卡号 + 结束符
-    char expireDate[11]; // 日期格式：YYYY-MM-DD
-} AuthCard;
-static AuthCard g_card_list[100] = {0}; // 最大100张卡
-static int g_card_count = 0;            // 当前卡片数量
+/* 批量导入的暂存表；卡片表的增删改都在 httpd 任务中串行执行，同一时间只有一个事务 */
+static card_store_t s_card_stage;
 
 static esp_err_t handler_api_cards_get(httpd_req_t *r) 
 {
-    // 1. 创建JSON数组
-    cJSON *root = cJSON_CreateArray();
-    if (root == NULL) {
-        httpd_resp_set_status(r, "500 Internal Server Error");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"JSON创建失败\"}");
-        return ESP_FAIL;
-    }
-
-    // 2. 填充卡片数据到JSON数组
-    for (int i = 0; i < g_card_count; i++) {
-        cJSON *card = cJSON_CreateObject();
-        cJSON_AddStringToObject(card, "id", g_card_list[i].id);
-        cJSON_AddStringToObject(card, "expireDate", g_card_list[i].expireDate);
-        cJSON_AddItemToArray(root, card);
-    }
-
-    // 3. 转换JSON为字符串并发送
-    char *json_str = cJSON_PrintUnformatted(root);
-    if (json_str == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_set_status(r, "500 Internal Server Error");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"JSON序列化失败\"}");
-        return ESP_FAIL;
+    char buf[HTTP_JSON_BUF_LEN];
+    char id[CARD_ID_STR_LEN + 1];
+    char date[CARD_DATE_STR_LEN + 1];
+    json_writer_t w;
+
+    // 逐张写入，缓冲区满时自动分块发送，卡片数量不影响内存占用
+    // (卡片表只在本任务中修改，遍历时不需要加锁)
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_array_begin(&w);
+    for (uint32_t i = 0; i < g_card_store.count; i++) {
+        card_id_format(g_card_store.cards[i].id, id);
+        card_date_format(g_card_store.cards[i].expire_day, date);
+        json_object_begin(&w);
+        json_kv_string(&w, "id", id);
+        json_kv_string(&w, "expireDate", date);
+        json_object_end(&w);
     }
-
-    // 设置响应头并发送
-    httpd_resp_set_status(r, "200 OK");
-    httpd_resp_set_type(r, "application/json");
-    httpd_resp_send(r, json_str, HTTPD_RESP_USE_STRLEN);
-
-    // 释放资源
-    cJSON_Delete(root);
-    free(json_str);
-    return ESP_OK;
+    json_array_end(&w);
+    return http_json_end(r, &w);
 }
 
 static esp_err_t handler_api_cards_post(httpd_req_t *r) {
-    // 1. 读取请求体（前端发送的JSON）
-    char buf[128] = {0};
-    ssize_t len = httpd_req_recv(r, buf, sizeof(buf) - 1);
-    if (len <= 0) {
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"读取请求数据失败\"}");
-        return ESP_FAIL;
-    }
-
-    // 2. 解析JSON
-    cJSON *root = cJSON_Parse(buf);
-    if (root == NULL) {
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"JSON格式错误\"}");
-        return ESP_FAIL;
+    card_json_t body = {0};
+    card_entry_t card = {0};
+    json_reader_t rd;
+    json_read_status_t ret;
+
+    // 1. 分块接收并解析，卡号和有效期的长度由字段表校验
+    json_reader_init(&rd, s_card_json, ARRAY_SIZE(s_card_json), &body);
+    ret = http_recv_json(r, &rd);
+    if (ret != JSON_READ_OK) {
+        return http_json_bad_request(r, json_read_strerror(ret), json_reader_error_field(&rd));
     }
 
-    // 3. 提取卡号和有效期
-    cJSON *id = cJSON_GetObjectItem(root, "id");
-    cJSON *expire = cJSON_GetObjectItem(root, "expireDate");
-    if (id == NULL || expire == NULL || !cJSON_IsString(id) || !cJSON_IsString(expire)) {
-        cJSON_Delete(root);
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"缺少卡号或有效期\"}");
-        return ESP_FAIL;
+    // 2. 验证卡号为8位数字、有效期为合法日期(与批量导入的规则一致)
+    if (!card_id_parse(body.id, strlen(body.id), &card.id)) {
+        return http_json_bad_request(r, "卡号必须为8位数字", "id");
     }
-
-    // 验证卡号为8位数字
-    if (strlen(id->valuestring) != 8) {
-        cJSON_Delete(root);
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"卡号必须为8位数字\"}");
-        return ESP_FAIL;
+    if (!card_date_parse(body.expireDate, strlen(body.expireDate), &card.expire_day)) {
+        return http_json_bad_request(r, "有效期格式错误", "expireDate");
     }
 
-    // 4. 保存卡片（检查是否已满）
-    if (g_card_count >= 100) {
-        cJSON_Delete(root);
-        httpd_resp_set_status(r, "400 Bad Request");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"卡片数量已达上限\"}");
-        return ESP_FAIL;
+    // 3. 有序插入，拒绝重复卡号
+    switch (card_store_add(&g_card_store, &card)) {
+    case CARD_STORE_DUPLICATE:
+        return http_json_bad_request(r, "卡片已存在", "id");
+    case CARD_STORE_FULL:
+        return http_json_bad_request(r, "卡片数量已达上限", NULL);
+    default:
+        break;
     }
+    storage_mark_dirty(STORAGE_DIRTY_CARDS);
 
-    // 复制数据到全局数组
-    strncpy(g_card_list[g_card_count].id, id->valuestring, 8);
-    strncpy(g_card_list[g_card_count].expireDate, expire->valuestring, 10);
-    g_card_count++;
-
-    // 5. 返回成功响应
-    cJSON_Delete(root);
+    // 4. 返回成功响应
     httpd_resp_set_status(r, "200 OK");
     httpd_resp_set_type(r, "application/json");
     httpd_resp_sendstr(r, "{\"success\": true}");
     return ESP_OK;
 }
 
-// 假设使用全局数组模拟告警存储
-typedef struct {
-    char time[20];       // 时间格式：YYYY-MM-DD HH:MM:SS
-    char coverStatus[5]; // "open" 或 "closed"
-    bool handled;        // 是否处理
-} AlarmRecord;
-static AlarmRecord g_alarm_list[50] = {0}; // 最大50条记录
-static int g_alarm_count = 0;              // 当前告警数量
-
-static esp_err_t handler_api_alarms_get(httpd_req_t *r) {
-    // 1. 创建JSON数组
-    cJSON *root = cJSON_CreateArray();
-    if (root == NULL) {
-        httpd_resp_set_status(r, "500 Internal Server Error");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"JSON创建失败\"}");
-        return ESP_FAIL;
-    }
+/**
+  * @brief  删除授权卡 DELETE /api/cards/{id}
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  */
+static esp_err_t handler_api_cards_delete(httpd_req_t *r) {
+    const char *id_text = r->uri + strlen("/api/cards/");
+    uint32_t id;
 
-    // 2. 填充告警数据到JSON数组
-    for (int i = 0; i < g_alarm_count; i++) {
-        cJSON *alarm = cJSON_CreateObject();
-        cJSON_AddStringToObject(alarm, "time", g_alarm_list[i].time);
-        cJSON_AddStringToObject(alarm, "coverStatus", g_alarm_list[i].coverStatus);
-        cJSON_AddBoolToObject(alarm, "handled", g_alarm_list[i].handled);
-        cJSON_AddItemToArray(root, alarm);
+    if (!card_id_parse(id_text, strcspn(id_text, "?#"), &id)) {
+        return http_json_bad_request(r, "卡号必须为8位数字", "id");
     }
-
-    // 3. 转换JSON为字符串并发送
-    char *json_str = cJSON_PrintUnformatted(root);
-    if (json_str == NULL) {
-        cJSON_Delete(root);
-        httpd_resp_set_status(r, "500 Internal Server Error");
-        httpd_resp_sendstr(r, "{\"success\": false, \"msg\": \"JSON序列化失败\"}");
-        return ESP_FAIL;
+    if (card_store_remove(&g_card_store, id) != CARD_STORE_OK) {
+        return http_json_bad_request(r, "卡片不存在", "id");
     }
+    storage_mark_dirty(STORAGE_DIRTY_CARDS);
 
-    // 设置响应头并发送
     httpd_resp_set_status(r, "200 OK");
     httpd_resp_set_type(r, "application/json");
-    httpd_resp_send(r, json_str, HTTPD_RESP_USE_STRLEN);
-
-    // 释放资源
-    cJSON_Delete(root);
-    free(json_str);
+    httpd_resp_sendstr(r, "{\"success\": true}");
     return ESP_OK;
 }
 
-static esp_err_t handler_api_alarms_delete(httpd_req_t *r) {
-    // 清空告警列表（实际应用中需同步清除持久化存储）
-    memset(g_alarm_list, 0, sizeof(g_alarm_list));
-    g_alarm_count = 0;
+/**
+ * @brief   批量导入的事务上下文
+ * @note    所有记录先写入暂存表，请求体完整接收且没有超出容量时才整体替换正式表
+ */
+typedef struct card_bulk{
+    card_store_t *stage;            // 暂存表
+    uint32_t inserted;              // 新增数量
+    uint32_t duplicate;             // 已存在(或请求中重复)的数量
+    bool full;                      // 超出容量，事务作废
+}card_bulk_t;
 
-    // 返回成功响应
-    httpd_resp_set_status(r, "200 OK");
-    httpd_resp_set_type(r, "application/json");
-    httpd_resp_sendstr(r, "{\"success\": true}");
-    return ESP_OK;
+/**
+  * @brief  批量导入的解码回调，把一条记录加入暂存表
+  * @param  ctx card_bulk_t
+  * @param  rec 卡片记录
+  * @retval false - 暂存表已满，停止解码
+  */
+static bool card_bulk_insert(void *ctx, const card_record_t *rec)
+{
+    card_bulk_t *tx = (card_bulk_t *)ctx;
+    card_entry_t card = { .id = rec->id, .expire_day = rec->expire_day };
+
+    switch (card_store_add(tx->stage, &card)) {
+    case CARD_STORE_OK:
+        tx->inserted++;
+        return true;
+    case CARD_STORE_DUPLICATE:
+        tx->duplicate++;
+        return true;
+    default:
+        tx->full = true;
+        return false;
+    }
+}
+
+/**
+  * @brief  批量导入授权卡
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   1. Content-Type 为 application/octet-stream 时按紧凑二进制解析，text/csv 时按 CSV 解析
+  *         2. 分块接收、边收边解码，请求体长度不受栈上缓冲区限制
+  *         3. 作为一个事务提交：数据不完整或超出容量时正式表保持不变；
+  *            格式错误的记录跳过并计数，不影响其余记录
+  */
+static esp_err_t handler_api_cards_bulk_post(httpd_req_t *r)
+{
+    char chunk[HTTP_RECV_CHUNK_LEN];
+    char type[32] = {0};
+    char buf[HTTP_JSON_BUF_LEN];
+    json_writer_t w;
+    card_decoder_t dec;
+    card_bulk_t tx = { .stage = &s_card_stage };
+    card_format_t format;
+    size_t remaining = r->content_len;
+    int len;
+
+    // 1. 按 Content-Type 选择格式
+    httpd_req_get_hdr_value_str(r, "Content-Type", type, sizeof(type));
+    if (strncmp(type, "application/octet-stream", strlen("application/octet-stream")) == 0) {
+        format = CARD_FORMAT_BIN;
+    } else if (strncmp(type, "text/csv", strlen("text/csv")) == 0) {
+        format = CARD_FORMAT_CSV;
+    } else {
+        return http_json_bad_request(r, "不支持的数据格式", NULL);
+    }
+    if (remaining > HTTP_CARD_BULK_MAX_LEN) {
+        return http_json_bad_request(r, "数据过长", NULL);
+    }
+
+    // 2. 以当前卡片表为底稿，边接收边解码进暂存表
+    card_store_copy(&s_card_stage, &g_card_store);
+    card_decoder_init(&dec, format, card_bulk_insert, &tx);
+    while (remaining > 0) {
+        len = httpd_req_recv(r, chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+        if (len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (len <= 0) {
+            return http_json_bad_request(r, "数据不完整", NULL);
+        }
+        remaining -= len;
+        if (!card_decoder_feed(&dec, chunk, len)) {
+            break;
+        }
+    }
+    card_decoder_finish(&dec);
+    if (tx.full) {
+        return http_json_bad_request(r, "卡片数量已达上限", NULL);
+    }
+
+    // 3. 整体提交，刷卡鉴权不会看到只导入了一半的表
+    card_store_copy(&g_card_store, &s_card_stage);
+    storage_mark_dirty(STORAGE_DIRTY_CARDS);
+    ESP_LOGI(TAG, "批量导入: 新增%u 重复%u 无效%u",
+             (unsigned)tx.inserted, (unsigned)tx.duplicate, (unsigned)dec.invalid);
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_bool(&w, "success", true);
+    json_kv_uint(&w, "inserted", tx.inserted);
+    json_kv_uint(&w, "duplicate", tx.duplicate);
+    json_kv_uint(&w, "invalid", dec.invalid);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+/**
+  * @brief  导出授权卡
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   ?format=csv 时导出 CSV(带表头)，否则导出紧凑二进制，与批量导入的格式一致；
+  *         逐条写入栈上的缓冲区，写满后分块发送
+  */
+static esp_err_t handler_api_cards_export(httpd_req_t *r)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    char query[32];
+    char value[8] = {0};
+    card_record_t rec;
+    bool csv = false;
+    bool chunked = false;
+    size_t used = 0;
+    int len;
+
+    if (httpd_req_get_url_query_str(r, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+        csv = (strcmp(value, "csv") == 0);
+    }
+
+    if (csv) {
+        httpd_resp_set_type(r, "text/csv");
+        httpd_resp_set_hdr(r, "Content-Disposition", "attachment; filename=\"cards.csv\"");
+        used = snprintf(buf, sizeof(buf), "id,expireDate\n");
+    } else {
+        httpd_resp_set_type(r, "application/octet-stream");
+        httpd_resp_set_hdr(r, "Content-Disposition", "attachment; filename=\"cards.bin\"");
+    }
+
+    for (uint32_t i = 0; i < g_card_store.count; i++) {
+        rec.id = g_card_store.cards[i].id;
+        rec.expire_day = g_card_store.cards[i].expire_day;
+        if (sizeof(buf) - used < CARD_CSV_LINE_LEN + 2) {
+            if (httpd_resp_send_chunk(r, buf, used) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            chunked = true;
+            used = 0;
+        }
+        if (csv) {
+            len = card_csv_encode(&rec, buf + used, sizeof(buf) - used);
+        } else {
+            len = card_wire_encode(&rec, (uint8_t *)buf + used);
+        }
+        used += len;
+    }
+
+    // 整个导出能放进缓冲区时一次发送(带 Content-Length)
+    if (!chunked) {
+        return httpd_resp_send(r, buf, used);
+    }
+    if (used > 0 && httpd_resp_send_chunk(r, buf, used) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(r, NULL, 0);
+}
+
+/**
+  * @brief  读取查询参数中的无符号整数
+  * @param  query 查询字符串
+  * @param  key 参数名
+  * @param  value 输出，参数不存在或不是数字时保持不变
+  * @retval 无
+  */
+static void http_query_uint(const char *query, const char *key, uint32_t *value)
+{
+    char str[12];
+    char *end;
+    unsigned long v;
+
+    if (httpd_query_key_value(query, key, str, sizeof(str)) != ESP_OK || str[0] == '\0')
+    {
+        return;
+    }
+    v = strtoul(str, &end, 10);
+    if (*end == '\0')
+    {
+        *value = (uint32_t)v;
+    }
+}
+
+/**
+  * @brief  分页读取告警记录
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   ?before=&since=&limit= ，按从新到旧的顺序返回 limit 条编号在 [since, before) 内的记录；
+  *         响应中的 next 作为下一页的 before，为 0 表示没有更早的记录。
+  *         每次从闪存读出 ALARM_READ_BATCH 条直接写入 JSON，不把日志载入内存
+  */
+static esp_err_t handler_api_alarms_get(httpd_req_t *r)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    char query[64];
+    alarm_record_t recs[ALARM_READ_BATCH];
+    uint32_t index[ALARM_READ_BATCH];
+    uint32_t before = UINT32_MAX;
+    uint32_t since = 0;
+    uint32_t limit = ALARM_PAGE_DEFAULT;
+    uint32_t next = 0;
+    size_t n, want;
+    json_writer_t w;
+
+    if (httpd_req_get_url_query_str(r, query, sizeof(query)) == ESP_OK)
+    {
+        http_query_uint(query, "before", &before);
+        http_query_uint(query, "since", &since);
+        http_query_uint(query, "limit", &limit);
+    }
+    if (limit == 0 || limit > ALARM_PAGE_MAX)
+    {
+        limit = ALARM_PAGE_MAX;
+    }
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_key(&w, "alarms");
+    json_array_begin(&w);
+    while (limit > 0)
+    {
+        want = limit < ARRAY_SIZE(recs) ? limit : ARRAY_SIZE(recs);
+        n = storage_alarm_read(before, since, recs, index, want, &next);
+        for (size_t i = 0; i < n; i++)
+        {
+            json_object_begin(&w);
+            json_kv_uint(&w, "id", index[i]);
+            json_kv_uint(&w, "time", recs[i].time);
+            json_kv_uint(&w, "code", recs[i].code);
+            json_kv_bool(&w, "handled", (recs[i].flags & ALARM_FLAG_HANDLED) != 0);
+            json_object_end(&w);
+        }
+        limit -= n;
+        if (next == 0)
+        {
+            break;
+        }
+        before = next;
+    }
+    json_array_end(&w);
+    json_kv_uint(&w, "next", next);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+/**
+  * @brief  清空告警记录
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   只切换到新扇区并记录清空点，不擦除整个分区
+  */
+static esp_err_t handler_api_alarms_delete(httpd_req_t *r)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    json_writer_t w;
+
+    if (!storage_alarm_clear())
+    {
+        httpd_resp_send_err(r, HTTPD_500_INTERNAL_SERVER_ERROR, "alarm log unavailable");
+        return ESP_FAIL;
+    }
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_bool(&w, "success", true);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+/* 历史数据各通道的名称和量化倍数(与 history_point_t 的通道顺序一致) */
+static const char *const s_history_fields[HISTORY_CHANNELS] = {"power", "voltage", "current"};
+static const uint16_t s_history_scale[HISTORY_CHANNELS] = {
+    TELEMETRY_SCALE_POWER, TELEMETRY_SCALE_VOLTAGE, TELEMETRY_SCALE_CURRENT,
+};
+
+/**
+  * @brief  以 JSON 输出一个历史点
+  * @param  w JSON 写入器
+  * @param  p 历史点
+  * @retval 无
+  * @note   [平均, 最小, 最大] x 通道 的量化值，没有采样时输出 null
+  */
+static void history_point_json(json_writer_t *w, const history_point_t *p)
+{
+    if (p->ch[0].avg == HISTORY_EMPTY)
+    {
+        json_null(w);
+        return;
+    }
+    json_array_begin(w);
+    for (int c = 0; c < HISTORY_CHANNELS; c++)
+    {
+        json_int(w, p->ch[c].avg);
+        json_int(w, p->ch[c].min);
+        json_int(w, p->ch[c].max);
+    }
+    json_array_end(w);
+}
+
+/**
+  * @brief  查询遥测历史
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   ?res=1|10|60(秒，默认 1)&from=(启动后的秒数)&format=json|bin ，按时间从旧到新输出；
+  *         点在插入时已汇总好，这里只分批拷贝，不重新扫描原始采样。
+  *         二进制格式: 头部 HISTORY_BIN_HEAD_LEN 字节(小端)，随后每点 [平均,最小,最大] x 通道 的 int16
+  */
+static esp_err_t handler_api_history(httpd_req_t *r)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    char query[64];
+    char value[8] = {0};
+    history_point_t points[HISTORY_READ_BATCH];
+    uint32_t res = HISTORY_TIER0_PERIOD;
+    uint32_t from = 0;
+    uint32_t first, end, n;
+    bool bin = false;
+    size_t used = 0;
+    int tier;
+    json_writer_t w;
+
+    if (httpd_req_get_url_query_str(r, query, sizeof(query)) == ESP_OK)
+    {
+        http_query_uint(query, "res", &res);
+        http_query_uint(query, "from", &from);
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK)
+        {
+            bin = (strcmp(value, "bin") == 0);
+        }
+    }
+    tier = history_tier_find(res);
+    if (tier < 0)
+    {
+        return http_json_bad_request(r, "res 只能为 1、10 或 60", "res");
+    }
+    telemetry_range(tier, from, &first, &end);
+
+    if (bin)
+    {
+        httpd_resp_set_type(r, "application/octet-stream");
+        wire_put_u16((uint8_t *)buf, HISTORY_BIN_MAGIC);
+        buf[2] = HISTORY_BIN_VERSION;
+        buf[3] = HISTORY_CHANNELS;
+        wire_put_u32((uint8_t *)buf + 4, res);
+        wire_put_u32((uint8_t *)buf + 8, first * res);
+        wire_put_u32((uint8_t *)buf + 12, end - first);
+        for (int c = 0; c < HISTORY_CHANNELS; c++)
+        {
+            wire_put_u16((uint8_t *)buf + 16 + 2 * c, s_history_scale[c]);
+        }
+        used = HISTORY_BIN_HEAD_LEN;
+
+        for (uint32_t b = first; b < end; b += n)
+        {
+            n = (end - b < HISTORY_READ_BATCH) ? end - b : HISTORY_READ_BATCH;
+            telemetry_read(tier, b, points, n);
+            for (uint32_t i = 0; i < n; i++)
+            {
+                if (sizeof(buf) - used < sizeof(history_point_t))
+                {
+                    if (httpd_resp_send_chunk(r, buf, used) != ESP_OK)
+                    {
+                        return ESP_FAIL;
+                    }
+                    used = 0;
+                }
+                for (int c = 0; c < HISTORY_CHANNELS; c++)
+                {
+                    wire_put_u16((uint8_t *)buf + used, (uint16_t)points[i].ch[c].avg);
+                    wire_put_u16((uint8_t *)buf + used + 2, (uint16_t)points[i].ch[c].min);
+                    wire_put_u16((uint8_t *)buf + used + 4, (uint16_t)points[i].ch[c].max);
+                    used += 6;
+                }
+            }
+        }
+        if (httpd_resp_send_chunk(r, buf, used) != ESP_OK)
+        {
+            return ESP_FAIL;
+        }
+        return httpd_resp_send_chunk(r, NULL, 0);
+    }
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_uint(&w, "res", res);
+    json_kv_uint(&w, "now", telemetry_now());
+    json_kv_uint(&w, "start", first * res);
+    json_kv_uint(&w, "mem", telemetry_footprint());
+    json_key(&w, "fields");
+    json_array_begin(&w);
+    for (int c = 0; c < HISTORY_CHANNELS; c++)
+    {
+        json_string(&w, s_history_fields[c]);
+    }
+    json_array_end(&w);
+    json_key(&w, "scale");
+    json_array_begin(&w);
+    for (int c = 0; c < HISTORY_CHANNELS; c++)
+    {
+        json_uint(&w, s_history_scale[c]);
+    }
+    json_array_end(&w);
+    json_key(&w, "points");
+    json_array_begin(&w);
+    for (uint32_t b = first; b < end; b += n)
+    {
+        n = (end - b < HISTORY_READ_BATCH) ? end - b : HISTORY_READ_BATCH;
+        telemetry_read(tier, b, points, n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            history_point_json(&w, &points[i]);
+        }
+    }
+    json_array_end(&w);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+/**
+  * @brief  以 JSON 输出一条充电记录
+  * @param  w JSON 写入器
+  * @param  rec 充电记录
+  * @retval 无
+  */
+static void session_record_json(json_writer_t *w, const session_record_t *rec)
+{
+    char id[CARD_ID_STR_LEN + 1];
+    char date[CARD_DATE_STR_LEN + 1];
+
+    json_object_begin(w);
+    json_kv_uint(w, "seq", rec->seq);
+    json_key(w, "card");
+    if (rec->card != 0)
+    {
+        card_id_format(rec->card, id);
+        json_string(w, id);
+    }
+    else
+    {
+        json_null(w);
+    }
+    json_key(w, "date");
+    if (rec->day != 0)
+    {
+        card_date_format(rec->day, date);
+        json_string(w, date);
+    }
+    else
+    {
+        json_null(w);
+    }
+    json_kv_uint(w, "duration", rec->duration_s);
+    json_kv_uint(w, "energy", rec->energy_wh);
+    json_kv_uint(w, "end", rec->end_state);
+    json_kv_bool(w, "gap", (rec->flags & SESSION_FLAG_GAP) != 0);
+    json_object_end(w);
+}
+
+/**
+  * @brief  查询充电记录
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   active 为正在进行的充电(没有时为 null)，sessions 为已结束的充电，从新到旧；
+  *         时长单位秒，电量单位 Wh，end 为结束时的充电桩状态
+  */
+static esp_err_t handler_api_sessions(httpd_req_t *r)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    session_record_t rec;
+    json_writer_t w;
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_key(&w, "active");
+    if (sessions_current(&rec))
+    {
+        session_record_json(&w, &rec);
+    }
+    else
+    {
+        json_null(&w);
+    }
+    json_key(&w, "sessions");
+    json_array_begin(&w);
+    for (uint32_t i = 0; sessions_get(i, &rec); i++)
+    {
+        session_record_json(&w, &rec);
+    }
+    json_array_end(&w);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+/**
+  * @brief  以 JSON 输出一个堆区域
+  * @param  w JSON 写入器
+  * @param  key 键名
+  * @param  heap 堆区域
+  * @retval 无
+  */
+static void diag_heap_json(json_writer_t *w, const char *key, const mem_diag_heap_t *heap)
+{
+    json_key(w, key);
+    json_object_begin(w);
+    json_kv_uint(w, "total", heap->total);
+    json_kv_uint(w, "free", heap->free);
+    json_kv_uint(w, "min_free", heap->min_free);
+    json_kv_uint(w, "largest", heap->largest);
+    json_object_end(w);
+}
+
+/**
+  * @brief  按二进制格式写入一个堆区域
+  * @param  buf 输出缓冲区，DIAG_MEM_BIN_HEAP_LEN 字节
+  * @param  heap 堆区域
+  * @retval 写入的字节数
+  */
+static size_t diag_heap_bin(uint8_t *buf, const mem_diag_heap_t *heap)
+{
+    wire_put_u32(buf, heap->total);
+    wire_put_u32(buf + 4, heap->free);
+    wire_put_u32(buf + 8, heap->min_free);
+    wire_put_u32(buf + 12, heap->largest);
+    return DIAG_MEM_BIN_HEAP_LEN;
+}
+
+/**
+  * @brief  查询内存使用情况
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   ?format=json|bin 。堆的当前空闲、最低空闲(低水位)和最大空闲块，各子系统的分配计数
+  *         (hooks 为 false 时计数无效)，登记任务的栈最低剩余，以及静态内存预算。
+  *         二进制格式(小端): 头部 DIAG_MEM_BIN_HEAD_LEN 字节，默认堆和片内 RAM 各 DIAG_MEM_BIN_HEAP_LEN，
+  *         随后依次为子系统、任务、静态块记录，名称以 0 填充到 MEM_DIAG_NAME_LEN
+  */
+static esp_err_t handler_api_diag_mem(httpd_req_t *r)
+{
+    mem_diag_snapshot_t snap;
+    char buf[HTTP_JSON_BUF_LEN];
+    char query[32];
+    char value[8] = {0};
+    json_writer_t w;
+
+    mem_diag_snapshot(&snap);
+
+    if (httpd_req_get_url_query_str(r, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK &&
+        strcmp(value, "bin") == 0)
+    {
+        uint8_t bin[DIAG_MEM_BIN_MAX_LEN] = {0};
+        size_t used = DIAG_MEM_BIN_HEAD_LEN;
+
+        wire_put_u16(bin, DIAG_MEM_BIN_MAGIC);
+        bin[2] = DIAG_MEM_BIN_VERSION;
+        bin[3] = snap.hooks ? 0x01 : 0x00;
+        wire_put_u32(bin + 4, snap.uptime_s);
+        bin[8] = MEM_SUBSYS_COUNT;
+        bin[9] = snap.task_count;
+        bin[10] = snap.static_count;
+        used += diag_heap_bin(bin + used, &snap.heap);
+        used += diag_heap_bin(bin + used, &snap.internal);
+        for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+        {
+            wire_put_u32(bin + used, snap.subsys[i].allocs);
+            wire_put_u32(bin + used + 4, snap.subsys[i].frees);
+            wire_put_u32(bin + used + 8, snap.subsys[i].bytes);
+            wire_put_u32(bin + used + 12, snap.subsys[i].failed);
+            used += DIAG_MEM_BIN_SUBSYS_LEN;
+        }
+        for (int i = 0; i < snap.task_count; i++)
+        {
+            strncpy((char *)bin + used, snap.tasks[i].name, MEM_DIAG_NAME_LEN);
+            bin[used + MEM_DIAG_NAME_LEN] = (uint8_t)snap.tasks[i].subsys;
+            wire_put_u32(bin + used + MEM_DIAG_NAME_LEN + 1, snap.tasks[i].stack_size);
+            wire_put_u32(bin + used + MEM_DIAG_NAME_LEN + 5, snap.tasks[i].stack_free_min);
+            used += DIAG_MEM_BIN_TASK_LEN;
+        }
+        for (int i = 0; i < snap.static_count; i++)
+        {
+            strncpy((char *)bin + used, snap.statics[i].name, MEM_DIAG_NAME_LEN);
+            wire_put_u32(bin + used + MEM_DIAG_NAME_LEN, snap.statics[i].size);
+            used += DIAG_MEM_BIN_STATIC_LEN;
+        }
+        httpd_resp_set_type(r, "application/octet-stream");
+        return httpd_resp_send(r, (const char *)bin, used);
+    }
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_uint(&w, "uptime", snap.uptime_s);
+    json_kv_bool(&w, "hooks", snap.hooks);
+    diag_heap_json(&w, "heap", &snap.heap);
+    diag_heap_json(&w, "internal", &snap.internal);
+    json_key(&w, "alloc");
+    json_object_begin(&w);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        json_key(&w, mem_subsys_name((mem_subsys_t)i));
+        json_object_begin(&w);
+        json_kv_uint(&w, "allocs", snap.subsys[i].allocs);
+        json_kv_uint(&w, "frees", snap.subsys[i].frees);
+        json_kv_uint(&w, "bytes", snap.subsys[i].bytes);
+        json_kv_uint(&w, "failed", snap.subsys[i].failed);
+        json_object_end(&w);
+    }
+    json_object_end(&w);
+    json_key(&w, "tasks");
+    json_array_begin(&w);
+    for (int i = 0; i < snap.task_count; i++)
+    {
+        json_object_begin(&w);
+        json_kv_string(&w, "name", snap.tasks[i].name);
+        json_kv_string(&w, "subsys", mem_subsys_name(snap.tasks[i].subsys));
+        json_kv_uint(&w, "stack", snap.tasks[i].stack_size);
+        json_kv_uint(&w, "free_min", snap.tasks[i].stack_free_min);
+        json_object_end(&w);
+    }
+    json_array_end(&w);
+    json_key(&w, "static");
+    json_object_begin(&w);
+    json_kv_uint(&w, "budget", MEM_DIAG_STATIC_BUDGET);
+    json_kv_uint(&w, "total", snap.static_total);
+    json_key(&w, "items");
+    json_object_begin(&w);
+    for (int i = 0; i < snap.static_count; i++)
+    {
+        json_kv_uint(&w, snap.statics[i].name, snap.statics[i].size);
+    }
+    json_object_end(&w);
+    json_object_end(&w);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+/**
+  * @brief  查询启动时间线
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   时间为启动后的微秒数；end_us 为 null 表示阶段还没有完成，没有执行的阶段不输出。
+  *         first_ping_us 为第一次响应 /api/ping 的时间(现场断电重启后的主要指标)
+  */
+static esp_err_t handler_api_diag_boot(httpd_req_t *r)
+{
+    char buf[HTTP_JSON_BUF_LEN];
+    boot_timeline_t tl;
+    json_writer_t w;
+
+    boot_timeline_get(&tl);
+
+    http_json_begin(r, &w, buf, sizeof(buf));
+    json_object_begin(&w);
+    json_kv_string(&w, "reset", boot_reset_reason_name(tl.reset_reason));
+    json_kv_bool(&w, "unclean", tl.unclean);
+    json_kv_bool(&w, "fs_ready", tl.fs_ready);
+    json_kv_uint(&w, "app_main_us", tl.app_main_us);
+    json_key(&w, "first_ping_us");
+    if (tl.first_ping_us != 0)
+    {
+        json_uint(&w, tl.first_ping_us);
+    }
+    else
+    {
+        json_null(&w);
+    }
+    json_key(&w, "stages");
+    json_array_begin(&w);
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++)
+    {
+        if (tl.stages[i].start_us == 0)
+        {
+            continue;
+        }
+        json_object_begin(&w);
+        json_kv_string(&w, "name", boot_stage_name((boot_stage_t)i));
+        json_kv_uint(&w, "start_us", tl.stages[i].start_us);
+        json_key(&w, "end_us");
+        if (tl.stages[i].end_us != 0)
+        {
+            json_uint(&w, tl.stages[i].end_us);
+            json_kv_string(&w, "result", esp_err_to_name(tl.stages[i].result));
+        }
+        else
+        {
+            json_null(&w);
+        }
+        json_object_end(&w);
+    }
+    json_array_end(&w);
+    json_object_end(&w);
+    return http_json_end(r, &w);
+}
+
+#if HTTP_STATIC_CHUNK_LEN < CAPTURE_RECORD_MAX_LEN
+#error "HTTP_STATIC_CHUNK_LEN must hold one capture record"
+#endif
+
+/**
+  * @brief  下载串口收发记录
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败
+  * @note   pcap 格式(LINKTYPE_USER0)，每条记录的第一个字节为方向(0 接收，1 发送)；
+  *         只发送请求时已有的记录，发送期间被覆盖的记录跳过。用 tools/uart_replay 离线回放
+  */
+static esp_err_t handler_api_diag_uart_capture(httpd_req_t *r)
+{
+    uint8_t chunk[HTTP_STATIC_CHUNK_LEN];
+    uint32_t pos;
+    uint32_t end;
+    uint32_t len;
+
+    if (!capture_begin(&uart_capture, &pos, &end))
+    {
+        return httpd_resp_send_err(r, HTTPD_404_NOT_FOUND, "uart capture disabled");
+    }
+
+    httpd_resp_set_type(r, "application/vnd.tcpdump.pcap");
+    httpd_resp_set_hdr(r, "Content-Disposition", "attachment; filename=\"uart.pcap\"");
+
+    len = capture_file_header(chunk);
+    if (httpd_resp_send_chunk(r, (const char *)chunk, len) != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+    while ((len = capture_read(&uart_capture, &pos, end, chunk, sizeof(chunk))) > 0)
+    {
+        if (httpd_resp_send_chunk(r, (const char *)chunk, len) != ESP_OK)
+        {
+            return ESP_FAIL;
+        }
+    }
+    return httpd_resp_send_chunk(r, NULL, 0);
 }
 
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                     int32_t event_id, void* event_data)
 {
-    if (event_id == WIFI_EVENT_AP_STACONNECTED) {
+    if (event_id == WIFI_EVENT_AP_START) {
+        boot_stage_end(BOOT_STAGE_WIFI, ESP_OK);
+    } else if (event_id == WIFI_EVENT_AP_STACONNECTED) {
         wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*) event_data;
         ESP_LOGI(TAG, "station "MACSTR" join, AID=%d",
                  MAC2STR(event->mac), event->aid);
@@ -675,7 +1836,9 @@ httpd_handle_t http_start_server(const httpd_uri_t *http_events_array[])
 
     /* 使能-清除最少使用的缓存项，可以释放资源 */
     config.lru_purge_enable = true;
-    config.max_uri_handlers = 16;  // 最大URI处理程序数量
+    config.max_uri_handlers = 24;  // 最大URI处理程序数量
+    config.stack_size = HTTP_SERVER_STACK_SIZE;
+    config.uri_match_fn = httpd_uri_match_wildcard;  // 支持 /api/cards/* 等通配符
 
     ESP_LOGI(TAG, "Http Server Port: '%d'", config.server_port);
     if (httpd_start(&server, &config) == ESP_OK) 
@@ -694,21 +1857,236 @@ httpd_handle_t http_start_server(const httpd_uri_t *http_events_array[])
     return NULL;
 }
 
+/**
+  * @brief  主控板串口发送后端
+  * @param  buf 整帧数据
+  * @param  len 帧长度
+  * @retval 无
+  * @note   整帧拷贝进驱动层发送缓冲区后立即返回，由驱动完成实际发送
+  */
+static void panel_uart_write(const uint8_t *buf, uint16_t len)
+{
+    uart_write_bytes(PANEL_UART_NUM, buf, len);
+}
+
+/**
+  * @brief  主控板串口时钟
+  * @param  无
+  * @retval 启动后的毫秒数(系统节拍精度)
+  * @note   用于 v2 链路的握手间隔和超时重发
+  */
+static uint32_t panel_uart_clock(void)
+{
+    return (uint32_t)pdTICKS_TO_MS(xTaskGetTickCount());
+}
+
+/**
+  * @brief  收发记录的时间戳
+  * @param  无
+  * @retval 启动后的微秒数
+  */
+static uint64_t panel_uart_capture_clock(void)
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+/**
+  * @brief  启用串口收发记录
+  * @param  无
+  * @retval 无
+  * @note   优先放在 PSRAM 中；没有 PSRAM 时退回一块较小的内部 RAM，分配失败则不记录
+  */
+static void panel_uart_capture_init(void)
+{
+    mem_subsys_t scope = mem_stats_scope_enter(MEM_SUBSYS_UART);
+    uint32_t size = PANEL_UART_CAPTURE_LEN;
+    const char *where = "psram";
+    uint8_t *buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+    if (buf == NULL)
+    {
+        size = PANEL_UART_CAPTURE_MIN_LEN;
+        where = "internal ram";
+        buf = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    mem_stats_scope_exit(scope);
+
+    if (buf == NULL || !mcu_uart_capture_init(buf, size, panel_uart_capture_clock))
+    {
+        ESP_LOGW(TAG, "uart capture disabled");
+        free(buf);
+        return;
+    }
+    ESP_LOGI(TAG, "uart capture %lu bytes in %s", (unsigned long)size, where);
+}
+
+/**
+  * @brief  主控板上报刷卡(FN_UPDT_RFID_CARD)
+  * @param  value 数据内容: 卡号(4字节小端) + 当天(2字节小端，1970-01-01 起的天数)
+  * @param  len 数据内容长度，固定为 RFID_SWIPE_LEN
+  * @retval 无
+  * @note   面板没有时钟，日期由主控板提供；在串口任务中直接查授权卡表(不加锁的二分查找)，
+  *         立即回复 卡号 + 鉴权结果(card_auth_t)；授权通过的卡号记入下一次充电
+  */
+static void rfid_card_swipe(const uint8_t *value, uint8_t len)
+{
+    uint8_t reply[RFID_RESULT_LEN];
+    uint32_t id = wire_get_u32(value);
+    uint16_t today = wire_get_u16(value + 4);
+    card_auth_t result = card_authorize(id, today);
+
+    (void)len;
+    if (result == CARD_AUTH_OK)
+    {
+        sessions_authorize(id, today);
+    }
+    wire_put_u32(reply, id);
+    reply[4] = (uint8_t)result;
+    mcu_fnum_data_update(FN_UPDT_RFID_CARD, reply, sizeof(reply));
+    ESP_LOGI(TAG, "刷卡 %08lu: %s", (unsigned long)id, card_auth_strerror(result));
+}
+
+/**
+  * @brief  主控板上报告警(FN_UPDT_ALARM_RECORD)
+  * @param  value 数据内容: 时间(4字节小端，Unix 时间戳) + 告警码(2字节小端) + 标志(1字节)
+  * @param  len 数据内容长度，固定为 ALARM_REPORT_LEN
+  * @retval 无
+  * @note   面板没有时钟，时间由主控板提供；记录只放入写入队列，串口任务不等待闪存写入和擦除
+  */
+static void alarm_record_report(const uint8_t *value, uint8_t len)
+{
+    alarm_record_t rec;
+
+    (void)len;
+    rec.time = wire_get_u32(value);
+    rec.code = wire_get_u16(value + 4);
+    rec.flags = value[6];
+    if (!storage_alarm_append(&rec))
+    {
+        ESP_LOGW(TAG, "告警 0x%04x 写入队列已满，丢弃", rec.code);
+    }
+}
+
+/**
+  * @brief  主控板串口任务
+  * @param  arg 未使用
+  * @retval 无
+  * @note   从驱动层整块读出数据送入接收队列，再调用协议服务解析数据帧；
+  *         同时作为唯一的发送写者，把其它任务放入发送队列的帧交给驱动
+  */
+static void uart_task(void *arg)
+{
+    uint8_t chunk[PANEL_UART_RX_CHUNK];
+    uint32_t version = running_info_version();
+    uint32_t since;
+    int len;
+
+    while (1)
+    {
+        len = uart_read_bytes(PANEL_UART_NUM, chunk, sizeof(chunk), pdMS_TO_TICKS(10));
+        if (len > 0)
+        {
+            uart_receive_buff_input(chunk, len);
+        }
+        mcu_uart_service();
+        mcu_uart_tx_service();
+        telemetry_service();
+
+        /* 运行参数有字段变化时唤醒推送任务，值都没有变化的更新(如只含心跳的增量帧)不唤醒 */
+        if (version != running_info_version())
+        {
+            since = version;
+            version = running_info_version();
+            if (running_info_changed(since) != 0)
+            {
+                status_push_notify();
+            }
+        }
+    }
+}
+
+/**
+  * @brief  初始化与主控板通信的串口
+  * @param  无
+  * @retval 无
+  */
+void panel_uart_init(void)
+{
+    const uart_config_t uart_config = {
+        .baud_rate  = PANEL_UART_BAUD_RATE,
+        .data_bits  = UART_DATA_8_BITS,
+        .parity     = UART_PARITY_DISABLE,
+        .stop_bits  = UART_STOP_BITS_1,
+        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    TaskHandle_t task = NULL;
+
+    ESP_ERROR_CHECK(uart_driver_install(PANEL_UART_NUM, PANEL_UART_DRV_BUF_LEN,
+                                        PANEL_UART_DRV_BUF_LEN, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(PANEL_UART_NUM, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(PANEL_UART_NUM, PANEL_UART_TX_PIN, PANEL_UART_RX_PIN,
+                                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+#ifdef PANEL_UART_LINK_V2
+    /* 主控板固件支持 v2 链路时启用: 握手期间仍用 v1 帧，主控板回复后才切换 */
+    mcu_uart_link_max_version_set(LINK_VERSION_V2);
+#endif
+    mcu_uart_protocol_init();
+    mem_diag_static_register("uart_rx", sizeof(uart_rx_buf) + sizeof(uart_data_process_buf));
+    mem_diag_static_register("uart_tx", sizeof(uart_tx_queue));
+    mem_diag_static_register("uart_link", sizeof(uart_link_t));
+    telemetry_init();
+    running_info_listener_register(sessions_on_running_info);
+    mcu_uart_tx_backend_register(panel_uart_write);
+    mcu_uart_clock_register(panel_uart_clock);
+    panel_uart_capture_init();
+    mcu_fnum_handler_register(FN_UPDT_RFID_CARD, rfid_card_swipe, RFID_SWIPE_LEN, RFID_SWIPE_LEN);
+    mcu_fnum_handler_register(FN_UPDT_ALARM_RECORD, alarm_record_report, ALARM_REPORT_LEN, ALARM_REPORT_LEN);
+    xTaskCreate(uart_task, "uart_task", PANEL_UART_TASK_STACK, NULL, 10, &task);
+    mem_diag_task_register(task, PANEL_UART_TASK_STACK, MEM_SUBSYS_UART);
+}
+
 void app_main(void) 
 {
-    /* init spiffs */
-    api_spiffs_init();  
+    /* 最先初始化，之后创建的任务登记后分配才能按子系统统计 */
+    mem_diag_init();
+    boot_init();
 
     //Initialize NVS
+    boot_stage_begin(BOOT_STAGE_NVS);
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
       ESP_ERROR_CHECK(nvs_flash_erase());
       ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_stage_end(BOOT_STAGE_NVS, ret);
+
+#ifndef WEB_ASSETS_EMBEDDED
+    /* SPIFFS 在后台挂载(内嵌网页资源时不需要挂载)，AP 和接口不等待整片扫描 */
+    boot_fs_start(static_assets_preload);
+#endif
 
+    /* AP 在 Wi-Fi 任务中启动，与下面的初始化并行，WIFI_EVENT_AP_START 时记录完成 */
     ESP_LOGI(TAG, "ESP_WIFI_MODE_AP");
+    boot_stage_begin(BOOT_STAGE_WIFI);
     wifi_init_softap();
 
-    http_start_server(http_uri_array);
+    /* 载入持久化的授权卡表和参数配置，挂载告警日志(必须在串口任务和 HTTP 服务启动之前) */
+    boot_stage_begin(BOOT_STAGE_STORAGE);
+    boot_stage_end(BOOT_STAGE_STORAGE, storage_init());
+
+    /* 慢请求交给工作任务，HTTP 服务任务只负责收发和分发 */
+    boot_stage_begin(BOOT_STAGE_HTTPD);
+    ESP_ERROR_CHECK(http_async_start());
+    httpd_handle_t server = http_start_server(http_uri_array);
+    mem_diag_task_register(xTaskGetHandle("httpd"), HTTP_SERVER_STACK_SIZE, MEM_SUBSYS_HTTP);
+    status_push_start(server);
+    storage_start(server);
+    boot_stage_end(BOOT_STAGE_HTTPD, (server != NULL) ? ESP_OK : ESP_FAIL);
+
+    boot_stage_begin(BOOT_STAGE_UART);
+    panel_uart_init();
+    boot_stage_end(BOOT_STAGE_UART, ESP_OK);
 }
\ No newline at end of file
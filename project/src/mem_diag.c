@@ -0,0 +1,340 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mem_diag.h"
+
+/**
+ * @brief   登记的任务
+ */
+typedef struct mem_diag_task_entry{
+    TaskHandle_t handle;
+    uint32_t stack_size;
+    mem_subsys_t subsys;            // 默认子系统
+    atomic_uchar scope;             // 当前子系统(mem_stats_scope_enter 修改，只由任务自己写)
+}mem_diag_task_entry_t;
+
+static const char *TAG = "mem_diag";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;     // 只保护登记，分配钩子中不加锁
+static mem_diag_task_entry_t s_tasks[MEM_DIAG_MAX_TASKS];
+static atomic_uint s_task_count = 0;                            // 条目填好后才增加，钩子读到的条目都是完整的
+static mem_diag_static_t s_statics[MEM_DIAG_MAX_STATICS];
+static uint8_t s_static_count = 0;
+static esp_timer_handle_t s_log_timer = NULL;
+
+/**
+  * @brief  查找当前任务的登记条目
+  * @param  无
+  * @retval 条目，未登记时返回 NULL
+  * @note   在分配钩子中调用，只做线性查找
+  */
+static IRAM_ATTR mem_diag_task_entry_t *mem_diag_current(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t count = atomic_load_explicit(&s_task_count, memory_order_acquire);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (s_tasks[i].handle == self)
+        {
+            return &s_tasks[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  当前任务的分配应记到的子系统
+  * @param  无
+  * @retval 子系统，未登记的任务记到 MEM_SUBSYS_OTHER
+  */
+static IRAM_ATTR mem_subsys_t mem_diag_current_subsys(void)
+{
+    mem_diag_task_entry_t *entry = mem_diag_current();
+
+    return (entry != NULL) ? (mem_subsys_t)atomic_load_explicit(&entry->scope, memory_order_relaxed)
+                           : MEM_SUBSYS_OTHER;
+}
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+/**
+  * @brief  堆分配成功的钩子(ESP-IDF 堆组件回调)
+  * @param  ptr 分配到的内存
+  * @param  size 请求的字节数
+  * @param  caps 内存属性
+  * @retval 无
+  */
+IRAM_ATTR void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    (void)ptr;
+    (void)caps;
+    mem_stats_alloc(mem_diag_current_subsys(), size);
+}
+
+/**
+  * @brief  堆释放的钩子(ESP-IDF 堆组件回调)
+  * @param  ptr 释放的内存
+  * @retval 无
+  * @note   记到释放时所在任务的子系统(不记录每块内存的归属，不占额外内存)
+  */
+IRAM_ATTR void esp_heap_trace_free_hook(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        mem_stats_free(mem_diag_current_subsys());
+    }
+}
+#endif
+
+/**
+  * @brief  堆分配失败的回调
+  * @param  size 请求的字节数
+  * @param  caps 内存属性
+  * @param  function_name 分配函数名
+  * @retval 无
+  */
+static void mem_diag_alloc_failed(size_t size, uint32_t caps, const char *function_name)
+{
+    (void)size;
+    (void)caps;
+    (void)function_name;
+    mem_stats_alloc_failed(mem_diag_current_subsys());
+}
+
+/**
+  * @brief  进入分配归属作用域
+  * @param  subsys 子系统
+  * @retval 原来的子系统，交给 mem_stats_scope_exit
+  * @note   只对登记过的任务有效，未登记的任务不做任何事
+  */
+mem_subsys_t mem_stats_scope_enter(mem_subsys_t subsys)
+{
+    mem_diag_task_entry_t *entry = mem_diag_current();
+
+    if (entry == NULL)
+    {
+        return MEM_SUBSYS_OTHER;
+    }
+    return (mem_subsys_t)atomic_exchange_explicit(&entry->scope, (unsigned char)subsys, memory_order_relaxed);
+}
+
+/**
+  * @brief  退出分配归属作用域
+  * @param  prev mem_stats_scope_enter 的返回值
+  * @retval 无
+  */
+void mem_stats_scope_exit(mem_subsys_t prev)
+{
+    mem_diag_task_entry_t *entry = mem_diag_current();
+
+    if (entry != NULL)
+    {
+        atomic_store_explicit(&entry->scope, (unsigned char)prev, memory_order_relaxed);
+    }
+}
+
+/**
+  * @brief  读取一个堆区域的使用情况
+  * @param  heap 输出
+  * @param  caps 内存属性
+  * @retval 无
+  */
+static void mem_diag_heap_get(mem_diag_heap_t *heap, uint32_t caps)
+{
+    heap->total = heap_caps_get_total_size(caps);
+    heap->free = heap_caps_get_free_size(caps);
+    heap->min_free = heap_caps_get_minimum_free_size(caps);
+    heap->largest = heap_caps_get_largest_free_block(caps);
+}
+
+/**
+  * @brief  周期日志
+  * @param  arg 未使用
+  * @retval 无
+  * @note   运行在 esp_timer 任务中，每个周期输出一行堆、分配计数和栈余量
+  */
+static void mem_diag_log_timer_cb(void *arg)
+{
+    static mem_diag_snapshot_t snap;    // 只在 esp_timer 任务中使用，不占该任务的栈
+    char line[192];
+    int len = 0;
+
+    (void)arg;
+    mem_diag_snapshot(&snap);
+    ESP_LOGI(TAG, "heap free %lu min %lu largest %lu, internal free %lu min %lu largest %lu",
+             (unsigned long)snap.heap.free, (unsigned long)snap.heap.min_free, (unsigned long)snap.heap.largest,
+             (unsigned long)snap.internal.free, (unsigned long)snap.internal.min_free,
+             (unsigned long)snap.internal.largest);
+
+    if (snap.hooks)
+    {
+        for (uint8_t i = 0; i < MEM_SUBSYS_COUNT && len < (int)sizeof(line); i++)
+        {
+            len += snprintf(line + len, sizeof(line) - len, " %s %lu/%lu", mem_subsys_name((mem_subsys_t)i),
+                            (unsigned long)snap.subsys[i].allocs, (unsigned long)snap.subsys[i].frees);
+        }
+        ESP_LOGI(TAG, "allocs/frees:%s", line);
+    }
+
+    len = 0;
+    for (uint8_t i = 0; i < snap.task_count && len < (int)sizeof(line); i++)
+    {
+        len += snprintf(line + len, sizeof(line) - len, " %s %lu", snap.tasks[i].name,
+                        (unsigned long)snap.tasks[i].stack_free_min);
+    }
+    ESP_LOGI(TAG, "stack free min:%s", line);
+}
+
+/**
+  * @brief  初始化内存诊断
+  * @param  无
+  * @retval ESP_OK - 成功，其他失败
+  * @note   在 app_main 开头调用；登记主控板通信等任务之前的分配都记到 other
+  */
+esp_err_t mem_diag_init(void)
+{
+    esp_err_t ret = heap_caps_register_failed_alloc_callback(mem_diag_alloc_failed);
+
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+#if MEM_DIAG_LOG_PERIOD_S > 0
+    const esp_timer_create_args_t args = {
+        .callback = mem_diag_log_timer_cb,
+        .name = "mem_diag",
+    };
+
+    ret = esp_timer_create(&args, &s_log_timer);
+    if (ret == ESP_OK)
+    {
+        ret = esp_timer_start_periodic(s_log_timer, (uint64_t)MEM_DIAG_LOG_PERIOD_S * 1000000ULL);
+    }
+#endif
+
+#ifndef CONFIG_HEAP_USE_HOOKS
+    ESP_LOGW(TAG, "CONFIG_HEAP_USE_HOOKS disabled, allocation counters stay at zero");
+#endif
+    return ret;
+}
+
+/**
+  * @brief  登记一个任务
+  * @param  task 任务句柄
+  * @param  stack_size 创建任务时的栈大小(字节)
+  * @param  subsys 该任务中的分配默认记到的子系统
+  * @retval 无
+  * @note   任务创建后立即调用；同一个任务重复登记时忽略
+  */
+void mem_diag_task_register(TaskHandle_t task, uint32_t stack_size, mem_subsys_t subsys)
+{
+    uint32_t count;
+
+    if (task == NULL)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_lock);
+    count = atomic_load_explicit(&s_task_count, memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (s_tasks[i].handle == task)
+        {
+            count = MEM_DIAG_MAX_TASKS;
+            break;
+        }
+    }
+    if (count < MEM_DIAG_MAX_TASKS)
+    {
+        s_tasks[count].handle = task;
+        s_tasks[count].stack_size = stack_size;
+        s_tasks[count].subsys = subsys;
+        atomic_store_explicit(&s_tasks[count].scope, (unsigned char)subsys, memory_order_relaxed);
+        atomic_store_explicit(&s_task_count, count + 1, memory_order_release);
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+/**
+  * @brief  登记一块静态内存，计入静态内存预算
+  * @param  name 名称(必须是字符串常量)
+  * @param  size 字节数
+  * @retval 无
+  * @note   在各模块初始化时调用；总量超出 MEM_DIAG_STATIC_BUDGET 时输出告警
+  */
+void mem_diag_static_register(const char *name, uint32_t size)
+{
+    uint32_t total = 0;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s_static_count < MEM_DIAG_MAX_STATICS)
+    {
+        s_statics[s_static_count].name = name;
+        s_statics[s_static_count].size = size;
+        s_static_count++;
+    }
+    for (uint8_t i = 0; i < s_static_count; i++)
+    {
+        total += s_statics[i].size;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (total > MEM_DIAG_STATIC_BUDGET)
+    {
+        ESP_LOGW(TAG, "static memory %lu bytes over budget %lu after '%s'", (unsigned long)total,
+                 (unsigned long)MEM_DIAG_STATIC_BUDGET, name);
+    }
+}
+
+/**
+  * @brief  读取内存快照
+  * @param  snap 输出
+  * @retval 无
+  * @note   可以在任意任务中调用(HTTP 工作任务、esp_timer 任务)
+  */
+void mem_diag_snapshot(mem_diag_snapshot_t *snap)
+{
+    uint32_t count = atomic_load_explicit(&s_task_count, memory_order_acquire);
+
+    memset(snap, 0, sizeof(*snap));
+    snap->uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+#ifdef CONFIG_HEAP_USE_HOOKS
+    snap->hooks = true;
+#endif
+    mem_diag_heap_get(&snap->heap, MALLOC_CAP_DEFAULT);
+    mem_diag_heap_get(&snap->internal, MALLOC_CAP_INTERNAL);
+    mem_stats_get(snap->subsys);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        mem_diag_task_t *task = &snap->tasks[i];
+
+        strlcpy(task->name, pcTaskGetName(s_tasks[i].handle), sizeof(task->name));
+        task->subsys = s_tasks[i].subsys;
+        task->stack_size = s_tasks[i].stack_size;
+        task->stack_free_min = uxTaskGetStackHighWaterMark(s_tasks[i].handle);  // ESP-IDF 中单位为字节
+    }
+    snap->task_count = (uint8_t)count;
+
+    taskENTER_CRITICAL(&s_lock);
+    for (uint8_t i = 0; i < s_static_count; i++)
+    {
+        snap->statics[i] = s_statics[i];
+        snap->static_total += s_statics[i].size;
+    }
+    snap->static_count = s_static_count;
+    taskEXIT_CRITICAL(&s_lock);
+}
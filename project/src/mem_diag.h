@@ -0,0 +1,73 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __MEM_DIAG_H__
+#define __MEM_DIAG_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "mem_stats.h"
+
+#define MEM_DIAG_MAX_TASKS              (8)             // 登记的任务数上限
+#define MEM_DIAG_MAX_STATICS            (12)            // 登记的静态内存块数上限
+#define MEM_DIAG_STATIC_BUDGET          (128 * 1024)    // 静态内存预算(字节)，超出时启动日志告警
+#define MEM_DIAG_LOG_PERIOD_S           (60)            // 周期日志间隔(秒)，0 表示不输出
+#define MEM_DIAG_NAME_LEN               (16)            // 与 configMAX_TASK_NAME_LEN 一致
+
+/**
+ * @brief   一个堆区域的使用情况(字节)
+ */
+typedef struct mem_diag_heap{
+    uint32_t total;                 // 总大小
+    uint32_t free;                  // 当前空闲
+    uint32_t min_free;              // 启动以来的最低空闲(低水位)
+    uint32_t largest;               // 最大的连续空闲块
+}mem_diag_heap_t;
+
+/**
+ * @brief   一个任务的栈使用情况
+ */
+typedef struct mem_diag_task{
+    char name[MEM_DIAG_NAME_LEN];
+    mem_subsys_t subsys;            // 该任务中的分配默认记到的子系统
+    uint32_t stack_size;            // 栈大小(字节)
+    uint32_t stack_free_min;        // 栈的最低剩余(高水位对应的剩余字节)
+}mem_diag_task_t;
+
+/**
+ * @brief   一块登记的静态内存
+ */
+typedef struct mem_diag_static{
+    const char *name;
+    uint32_t size;
+}mem_diag_static_t;
+
+/**
+ * @brief   内存快照
+ */
+typedef struct mem_diag_snapshot{
+    uint32_t uptime_s;
+    bool hooks;                                     // 分配计数是否有效(CONFIG_HEAP_USE_HOOKS)
+    mem_diag_heap_t heap;                           // 默认堆(MALLOC_CAP_DEFAULT)
+    mem_diag_heap_t internal;                       // 片内 RAM(MALLOC_CAP_INTERNAL)
+    mem_subsys_stats_t subsys[MEM_SUBSYS_COUNT];
+    uint8_t task_count;
+    mem_diag_task_t tasks[MEM_DIAG_MAX_TASKS];
+    uint8_t static_count;
+    mem_diag_static_t statics[MEM_DIAG_MAX_STATICS];
+    uint32_t static_total;
+}mem_diag_snapshot_t;
+
+/* public function protypes ------------------------------------------------- */
+esp_err_t mem_diag_init(void);
+void mem_diag_task_register(TaskHandle_t task, uint32_t stack_size, mem_subsys_t subsys);
+void mem_diag_static_register(const char *name, uint32_t size);
+void mem_diag_snapshot(mem_diag_snapshot_t *snap);
+
+#endif /* __MEM_DIAG_H__ */
@@ -0,0 +1,153 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sessions.h"
+#include "mem_diag.h"
+#include "storage.h"
+
+static const char *TAG = "sessions";
+
+static session_engine_t s_engine;
+static session_log_t s_log;
+static SemaphoreHandle_t s_lock = NULL;         // 串口任务更新，HTTP 服务任务读取和持久化
+
+/**
+  * @brief  从持久化数据恢复充电记录并初始化计量引擎
+  * @param  buf 数据，NULL 表示没有保存过
+  * @param  len 数据长度
+  * @retval 无
+  * @note   由 storage_init 在串口任务启动之前调用
+  */
+void sessions_restore(const uint8_t *buf, size_t len)
+{
+    uint32_t next_seq = 1;
+
+    if (s_lock == NULL)
+    {
+        s_lock = xSemaphoreCreateMutex();
+        mem_diag_static_register("sessions", sizeof(s_engine) + sizeof(s_log));
+    }
+    session_log_init(&s_log);
+    if (buf != NULL && len > 0)
+    {
+        next_seq = session_log_decode(&s_log, buf, len);
+    }
+    session_init(&s_engine, next_seq);
+}
+
+/**
+  * @brief  编码充电记录用于持久化
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小，至少 SESSIONS_BLOB_LEN
+  * @retval 编码长度
+  */
+size_t sessions_encode(uint8_t *buf, size_t size)
+{
+    size_t len;
+
+    if (s_lock == NULL)
+    {
+        return 0;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    len = session_log_encode(&s_log, buf, size);
+    xSemaphoreGive(s_lock);
+    return len;
+}
+
+/**
+  * @brief  运行参数更新通知(running_info_listener_t)
+  * @param  info 刚收到的运行参数
+  * @retval 无
+  * @note   在串口任务中对每一帧调用，引擎 O(1)、不分配内存；充电结束时追加记录并延迟写入闪存
+  */
+void sessions_on_running_info(const running_info_t *info)
+{
+    session_record_t done;
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    bool ended;
+
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ended = session_feed(&s_engine, now_ms, info->charge_status, (int32_t)lroundf(info->power), &done);
+    if (ended)
+    {
+        session_log_push(&s_log, &done);
+    }
+    xSemaphoreGive(s_lock);
+
+    if (ended)
+    {
+        ESP_LOGI(TAG, "session %lu: card %08lu, %lu s, %lu Wh", (unsigned long)done.seq,
+                 (unsigned long)done.card, (unsigned long)done.duration_s, (unsigned long)done.energy_wh);
+        storage_mark_dirty(STORAGE_DIRTY_SESSIONS);
+    }
+}
+
+/**
+  * @brief  记录授权通过的刷卡，用于归属充电记录
+  * @param  card 卡号
+  * @param  day 当天(1970-01-01 起的天数)
+  * @retval 无
+  */
+void sessions_authorize(uint32_t card, uint16_t day)
+{
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    session_authorize(&s_engine, card, day);
+    xSemaphoreGive(s_lock);
+}
+
+/**
+  * @brief  获取正在进行的充电
+  * @param  rec 输出
+  * @retval 是否正在充电
+  */
+bool sessions_current(session_record_t *rec)
+{
+    bool active;
+
+    if (s_lock == NULL)
+    {
+        return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    active = session_current(&s_engine, rec);
+    xSemaphoreGive(s_lock);
+    return active;
+}
+
+/**
+  * @brief  按从新到旧的顺序读取已结束的充电记录
+  * @param  i 序号，0 为最新
+  * @param  rec 输出
+  * @retval 是否存在
+  */
+bool sessions_get(uint32_t i, session_record_t *rec)
+{
+    bool ok;
+
+    if (s_lock == NULL)
+    {
+        return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ok = session_log_get(&s_log, i, rec);
+    xSemaphoreGive(s_lock);
+    return ok;
+}
@@ -0,0 +1,26 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __SESSIONS_H__
+#define __SESSIONS_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "session.h"
+#include "system.h"
+
+#define SESSIONS_BLOB_LEN               (SESSION_LOG_LEN * SESSION_RECORD_WIRE_LEN)
+
+/* public function protypes ------------------------------------------------- */
+void sessions_restore(const uint8_t *buf, size_t len);
+size_t sessions_encode(uint8_t *buf, size_t size);
+void sessions_on_running_info(const running_info_t *info);
+void sessions_authorize(uint32_t card, uint16_t day);
+bool sessions_current(session_record_t *rec);
+bool sessions_get(uint32_t i, session_record_t *rec);
+
+#endif /* __SESSIONS_H__ */
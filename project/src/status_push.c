@@ -0,0 +1,224 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "json_writer.h"
+#include "mem_diag.h"
+#include "status_push.h"
+#include "system.h"
+
+#define STATUS_PUSH_MAX_CLIENTS     (8)     // 单次扇出的最大连接数
+#define STATUS_PUSH_MSG_LEN         (128)   // 单条推送消息的最大长度
+
+static const char *TAG = "status_push";
+
+static httpd_handle_t s_server = NULL;
+static TaskHandle_t s_push_task = NULL;
+static atomic_bool s_full_pending = false;     // 有新客户端，需要推送完整状态
+
+static esp_err_t handler_ws_status(httpd_req_t *r);
+
+/* 由 main.c 注册，必须排在通配符处理程序之前 */
+const httpd_uri_t ws_status = {
+    .uri        = "/ws/status",
+    .method     = HTTP_GET,
+    .handler    = handler_ws_status,
+    .user_ctx   = NULL,
+    .is_websocket = true,
+};
+
+/**
+  * @brief  WebSocket 状态推送通道
+  * @param  r http请求句柄
+  * @retval ESP_OK - 成功，其他失败(连接将被关闭)
+  * @note   握手完成后为新客户端补发一份完整状态；推送是单向的，客户端发来的消息直接丢弃
+  */
+static esp_err_t handler_ws_status(httpd_req_t *r)
+{
+    httpd_ws_frame_t frame;
+    uint8_t buf[32];
+
+    if (r->method == HTTP_GET)
+    {
+        ESP_LOGI(TAG, "ws client connected, fd=%d", httpd_req_to_sockfd(r));
+        atomic_store(&s_full_pending, true);
+        status_push_notify();
+        return ESP_OK;
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    if (httpd_ws_recv_frame(r, &frame, 0) != ESP_OK)
+    {
+        return ESP_FAIL;
+    }
+    if (frame.len > sizeof(buf))
+    {
+        return ESP_FAIL;
+    }
+    frame.payload = buf;
+    return httpd_ws_recv_frame(r, &frame, frame.len);
+}
+
+/**
+  * @brief  把实时运行参数编码为紧凑的 JSON 增量
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @param  cur 当前状态
+  * @param  dirty 需要输出的字段(RUN_INFO_FIELD_BIT 位图)
+  * @retval 消息长度，0 表示没有字段变化或缓冲区不足
+  * @note   与 GET 接口一样使用 json_writer，字段名和小数位数与 /api/status 一致
+  */
+static size_t status_push_format(char *buf, size_t size, const running_info_t *cur, uint32_t dirty)
+{
+    json_writer_t w;
+
+    if ((dirty & RUN_INFO_FIELDS_ALL) == 0)
+    {
+        return 0;
+    }
+
+    json_writer_init(&w, buf, size, NULL, NULL);
+    json_object_begin(&w);
+    if (dirty & RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_CHARGE_STATUS))
+    {
+        json_kv_uint(&w, "charge_status", cur->charge_status);
+    }
+    if (dirty & RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_POWER))
+    {
+        json_kv_float(&w, "power", cur->power, 1);
+    }
+    if (dirty & RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_VOLTAGE))
+    {
+        json_kv_float(&w, "voltage", cur->voltage, 1);
+    }
+    if (dirty & RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_CURRENT))
+    {
+        json_kv_float(&w, "current", cur->current, 2);
+    }
+    if (dirty & RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_NET_STATUS))
+    {
+        json_kv_uint(&w, "net_status", cur->net_status);
+    }
+    json_object_end(&w);
+    return json_writer_ok(&w) ? w.len : 0;
+}
+
+/**
+  * @brief  把一条消息发送给所有 WebSocket 客户端
+  * @param  msg 消息
+  * @param  len 消息长度
+  * @retval 无
+  */
+static void status_push_broadcast(char *msg, size_t len)
+{
+    int fds[STATUS_PUSH_MAX_CLIENTS];
+    size_t count = STATUS_PUSH_MAX_CLIENTS;
+    httpd_ws_frame_t frame = {
+        .final   = true,
+        .type    = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)msg,
+        .len     = len,
+    };
+
+    if (httpd_get_client_list(s_server, &count, fds) != ESP_OK)
+    {
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (httpd_ws_get_fd_info(s_server, fds[i]) == HTTPD_WS_CLIENT_WEBSOCKET)
+        {
+            httpd_ws_send_frame_async(s_server, fds[i], &frame);
+        }
+    }
+}
+
+/**
+  * @brief  状态推送任务
+  * @param  arg 未使用
+  * @retval 无
+  * @note   被串口任务唤醒后推送上次推送之后变化过的字段(按字段版本号判断，不再逐字段比较)；
+  *         两次推送间隔不小于 STATUS_PUSH_MIN_INTERVAL_MS，间隔内的多次更新合并为一次
+  */
+static void status_push_task(void *arg)
+{
+    running_info_t cur;
+    uint32_t last_version = 0;
+    uint32_t version;
+    uint32_t dirty;
+    bool have_last = false;
+    int64_t last_push_us = 0;
+    int64_t wait_us;
+    char msg[STATUS_PUSH_MSG_LEN];
+    size_t len;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        wait_us = last_push_us + STATUS_PUSH_MIN_INTERVAL_MS * 1000LL - esp_timer_get_time();
+        if (wait_us > 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(wait_us / 1000) + 1);
+        }
+
+        version = running_info_read(&cur);
+        if (atomic_exchange(&s_full_pending, false))
+        {
+            have_last = false;
+        }
+        dirty = have_last ? running_info_changed(last_version) : RUN_INFO_FIELDS_ALL;
+        len = status_push_format(msg, sizeof(msg), &cur, dirty);
+        if (len > 0)
+        {
+            status_push_broadcast(msg, len);
+            last_push_us = esp_timer_get_time();
+        }
+        last_version = version;
+        have_last = true;
+    }
+}
+
+/**
+  * @brief  启动状态推送任务
+  * @param  server http服务器句柄(ws_status 已注册到该服务器)
+  * @retval ESP_OK - 成功，其他失败
+  */
+esp_err_t status_push_start(httpd_handle_t server)
+{
+    if (server == NULL)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_server = server;
+
+    if (xTaskCreate(status_push_task, "status_push", 4096, NULL, 5, &s_push_task) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    mem_diag_task_register(s_push_task, 4096, MEM_SUBSYS_HTTP);
+    return ESP_OK;
+}
+
+/**
+  * @brief  通知推送任务运行参数已更新
+  * @param  无
+  * @retval 无
+  * @note   可在任意任务中调用，只是置位任务通知，不会阻塞
+  */
+void status_push_notify(void)
+{
+    if (s_push_task != NULL)
+    {
+        xTaskNotifyGive(s_push_task);
+    }
+}
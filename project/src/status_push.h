@@ -0,0 +1,23 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __STATUS_PUSH_H__
+#define __STATUS_PUSH_H__
+
+/* include ------------------------------------------------------------------ */
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+/* 两次推送之间的最小间隔，期间的多次更新合并为一次推送 */
+#define STATUS_PUSH_MIN_INTERVAL_MS     (200)
+
+/* WebSocket 推送通道 /ws/status */
+extern const httpd_uri_t ws_status;
+
+/* public function protypes ------------------------------------------------- */
+esp_err_t status_push_start(httpd_handle_t server);
+void status_push_notify(void);
+
+#endif /* __STATUS_PUSH_H__ */
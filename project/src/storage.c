@@ -0,0 +1,523 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "storage.h"
+#include "card_store.h"
+#include "mem_diag.h"
+#include "sessions.h"
+#include "system.h"
+#include "wire_codec.h"
+
+#define STORAGE_NAMESPACE           "evse"          // NVS 命名空间
+#define STORAGE_CONFIG_KEY          "config"        // 参数配置的键名
+#define STORAGE_CONFIG_VERSION      1               // 参数配置的格式版本(内容为线上编码)
+#define STORAGE_SESSIONS_KEY        "sessions"      // 充电记录的键名
+#define STORAGE_SESSIONS_VERSION    1               // 充电记录的格式版本
+
+static const char *TAG = "storage";
+
+static nvs_handle_t s_nvs = 0;
+static httpd_handle_t s_server = NULL;
+static esp_timer_handle_t s_commit_timer = NULL;
+static atomic_uint s_dirty = 0;                 // STORAGE_DIRTY_xxx
+static int64_t s_first_dirty_us = 0;            // 本轮第一次修改的时间，0 表示没有待写入的数据
+static SemaphoreHandle_t s_commit_lock = NULL;  // 保护 s_first_dirty_us 和定时器的停止/启动(串口任务、HTTP 服务任务都会标记)
+static persist_cards_t s_cards_image;           // 卡片表在闪存中的槽位镜像
+static storage_stats_t s_stats;
+static alarm_flash_t s_alarm_flash;             // 告警日志分区
+static alarm_log_t s_alarm_log;
+static SemaphoreHandle_t s_alarm_lock = NULL;   // 告警写入任务追加、HTTP 服务任务读取和清空
+static QueueHandle_t s_alarm_queue = NULL;      // 串口任务放入、告警写入任务取出
+static atomic_uint s_alarm_dropped = 0;
+static atomic_uint s_alarm_failed = 0;
+
+static int storage_nvs_read(void *ctx, const char *key, void *buf, size_t size);
+static bool storage_nvs_write(void *ctx, const char *key, const void *buf, size_t len);
+static bool storage_nvs_commit(void *ctx);
+static esp_err_t storage_alarm_init(void);
+
+/* NVS 存储后端 */
+static const persist_backend_t s_backend = {
+    .read   = storage_nvs_read,
+    .write  = storage_nvs_write,
+    .commit = storage_nvs_commit,
+    .ctx    = NULL,
+};
+
+/**
+  * @brief  NVS 后端: 读取 blob
+  * @param  ctx 未使用
+  * @param  key 键名
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval 实际长度；键不存在返回 -1，其他错误返回 -2
+  */
+static int storage_nvs_read(void *ctx, const char *key, void *buf, size_t size)
+{
+    size_t len = size;
+    esp_err_t ret = nvs_get_blob(s_nvs, key, buf, &len);
+
+    if (ret == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return -1;
+    }
+    return (ret == ESP_OK) ? (int)len : -2;
+}
+
+/**
+  * @brief  NVS 后端: 写入 blob(提交前只在 NVS 缓存中)
+  * @param  ctx 未使用
+  * @param  key 键名
+  * @param  buf 数据
+  * @param  len 数据长度
+  * @retval true - 成功
+  */
+static bool storage_nvs_write(void *ctx, const char *key, const void *buf, size_t len)
+{
+    esp_err_t ret = nvs_set_blob(s_nvs, key, buf, len);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "write %s failed: %s", key, esp_err_to_name(ret));
+    }
+    return ret == ESP_OK;
+}
+
+/**
+  * @brief  NVS 后端: 提交
+  * @param  ctx 未使用
+  * @retval true - 成功
+  */
+static bool storage_nvs_commit(void *ctx)
+{
+    return nvs_commit(s_nvs) == ESP_OK;
+}
+
+/**
+  * @brief  启动时从 NVS 载入授权卡表、参数配置和充电记录
+  * @param  无
+  * @retval ESP_OK - 成功，其他失败(数据保持默认值)
+  * @note   在 nvs_flash_init 之后、串口任务和 HTTP 服务启动之前调用；
+  *         每个 blob 只读一次，损坏的 blob 被丢弃并在下次写入时覆盖
+  */
+esp_err_t storage_init(void)
+{
+    param_config_t config;
+    uint8_t buf[PARAM_CONFIG_WIRE_LEN];
+    uint8_t sessions[SESSIONS_BLOB_LEN];
+    persist_status_t ret;
+    size_t len;
+    uint32_t cards;
+    int64_t t0 = esp_timer_get_time();
+
+    mem_diag_static_register("card_store", sizeof(g_card_store));
+    mem_diag_static_register("card_image", sizeof(s_cards_image));
+    mem_diag_static_register("alarm_log", sizeof(s_alarm_log));
+
+    /* NVS 不可用时充电计量仍然工作，只是记录不保存 */
+    sessions_restore(NULL, 0);
+    ESP_RETURN_ON_ERROR(nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &s_nvs), TAG, "nvs_open failed");
+
+    cards = persist_cards_load(&s_cards_image, &s_backend, &g_card_store);
+    if (s_cards_image.dirty != 0)
+    {
+        ESP_LOGW(TAG, "card pages 0x%08lx corrupt, dropped", (unsigned long)s_cards_image.dirty);
+    }
+
+    ret = persist_blob_read(&s_backend, STORAGE_CONFIG_KEY, STORAGE_CONFIG_VERSION, buf, sizeof(buf), &len);
+    if (ret == PERSIST_OK && param_config_decode(buf, len, &config))
+    {
+        param_config_publish(&config);
+    }
+    else if (ret != PERSIST_ERR_NOT_FOUND)
+    {
+        ESP_LOGW(TAG, "config blob invalid (%d), using defaults", ret);
+    }
+
+    ret = persist_blob_read(&s_backend, STORAGE_SESSIONS_KEY, STORAGE_SESSIONS_VERSION,
+                            sessions, sizeof(sessions), &len);
+    if (ret != PERSIST_OK)
+    {
+        len = 0;
+        if (ret != PERSIST_ERR_NOT_FOUND)
+        {
+            ESP_LOGW(TAG, "sessions blob invalid (%d), dropped", ret);
+        }
+    }
+    sessions_restore(sessions, len);
+
+    if (storage_alarm_init() != ESP_OK)
+    {
+        ESP_LOGW(TAG, "alarm log unavailable");
+    }
+
+    ESP_LOGI(TAG, "loaded %lu cards and config in %lld us", (unsigned long)cards, esp_timer_get_time() - t0);
+    return ESP_OK;
+}
+
+/**
+  * @brief  把待写入的数据写入 NVS
+  * @param  arg 未使用
+  * @retval 无
+  * @note   通过 httpd_queue_work 在 HTTP 服务任务中执行，授权卡表也只在该任务中修改，
+  *         因此比对和编码时不需要加锁
+  */
+static void storage_flush_work(void *arg)
+{
+    param_config_t config;
+    uint8_t buf[PARAM_CONFIG_WIRE_LEN];
+    uint8_t sessions[SESSIONS_BLOB_LEN];
+    uint32_t what;
+    uint32_t pages = 0;
+    uint32_t elapsed;
+    bool ok = true;
+    int64_t t0 = esp_timer_get_time();
+    mem_subsys_t scope = mem_stats_scope_enter(MEM_SUBSYS_STORAGE);
+
+    xSemaphoreTake(s_commit_lock, portMAX_DELAY);
+    s_first_dirty_us = 0;
+    what = atomic_exchange(&s_dirty, 0);
+    xSemaphoreGive(s_commit_lock);
+
+    if (what & STORAGE_DIRTY_CARDS)
+    {
+        pages = persist_cards_sync(&s_cards_image, &s_backend, &g_card_store);
+        ok = (s_cards_image.dirty == 0);
+    }
+    if (what & STORAGE_DIRTY_CONFIG)
+    {
+        param_config_read(&config);
+        if (persist_blob_write(&s_backend, STORAGE_CONFIG_KEY, STORAGE_CONFIG_VERSION,
+                               buf, param_config_encode(&config, buf, sizeof(buf))) != PERSIST_OK)
+        {
+            ok = false;
+        }
+    }
+    if (what & STORAGE_DIRTY_SESSIONS)
+    {
+        if (persist_blob_write(&s_backend, STORAGE_SESSIONS_KEY, STORAGE_SESSIONS_VERSION,
+                               sessions, sessions_encode(sessions, sizeof(sessions))) != PERSIST_OK)
+        {
+            ok = false;
+        }
+    }
+    if (!persist_commit(&s_backend))
+    {
+        ok = false;
+    }
+
+    elapsed = (uint32_t)(esp_timer_get_time() - t0);
+    s_stats.flushes++;
+    s_stats.last_flush_us = elapsed;
+    if (elapsed > s_stats.max_flush_us)
+    {
+        s_stats.max_flush_us = elapsed;
+    }
+    ESP_LOGI(TAG, "flush 0x%02lx: %lu card pages, %lu us", (unsigned long)what, (unsigned long)pages,
+             (unsigned long)elapsed);
+    mem_stats_scope_exit(scope);
+
+    if (!ok)
+    {
+        /* 写入失败的部分保持待写入，稍后重试 */
+        ESP_LOGW(TAG, "flush incomplete, retry later");
+        storage_mark_dirty(what);
+    }
+}
+
+/**
+  * @brief  写入合并定时器到期
+  * @param  arg 未使用
+  * @retval 无
+  * @note   运行在 esp_timer 任务中，只把写入工作转交给 HTTP 服务任务
+  */
+static void storage_commit_timer_cb(void *arg)
+{
+    if (httpd_queue_work(s_server, storage_flush_work, NULL) != ESP_OK)
+    {
+        esp_timer_start_once(s_commit_timer, STORAGE_COMMIT_DELAY_MS * 1000LL);
+    }
+}
+
+/**
+  * @brief  启动写入合并
+  * @param  server http服务器句柄，写入在其任务中执行
+  * @retval ESP_OK - 成功，其他失败
+  */
+esp_err_t storage_start(httpd_handle_t server)
+{
+    const esp_timer_create_args_t args = {
+        .callback = storage_commit_timer_cb,
+        .name     = "storage_commit",
+    };
+
+    if (server == NULL || s_nvs == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_server = server;
+    s_commit_lock = xSemaphoreCreateMutex();
+    if (s_commit_lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_RETURN_ON_ERROR(esp_timer_create(&args, &s_commit_timer), TAG, "timer create failed");
+
+    /* 载入时发现的损坏页尽快用内存中的数据覆盖 */
+    if (s_cards_image.dirty != 0)
+    {
+        storage_mark_dirty(STORAGE_DIRTY_CARDS);
+    }
+    return ESP_OK;
+}
+
+/**
+  * @brief  标记数据已修改，延迟合并写入
+  * @param  what STORAGE_DIRTY_xxx 的组合
+  * @retval 无
+  * @note   每次调用都把写入推迟 STORAGE_COMMIT_DELAY_MS，但不会晚于本轮第一次修改后
+  *         STORAGE_COMMIT_MAX_DELAY_MS；连续添加多张卡只产生一次写入。
+  *         可以在任意任务中调用(不能在中断中调用)
+  */
+void storage_mark_dirty(uint32_t what)
+{
+    int64_t now;
+    int64_t delay_us = STORAGE_COMMIT_DELAY_MS * 1000LL;
+    int64_t left_us;
+
+    atomic_fetch_or(&s_dirty, what);
+    if (s_commit_timer == NULL)
+    {
+        return;
+    }
+
+    /* 合并状态在 32 位双核上不能原子读写，停止/启动定时器也要成对执行 */
+    xSemaphoreTake(s_commit_lock, portMAX_DELAY);
+    now = esp_timer_get_time();
+    if (s_first_dirty_us == 0)
+    {
+        s_first_dirty_us = now;
+    }
+    left_us = s_first_dirty_us + STORAGE_COMMIT_MAX_DELAY_MS * 1000LL - now;
+    if (left_us < delay_us)
+    {
+        delay_us = left_us > 0 ? left_us : 0;
+    }
+
+    esp_timer_stop(s_commit_timer);
+    esp_timer_start_once(s_commit_timer, delay_us);
+    xSemaphoreGive(s_commit_lock);
+}
+
+/**
+  * @brief  获取持久化统计
+  * @param  stats 输出
+  * @retval 无
+  */
+void storage_stats_get(storage_stats_t *stats)
+{
+    *stats = s_stats;
+    stats->alarm_dropped = atomic_load(&s_alarm_dropped);
+    stats->alarm_failed = atomic_load(&s_alarm_failed);
+    persist_stats_get(&stats->persist);
+}
+
+/**
+  * @brief  告警分区后端: 读取
+  * @param  ctx 分区(const esp_partition_t *)
+  * @param  addr 分区内地址
+  * @param  buf 输出缓冲区
+  * @param  len 长度
+  * @retval true - 成功
+  */
+static bool storage_alarm_flash_read(void *ctx, uint32_t addr, void *buf, size_t len)
+{
+    return esp_partition_read((const esp_partition_t *)ctx, addr, buf, len) == ESP_OK;
+}
+
+/**
+  * @brief  告警分区后端: 写入
+  * @param  ctx 分区(const esp_partition_t *)
+  * @param  addr 分区内地址
+  * @param  buf 数据
+  * @param  len 长度
+  * @retval true - 成功
+  */
+static bool storage_alarm_flash_write(void *ctx, uint32_t addr, const void *buf, size_t len)
+{
+    return esp_partition_write((const esp_partition_t *)ctx, addr, buf, len) == ESP_OK;
+}
+
+/**
+  * @brief  告警分区后端: 擦除一个扇区
+  * @param  ctx 分区(const esp_partition_t *)
+  * @param  addr 扇区起始地址
+  * @retval true - 成功
+  */
+static bool storage_alarm_flash_erase(void *ctx, uint32_t addr)
+{
+    return esp_partition_erase_range((const esp_partition_t *)ctx, addr, ALARM_LOG_SECTOR_SIZE) == ESP_OK;
+}
+
+/**
+  * @brief  告警写入任务
+  * @param  arg 未使用
+  * @retval 无
+  * @note   写入闪存和写满时擦除扇区(几十毫秒)都在本任务中进行；
+  *         等待 HTTP 服务任务读完一页时阻塞的也只是本任务，串口任务从不等待
+  */
+static void storage_alarm_task(void *arg)
+{
+    alarm_record_t rec;
+    bool ok;
+
+    for (;;)
+    {
+        if (xQueueReceive(s_alarm_queue, &rec, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        xSemaphoreTake(s_alarm_lock, portMAX_DELAY);
+        ok = alarm_log_append(&s_alarm_log, &rec, NULL);
+        xSemaphoreGive(s_alarm_lock);
+        if (!ok)
+        {
+            atomic_fetch_add(&s_alarm_failed, 1);
+            ESP_LOGW(TAG, "alarm 0x%04x not recorded", rec.code);
+        }
+    }
+}
+
+/**
+  * @brief  挂载告警日志分区，启动告警写入任务
+  * @param  无
+  * @retval ESP_OK - 成功，其他失败(告警不被记录)
+  * @note   只读各扇区头，耗时与记录数无关
+  */
+static esp_err_t storage_alarm_init(void)
+{
+    TaskHandle_t task = NULL;
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, STORAGE_ALARM_SUBTYPE,
+                                                           STORAGE_ALARM_PARTITION);
+
+    if (part == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_alarm_flash.read  = storage_alarm_flash_read;
+    s_alarm_flash.write = storage_alarm_flash_write;
+    s_alarm_flash.erase = storage_alarm_flash_erase;
+    s_alarm_flash.ctx   = (void *)part;
+    s_alarm_flash.size  = part->size;
+
+    s_alarm_lock = xSemaphoreCreateMutex();
+    if (s_alarm_lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!alarm_log_mount(&s_alarm_log, &s_alarm_flash))
+    {
+        return ESP_FAIL;
+    }
+    s_alarm_queue = xQueueCreate(STORAGE_ALARM_QUEUE_LEN, sizeof(alarm_record_t));
+    if (s_alarm_queue == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(storage_alarm_task, "alarm_log", STORAGE_ALARM_TASK_STACK, NULL, STORAGE_ALARM_TASK_PRIO,
+                    &task) != pdPASS)
+    {
+        vQueueDelete(s_alarm_queue);
+        s_alarm_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    mem_diag_task_register(task, STORAGE_ALARM_TASK_STACK, MEM_SUBSYS_STORAGE);
+    ESP_LOGI(TAG, "alarm log: %lu records", (unsigned long)(alarm_log_end(&s_alarm_log) - alarm_log_begin(&s_alarm_log)));
+    return ESP_OK;
+}
+
+/**
+  * @brief  追加一条告警记录
+  * @param  rec 记录
+  * @retval true - 已放入写入队列
+  * @note   在串口任务中调用，不等待: 只入队，由告警写入任务写入闪存(8 字节，扇区写满时额外擦除一个扇区)；
+  *         队列已满时丢弃并计数
+  */
+bool storage_alarm_append(const alarm_record_t *rec)
+{
+    if (s_alarm_queue == NULL)
+    {
+        return false;
+    }
+    if (xQueueSend(s_alarm_queue, rec, 0) != pdTRUE)
+    {
+        atomic_fetch_add(&s_alarm_dropped, 1);
+        return false;
+    }
+    return true;
+}
+
+/**
+  * @brief  清空告警日志
+  * @param  无
+  * @retval true - 成功
+  */
+bool storage_alarm_clear(void)
+{
+    bool ok;
+
+    if (s_alarm_lock == NULL)
+    {
+        return false;
+    }
+    xSemaphoreTake(s_alarm_lock, portMAX_DELAY);
+    /* 清空之前收到、还没有写入的告警一并丢弃 */
+    if (s_alarm_queue != NULL)
+    {
+        xQueueReset(s_alarm_queue);
+    }
+    ok = alarm_log_clear(&s_alarm_log);
+    xSemaphoreGive(s_alarm_lock);
+    return ok;
+}
+
+/**
+  * @brief  从新到旧读取一页告警记录
+  * @param  before 只读取编号小于该值的记录(分页游标)
+  * @param  since 只读取编号不小于该值的记录
+  * @param  recs 输出记录
+  * @param  index 输出记录编号
+  * @param  max 最多读取的条数
+  * @param  next 输出下一页的游标，没有更多记录时为 0
+  * @retval 读到的条数
+  */
+size_t storage_alarm_read(uint32_t before, uint32_t since, alarm_record_t *recs, uint32_t *index,
+                          size_t max, uint32_t *next)
+{
+    size_t n;
+
+    *next = 0;
+    if (s_alarm_lock == NULL)
+    {
+        return 0;
+    }
+    xSemaphoreTake(s_alarm_lock, portMAX_DELAY);
+    n = alarm_log_read_back(&s_alarm_log, before, since, recs, index, max, next);
+    xSemaphoreGive(s_alarm_lock);
+    return n;
+}
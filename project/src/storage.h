@@ -0,0 +1,55 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __STORAGE_H__
+#define __STORAGE_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "persist.h"
+#include "alarm_log.h"
+
+/* 写入合并: 最后一次修改后等待 STORAGE_COMMIT_DELAY_MS 再写入，
+   持续修改时最迟在第一次修改后 STORAGE_COMMIT_MAX_DELAY_MS 写入 */
+#define STORAGE_COMMIT_DELAY_MS         (2000)
+#define STORAGE_COMMIT_MAX_DELAY_MS     (10000)
+
+/* 待写入的数据 */
+#define STORAGE_DIRTY_CARDS             0x01            // 授权卡表
+#define STORAGE_DIRTY_CONFIG            0x02            // 参数配置
+#define STORAGE_DIRTY_SESSIONS          0x04            // 充电记录
+
+#define STORAGE_ALARM_PARTITION         "alarms"        // 告警日志所在的数据分区
+#define STORAGE_ALARM_SUBTYPE           0x40            // 分区子类型(partitions.csv)
+#define STORAGE_ALARM_QUEUE_LEN         32              // 待写入的告警记录数(串口任务只入队)
+#define STORAGE_ALARM_TASK_STACK        (3072)
+#define STORAGE_ALARM_TASK_PRIO         4               // 低于串口任务，写入和擦除扇区不影响接收
+
+/**
+ * @brief   持久化统计
+ */
+typedef struct storage_stats{
+    persist_stats_t persist;        // blob 读写统计
+    uint32_t flushes;               // 合并后的写入次数
+    uint32_t last_flush_us;         // 最近一次写入(含提交)耗时
+    uint32_t max_flush_us;          // 最长一次写入耗时
+    uint32_t alarm_dropped;         // 写入队列已满而丢弃的告警
+    uint32_t alarm_failed;          // 写入闪存失败的告警
+}storage_stats_t;
+
+/* public function protypes ------------------------------------------------- */
+esp_err_t storage_init(void);
+esp_err_t storage_start(httpd_handle_t server);
+void storage_mark_dirty(uint32_t what);
+void storage_stats_get(storage_stats_t *stats);
+
+bool storage_alarm_append(const alarm_record_t *rec);
+bool storage_alarm_clear(void);
+size_t storage_alarm_read(uint32_t before, uint32_t since, alarm_record_t *recs, uint32_t *index,
+                          size_t max, uint32_t *next);
+
+#endif /* __STORAGE_H__ */
@@ -0,0 +1,154 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "telemetry.h"
+#include "mem_diag.h"
+#include "system.h"
+
+static const char *TAG = "telemetry";
+
+/* 历史中记录的字段 */
+#define TELEMETRY_FIELDS    (RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_POWER) | RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_VOLTAGE) | \
+                             RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_CURRENT))
+
+static history_t s_history;
+static SemaphoreHandle_t s_lock = NULL;         // 串口任务写入、HTTP 服务任务读取
+static uint32_t s_version = 0;                  // 最近一次采样时运行参数的版本号
+static uint32_t s_last_sample_s = 0;            // 最近一次采样的时间
+static uint32_t s_last_update_s = 0;            // 最近一次收到运行参数的时间
+
+/**
+  * @brief  初始化遥测历史
+  * @param  无
+  * @retval ESP_OK - 成功，其他失败
+  * @note   在串口任务启动之前调用
+  */
+esp_err_t telemetry_init(void)
+{
+    s_lock = xSemaphoreCreateMutex();
+    if (s_lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    history_init(&s_history);
+    mem_diag_static_register("history", sizeof(s_history));
+    ESP_LOGI(TAG, "history: %u bytes", (unsigned)telemetry_footprint());
+    return ESP_OK;
+}
+
+/**
+  * @brief  采样服务
+  * @param  无
+  * @retval 无
+  * @note   在串口任务的循环中调用。功率/电压/电流有变化的更新都作为一个采样(同一秒内的多次更新
+  *         合并统计)；没有更新、或更新中这三个字段都没有变化时，每秒按最后的值补一个采样，
+  *         最多补 TELEMETRY_HOLD_S 秒
+  */
+void telemetry_service(void)
+{
+    running_info_t info;
+    int16_t value[HISTORY_CHANNELS];
+    uint32_t version = running_info_version();
+    uint32_t now = telemetry_now();
+
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    if (version != s_version)
+    {
+        s_last_update_s = now;
+        if ((running_info_changed(s_version) & TELEMETRY_FIELDS) == 0)
+        {
+            s_version = version;
+        }
+    }
+    if (version == s_version)
+    {
+        if (version == 0 || now == s_last_sample_s || now - s_last_update_s > TELEMETRY_HOLD_S)
+        {
+            return;
+        }
+    }
+
+    running_info_read(&info);
+    value[0] = history_quantize(info.power, TELEMETRY_SCALE_POWER);
+    value[1] = history_quantize(info.voltage, TELEMETRY_SCALE_VOLTAGE);
+    value[2] = history_quantize(info.current, TELEMETRY_SCALE_CURRENT);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    history_add(&s_history, now, value);
+    xSemaphoreGive(s_lock);
+
+    s_version = version;
+    s_last_sample_s = now;
+}
+
+/**
+  * @brief  获取历史使用的时间(启动后的秒数)
+  * @param  无
+  * @retval 秒
+  */
+uint32_t telemetry_now(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+/**
+  * @brief  获取某一级中可查询的时间段编号范围
+  * @param  tier 级别
+  * @param  from 起始时间(启动后的秒数)
+  * @param  first 输出第一个时间段的编号
+  * @param  end 输出最后一个时间段的编号 + 1
+  * @retval 无
+  */
+void telemetry_range(uint8_t tier, uint32_t from, uint32_t *first, uint32_t *end)
+{
+    *first = 0;
+    *end = 0;
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    history_range(&s_history, tier, from, first, end);
+    xSemaphoreGive(s_lock);
+}
+
+/**
+  * @brief  读取连续的时间段
+  * @param  tier 级别
+  * @param  bucket 第一个时间段的编号
+  * @param  points 输出
+  * @param  n 个数
+  * @retval 无
+  * @note   每次只持有锁拷贝一小批，串口任务的采样不会被长时间阻塞
+  */
+void telemetry_read(uint8_t tier, uint32_t bucket, history_point_t *points, uint32_t n)
+{
+    if (s_lock == NULL)
+    {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    history_read(&s_history, tier, bucket, points, n);
+    xSemaphoreGive(s_lock);
+}
+
+/**
+  * @brief  获取遥测历史占用的内存
+  * @param  无
+  * @retval 字节数
+  */
+size_t telemetry_footprint(void)
+{
+    return sizeof(s_history);
+}
@@ -0,0 +1,31 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "history.h"
+
+/* 各通道的量化倍数: 功率 1 W(int16 可表示到 32.7 kW)，电压 0.1 V，电流 0.01 A */
+#define TELEMETRY_SCALE_POWER           (1)
+#define TELEMETRY_SCALE_VOLTAGE         (10)
+#define TELEMETRY_SCALE_CURRENT         (100)
+
+/* 主控板停止上报后继续按最后的值采样的时间，超过后历史中留空 */
+#define TELEMETRY_HOLD_S                (5)
+
+/* public function protypes ------------------------------------------------- */
+esp_err_t telemetry_init(void);
+void telemetry_service(void);
+uint32_t telemetry_now(void);
+void telemetry_range(uint8_t tier, uint32_t from, uint32_t *first, uint32_t *end);
+void telemetry_read(uint8_t tier, uint32_t bucket, history_point_t *points, uint32_t n);
+size_t telemetry_footprint(void);
+
+#endif /* __TELEMETRY_H__ */
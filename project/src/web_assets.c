@@ -0,0 +1,51 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifdef WEB_ASSETS_EMBEDDED
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+#include "web_assets.h"
+
+/**
+ * @brief  在资源表中二分查找请求路径
+ * @param  path 请求路径(可以不以'\0'结尾，如带查询参数的 URI)
+ * @param  path_len 路径长度
+ * @return 资源，未找到时返回 NULL
+ */
+const web_asset_t *web_asset_find(const char *path, size_t path_len)
+{
+    size_t low = 0;
+    size_t high = g_web_asset_count;
+    size_t mid;
+    int cmp;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        cmp = strncmp(g_web_assets[mid].path, path, path_len);
+        if (cmp == 0 && g_web_assets[mid].path[path_len] != '\0')
+        {
+            /* 表中路径更长，排在请求路径之后 */
+            cmp = 1;
+        }
+
+        if (cmp == 0)
+        {
+            return &g_web_assets[mid];
+        }
+        else if (cmp < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return NULL;
+}
+
+#endif /* WEB_ASSETS_EMBEDDED */
@@ -0,0 +1,33 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+#ifndef __WEB_ASSETS_H__
+#define __WEB_ASSETS_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief   编译进固件的网页资源(定义 WEB_ASSETS_EMBEDDED 时由 tools/web_assets.py 生成)
+ */
+typedef struct web_asset{
+    const char *path;               // 请求路径，如 "/index.html"
+    const char *type;               // Content-Type
+    const char *etag;               // 内容哈希(含引号)
+    bool gzip;                      // data 是否为 gzip 压缩数据
+    const uint8_t *data;            // 资源数据(位于 flash 常量区)
+    uint32_t len;                   // 资源数据长度
+}web_asset_t;
+
+/* 按 path 升序排列的资源表 */
+extern const web_asset_t g_web_assets[];
+extern const size_t g_web_asset_count;
+
+/* public function protypes ------------------------------------------------- */
+const web_asset_t *web_asset_find(const char *path, size_t path_len);
+
+#endif /* __WEB_ASSETS_H__ */
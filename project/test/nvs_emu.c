@@ -0,0 +1,318 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ */
+
+/* include ------------------------------------------------------------------ */
+#include <string.h>
+
+#include "nvs_emu.h"
+
+/* private function protypes -------------------------------------------------*/
+static int nvs_emu_read(void *ctx, const char *key, void *buf, size_t size);
+static bool nvs_emu_write(void *ctx, const char *key, const void *buf, size_t len);
+static bool nvs_emu_commit(void *ctx);
+static bool nvs_emu_alloc(nvs_emu_t *emu, uint32_t span);
+static void nvs_emu_reclaim(nvs_emu_t *emu, uint32_t page);
+static uint32_t nvs_emu_free_pages(const nvs_emu_t *emu);
+
+/**
+  * @brief  初始化(整个分区为空)
+  * @param  emu 仿真分区
+  * @param  partition_size 分区大小，如 0x6000
+  * @retval 无
+  */
+void nvs_emu_init(nvs_emu_t *emu, uint32_t partition_size)
+{
+    memset(emu, 0, sizeof(*emu));
+    emu->page_count = partition_size / NVS_EMU_PAGE_SIZE;
+    if (emu->page_count > NVS_EMU_MAX_PAGES)
+    {
+        emu->page_count = NVS_EMU_MAX_PAGES;
+    }
+    emu->pages[0].active = true;
+    emu->pages[0].seq = emu->next_seq++;
+    emu->fail_after = -1;
+    emu->cut_after = -1;
+}
+
+/**
+  * @brief  填充 persist 的存储后端
+  * @param  emu 仿真分区
+  * @param  be 输出
+  * @retval 无
+  */
+void nvs_emu_backend(nvs_emu_t *emu, persist_backend_t *be)
+{
+    be->read = nvs_emu_read;
+    be->write = nvs_emu_write;
+    be->commit = nvs_emu_commit;
+    be->ctx = emu;
+}
+
+/**
+  * @brief  擦除次数最多的页的擦除次数
+  * @param  emu 仿真分区
+  * @retval 擦除次数
+  */
+uint32_t nvs_emu_max_erases(const nvs_emu_t *emu)
+{
+    uint32_t max = 0;
+
+    for (uint32_t i = 0; i < emu->page_count; i++)
+    {
+        max = (emu->pages[i].erase_count > max) ? emu->pages[i].erase_count : max;
+    }
+    return max;
+}
+
+/**
+  * @brief  查找键(用于注入故障)
+  * @param  emu 仿真分区
+  * @param  key 键名
+  * @retval 键，不存在时返回 NULL
+  */
+nvs_emu_key_t *nvs_emu_find(nvs_emu_t *emu, const char *key)
+{
+    for (uint32_t i = 0; i < NVS_EMU_MAX_KEYS; i++)
+    {
+        if (emu->keys[i].used && strcmp(emu->keys[i].key, key) == 0)
+        {
+            return &emu->keys[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  删除键
+  * @param  emu 仿真分区
+  * @param  key 键名
+  * @retval true - 键存在
+  */
+bool nvs_emu_remove(nvs_emu_t *emu, const char *key)
+{
+    nvs_emu_key_t *k = nvs_emu_find(emu, key);
+
+    if (k == NULL)
+    {
+        return false;
+    }
+    emu->pages[k->page].erased += k->span;
+    k->used = false;
+    return true;
+}
+
+/**
+  * @brief  后端: 读取 blob
+  * @param  ctx 仿真分区
+  * @param  key 键名
+  * @param  buf 输出缓冲区
+  * @param  size 缓冲区大小
+  * @retval 实际长度；键不存在返回 -1，缓冲区不够返回 -2(与 NVS 后端相同)
+  */
+static int nvs_emu_read(void *ctx, const char *key, void *buf, size_t size)
+{
+    nvs_emu_key_t *k = nvs_emu_find(ctx, key);
+
+    if (k == NULL)
+    {
+        return -1;
+    }
+    if (k->len > size)
+    {
+        return -2;
+    }
+    memcpy(buf, k->data, k->len);
+    return k->len;
+}
+
+/**
+  * @brief  后端: 写入 blob，追加新条目并删除旧条目
+  * @param  ctx 仿真分区
+  * @param  key 键名
+  * @param  buf 数据
+  * @param  len 数据长度
+  * @retval true - 成功
+  */
+static bool nvs_emu_write(void *ctx, const char *key, const void *buf, size_t len)
+{
+    nvs_emu_t *emu = ctx;
+    nvs_emu_key_t *k = nvs_emu_find(emu, key);
+    uint32_t span = 2 + (uint32_t)(len + NVS_EMU_ENTRY_SIZE - 1) / NVS_EMU_ENTRY_SIZE;
+
+    if (emu->fail_after == 0)
+    {
+        return false;
+    }
+    if (emu->fail_after > 0)
+    {
+        emu->fail_after--;
+    }
+    if (emu->cut_after == 0)
+    {
+        return true;
+    }
+    if (emu->cut_after > 0)
+    {
+        emu->cut_after--;
+    }
+    if (len > NVS_EMU_MAX_BLOB || strlen(key) > PERSIST_KEY_LEN)
+    {
+        return false;
+    }
+
+    if (!nvs_emu_alloc(emu, span))
+    {
+        return false;
+    }
+    if (k == NULL)
+    {
+        for (uint32_t i = 0; i < NVS_EMU_MAX_KEYS && k == NULL; i++)
+        {
+            if (!emu->keys[i].used)
+            {
+                k = &emu->keys[i];
+                memset(k, 0, sizeof(*k));
+                strcpy(k->key, key);
+            }
+        }
+        if (k == NULL)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        /* 新条目写入后才标记删除旧条目(与 NVS 相同，掉电时旧值仍有效) */
+        emu->pages[k->page].erased += k->span;
+    }
+
+    memcpy(k->data, buf, len);
+    k->len = (uint16_t)len;
+    k->page = (uint8_t)emu->current;
+    k->span = (uint8_t)span;
+    k->used = true;
+    emu->pages[emu->current].written += span;
+    emu->entries_written += span;
+    emu->flash_us += (uint64_t)span * NVS_EMU_WRITE_US;
+    emu->writes++;
+    return true;
+}
+
+/**
+  * @brief  后端: 提交(NVS 的写入已经落盘，这里只计数)
+  * @param  ctx 仿真分区
+  * @retval true
+  */
+static bool nvs_emu_commit(void *ctx)
+{
+    nvs_emu_t *emu = ctx;
+
+    emu->commits++;
+    return true;
+}
+
+/**
+  * @brief  为 span 个条目找到写入位置，必要时换页或回收最旧的页
+  * @param  emu 仿真分区
+  * @param  span 条目数
+  * @retval true - 成功，写入位置为 emu->current
+  */
+static bool nvs_emu_alloc(nvs_emu_t *emu, uint32_t span)
+{
+    uint32_t oldest;
+
+    while (emu->pages[emu->current].written + span > NVS_EMU_ENTRIES)
+    {
+        /* 保留一个空页用于回收 */
+        if (nvs_emu_free_pages(emu) > 1)
+        {
+            for (uint32_t i = 0; i < emu->page_count; i++)
+            {
+                if (!emu->pages[i].active)
+                {
+                    emu->current = i;
+                    emu->pages[i].active = true;
+                    emu->pages[i].seq = emu->next_seq++;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        oldest = emu->current;
+        for (uint32_t i = 0; i < emu->page_count; i++)
+        {
+            if (emu->pages[i].active && emu->pages[i].seq < emu->pages[oldest].seq)
+            {
+                oldest = i;
+            }
+        }
+        if (oldest == emu->current || emu->pages[oldest].erased == 0)
+        {
+            /* 没有可回收的空间 */
+            return false;
+        }
+        nvs_emu_reclaim(emu, oldest);
+    }
+    return true;
+}
+
+/**
+  * @brief  回收一页: 有效条目搬到空页，擦除原页
+  * @param  emu 仿真分区
+  * @param  page 页号
+  * @retval 无
+  */
+static void nvs_emu_reclaim(nvs_emu_t *emu, uint32_t page)
+{
+    uint32_t target = page;
+
+    for (uint32_t i = 0; i < emu->page_count; i++)
+    {
+        if (!emu->pages[i].active)
+        {
+            target = i;
+            break;
+        }
+    }
+    emu->pages[target].active = true;
+    emu->pages[target].seq = emu->next_seq++;
+    for (uint32_t i = 0; i < NVS_EMU_MAX_KEYS; i++)
+    {
+        nvs_emu_key_t *k = &emu->keys[i];
+
+        if (k->used && k->page == page)
+        {
+            k->page = (uint8_t)target;
+            emu->pages[target].written += k->span;
+            emu->entries_written += k->span;
+            emu->flash_us += (uint64_t)k->span * NVS_EMU_WRITE_US;
+            emu->writes++;
+        }
+    }
+    emu->pages[page].written = 0;
+    emu->pages[page].erased = 0;
+    emu->pages[page].active = false;
+    emu->pages[page].erase_count++;
+    emu->erases++;
+    emu->flash_us += NVS_EMU_ERASE_US;
+    emu->current = target;
+}
+
+/**
+  * @brief  空页数
+  * @param  emu 仿真分区
+  * @retval 空页数
+  */
+static uint32_t nvs_emu_free_pages(const nvs_emu_t *emu)
+{
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < emu->page_count; i++)
+    {
+        n += emu->pages[i].active ? 0 : 1;
+    }
+    return n;
+}
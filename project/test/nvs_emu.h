@@ -0,0 +1,88 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * 内存中的 NVS 仿真(主机测试用)，实现 persist_backend_t:
+ *
+ *   分区按 4 KB 的页划分，每页 126 个 32 字节的条目(与 ESP-IDF 的 NVS 相同)。一个 blob 占用
+ *   2 + ceil(长度 / 32) 个条目(索引条目 + 数据条目头 + 数据)，只追加写入当前页，旧的条目被标记为删除；
+ *   当前页写满后换到下一个空页，只剩一个空页时回收最旧的页: 把其中仍有效的条目搬到空页，再擦除它。
+ *   统计每页的擦除次数(磨损)和写入的条目数，并按典型的 SPI 闪存时间估算写入/擦除耗时。
+ *
+ *   故障注入: 改写已存储的 blob 的字节、截断、删除键；写入若干次后让写入失败或模拟掉电(之后的写入丢失)
+ */
+
+#ifndef __NVS_EMU_H__
+#define __NVS_EMU_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "persist.h"
+
+#define NVS_EMU_PAGE_SIZE           4096            // 页大小(一个擦除扇区)
+#define NVS_EMU_ENTRIES             126             // 每页条目数
+#define NVS_EMU_ENTRY_SIZE          32              // 条目大小
+#define NVS_EMU_MAX_PAGES           16              // 最大页数
+#define NVS_EMU_MAX_KEYS            64              // 最大键数
+#define NVS_EMU_MAX_BLOB            (PERSIST_BLOB_HEAD_LEN + PERSIST_BLOB_MAX_LEN)
+
+/* 闪存时间估算(典型 SPI NOR 闪存: 页编程约 0.7 ms/256 字节，4 KB 扇区擦除约 45 ms) */
+#define NVS_EMU_WRITE_US            90              // 写入一个条目(含条目状态位图的更新)
+#define NVS_EMU_ERASE_US            45000           // 擦除一页
+
+/**
+ * @brief   一个键的当前值
+ */
+typedef struct nvs_emu_key{
+    char key[PERSIST_KEY_LEN + 1];
+    uint8_t data[NVS_EMU_MAX_BLOB];
+    uint16_t len;
+    uint8_t page;                   // 所在页
+    uint8_t span;                   // 占用条目数
+    bool used;
+}nvs_emu_key_t;
+
+/**
+ * @brief   一页的状态
+ */
+typedef struct nvs_emu_page{
+    uint16_t written;               // 已写入的条目数(含已删除的)
+    uint16_t erased;                // 已删除的条目数
+    uint32_t seq;                   // 启用顺序，回收时选最小的
+    uint32_t erase_count;           // 擦除次数
+    bool active;                    // 已启用(非空页)
+}nvs_emu_page_t;
+
+/**
+ * @brief   仿真的 NVS 分区
+ */
+typedef struct nvs_emu{
+    nvs_emu_key_t keys[NVS_EMU_MAX_KEYS];
+    nvs_emu_page_t pages[NVS_EMU_MAX_PAGES];
+    uint32_t page_count;
+    uint32_t current;               // 当前写入页
+    uint32_t next_seq;
+
+    /* 统计 */
+    uint32_t writes;                // 写入的 blob 数(含回收时搬移的)
+    uint32_t entries_written;       // 写入的条目数
+    uint32_t erases;                // 擦除次数
+    uint32_t commits;               // 提交次数
+    uint64_t flash_us;              // 估算的闪存耗时
+
+    /* 故障注入 */
+    int32_t fail_after;             // 再写入 n 次后写入失败，-1 表示不注入
+    int32_t cut_after;              // 再写入 n 次后掉电，之后的写入都丢失(但返回成功)，-1 表示不注入
+}nvs_emu_t;
+
+/* public function protypes ------------------------------------------------- */
+void nvs_emu_init(nvs_emu_t *emu, uint32_t partition_size);
+void nvs_emu_backend(nvs_emu_t *emu, persist_backend_t *be);
+uint32_t nvs_emu_max_erases(const nvs_emu_t *emu);
+nvs_emu_key_t *nvs_emu_find(nvs_emu_t *emu, const char *key);
+bool nvs_emu_remove(nvs_emu_t *emu, const char *key);
+
+#endif /* __NVS_EMU_H__ */
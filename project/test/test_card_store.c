@@ -0,0 +1,500 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/cards/card_store 的主机测试和基准(以 CARD_STORE_CAPACITY=10240 构建):
+ *
+ *   检查  增删的返回值(重复、已满、不存在)、排序去重、鉴权结果(过期当天仍有效、停用)；
+ *         随机增删与参考集合逐项比较，表始终按卡号严格升序
+ *   并发  写者线程(HTTP 服务任务)不停地增删、整表替换，读者线程(串口任务刷卡)同时查找:
+ *         常驻的卡必须找到且内容正确，从未添加的卡必须找不到，反复增删的卡找到时内容必须正确
+ *   基准  10000 张卡时的鉴权耗时(命中/未命中)，与旧固件 AuthCard 数组的 strcmp 线性查找比较；
+ *         逐张添加和从闪存载入后整表排序的耗时；两种格式占用的内存
+ */
+
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "card_store.h"
+#include "test_common.h"
+
+#define TEST_BENCH_CARDS            10000           // 基准的卡片数量
+#define TEST_BENCH_LOOKUPS          200000          // 新格式的查找次数
+#define TEST_LEGACY_LOOKUPS         20000           // 旧格式的查找次数(线性查找太慢)
+#define TEST_RANDOM_OPS             200000          // 随机增删次数
+#define TEST_RANDOM_IDS             4096            // 随机增删使用的卡号范围
+#define TEST_STABLE_CARDS           2000            // 并发测试中常驻的卡片数量
+#define TEST_RUN_MS                 400             // 并发测试时长
+#define TEST_READERS                2               // 读者线程数
+
+_Static_assert(CARD_STORE_CAPACITY >= TEST_BENCH_CARDS, "build test_card_store with CARD_STORE_CAPACITY >= 10000");
+
+/**
+ * @brief   旧固件的授权卡(main.c 的 AuthCard)
+ */
+typedef struct test_legacy_card{
+    char id[9];
+    char expireDate[11];
+}test_legacy_card_t;
+
+static card_store_t s_store;
+static card_store_t s_stage;
+static test_legacy_card_t s_legacy[TEST_BENCH_CARDS];
+static atomic_bool s_stop;
+
+/**
+  * @brief  生成一张卡片，有效期由卡号决定，便于读者核对内容
+  * @param  id 卡号
+  * @retval 卡片
+  */
+static card_entry_t test_card(uint32_t id)
+{
+    card_entry_t card;
+
+    card.id = id;
+    card.expire_day = (uint16_t)(id * 7u);
+    card.flags = (id % 5 == 0) ? CARD_FLAG_DISABLED : 0;
+    return card;
+}
+
+/**
+  * @brief  卡片内容与卡号对应
+  * @param  card 卡片
+  * @retval 是否一致
+  */
+static bool test_card_valid(const card_entry_t *card)
+{
+    card_entry_t expect = test_card(card->id);
+
+    return card->expire_day == expect.expire_day && card->flags == expect.flags;
+}
+
+/**
+  * @brief  表按卡号严格升序
+  * @param  store 授权卡表
+  * @retval 无
+  */
+static void test_check_sorted(const card_store_t *store)
+{
+    TEST_CHECK(store->count <= CARD_STORE_CAPACITY);
+    for (uint32_t i = 1; i < store->count; i++)
+    {
+        TEST_CHECK(store->cards[i - 1].id < store->cards[i].id);
+    }
+}
+
+/**
+  * @brief  增删的返回值、排序去重和鉴权结果
+  * @param  无
+  * @retval 无
+  */
+static void test_basic(void)
+{
+    card_entry_t card = { 12345678, 20000, 0 };
+    card_entry_t out;
+
+    card_store_init(&s_store);
+    TEST_CHECK(card_store_find(&s_store, card.id, NULL) == false);
+    TEST_CHECK(card_store_authorize(&s_store, card.id, 0) == CARD_AUTH_UNKNOWN);
+    TEST_CHECK(card_store_remove(&s_store, card.id) == CARD_STORE_NOT_FOUND);
+
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_OK);
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_DUPLICATE);
+    TEST_CHECK(s_store.count == 1);
+    TEST_CHECK(card_store_find(&s_store, card.id, &out) && memcmp(&out, &card, sizeof(out)) == 0);
+    TEST_CHECK(card_store_index(&s_store, card.id) == 0);
+    TEST_CHECK(card_store_index(&s_store, card.id + 1) == -1);
+
+    /* 有效期当天仍可用，第二天过期；停用优先于过期 */
+    TEST_CHECK(card_store_authorize(&s_store, card.id, 19999) == CARD_AUTH_OK);
+    TEST_CHECK(card_store_authorize(&s_store, card.id, 20000) == CARD_AUTH_OK);
+    TEST_CHECK(card_store_authorize(&s_store, card.id, 20001) == CARD_AUTH_EXPIRED);
+    TEST_CHECK(card_store_remove(&s_store, card.id) == CARD_STORE_OK);
+    card.flags = CARD_FLAG_DISABLED;
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_OK);
+    TEST_CHECK(card_store_authorize(&s_store, card.id, 0) == CARD_AUTH_DISABLED);
+    TEST_CHECK(card_store_authorize(&s_store, card.id, 20001) == CARD_AUTH_DISABLED);
+    TEST_CHECK(strcmp(card_auth_strerror(CARD_AUTH_OK), "ok") == 0);
+
+    /* 卡号为 0 和最大值的边界 */
+    card_store_init(&s_store);
+    card = test_card(0);
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_OK);
+    card = test_card(UINT32_MAX);
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_OK);
+    TEST_CHECK(card_store_find(&s_store, 0, NULL) && card_store_find(&s_store, UINT32_MAX, NULL));
+    TEST_CHECK(!card_store_find(&s_store, 1, NULL) && !card_store_find(&s_store, UINT32_MAX - 1, NULL));
+
+    /* 填满 */
+    card_store_init(&s_store);
+    for (uint32_t i = 0; i < CARD_STORE_CAPACITY; i++)
+    {
+        card = test_card(CARD_STORE_CAPACITY - i);
+        TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_OK);
+    }
+    card = test_card(CARD_STORE_CAPACITY + 1);
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_FULL);
+    card = test_card(1);
+    TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_DUPLICATE);
+    test_check_sorted(&s_store);
+
+    /* 直接填充(从闪存载入)后排序去重，超出容量的部分被截断 */
+    for (uint32_t i = 0; i < CARD_STORE_CAPACITY; i++)
+    {
+        s_store.cards[i] = test_card((i * 2654435761u) % (CARD_STORE_CAPACITY / 2));
+    }
+    s_store.count = CARD_STORE_CAPACITY + 100;
+    card_store_sort(&s_store);
+    test_check_sorted(&s_store);
+    TEST_CHECK(s_store.count <= CARD_STORE_CAPACITY / 2);
+    for (uint32_t i = 0; i < s_store.count; i++)
+    {
+        TEST_CHECK(test_card_valid(&s_store.cards[i]));
+    }
+
+    /* 整表替换 */
+    card_store_init(&s_stage);
+    card_store_copy(&s_stage, &s_store);
+    TEST_CHECK(s_stage.count == s_store.count);
+    TEST_CHECK(memcmp(s_stage.cards, s_store.cards, s_store.count * sizeof(card_entry_t)) == 0);
+}
+
+/**
+  * @brief  随机增删，与参考集合逐项比较
+  * @param  无
+  * @retval 无
+  */
+static void test_random(void)
+{
+    static bool present[TEST_RANDOM_IDS];
+    uint32_t seed = 0x12345678u;
+    uint32_t count = 0;
+    card_entry_t card;
+    card_entry_t out;
+    uint32_t id;
+
+    memset(present, 0, sizeof(present));
+    card_store_init(&s_store);
+    for (uint32_t n = 0; n < TEST_RANDOM_OPS; n++)
+    {
+        id = test_rand(&seed) % TEST_RANDOM_IDS;
+        card = test_card(id);
+        switch (test_rand(&seed) % 3)
+        {
+            case 0:
+            TEST_CHECK(card_store_add(&s_store, &card) == (present[id] ? CARD_STORE_DUPLICATE : CARD_STORE_OK));
+            count += present[id] ? 0 : 1;
+            present[id] = true;
+            break;
+
+            case 1:
+            TEST_CHECK(card_store_remove(&s_store, id) == (present[id] ? CARD_STORE_OK : CARD_STORE_NOT_FOUND));
+            count -= present[id] ? 1 : 0;
+            present[id] = false;
+            break;
+
+            default:
+            TEST_CHECK(card_store_find(&s_store, id, &out) == present[id]);
+            TEST_CHECK(!present[id] || memcmp(&out, &card, sizeof(out)) == 0);
+            break;
+        }
+        TEST_CHECK(s_store.count == count);
+    }
+    test_check_sorted(&s_store);
+    for (id = 0; id < TEST_RANDOM_IDS; id++)
+    {
+        TEST_CHECK(card_store_find(&s_store, id, NULL) == present[id]);
+    }
+}
+
+/* 并发测试的卡号: 4k 常驻，4k + 1 反复增删，4k + 2 从不添加 */
+#define TEST_ID_STABLE(k)           (4u * (k) + 100000u)
+#define TEST_ID_CHURN(k)            (4u * (k) + 100001u)
+#define TEST_ID_ABSENT(k)           (4u * (k) + 100002u)
+
+/**
+ * @brief   写者的统计
+ */
+typedef struct test_writer{
+    uint32_t adds;
+    uint32_t removes;
+    uint32_t copies;
+}test_writer_t;
+
+/**
+ * @brief   读者的统计
+ */
+typedef struct test_reader{
+    pthread_t thread;
+    uint32_t lookups;
+    uint32_t churn_hits;
+    uint64_t max_ns;                // 单次鉴权的最长耗时
+}test_reader_t;
+
+/**
+  * @brief  写者(HTTP 服务任务): 随机增删反复增删的卡，偶尔在副本上修改后整表替换(批量导入)
+  * @param  arg test_writer_t
+  * @retval NULL
+  */
+static void *test_writer(void *arg)
+{
+    test_writer_t *w = arg;
+    uint32_t seed = 0xC0FFEEu;
+    card_entry_t card;
+    uint32_t k;
+
+    while (!atomic_load_explicit(&s_stop, memory_order_relaxed))
+    {
+        k = test_rand(&seed) % TEST_STABLE_CARDS;
+        card = test_card(TEST_ID_CHURN(k));
+        if (card_store_add(&s_store, &card) == CARD_STORE_OK)
+        {
+            w->adds++;
+        }
+        k = test_rand(&seed) % TEST_STABLE_CARDS;
+        if (card_store_remove(&s_store, TEST_ID_CHURN(k)) == CARD_STORE_OK)
+        {
+            w->removes++;
+        }
+        if ((test_rand(&seed) & 1023) == 0)
+        {
+            card_store_copy(&s_stage, &s_store);
+            for (int i = 0; i < 16; i++)
+            {
+                card = test_card(TEST_ID_CHURN(test_rand(&seed) % TEST_STABLE_CARDS));
+                card_store_add(&s_stage, &card);
+            }
+            card_store_copy(&s_store, &s_stage);
+            w->copies++;
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  读者(串口任务刷卡)
+  * @param  arg test_reader_t
+  * @retval NULL
+  */
+static void *test_reader(void *arg)
+{
+    test_reader_t *r = arg;
+    uint32_t seed = (uint32_t)(uintptr_t)arg | 1;
+    card_entry_t card;
+    uint64_t t0;
+    uint64_t ns;
+    uint32_t k;
+
+    while (!atomic_load_explicit(&s_stop, memory_order_relaxed))
+    {
+        k = test_rand(&seed) % TEST_STABLE_CARDS;
+        t0 = test_now_ns();
+        TEST_CHECK(card_store_find(&s_store, TEST_ID_STABLE(k), &card));
+        ns = test_now_ns() - t0;
+        r->max_ns = (ns > r->max_ns) ? ns : r->max_ns;
+        TEST_CHECK(card.id == TEST_ID_STABLE(k) && test_card_valid(&card));
+
+        TEST_CHECK(!card_store_find(&s_store, TEST_ID_ABSENT(k), NULL));
+        if (card_store_find(&s_store, TEST_ID_CHURN(k), &card))
+        {
+            TEST_CHECK(card.id == TEST_ID_CHURN(k) && test_card_valid(&card));
+            r->churn_hits++;
+        }
+        r->lookups += 3;
+    }
+    return NULL;
+}
+
+/**
+  * @brief  一个写者与多个读者并发
+  * @param  无
+  * @retval 无
+  */
+static void test_concurrent(void)
+{
+    test_reader_t readers[TEST_READERS];
+    test_writer_t writer;
+    pthread_t writer_thread;
+    struct timespec ts = { 0, TEST_RUN_MS * 1000000L };
+    uint32_t lookups = 0;
+    uint64_t max_ns = 0;
+    card_entry_t card;
+
+    card_store_init(&s_store);
+    for (uint32_t k = 0; k < TEST_STABLE_CARDS; k++)
+    {
+        card = test_card(TEST_ID_STABLE(k));
+        TEST_CHECK(card_store_add(&s_store, &card) == CARD_STORE_OK);
+    }
+
+    memset(readers, 0, sizeof(readers));
+    memset(&writer, 0, sizeof(writer));
+    atomic_store(&s_stop, false);
+    pthread_create(&writer_thread, NULL, test_writer, &writer);
+    for (int i = 0; i < TEST_READERS; i++)
+    {
+        pthread_create(&readers[i].thread, NULL, test_reader, &readers[i]);
+    }
+    nanosleep(&ts, NULL);
+    atomic_store(&s_stop, true);
+    pthread_join(writer_thread, NULL);
+    for (int i = 0; i < TEST_READERS; i++)
+    {
+        pthread_join(readers[i].thread, NULL);
+        lookups += readers[i].lookups;
+        max_ns = (readers[i].max_ns > max_ns) ? readers[i].max_ns : max_ns;
+    }
+    printf("concurrent: %lu lookups, %lu adds, %lu removes, %lu copies in %d ms, max lookup %.1f us\n",
+           (unsigned long)lookups, (unsigned long)writer.adds, (unsigned long)writer.removes,
+           (unsigned long)writer.copies, TEST_RUN_MS, max_ns / 1e3);
+    TEST_CHECK(lookups > 0 && writer.adds > 0 && writer.removes > 0);
+    test_check_sorted(&s_store);
+    TEST_CHECK((uint32_t)atomic_load(&s_store.seq) % 2 == 0);
+}
+
+/**
+  * @brief  旧固件的刷卡查找: 逐张 strcmp 卡号并比较有效期字符串
+  * @param  cards 卡片数组
+  * @param  count 卡片数量
+  * @param  id 卡号(8 位数字)
+  * @param  today 当天(YYYY-MM-DD)
+  * @retval 鉴权结果
+  */
+static card_auth_t test_legacy_authorize(const test_legacy_card_t *cards, uint32_t count, const char *id,
+                                         const char *today)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (strcmp(cards[i].id, id) == 0)
+        {
+            return (strcmp(today, cards[i].expireDate) > 0) ? CARD_AUTH_EXPIRED : CARD_AUTH_OK;
+        }
+    }
+    return CARD_AUTH_UNKNOWN;
+}
+
+/**
+  * @brief  基准: 10000 张卡
+  * @param  无
+  * @retval 无
+  */
+static void test_bench(void)
+{
+    static uint32_t ids[TEST_BENCH_CARDS];
+    uint32_t seed = 0xBEEFu;
+    card_entry_t card;
+    uint32_t hits = 0;
+    char id_text[16];
+    uint64_t c0;
+    uint64_t c1;
+    uint64_t t0;
+    uint32_t id;
+
+    /* 逐张添加随机卡号(与 POST /api/cards 相同)，重复的卡号由 card_store 拒绝 */
+    card_store_init(&s_store);
+    t0 = test_now_ns();
+    for (uint32_t n = 0; n < TEST_BENCH_CARDS;)
+    {
+        id = test_rand(&seed) % 100000000u;
+        card = test_card(id);
+        card.flags = 0;
+        card.expire_day = 0xFFFF;
+        if (card_store_add(&s_store, &card) == CARD_STORE_OK)
+        {
+            ids[n++] = id;
+        }
+    }
+    printf("add %u cards one by one: %8.2f ms\n", TEST_BENCH_CARDS, (test_now_ns() - t0) / 1e6);
+    test_check_sorted(&s_store);
+
+    /* 从闪存载入: 直接填充后一次排序 */
+    for (uint32_t i = 0; i < TEST_BENCH_CARDS; i++)
+    {
+        s_stage.cards[i] = s_store.cards[(i * 7919u) % TEST_BENCH_CARDS];
+    }
+    s_stage.count = TEST_BENCH_CARDS;
+    t0 = test_now_ns();
+    card_store_sort(&s_stage);
+    printf("sort %u loaded cards:   %8.2f ms\n", TEST_BENCH_CARDS, (test_now_ns() - t0) / 1e6);
+    TEST_CHECK(s_stage.count == TEST_BENCH_CARDS);
+
+    for (uint32_t i = 0; i < TEST_BENCH_CARDS; i++)
+    {
+        snprintf(s_legacy[i].id, sizeof(s_legacy[i].id), "%08u", ids[i] % 100000000u);
+        snprintf(s_legacy[i].expireDate, sizeof(s_legacy[i].expireDate), "2099-12-31");
+    }
+
+    /* 命中: 随机已有的卡；未命中: 随机卡号(10000/1e8 的概率命中) */
+    /* card_authorize 查的是全局表 */
+    card_store_copy(&g_card_store, &s_store);
+    c0 = test_cycles();
+    for (uint32_t n = 0; n < TEST_BENCH_LOOKUPS; n++)
+    {
+        id = ids[test_rand(&seed) % TEST_BENCH_CARDS];
+        TEST_KEEP(id);
+        hits += card_authorize(id, 20000) == CARD_AUTH_OK;
+    }
+    c1 = test_cycles();
+    TEST_CHECK(hits == TEST_BENCH_LOOKUPS);
+    printf("card_store hit:  %9.1f cycles/swipe\n", (double)(c1 - c0) / TEST_BENCH_LOOKUPS);
+
+    c0 = test_cycles();
+    for (uint32_t n = 0; n < TEST_BENCH_LOOKUPS; n++)
+    {
+        id = test_rand(&seed) % 100000000u;
+        TEST_KEEP(id);
+        hits += card_authorize(id, 20000) == CARD_AUTH_OK;
+    }
+    c1 = test_cycles();
+    printf("card_store miss: %9.1f cycles/swipe\n", (double)(c1 - c0) / TEST_BENCH_LOOKUPS);
+
+    /* 旧格式: 卡号先格式化为字符串再线性查找 */
+    hits = 0;
+    c0 = test_cycles();
+    for (uint32_t n = 0; n < TEST_LEGACY_LOOKUPS; n++)
+    {
+        id = ids[test_rand(&seed) % TEST_BENCH_CARDS];
+        snprintf(id_text, sizeof(id_text), "%08u", id);
+        hits += test_legacy_authorize(s_legacy, TEST_BENCH_CARDS, id_text, "2024-06-01") == CARD_AUTH_OK;
+    }
+    c1 = test_cycles();
+    TEST_CHECK(hits == TEST_LEGACY_LOOKUPS);
+    printf("legacy hit:      %9.1f cycles/swipe\n", (double)(c1 - c0) / TEST_LEGACY_LOOKUPS);
+
+    c0 = test_cycles();
+    for (uint32_t n = 0; n < TEST_LEGACY_LOOKUPS; n++)
+    {
+        snprintf(id_text, sizeof(id_text), "%08u", test_rand(&seed) % 100000000u);
+        hits += test_legacy_authorize(s_legacy, TEST_BENCH_CARDS, id_text, "2024-06-01") == CARD_AUTH_OK;
+    }
+    c1 = test_cycles();
+    TEST_KEEP(hits);
+    printf("legacy miss:     %9.1f cycles/swipe\n", (double)(c1 - c0) / TEST_LEGACY_LOOKUPS);
+
+    /* 旧固件的实际容量: 100 张 */
+    c0 = test_cycles();
+    for (uint32_t n = 0; n < TEST_LEGACY_LOOKUPS; n++)
+    {
+        snprintf(id_text, sizeof(id_text), "%08u", test_rand(&seed) % 100000000u);
+        hits += test_legacy_authorize(s_legacy, 100, id_text, "2024-06-01") == CARD_AUTH_OK;
+    }
+    c1 = test_cycles();
+    TEST_KEEP(hits);
+    printf("legacy miss/100: %9.1f cycles/swipe\n", (double)(c1 - c0) / TEST_LEGACY_LOOKUPS);
+
+    printf("memory for %u cards: card_store %lu bytes, AuthCard %lu bytes\n", TEST_BENCH_CARDS,
+           (unsigned long)(TEST_BENCH_CARDS * sizeof(card_entry_t)),
+           (unsigned long)(TEST_BENCH_CARDS * sizeof(test_legacy_card_t)));
+}
+
+int main(void)
+{
+    test_basic();
+    test_random();
+    test_concurrent();
+    test_bench();
+    return 0;
+}
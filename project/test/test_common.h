@@ -0,0 +1,78 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * 主机测试的公共宏和计时函数(test/CMakeLists.txt 构建)。
+ * 检查失败时打印位置并退出，不依赖 assert，Release 构建(NDEBUG)下同样生效。
+ */
+
+#ifndef __TEST_COMMON_H__
+#define __TEST_COMMON_H__
+
+/* include ------------------------------------------------------------------ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TEST_CHECK(cond)                                                                \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(cond))                                                                    \
+        {                                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                                    \
+        }                                                                               \
+    } while (0)
+
+/* 防止编译器把基准测试中结果没有被使用的计算优化掉 */
+#define TEST_KEEP(value)            __asm__ __volatile__("" : : "g"(value) : "memory")
+
+/**
+  * @brief  单调时钟(纳秒)
+  * @param  无
+  * @retval 纳秒
+  */
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief  处理器周期计数(x86 为 rdtsc，其它架构以纳秒代替)
+  * @param  无
+  * @retval 计数
+  */
+static inline uint64_t test_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo;
+    uint32_t hi;
+
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return test_now_ns();
+#endif
+}
+
+/**
+  * @brief  xorshift32 伪随机数
+  * @param  state 状态(非零)
+  * @retval 随机数
+  */
+static inline uint32_t test_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+#endif /* __TEST_COMMON_H__ */
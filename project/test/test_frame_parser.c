@@ -0,0 +1,462 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/uart 帧解析器的主机测试和基准: 坏帧之后的重新同步，以及在同一段字节流上
+ * 比较原来的解析器(逐字节队列 + 处理缓冲区 + 重扫 + 搬移)和现在的状态机的吞吐。
+ *
+ *   ./test_frame_parser            运行检查，并打印两种解析器的帧率和每字节周期数
+ *   ./test_frame_parser rx.bin     另外在记录的接收字节流(原始字节)上比较两种解析器
+ *
+ * 字节流为连续的运行参数全量帧，夹杂随机的干扰字节、校验和错误的帧和长度字节错误的帧，按每次 16 字节
+ * (一次串口接收事件)送入解析器。原来的解析器按基线版本原样重写在本文件中，
+ * 缓冲区大小也与基线相同(36 字节)。
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "panel_uart_api.h"
+#include "wire_codec.h"
+#include "test_common.h"
+
+#define TEST_FRAMES                 20000           // 字节流中的帧数
+#define TEST_BAD_PERCENT            2               // 校验和错误的帧(%)
+#define TEST_LEN_PERCENT            1               // 长度字节错误的帧(%)
+#define TEST_NOISE_PERCENT          5               // 帧前夹杂干扰字节的比例(%)
+#define TEST_CHUNK                  16              // 每次送入解析器的字节数
+#define TEST_ROUNDS                 20              // 基准重复次数
+
+/* 基线版本的缓冲区(PROTOCOL_HEAD + 32) */
+#define LEGACY_BUFF_LEN             (PROTOCOL_HEAD + 32)
+
+/**
+ * @brief   测试字节流
+ */
+typedef struct test_stream{
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t good;                  // 校验正确的帧数
+}test_stream_t;
+
+static uint32_t s_delivered = 0;
+static uint32_t s_next_power = 0;   // 下一帧应有的最小计数(检查乱序)
+static bool s_check_order = false;
+
+/* 基线版本的接收队列和处理缓冲区 */
+static volatile uint8_t s_legacy_rx_buf[LEGACY_BUFF_LEN];
+static volatile uint8_t s_legacy_process_buf[LEGACY_BUFF_LEN];
+static volatile uint8_t *s_legacy_in = s_legacy_rx_buf;
+static volatile uint8_t *s_legacy_out = s_legacy_rx_buf;
+static uint16_t s_legacy_process_in = 0;
+static uint32_t s_legacy_delivered = 0;
+
+/**
+  * @brief  基线: 单字节入队
+  * @param  value 字节
+  * @retval 无
+  */
+static void legacy_receive_input(uint8_t value)
+{
+    if (1 == s_legacy_out - s_legacy_in)
+    {
+    }
+    else if ((s_legacy_in > s_legacy_out) && ((s_legacy_in - s_legacy_out) >= (long)sizeof(s_legacy_rx_buf)))
+    {
+    }
+    else
+    {
+        if (s_legacy_in >= (volatile uint8_t *)(s_legacy_rx_buf + sizeof(s_legacy_rx_buf)))
+        {
+            s_legacy_in = s_legacy_rx_buf;
+        }
+        *s_legacy_in++ = value;
+    }
+}
+
+/**
+  * @brief  基线: 出队一字节
+  * @param  无
+  * @retval 字节
+  */
+static uint8_t legacy_take_byte(void)
+{
+    uint8_t value = 0;
+
+    if (s_legacy_out != s_legacy_in)
+    {
+        if (s_legacy_out >= (volatile uint8_t *)(s_legacy_rx_buf + sizeof(s_legacy_rx_buf)))
+        {
+            s_legacy_out = s_legacy_rx_buf;
+        }
+        value = *s_legacy_out++;
+    }
+    return value;
+}
+
+/**
+  * @brief  基线: 累加校验和
+  * @param  pack 数据
+  * @param  pack_len 长度
+  * @retval 校验和
+  */
+static uint8_t legacy_check_sum(volatile uint8_t *pack, uint16_t pack_len)
+{
+    uint16_t check_sum = 0;
+
+    for (uint16_t i = 0; i < pack_len; i++)
+    {
+        check_sum += *pack++;
+    }
+    return (uint8_t)check_sum;
+}
+
+/**
+  * @brief  基线: 功能码检查
+  * @param  data 功能码
+  * @retval 是否有效
+  */
+static bool legacy_valid_function_num(uint8_t data)
+{
+    return (data == 0x10) || (data == 0x11) || (data == 0x12) || (data == 0x14) || (data == 0x15) ||
+           (data == 0x18) || (data == 0x20) || (data == 0x30);
+}
+
+/**
+  * @brief  基线: mcu_uart_service(包括校验失败时跳过 len+1 字节的原有行为)
+  * @param  无
+  * @retval 无
+  */
+static void legacy_service(void)
+{
+    uint8_t rx_value_len = 0;
+    uint16_t offset = 0;
+    uint8_t checksum = 0;
+
+    while ((s_legacy_process_in < sizeof(s_legacy_process_buf)) && (s_legacy_in != s_legacy_out))
+    {
+        s_legacy_process_buf[s_legacy_process_in++] = legacy_take_byte();
+    }
+    if (s_legacy_process_in < PROTOCOL_HEAD)
+    {
+        return;
+    }
+
+    while ((s_legacy_process_in - offset) >= PROTOCOL_HEAD)
+    {
+        if (s_legacy_process_buf[offset + HEAD_FIRST] != FRAME_FIRST)
+        {
+            offset++;
+            continue;
+        }
+        if (s_legacy_process_buf[offset + HEAD_SECOND] != FRAME_SECOND)
+        {
+            offset++;
+            continue;
+        }
+        if (!legacy_valid_function_num(s_legacy_process_buf[offset + FUNCTION_NUM]))
+        {
+            offset++;
+            continue;
+        }
+        rx_value_len = s_legacy_process_buf[offset + LENGTH];
+        if ((s_legacy_process_in - offset) < PROTOCOL_HEAD + rx_value_len + 1)
+        {
+            break;
+        }
+        checksum = legacy_check_sum(s_legacy_process_buf + offset, PROTOCOL_HEAD + rx_value_len);
+        if (checksum != s_legacy_process_buf[offset + PROTOCOL_HEAD + rx_value_len])
+        {
+            offset += rx_value_len + 1;
+            continue;
+        }
+        s_legacy_delivered++;
+        offset += PROTOCOL_HEAD + rx_value_len + 1;
+    }
+
+    s_legacy_process_in -= offset;
+    if (s_legacy_process_in > 0)
+    {
+        memcpy((char *)s_legacy_process_buf, (const char *)s_legacy_process_buf + offset, s_legacy_process_in);
+    }
+}
+
+/**
+  * @brief  基准中使用的毫秒时钟(目标板上是读节拍计数，主机上 clock_gettime 的开销会计入解析器)
+  * @param  无
+  * @retval 0
+  */
+static uint32_t test_clock(void)
+{
+    return 0;
+}
+
+/**
+  * @brief  现在的解析器: 运行参数处理函数(代替 system.c 中的解码和发布，只计数)
+  * @param  value 数据内容
+  * @param  len 数据内容长度
+  * @retval 无
+  */
+static void test_frame_handle(const uint8_t *value, uint8_t len)
+{
+    running_info_t info;
+
+    if (s_check_order)
+    {
+        TEST_CHECK(running_info_decode(value, len, &info));
+        TEST_CHECK(info.power >= (float)s_next_power);
+        s_next_power = (uint32_t)info.power + 1;
+    }
+    s_delivered++;
+}
+
+/**
+  * @brief  组一帧运行参数
+  * @param  frame 帧缓冲区
+  * @param  n 计数(写在功率中)
+  * @retval 帧长度
+  */
+static uint16_t test_pack(uint8_t *frame, uint32_t n)
+{
+    running_info_t info = {
+        .charge_status = 2,
+        .power = (float)n,
+        .voltage = 230.0f,
+        .current = 31.5f,
+        .net_status = 1,
+    };
+    uint8_t value[RUNNING_INFO_WIRE_LEN];
+
+    return uart_frame_pack(frame, FN_UPDT_RUN_INFO_ALL, value, running_info_encode(&info, value, sizeof(value)));
+}
+
+/**
+  * @brief  生成测试字节流
+  * @param  s 输出
+  * @retval 无
+  */
+static void test_stream_build(test_stream_t *s)
+{
+    uint8_t frame[PROTOCOL_HEAD + UART_MAX_DATA_LEN + 1];
+    uint32_t seed = 0xC0FFEEu;
+    uint32_t cap = TEST_FRAMES * (sizeof(frame) + 8);
+    uint16_t len;
+
+    s->buf = malloc(cap);
+    s->len = 0;
+    s->good = 0;
+    TEST_CHECK(s->buf != NULL);
+    for (uint32_t n = 0; n < TEST_FRAMES; n++)
+    {
+        if (test_rand(&seed) % 100 < TEST_NOISE_PERCENT)
+        {
+            for (uint32_t k = 1 + test_rand(&seed) % 7; k > 0; k--)
+            {
+                s->buf[s->len++] = (uint8_t)test_rand(&seed);
+            }
+        }
+        len = test_pack(frame, n);
+        if (test_rand(&seed) % 100 < TEST_BAD_PERCENT)
+        {
+            frame[len - 1] ^= 0x01;
+        }
+        else if (test_rand(&seed) % 100 < TEST_LEN_PERCENT)
+        {
+            /* 长度偏大(仍能放进基线的处理缓冲区)，基线版本校验失败后跳过 len+1 字节，连下一帧的帧头一起丢掉 */
+            frame[LENGTH] = (uint8_t)(26 + test_rand(&seed) % 6);
+        }
+        else
+        {
+            s->good++;
+        }
+        memcpy(s->buf + s->len, frame, len);
+        s->len += len;
+    }
+}
+
+/**
+  * @brief  现在的解析器处理整段字节流
+  * @param  s 字节流
+  * @retval 无
+  */
+static void test_feed(const test_stream_t *s)
+{
+    for (uint32_t pos = 0; pos < s->len; pos += TEST_CHUNK)
+    {
+        uart_receive_buff_input(s->buf + pos, (unsigned short)((s->len - pos < TEST_CHUNK) ? s->len - pos : TEST_CHUNK));
+        mcu_uart_service();
+    }
+}
+
+/**
+  * @brief  基线解析器处理整段字节流
+  * @param  s 字节流
+  * @retval 无
+  */
+static void legacy_feed(const test_stream_t *s)
+{
+    uint32_t end;
+
+    for (uint32_t pos = 0; pos < s->len; pos = end)
+    {
+        end = (s->len - pos < TEST_CHUNK) ? s->len : pos + TEST_CHUNK;
+        for (uint32_t i = pos; i < end; i++)
+        {
+            legacy_receive_input(s->buf[i]);
+        }
+        legacy_service();
+    }
+}
+
+/**
+  * @brief  重新同步: 坏帧数据内容中夹带的合法帧、错误的长度字节、干扰字节之后的帧都要收到
+  * @param  无
+  * @retval 无
+  */
+static void test_resync(void)
+{
+    uint8_t frame[PROTOCOL_HEAD + UART_MAX_DATA_LEN + 1];
+    uint8_t inner[PROTOCOL_HEAD + UART_MAX_DATA_LEN + 1];
+    uint8_t stream[256];
+    uint16_t len;
+    uint16_t inner_len;
+    uint32_t pos = 0;
+
+    mcu_uart_protocol_init();
+    mcu_fnum_handler_register(FN_UPDT_RUN_INFO_ALL, test_frame_handle, RUNNING_INFO_WIRE_LEN, RUNNING_INFO_WIRE_LEN);
+    s_delivered = 0;
+
+    /* 帧头 + 功能码 + 长度之后紧跟一个完整的合法帧，外层帧的校验和必然错误 */
+    len = test_pack(frame, 1);
+    inner_len = test_pack(inner, 2);
+    memcpy(stream + pos, frame, PROTOCOL_HEAD);
+    pos += PROTOCOL_HEAD;
+    memcpy(stream + pos, inner, inner_len);
+    pos += inner_len;
+    /* 长度字节错误(超过功能码表约定)的帧，之后的合法帧不必等待 */
+    len = test_pack(frame, 3);
+    frame[LENGTH] = 200;
+    memcpy(stream + pos, frame, PROTOCOL_HEAD);
+    pos += PROTOCOL_HEAD;
+    len = test_pack(frame, 4);
+    memcpy(stream + pos, frame, len);
+    pos += len;
+    /* 干扰字节(包括半个帧头)之后的合法帧 */
+    stream[pos++] = FRAME_FIRST;
+    stream[pos++] = 0x00;
+    stream[pos++] = FRAME_FIRST;
+    len = test_pack(frame, 5);
+    memcpy(stream + pos, frame, len);
+    pos += len;
+
+    uart_receive_buff_input(stream, (unsigned short)pos);
+    mcu_uart_service();
+    TEST_CHECK(s_delivered == 3);
+    TEST_CHECK(uart_rx_overflow_count() == 0);
+}
+
+/**
+  * @brief  从文件读入记录的接收字节流
+  * @param  path 文件路径
+  * @param  s 输出
+  * @retval 无
+  */
+static void test_stream_load(const char *path, test_stream_t *s)
+{
+    FILE *fp = fopen(path, "rb");
+    long size;
+
+    TEST_CHECK(fp != NULL);
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    TEST_CHECK(size > 0);
+    s->buf = malloc((size_t)size);
+    TEST_CHECK(s->buf != NULL);
+    s->len = (uint32_t)fread(s->buf, 1, (size_t)size, fp);
+    s->good = 0;
+    fclose(fp);
+}
+
+/**
+  * @brief  在同一段字节流上比较两种解析器
+  * @param  name 字节流名称
+  * @param  s 字节流
+  * @retval 无
+  */
+static void test_bench(const char *name, const test_stream_t *s)
+{
+    uint32_t new_frames;
+    uint32_t old_frames;
+    uint64_t c0;
+    uint64_t t0;
+    double new_cycles;
+    double new_ns;
+    double old_cycles;
+    double old_ns;
+
+    mcu_uart_protocol_init();
+    mcu_fnum_handler_register(FN_UPDT_RUN_INFO_ALL, test_frame_handle, RUNNING_INFO_WIRE_LEN, RUNNING_INFO_WIRE_LEN);
+    s_delivered = 0;
+    s_legacy_delivered = 0;
+    test_feed(s);
+    legacy_feed(s);
+    new_frames = s_delivered;
+    old_frames = s_legacy_delivered;
+
+    c0 = test_cycles();
+    t0 = test_now_ns();
+    for (int r = 0; r < TEST_ROUNDS; r++)
+    {
+        test_feed(s);
+    }
+    new_cycles = (double)(test_cycles() - c0);
+    new_ns = (double)(test_now_ns() - t0);
+
+    c0 = test_cycles();
+    t0 = test_now_ns();
+    for (int r = 0; r < TEST_ROUNDS; r++)
+    {
+        legacy_feed(s);
+    }
+    old_cycles = (double)(test_cycles() - c0);
+    old_ns = (double)(test_now_ns() - t0);
+
+    printf("%s: %lu bytes\n", name, (unsigned long)s->len);
+    printf("  %-8s %10s %12s %12s\n", "parser", "frames", "frames/s", "cycles/byte");
+    printf("  %-8s %10lu %12.0f %12.2f\n", "legacy", (unsigned long)old_frames,
+           (double)old_frames * TEST_ROUNDS / (old_ns / 1e9), old_cycles / ((double)s->len * TEST_ROUNDS));
+    printf("  %-8s %10lu %12.0f %12.2f\n", "new", (unsigned long)new_frames,
+           (double)new_frames * TEST_ROUNDS / (new_ns / 1e9), new_cycles / ((double)s->len * TEST_ROUNDS));
+}
+
+int main(int argc, char *argv[])
+{
+    test_stream_t s;
+
+    test_resync();
+    test_stream_build(&s);
+    mcu_uart_clock_register(test_clock);
+
+    /* 正确性: 每一帧校验正确的帧都收到，且没有乱序 */
+    mcu_uart_protocol_init();
+    mcu_fnum_handler_register(FN_UPDT_RUN_INFO_ALL, test_frame_handle, RUNNING_INFO_WIRE_LEN, RUNNING_INFO_WIRE_LEN);
+    s_delivered = 0;
+    s_check_order = true;
+    test_feed(&s);
+    TEST_CHECK(s_delivered == s.good);
+    TEST_CHECK(uart_rx_overflow_count() == 0);
+    s_check_order = false;
+
+    printf("synthetic stream: %u frames, %lu with a good checksum\n", TEST_FRAMES, (unsigned long)s.good);
+    test_bench("synthetic", &s);
+    free(s.buf);
+
+    if (argc > 1)
+    {
+        test_stream_load(argv[1], &s);
+        test_bench(argv[1], &s);
+        free(s.buf);
+    }
+    return 0;
+}
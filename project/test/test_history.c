@@ -0,0 +1,334 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/telemetry/history 的主机测试: 模拟 24 小时的串口遥测(每秒 1~2 个采样，有多次充电、
+ * 链路中断和超过 10 分钟的空白)，每隔 10 分钟把三级分辨率的全部可查询点与从原始采样直接计算的
+ * 平均值/最小值/最大值逐点比较；检查量化、时间倒退和空白时间段；报告内存占用，并给出插入和查询的耗时
+ * (查询只读已结束的点，耗时与原始采样数无关)。
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "history.h"
+#include "test_common.h"
+
+#define TEST_START                  1700000000u     // 模拟开始时间(Unix 时间，秒)
+#define TEST_SECONDS                (24u * 3600u)   // 模拟时长
+#define TEST_CHECK_EVERY            600             // 每隔多少秒全量比较一次
+#define TEST_BENCH_ROUNDS           2000            // 查询基准的轮数
+
+/**
+ * @brief   参考结果: 一个时间段内的原始采样统计
+ */
+typedef struct test_ref{
+    int32_t sum[HISTORY_CHANNELS];
+    int16_t min[HISTORY_CHANNELS];
+    int16_t max[HISTORY_CHANNELS];
+    uint32_t count;
+}test_ref_t;
+
+static history_t s_history;
+static test_ref_t s_ref0[TEST_SECONDS / HISTORY_TIER0_PERIOD + 1];
+static test_ref_t s_ref1[TEST_SECONDS / HISTORY_TIER1_PERIOD + 1];
+static test_ref_t s_ref2[TEST_SECONDS / HISTORY_TIER2_PERIOD + 1];
+static test_ref_t *const s_refs[HISTORY_TIERS] = { s_ref0, s_ref1, s_ref2 };
+static uint64_t s_samples;
+static uint32_t s_last;             // 最后一个采样的时间(相对开始的秒数)
+
+/**
+  * @brief  第 t 秒的模拟值: 电压 220 V 附近波动，每 3 小时一次约 90 分钟的充电(电流缓升、恒流、缓降)
+  * @param  t 相对开始的秒数
+  * @param  seed 随机数状态
+  * @param  value 输出量化值(功率 W、电压 0.1 V、电流 0.01 A，与 telemetry.c 相同)
+  * @retval 无
+  */
+static void test_sample(uint32_t t, uint32_t *seed, int16_t value[HISTORY_CHANNELS])
+{
+    uint32_t phase = t % (3 * 3600);
+    float voltage = 220.0f + (float)(test_rand(seed) % 101) / 10.0f - 5.0f;
+    float current = 0.0f;
+
+    if (phase < 90 * 60)
+    {
+        current = 32.0f;
+        if (phase < 300)
+        {
+            current = 32.0f * (float)phase / 300.0f;
+        }
+        else if (phase > 80 * 60)
+        {
+            current = 32.0f * (float)(90 * 60 - phase) / 600.0f;
+        }
+        current += (float)(test_rand(seed) % 21) / 100.0f - 0.1f;
+        current = (current < 0.0f) ? 0.0f : current;
+    }
+    value[0] = history_quantize(voltage * current, 1);
+    value[1] = history_quantize(voltage, 10);
+    value[2] = history_quantize(current, 100);
+}
+
+/**
+  * @brief  累加到参考结果
+  * @param  t 相对开始的秒数
+  * @param  value 量化值
+  * @retval 无
+  */
+static void test_ref_add(uint32_t t, const int16_t value[HISTORY_CHANNELS])
+{
+    for (int i = 0; i < HISTORY_TIERS; i++)
+    {
+        test_ref_t *r = &s_refs[i][(TEST_START + t) / s_history.tiers[i].period -
+                                   TEST_START / s_history.tiers[i].period];
+
+        if (r->count == 0)
+        {
+            for (int c = 0; c < HISTORY_CHANNELS; c++)
+            {
+                r->min[c] = value[c];
+                r->max[c] = value[c];
+            }
+        }
+        for (int c = 0; c < HISTORY_CHANNELS; c++)
+        {
+            r->sum[c] += value[c];
+            r->min[c] = (value[c] < r->min[c]) ? value[c] : r->min[c];
+            r->max[c] = (value[c] > r->max[c]) ? value[c] : r->max[c];
+        }
+        r->count++;
+    }
+}
+
+/**
+  * @brief  把三级分辨率的全部可查询点与参考结果比较
+  * @param  无
+  * @retval 无
+  */
+static void test_compare(void)
+{
+    static history_point_t points[HISTORY_TIER2_SLOTS];
+
+    for (uint8_t i = 0; i < HISTORY_TIERS; i++)
+    {
+        const history_tier_t *t = &s_history.tiers[i];
+        uint32_t base = TEST_START / t->period;
+        uint32_t first;
+        uint32_t end;
+
+        history_range(&s_history, i, 0, &first, &end);
+        /* 最后一个采样所在的时间段尚未结束；最多保留 slots 个点 */
+        TEST_CHECK(end == (TEST_START + s_last) / t->period);
+        TEST_CHECK(first == ((end - base > t->slots) ? end - t->slots : base));
+        TEST_CHECK(end - first <= t->slots);
+
+        history_read(&s_history, i, first, points, end - first);
+        for (uint32_t b = first; b < end; b++)
+        {
+            const history_point_t *p = &points[b - first];
+            const test_ref_t *r = &s_refs[i][b - base];
+            int32_t half = (int32_t)r->count / 2;
+            int32_t avg;
+
+            for (int c = 0; c < HISTORY_CHANNELS; c++)
+            {
+                if (r->count == 0)
+                {
+                    TEST_CHECK(p->ch[c].avg == HISTORY_EMPTY && p->ch[c].min == HISTORY_EMPTY &&
+                               p->ch[c].max == HISTORY_EMPTY);
+                    continue;
+                }
+                /* 四舍五入(远离零)的整数平均值 */
+                avg = (r->sum[c] >= 0) ? (r->sum[c] + half) / (int32_t)r->count
+                                       : (r->sum[c] - half) / (int32_t)r->count;
+                TEST_CHECK(p->ch[c].avg == avg);
+                TEST_CHECK(p->ch[c].min == r->min[c] && p->ch[c].max == r->max[c]);
+                TEST_CHECK(p->ch[c].min <= p->ch[c].avg && p->ch[c].avg <= p->ch[c].max);
+            }
+        }
+
+        /* 超出范围的时间段读为空 */
+        history_read(&s_history, i, end, points, 2);
+        TEST_CHECK(points[0].ch[0].avg == HISTORY_EMPTY && points[1].ch[2].max == HISTORY_EMPTY);
+        if (first > 0)
+        {
+            history_read(&s_history, i, first - 1, points, 1);
+            TEST_CHECK(points[0].ch[1].min == HISTORY_EMPTY);
+        }
+    }
+}
+
+/**
+  * @brief  第 t 秒是否有采样: 模拟链路中断(1 分钟、20 分钟)和偶发的丢帧
+  * @param  t 相对开始的秒数
+  * @param  seed 随机数状态
+  * @retval 是否有采样
+  */
+static bool test_online(uint32_t t, uint32_t *seed)
+{
+    if ((t >= 3600 && t < 3660) || (t >= 40000 && t < 41200))
+    {
+        return false;
+    }
+    return test_rand(seed) % 50 != 0;
+}
+
+/**
+  * @brief  24 小时模拟
+  * @param  无
+  * @retval 无
+  */
+static void test_day(void)
+{
+    int16_t value[HISTORY_CHANNELS];
+    uint32_t seed = 0xA11CEu;
+    uint64_t cycles = 0;
+    uint64_t c0;
+
+    history_init(&s_history);
+    memset(s_ref0, 0, sizeof(s_ref0));
+    memset(s_ref1, 0, sizeof(s_ref1));
+    memset(s_ref2, 0, sizeof(s_ref2));
+
+    for (uint32_t t = 0; t < TEST_SECONDS; t++)
+    {
+        if (t > 0 && t % TEST_CHECK_EVERY == 0)
+        {
+            test_compare();
+        }
+        if (!test_online(t, &seed))
+        {
+            continue;
+        }
+        /* 串口任务在同一秒内可能收到两帧运行参数 */
+        for (int n = (test_rand(&seed) % 5 == 0) ? 2 : 1; n > 0; n--)
+        {
+            test_sample(t, &seed, value);
+            c0 = test_cycles();
+            TEST_CHECK(history_add(&s_history, TEST_START + t, value));
+            cycles += test_cycles() - c0;
+            test_ref_add(t, value);
+            s_samples++;
+            s_last = t;
+        }
+    }
+    /* 再插入一个采样结束最后一个时间段 */
+    test_sample(TEST_SECONDS, &seed, value);
+    TEST_CHECK(history_add(&s_history, TEST_START + TEST_SECONDS, value));
+    s_last = TEST_SECONDS;
+    test_compare();
+
+    printf("24 h: %lu samples, %.1f cycles/sample to insert\n", (unsigned long)s_samples,
+           (double)cycles / s_samples);
+}
+
+/**
+  * @brief  量化、时间倒退、长时间空白
+  * @param  无
+  * @retval 无
+  */
+static void test_edges(void)
+{
+    int16_t value[HISTORY_CHANNELS] = { 100, 2200, 1600 };
+    history_point_t p;
+    uint32_t first;
+    uint32_t end;
+
+    TEST_CHECK(history_quantize(1.25f, 10) == 13);
+    TEST_CHECK(history_quantize(-1.25f, 10) == -13);
+    TEST_CHECK(history_quantize(0.04f, 10) == 0);
+    TEST_CHECK(history_quantize(1e9f, 1) == HISTORY_VALUE_MAX);
+    TEST_CHECK(history_quantize(-1e9f, 1) == -HISTORY_VALUE_MAX);
+    TEST_CHECK(history_quantize(-1e9f, 1) != HISTORY_EMPTY);
+
+    TEST_CHECK(history_tier_find(1) == 0 && history_tier_find(10) == 1 && history_tier_find(60) == 2);
+    TEST_CHECK(history_tier_find(5) == -1);
+
+    history_init(&s_history);
+    history_range(&s_history, 0, 0, &first, &end);
+    TEST_CHECK(first == end);
+
+    TEST_CHECK(history_add(&s_history, 1000, value));
+    TEST_CHECK(history_add(&s_history, 1000, value));
+    TEST_CHECK(!history_add(&s_history, 999, value));
+    value[0] = -300;
+    TEST_CHECK(history_add(&s_history, 1001, value));
+    history_range(&s_history, 0, 0, &first, &end);
+    TEST_CHECK(first == 1000 && end == 1001);
+    history_read(&s_history, 0, 1000, &p, 1);
+    TEST_CHECK(p.ch[0].avg == 100 && p.ch[0].min == 100 && p.ch[0].max == 100);
+
+    /* from 之前的时间段不返回 */
+    TEST_CHECK(history_add(&s_history, 1010, value));
+    history_range(&s_history, 0, 1005, &first, &end);
+    TEST_CHECK(first == 1005 && end == 1010);
+    history_read(&s_history, 0, 1005, &p, 1);
+    TEST_CHECK(p.ch[0].avg == HISTORY_EMPTY);
+    history_range(&s_history, 0, 5000, &first, &end);
+    TEST_CHECK(first == end);
+
+    /* 10 秒一级: 1000~1009 秒的三个采样，负数的平均值远离零取整 */
+    history_read(&s_history, 1, 100, &p, 1);
+    TEST_CHECK(p.ch[0].min == -300 && p.ch[0].max == 100 && p.ch[0].avg == -33);
+    history_read(&s_history, 1, 101, &p, 1);
+    TEST_CHECK(p.ch[0].avg == HISTORY_EMPTY);
+    TEST_CHECK(history_add(&s_history, 1020, value));
+    history_read(&s_history, 1, 101, &p, 1);
+    TEST_CHECK(p.ch[0].avg == -300);
+
+    /* 空白超过一整级: 该级全部为空，已结束的范围仍连续 */
+    TEST_CHECK(history_add(&s_history, 1020 + 2 * 24 * 3600, value));
+    for (uint8_t i = 0; i < HISTORY_TIERS; i++)
+    {
+        history_range(&s_history, i, 0, &first, &end);
+        TEST_CHECK(end - first == s_history.tiers[i].slots);
+        for (uint32_t b = first; b < end; b++)
+        {
+            history_read(&s_history, i, b, &p, 1);
+            TEST_CHECK(p.ch[1].avg == HISTORY_EMPTY);
+        }
+    }
+}
+
+/**
+  * @brief  内存占用和查询耗时
+  * @param  无
+  * @retval 无
+  */
+static void test_footprint(void)
+{
+    static history_point_t points[HISTORY_TIER2_SLOTS];
+    uint32_t first;
+    uint32_t end;
+    uint64_t c0;
+
+    printf("history_t: %lu bytes (%u points x %lu bytes + %lu bytes of tier state)\n",
+           (unsigned long)sizeof(history_t), HISTORY_TOTAL_SLOTS, (unsigned long)sizeof(history_point_t),
+           (unsigned long)(sizeof(history_t) - sizeof(s_history.points)));
+    printf("raw float samples for the same spans: %lu bytes (10 min at 1 s + 2 h at 10 s + 24 h at 1 min, "
+           "3 channels x min/avg/max); 24 h at 1 s: %lu bytes\n",
+           (unsigned long)(HISTORY_TOTAL_SLOTS * HISTORY_CHANNELS * 3 * sizeof(float)),
+           (unsigned long)(TEST_SECONDS * HISTORY_CHANNELS * sizeof(float)));
+    TEST_CHECK(sizeof(history_point_t) == 18);
+
+    for (uint8_t i = 0; i < HISTORY_TIERS; i++)
+    {
+        history_range(&s_history, i, 0, &first, &end);
+        c0 = test_cycles();
+        for (int n = 0; n < TEST_BENCH_ROUNDS; n++)
+        {
+            history_read(&s_history, i, first, points, end - first);
+            TEST_KEEP(points);
+        }
+        printf("tier %u (%2lu s): %4lu points, %7.0f cycles/query\n", i, (unsigned long)s_history.tiers[i].period,
+               (unsigned long)(end - first), (double)(test_cycles() - c0) / TEST_BENCH_ROUNDS);
+    }
+}
+
+int main(void)
+{
+    test_edges();
+    test_day();
+    test_footprint();
+    return 0;
+}
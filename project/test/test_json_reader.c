@@ -0,0 +1,496 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/json/json_reader 的主机测试、模糊测试和基准:
+ *
+ *   检查  配置和卡片请求体(字段表与 main.c 相同)的各种错误码和出错字段
+ *   模糊  在语料上随机改写(翻转、插入、删除、截断、复制片段)，按随机大小分块输入，
+ *         结果必须与整段输入相同；成功时每个字段都在字段表的范围内；目标结构体之外的字节不被改写；
+ *         整个过程不申请堆内存(mem_stats 包装 malloc)
+ *   基准  按 128 字节(HTTP_RECV_CHUNK_LEN)分块解析配置请求体的耗时，以及最坏输入(1 KB 空白、
+ *         最长的键和值)的每字节耗时，验证耗时只与输入长度成正比
+ *
+ *   ./test_json_reader [轮数]      默认 200000 轮模糊测试
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "json_reader.h"
+#include "mem_stats.h"
+#include "test_common.h"
+
+#define TEST_FUZZ_ROUNDS            200000          // 默认模糊测试轮数
+#define TEST_DOC_LEN                1024            // 与 HTTP_JSON_BODY_MAX_LEN 相同
+#define TEST_RECV_CHUNK             128             // 与 HTTP_RECV_CHUNK_LEN 相同
+#define TEST_BENCH_ROUNDS           200000          // 基准请求数
+#define TEST_GUARD                  0xA5            // 目标结构体前后的保护字节
+
+/**
+ * @brief   参数配置(与 param_config_t 相同)
+ */
+typedef struct test_config{
+    float ov_threshold;
+    float uv_threshold;
+    uint8_t leakagedc;
+    uint8_t leakageac;
+    uint8_t maxcc;
+}test_config_t;
+
+/**
+ * @brief   添加卡片的请求体(与 main.c 的 card_json_t 相同)
+ */
+typedef struct test_card{
+    char id[8 + 1];
+    char expireDate[10 + 1];
+}test_card_t;
+
+/**
+ * @brief   所有字段类型
+ */
+typedef struct test_all{
+    uint16_t u16;
+    uint32_t u32;
+    bool flag;
+    char name[16];
+}test_all_t;
+
+static const json_field_t s_config_fields[] =
+{
+    JSON_FIELD_FLOAT32(test_config_t, ov_threshold, 0.0f, 400.0f, 0),
+    JSON_FIELD_FLOAT32(test_config_t, uv_threshold, 0.0f, 400.0f, 0),
+    JSON_FIELD_UINT8(test_config_t, leakagedc, 10, 50, 0),
+    JSON_FIELD_UINT8(test_config_t, leakageac, 10, 50, 0),
+    JSON_FIELD_UINT8(test_config_t, maxcc, 0, 64, 0),
+};
+
+static const json_field_t s_card_fields[] =
+{
+    JSON_FIELD_STR(test_card_t, id, 8, 8, JSON_FIELD_REQUIRED),
+    JSON_FIELD_STR(test_card_t, expireDate, 10, 10, JSON_FIELD_REQUIRED),
+};
+
+static const json_field_t s_all_fields[] =
+{
+    JSON_FIELD_UINT16(test_all_t, u16, 0, 65535, 0),
+    JSON_FIELD_UINT32(test_all_t, u32, 0, 4e9f, 0),
+    JSON_FIELD_BOOLEAN(test_all_t, flag, JSON_FIELD_REQUIRED),
+    JSON_FIELD_STR(test_all_t, name, 0, 15, 0),
+};
+
+/**
+ * @brief   一个字段表及其目标结构体
+ */
+typedef struct test_schema{
+    const char *name;
+    const json_field_t *fields;
+    uint8_t count;
+    size_t size;                    // 目标结构体大小
+}test_schema_t;
+
+static const test_schema_t s_schemas[] =
+{
+    { "config", s_config_fields, sizeof(s_config_fields) / sizeof(s_config_fields[0]), sizeof(test_config_t) },
+    { "card", s_card_fields, sizeof(s_card_fields) / sizeof(s_card_fields[0]), sizeof(test_card_t) },
+    { "all", s_all_fields, sizeof(s_all_fields) / sizeof(s_all_fields[0]), sizeof(test_all_t) },
+};
+
+/**
+ * @brief   语料: 字段表下标 + 请求体
+ */
+typedef struct test_doc{
+    uint8_t schema;
+    const char *text;
+}test_doc_t;
+
+static const test_doc_t s_corpus[] =
+{
+    { 0, "{\"ov_threshold\":264.5,\"uv_threshold\":195.5,\"leakagedc\":30,\"leakageac\":30,\"maxcc\":32}" },
+    { 0, " { \"maxcc\" : 16 ,\r\n\t\"ov_threshold\": 2.5e2 } " },
+    { 0, "{}" },
+    { 1, "{\"id\":\"12345678\",\"expireDate\":\"2026-12-31\"}" },
+    { 1, "{\"expireDate\":\"2026\\/12\\/31\",\"id\":\"0000000\\u0031\"}" },
+    { 2, "{\"u16\":65535,\"u32\":4000000000,\"flag\":true,\"name\":\"a\\\"b\\\\c\\n\"}" },
+    { 2, "{\"flag\":false,\"u32\":-0}" },
+};
+
+/**
+ * @brief   一次解析的结果
+ */
+typedef struct test_result{
+    json_read_status_t status;
+    const char *field;
+    uint8_t obj[64];
+}test_result_t;
+
+/**
+  * @brief  解析一个请求体
+  * @param  schema 字段表
+  * @param  text 请求体
+  * @param  len 长度
+  * @param  seed 分块大小的随机数状态，NULL 表示整段输入
+  * @param  res 输出
+  * @retval 无
+  */
+static void test_parse(const test_schema_t *schema, const char *text, size_t len, uint32_t *seed, test_result_t *res)
+{
+    uint8_t area[sizeof(res->obj) + 32];
+    uint8_t *obj = area + 16;
+    json_reader_t rd;
+    size_t pos = 0;
+    size_t n;
+
+    memset(area, TEST_GUARD, sizeof(area));
+    memset(obj, 0, schema->size);
+    json_reader_init(&rd, schema->fields, schema->count, obj);
+    while (pos < len)
+    {
+        n = (seed == NULL) ? len - pos : 1 + test_rand(seed) % 24;
+        n = (n < len - pos) ? n : len - pos;
+        if (json_reader_feed(&rd, text + pos, n) != JSON_READ_OK)
+        {
+            /* 出错后之后的输入被忽略 */
+            TEST_CHECK(json_reader_feed(&rd, "{}", 2) == (json_read_status_t)rd.status);
+            break;
+        }
+        pos += n;
+    }
+    res->status = json_reader_finish(&rd);
+    res->field = json_reader_error_field(&rd);
+    memcpy(res->obj, obj, schema->size);
+
+    for (size_t i = 0; i < 16; i++)
+    {
+        TEST_CHECK(area[i] == TEST_GUARD);
+    }
+    for (size_t i = 16 + schema->size; i < sizeof(area); i++)
+    {
+        TEST_CHECK(area[i] == TEST_GUARD);
+    }
+}
+
+/**
+  * @brief  解析成功时，每个出现过的字段都在字段表的范围内
+  * @param  schema 字段表
+  * @param  res 结果
+  * @retval 无
+  */
+static void test_check_ranges(const test_schema_t *schema, const test_result_t *res)
+{
+    for (uint8_t i = 0; i < schema->count; i++)
+    {
+        const json_field_t *f = &schema->fields[i];
+        const uint8_t *member = res->obj + f->offset;
+        float fv;
+        uint32_t u32;
+        uint16_t u16;
+
+        switch (f->type)
+        {
+            case JSON_FIELD_FLOAT:
+            memcpy(&fv, member, sizeof(fv));
+            TEST_CHECK(fv == 0.0f || (fv >= f->min && fv <= f->max));
+            break;
+
+            case JSON_FIELD_U8:
+            TEST_CHECK(*member == 0 || (*member >= f->min && *member <= f->max));
+            break;
+
+            case JSON_FIELD_U16:
+            memcpy(&u16, member, sizeof(u16));
+            TEST_CHECK(u16 == 0 || (u16 >= f->min && u16 <= f->max));
+            break;
+
+            case JSON_FIELD_U32:
+            memcpy(&u32, member, sizeof(u32));
+            TEST_CHECK(u32 == 0 || ((float)u32 >= f->min && (float)u32 <= f->max));
+            break;
+
+            case JSON_FIELD_BOOL:
+            TEST_CHECK(*member <= 1);
+            break;
+
+            case JSON_FIELD_STRING:
+            default:
+            TEST_CHECK(memchr(member, '\0', f->size) != NULL);
+            TEST_CHECK(strlen((const char *)member) == 0 ||
+                       (strlen((const char *)member) >= f->min && strlen((const char *)member) <= f->max));
+            break;
+        }
+    }
+}
+
+/**
+  * @brief  期望的错误码和出错字段
+  * @param  schema 字段表下标
+  * @param  text 请求体
+  * @param  status 期望的错误码
+  * @param  field 期望的出错字段，NULL 表示无
+  * @retval 无
+  */
+static void test_expect(uint8_t schema, const char *text, json_read_status_t status, const char *field)
+{
+    test_result_t res;
+    uint32_t seed = 1;
+
+    test_parse(&s_schemas[schema], text, strlen(text), NULL, &res);
+    if (res.status != status || (field == NULL) != (res.field == NULL) ||
+        (field != NULL && strcmp(field, res.field) != 0))
+    {
+        fprintf(stderr, "%s: got %s (%s)\n", text, json_read_strerror(res.status), res.field ? res.field : "-");
+    }
+    TEST_CHECK(res.status == status);
+    TEST_CHECK((field == NULL) == (res.field == NULL));
+    TEST_CHECK(field == NULL || strcmp(field, res.field) == 0);
+
+    /* 逐字节输入结果相同 */
+    for (int i = 0; i < 4; i++)
+    {
+        test_result_t chunked;
+
+        test_parse(&s_schemas[schema], text, strlen(text), &seed, &chunked);
+        TEST_CHECK(chunked.status == res.status && chunked.field == res.field);
+        TEST_CHECK(memcmp(chunked.obj, res.obj, s_schemas[schema].size) == 0);
+    }
+}
+
+/**
+  * @brief  各种错误码
+  * @param  无
+  * @retval 无
+  */
+static void test_cases(void)
+{
+    test_result_t res;
+    test_config_t config;
+    test_card_t card;
+    test_all_t all;
+
+    test_parse(&s_schemas[0], s_corpus[0].text, strlen(s_corpus[0].text), NULL, &res);
+    TEST_CHECK(res.status == JSON_READ_OK);
+    memcpy(&config, res.obj, sizeof(config));
+    TEST_CHECK(config.ov_threshold == 264.5f && config.uv_threshold == 195.5f);
+    TEST_CHECK(config.leakagedc == 30 && config.leakageac == 30 && config.maxcc == 32);
+
+    test_parse(&s_schemas[1], s_corpus[4].text, strlen(s_corpus[4].text), NULL, &res);
+    TEST_CHECK(res.status == JSON_READ_ERR_SYNTAX);     // 不支持 \u 转义
+    test_parse(&s_schemas[1], s_corpus[3].text, strlen(s_corpus[3].text), NULL, &res);
+    TEST_CHECK(res.status == JSON_READ_OK);
+    memcpy(&card, res.obj, sizeof(card));
+    TEST_CHECK(strcmp(card.id, "12345678") == 0 && strcmp(card.expireDate, "2026-12-31") == 0);
+
+    test_parse(&s_schemas[2], s_corpus[5].text, strlen(s_corpus[5].text), NULL, &res);
+    TEST_CHECK(res.status == JSON_READ_OK);
+    memcpy(&all, res.obj, sizeof(all));
+    TEST_CHECK(all.u16 == 65535 && all.u32 == 4000000000u && all.flag && strcmp(all.name, "a\"b\\c\n") == 0);
+
+    test_expect(0, s_corpus[1].text, JSON_READ_OK, NULL);
+    test_expect(0, "{\"ov_threshold\":400.1}", JSON_READ_ERR_RANGE, "ov_threshold");
+    test_expect(0, "{\"ov_threshold\":-1}", JSON_READ_ERR_RANGE, "ov_threshold");
+    test_expect(0, "{\"ov_threshold\":nan}", JSON_READ_ERR_TYPE, "ov_threshold");
+    test_expect(0, "{\"ov_threshold\":0x10}", JSON_READ_ERR_TYPE, "ov_threshold");
+    test_expect(0, "{\"ov_threshold\":\"230\"}", JSON_READ_ERR_TYPE, "ov_threshold");
+    test_expect(0, "{\"maxcc\":65}", JSON_READ_ERR_RANGE, "maxcc");
+    test_expect(0, "{\"maxcc\":1.5}", JSON_READ_ERR_TYPE, "maxcc");
+    test_expect(0, "{\"maxcc\":-3}", JSON_READ_ERR_RANGE, "maxcc");
+    test_expect(0, "{\"maxcc\":99999999999}", JSON_READ_ERR_RANGE, "maxcc");
+    test_expect(0, "{\"leakagedc\":9}", JSON_READ_ERR_RANGE, "leakagedc");
+    test_expect(0, "{\"maxcc\":1,\"maxcc\":2}", JSON_READ_ERR_DUPLICATE, "maxcc");
+    test_expect(0, "{\"power\":1}", JSON_READ_ERR_UNKNOWN, NULL);
+    test_expect(0, "{\"maxcc\":{}}", JSON_READ_ERR_SYNTAX, "maxcc");
+    test_expect(0, "{\"maxcc\":[1]}", JSON_READ_ERR_SYNTAX, "maxcc");
+    test_expect(0, "{\"maxcc\":1,}", JSON_READ_ERR_SYNTAX, NULL);
+    test_expect(0, "{\"maxcc\":1} x", JSON_READ_ERR_SYNTAX, NULL);
+    test_expect(0, "[]", JSON_READ_ERR_SYNTAX, NULL);
+    test_expect(0, "", JSON_READ_ERR_INCOMPLETE, NULL);
+    test_expect(0, "{\"maxcc\":1", JSON_READ_ERR_INCOMPLETE, "maxcc");
+    test_expect(0, "{\"maxcc\":1234567890123456789012345678901234}", JSON_READ_ERR_TOO_LONG, "maxcc");
+    test_expect(0, "{\"abcdefghijklmnopqrstuvwxyz\":1}", JSON_READ_ERR_TOO_LONG, NULL);
+    test_expect(1, "{\"id\":\"12345678\"}", JSON_READ_ERR_MISSING, "expireDate");
+    test_expect(1, "{\"id\":\"1234567\",\"expireDate\":\"2026-12-31\"}", JSON_READ_ERR_RANGE, "id");
+    test_expect(1, "{\"id\":12345678}", JSON_READ_ERR_TYPE, "id");
+    test_expect(1, "{\"id\":\"1234\n5678\"}", JSON_READ_ERR_SYNTAX, "id");
+    test_expect(2, "{\"flag\":1}", JSON_READ_ERR_TYPE, "flag");
+    test_expect(2, "{\"flag\":true,\"u16\":65536}", JSON_READ_ERR_RANGE, "u16");
+    test_expect(2, "{\"flag\":true,\"u32\":4294967296}", JSON_READ_ERR_RANGE, "u32");
+    test_expect(2, "{\"flag\":true,\"name\":\"0123456789abcdef\"}", JSON_READ_ERR_RANGE, "name");
+    test_expect(2, "{\"flag\":true,\"name\":\"\\x\"}", JSON_READ_ERR_SYNTAX, "name");
+}
+
+/**
+  * @brief  随机改写一个请求体
+  * @param  src 原文
+  * @param  dst 输出
+  * @param  seed 随机数状态
+  * @retval 长度
+  */
+static size_t test_mutate(const char *src, char *dst, uint32_t *seed)
+{
+    static const char tokens[] = "{}[]\":,\\ -.0123456789eEtrufalsn";
+    size_t len = strlen(src);
+    size_t pos;
+    size_t n;
+
+    memcpy(dst, src, len);
+    for (uint32_t k = 1 + test_rand(seed) % 4; k > 0 && len > 0; k--)
+    {
+        pos = test_rand(seed) % len;
+        switch (test_rand(seed) % 6)
+        {
+            case 0:                 /* 翻转一位 */
+            dst[pos] ^= (char)(1u << (test_rand(seed) % 8));
+            break;
+
+            case 1:                 /* 替换为语法字符 */
+            dst[pos] = tokens[test_rand(seed) % (sizeof(tokens) - 1)];
+            break;
+
+            case 2:                 /* 插入 */
+            if (len < TEST_DOC_LEN - 1)
+            {
+                memmove(dst + pos + 1, dst + pos, len - pos);
+                dst[pos] = (test_rand(seed) & 1) ? tokens[test_rand(seed) % (sizeof(tokens) - 1)] :
+                                                    (char)test_rand(seed);
+                len++;
+            }
+            break;
+
+            case 3:                 /* 删除 */
+            memmove(dst + pos, dst + pos + 1, len - pos - 1);
+            len--;
+            break;
+
+            case 4:                 /* 截断 */
+            len = pos;
+            break;
+
+            default:                /* 复制一段到末尾之前 */
+            n = 1 + test_rand(seed) % 16;
+            n = (pos + n <= len) ? n : len - pos;
+            if (len + n < TEST_DOC_LEN)
+            {
+                memmove(dst + pos + n, dst + pos, len - pos);
+                len += n;
+            }
+            break;
+        }
+    }
+    return len;
+}
+
+/**
+  * @brief  模糊测试
+  * @param  rounds 轮数
+  * @retval 无
+  */
+static void test_fuzz(uint32_t rounds)
+{
+    mem_subsys_stats_t before[MEM_SUBSYS_COUNT];
+    mem_subsys_stats_t after[MEM_SUBSYS_COUNT];
+    uint32_t counts[JSON_READ_ERR_INCOMPLETE + 1] = { 0 };
+    char doc[TEST_DOC_LEN];
+    uint32_t seed = 0xF022u;
+    uint32_t chunk_seed = 0xC4u;
+    test_result_t whole;
+    test_result_t chunked;
+    const test_doc_t *src;
+    size_t len;
+
+    mem_stats_get(before);
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        src = &s_corpus[test_rand(&seed) % (sizeof(s_corpus) / sizeof(s_corpus[0]))];
+        len = test_mutate(src->text, doc, &seed);
+        test_parse(&s_schemas[src->schema], doc, len, NULL, &whole);
+        test_parse(&s_schemas[src->schema], doc, len, &chunk_seed, &chunked);
+        TEST_CHECK(whole.status == chunked.status && whole.field == chunked.field);
+        TEST_CHECK(memcmp(whole.obj, chunked.obj, s_schemas[src->schema].size) == 0);
+        if (whole.status == JSON_READ_OK)
+        {
+            test_check_ranges(&s_schemas[src->schema], &whole);
+        }
+        counts[whole.status]++;
+    }
+    mem_stats_get(after);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        TEST_CHECK(after[i].allocs == before[i].allocs);
+    }
+
+    printf("fuzz: %lu inputs, no heap allocations;", (unsigned long)rounds);
+    for (int i = 0; i <= JSON_READ_ERR_INCOMPLETE; i++)
+    {
+        printf(" %s %lu%s", json_read_strerror((json_read_status_t)i), (unsigned long)counts[i],
+               i < JSON_READ_ERR_INCOMPLETE ? "," : "\n");
+    }
+}
+
+/**
+  * @brief  按 128 字节分块解析一个请求体多次
+  * @param  name 名称
+  * @param  schema 字段表
+  * @param  text 请求体
+  * @param  len 长度
+  * @retval 无
+  */
+static void test_bench_doc(const char *name, const test_schema_t *schema, const char *text, size_t len)
+{
+    uint8_t obj[64];
+    json_reader_t rd;
+    uint64_t t0;
+    uint64_t c0;
+    double ns;
+    double cycles;
+
+    t0 = test_now_ns();
+    c0 = test_cycles();
+    for (uint32_t r = 0; r < TEST_BENCH_ROUNDS; r++)
+    {
+        json_reader_init(&rd, schema->fields, schema->count, obj);
+        for (size_t pos = 0; pos < len; pos += TEST_RECV_CHUNK)
+        {
+            json_reader_feed(&rd, text + pos, (len - pos < TEST_RECV_CHUNK) ? len - pos : TEST_RECV_CHUNK);
+        }
+        json_reader_finish(&rd);
+        TEST_KEEP(obj);
+    }
+    cycles = (double)(test_cycles() - c0) / TEST_BENCH_ROUNDS;
+    ns = (double)(test_now_ns() - t0) / TEST_BENCH_ROUNDS;
+    printf("%-14s %5lu bytes %8.2f us/request %7.1f MB/s %6.1f cycles/byte (%s)\n", name, (unsigned long)len,
+           ns / 1e3, len / ns * 1e3, cycles / len, json_read_strerror(json_reader_finish(&rd)));
+}
+
+/**
+  * @brief  基准: 正常请求体和最坏输入
+  * @param  无
+  * @retval 无
+  */
+static void test_bench(void)
+{
+    static char doc[TEST_DOC_LEN];
+    size_t len;
+
+    test_bench_doc("config", &s_schemas[0], s_corpus[0].text, strlen(s_corpus[0].text));
+    test_bench_doc("card", &s_schemas[1], s_corpus[3].text, strlen(s_corpus[3].text));
+
+    /* 1 KB 空白后跟一个配置 */
+    len = strlen(s_corpus[0].text);
+    memset(doc, ' ', sizeof(doc) - len);
+    memcpy(doc + sizeof(doc) - len, s_corpus[0].text, len);
+    test_bench_doc("1k whitespace", &s_schemas[0], doc, sizeof(doc));
+
+    /* 最长的字符串值和大量转义 */
+    len = (size_t)snprintf(doc, sizeof(doc), "{\"flag\":true,\"name\":\"\\t\\n\\\"\\\\abcdefghijk\",\"u32\":4000000000}");
+    test_bench_doc("escapes", &s_schemas[2], doc, len);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t rounds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : TEST_FUZZ_ROUNDS;
+
+    test_cases();
+    test_fuzz(rounds);
+    test_bench();
+    return 0;
+}
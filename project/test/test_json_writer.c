@@ -0,0 +1,437 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/json/json_writer 的主机测试和基准:
+ *
+ *   检查  字符串转义、整数边界、定点小数的舍入(与 printf 比较)、逗号和嵌套、错误状态、
+ *         小缓冲区分块输出与一次输出的内容相同、生成一个响应不申请堆内存(mem_stats 包装 malloc)
+ *   基准  /api/status 和 100 张卡片的 /api/cards，与逐个值 snprintf(浮点数用 cJSON 的 "%1.15g")
+ *         的写法比较每秒输出的字节数；找到 cJSON 库时(TEST_HAVE_CJSON)再与 cJSON 的 DOM 比较，
+ *         并统计每个请求的堆分配次数
+ */
+
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <string.h>
+
+#include "json_writer.h"
+#include "mem_stats.h"
+#include "test_common.h"
+#ifdef TEST_HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+#define TEST_CARDS                  100             // 卡片列表的卡片数(旧固件的上限)
+#define TEST_BUF_LEN                512             // 与 HTTP_JSON_BUF_LEN 相同
+#define TEST_BENCH_ROUNDS           20000           // 基准请求数
+#define TEST_OUT_LEN                8192            // 收集输出的缓冲区
+
+/**
+ * @brief   输出收集(模拟 httpd_resp_send_chunk)
+ */
+typedef struct test_out{
+    char buf[TEST_OUT_LEN];
+    size_t len;
+    uint32_t chunks;
+}test_out_t;
+
+static char s_card_ids[TEST_CARDS][9];
+static const char *s_card_date = "2026-12-31";
+
+/**
+  * @brief  输出回调: 追加到收集缓冲区
+  * @param  ctx test_out_t
+  * @param  buf 数据
+  * @param  len 长度
+  * @retval 是否成功
+  */
+static bool test_flush(void *ctx, const char *buf, size_t len)
+{
+    test_out_t *out = ctx;
+
+    if (out->len + len >= sizeof(out->buf))
+    {
+        return false;
+    }
+    memcpy(out->buf + out->len, buf, len);
+    out->len += len;
+    out->buf[out->len] = '\0';
+    out->chunks++;
+    return true;
+}
+
+/**
+  * @brief  用指定大小的缓冲区写一个值并取得完整输出
+  * @param  size 写入器缓冲区大小
+  * @param  build 写入函数
+  * @param  out 输出
+  * @retval 写入器是否正常
+  */
+static bool test_write(size_t size, void (*build)(json_writer_t *w), test_out_t *out)
+{
+    char buf[TEST_OUT_LEN];
+    json_writer_t w;
+
+    out->len = 0;
+    out->chunks = 0;
+    out->buf[0] = '\0';
+    json_writer_init(&w, buf, size, test_flush, out);
+    build(&w);
+    json_writer_flush(&w);
+    return json_writer_ok(&w);
+}
+
+/**
+  * @brief  与 handler_get_api_status 相同的响应
+  */
+static void test_build_status(json_writer_t *w)
+{
+    json_object_begin(w);
+    json_kv_uint(w, "charge_status", 2);
+    json_kv_float(w, "power", 7040.0f, 1);
+    json_kv_float(w, "voltage", 230.5f, 1);
+    json_kv_float(w, "current", 30.61f, 2);
+    json_kv_uint(w, "net_status", 1);
+    json_object_end(w);
+}
+
+/**
+  * @brief  与 handler_api_cards_get 相同的响应
+  */
+static void test_build_cards(json_writer_t *w)
+{
+    json_array_begin(w);
+    for (int i = 0; i < TEST_CARDS; i++)
+    {
+        json_object_begin(w);
+        json_kv_string(w, "id", s_card_ids[i]);
+        json_kv_string(w, "expireDate", s_card_date);
+        json_object_end(w);
+    }
+    json_array_end(w);
+}
+
+/**
+  * @brief  各种值类型、转义和嵌套
+  */
+static void test_build_mixed(json_writer_t *w)
+{
+    json_object_begin(w);
+    json_kv_string(w, "s", "a\"b\\c\n\r\t\x01\x1f \xe5\x85\x85/");
+    json_kv_int(w, "min", INT32_MIN);
+    json_kv_int(w, "neg", -7);
+    json_kv_uint(w, "max", UINT32_MAX);
+    json_kv_bool(w, "t", true);
+    json_kv_bool(w, "f", false);
+    json_key(w, "n");
+    json_null(w);
+    json_key(w, "nested");
+    json_array_begin(w);
+    json_array_begin(w);
+    json_array_end(w);
+    json_object_begin(w);
+    json_object_end(w);
+    json_uint(w, 0);
+    json_string(w, NULL);
+    json_float(w, NAN, 1);
+    json_float(w, INFINITY, 1);
+    json_array_end(w);
+    json_kv_string(w, "", "");
+    json_object_end(w);
+}
+
+/**
+  * @brief  正确性检查
+  * @param  无
+  * @retval 无
+  */
+static void test_format(void)
+{
+    static const char *expect_mixed =
+        "{\"s\":\"a\\\"b\\\\c\\n\\r\\t\\u0001\\u001f \xe5\x85\x85/\",\"min\":-2147483648,\"neg\":-7,"
+        "\"max\":4294967295,\"t\":true,\"f\":false,\"n\":null,\"nested\":[[],{},0,null,null,null],\"\":\"\"}";
+    static const char *expect_status =
+        "{\"charge_status\":2,\"power\":7040.0,\"voltage\":230.5,\"current\":30.61,\"net_status\":1}";
+    test_out_t *out = malloc(sizeof(*out));
+    test_out_t *ref = malloc(sizeof(*ref));
+    char num[JSON_NUM_BUF_LEN + 1];
+    json_writer_t w;
+    char small[8];
+
+    TEST_CHECK(out != NULL && ref != NULL);
+    TEST_CHECK(test_write(TEST_OUT_LEN, test_build_mixed, out));
+    TEST_CHECK(strcmp(out->buf, expect_mixed) == 0);
+    TEST_CHECK(test_write(TEST_OUT_LEN, test_build_status, out));
+    TEST_CHECK(strcmp(out->buf, expect_status) == 0);
+
+    /* 任意大小的缓冲区分块输出，拼起来与一次输出相同 */
+    TEST_CHECK(test_write(TEST_OUT_LEN, test_build_cards, ref));
+    TEST_CHECK(ref->chunks == 1);
+    for (size_t size = 1; size <= 64; size++)
+    {
+        TEST_CHECK(test_write(size, test_build_cards, out));
+        TEST_CHECK(out->len == ref->len && strcmp(out->buf, ref->buf) == 0);
+        TEST_CHECK(test_write(size, test_build_mixed, out));
+        TEST_CHECK(strcmp(out->buf, expect_mixed) == 0);
+    }
+
+    /* 浮点数的舍入 */
+    num[json_format_float(num, 0.96f, 1)] = '\0';
+    TEST_CHECK(strcmp(num, "1.0") == 0);
+    num[json_format_float(num, -0.04f, 1)] = '\0';
+    TEST_CHECK(strcmp(num, "0.0") == 0);
+    num[json_format_float(num, -2.5f, 0)] = '\0';
+    TEST_CHECK(strcmp(num, "-3") == 0);
+    num[json_format_float(num, 1.5f, 9)] = '\0';
+    TEST_CHECK(strcmp(num, "1.500000") == 0);
+    num[json_format_float(num, 1e10f, 1)] = '\0';
+    TEST_CHECK(strcmp(num, "1e+10") == 0);
+    num[json_format_float(num, -3e38f, 2)] = '\0';
+    TEST_CHECK((float)strtod(num, NULL) == -3e38f);
+
+    /* 出错: 没有回调时缓冲区不足、多余的结束、键名后直接结束、嵌套过深 */
+    json_writer_init(&w, small, sizeof(small), NULL, NULL);
+    test_build_status(&w);
+    TEST_CHECK(!json_writer_ok(&w));
+    json_writer_init(&w, small, sizeof(small), NULL, NULL);
+    json_array_end(&w);
+    TEST_CHECK(!json_writer_ok(&w));
+    json_writer_init(&w, small, sizeof(small), NULL, NULL);
+    json_object_begin(&w);
+    json_key(&w, "k");
+    json_object_end(&w);
+    TEST_CHECK(!json_writer_ok(&w));
+    json_writer_init(&w, out->buf, sizeof(out->buf), NULL, NULL);
+    for (int i = 0; i <= JSON_WRITER_MAX_DEPTH; i++)
+    {
+        json_array_begin(&w);
+    }
+    TEST_CHECK(!json_writer_ok(&w));
+    json_writer_init(&w, small, sizeof(small), NULL, NULL);
+    json_object_begin(&w);
+    TEST_CHECK(!json_writer_ok(&w));
+    json_object_end(&w);
+    TEST_CHECK(json_writer_ok(&w));
+
+    free(out);
+    free(ref);
+}
+
+/**
+  * @brief  定点小数与 printf 比较: 只允许在最后一位上因单精度运算差 1
+  * @param  无
+  * @retval 无
+  */
+static void test_float_random(void)
+{
+    char num[JSON_NUM_BUF_LEN + 1];
+    char ref[64];
+    uint32_t seed = 0xF1047u;
+    uint32_t exact = 0;
+    uint32_t total = 0;
+    float value;
+
+    for (uint32_t n = 0; n < 200000; n++)
+    {
+        for (uint8_t prec = 0; prec <= 3; prec++)
+        {
+            value = (float)((int32_t)test_rand(&seed) % 10000000) / 1000.0f;
+            num[json_format_float(num, value, prec)] = '\0';
+            snprintf(ref, sizeof(ref), "%.*f", prec, (double)value);
+            if (strcmp(ref, "-0") == 0 || strncmp(ref, "-0.", 3) == 0)
+            {
+                if (strtod(ref, NULL) == 0.0)
+                {
+                    memmove(ref, ref + 1, strlen(ref));
+                }
+            }
+            total++;
+            if (strcmp(num, ref) == 0)
+            {
+                exact++;
+                continue;
+            }
+            TEST_CHECK(fabs(strtod(num, NULL) - strtod(ref, NULL)) <= 1.01 * pow(10.0, -prec));
+        }
+    }
+    printf("json_format_float: %lu of %lu values identical to printf (others differ by one in the last digit)\n",
+           (unsigned long)exact, (unsigned long)total);
+}
+
+/**
+  * @brief  生成一个响应不申请堆内存
+  * @param  无
+  * @retval 无
+  */
+static void test_no_alloc(void)
+{
+    mem_subsys_stats_t before[MEM_SUBSYS_COUNT];
+    mem_subsys_stats_t after[MEM_SUBSYS_COUNT];
+    test_out_t *out = malloc(sizeof(*out));
+    mem_subsys_t prev;
+    void *p;
+
+    TEST_CHECK(out != NULL);
+    prev = mem_stats_scope_enter(MEM_SUBSYS_JSON);
+
+    /* 包装生效: 作用域中的 malloc 记到 JSON */
+    mem_stats_get(before);
+    p = malloc(16);
+    TEST_KEEP(p);
+    free(p);
+    mem_stats_get(after);
+    TEST_CHECK(after[MEM_SUBSYS_JSON].allocs == before[MEM_SUBSYS_JSON].allocs + 1);
+
+    mem_stats_get(before);
+    TEST_CHECK(test_write(TEST_BUF_LEN, test_build_cards, out));
+    TEST_CHECK(test_write(TEST_BUF_LEN, test_build_status, out));
+    TEST_CHECK(test_write(TEST_BUF_LEN, test_build_mixed, out));
+    mem_stats_get(after);
+    mem_stats_scope_exit(prev);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        TEST_CHECK(after[i].allocs == before[i].allocs);
+    }
+    free(out);
+}
+
+/**
+  * @brief  对照: 逐个值 snprintf 到栈上的缓冲区(浮点数与 cJSON 相同用 "%1.15g")
+  * @param  out 输出
+  * @param  cards 是否为卡片列表
+  * @retval 无
+  */
+static void test_snprintf_build(test_out_t *out, bool cards)
+{
+    char buf[TEST_OUT_LEN];
+    size_t len = 0;
+
+    if (cards)
+    {
+        buf[len++] = '[';
+        for (int i = 0; i < TEST_CARDS; i++)
+        {
+            len += (size_t)snprintf(buf + len, sizeof(buf) - len, "%s{\"id\":\"%s\",\"expireDate\":\"%s\"}",
+                                    i ? "," : "", s_card_ids[i], s_card_date);
+        }
+        buf[len++] = ']';
+    }
+    else
+    {
+        len += (size_t)snprintf(buf, sizeof(buf),
+                                "{\"charge_status\":%u,\"power\":%1.15g,\"voltage\":%1.15g,\"current\":%1.15g,"
+                                "\"net_status\":%u}",
+                                2u, (double)7040.0f, (double)230.5f, (double)30.61f, 1u);
+    }
+    out->len = 0;
+    test_flush(out, buf, len);
+}
+
+#ifdef TEST_HAVE_CJSON
+/**
+  * @brief  对照: 旧固件的 cJSON 写法
+  * @param  out 输出
+  * @param  cards 是否为卡片列表
+  * @retval 无
+  */
+static void test_cjson_build(test_out_t *out, bool cards)
+{
+    cJSON *root;
+    cJSON *item;
+    char *text;
+
+    if (cards)
+    {
+        root = cJSON_CreateArray();
+        for (int i = 0; i < TEST_CARDS; i++)
+        {
+            item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "id", s_card_ids[i]);
+            cJSON_AddStringToObject(item, "expireDate", s_card_date);
+            cJSON_AddItemToArray(root, item);
+        }
+    }
+    else
+    {
+        root = cJSON_CreateObject();
+        cJSON_AddNumberToObject(root, "charge_status", 2);
+        cJSON_AddNumberToObject(root, "power", 7040.0f);
+        cJSON_AddNumberToObject(root, "voltage", 230.5f);
+        cJSON_AddNumberToObject(root, "current", 30.61f);
+        cJSON_AddNumberToObject(root, "net_status", 1);
+    }
+    text = cJSON_PrintUnformatted(root);
+    out->len = 0;
+    test_flush(out, text, strlen(text));
+    free(text);
+    cJSON_Delete(root);
+}
+#endif
+
+/**
+  * @brief  json_writer 的写法(512 字节缓冲区分块输出)
+  * @param  out 输出
+  * @param  cards 是否为卡片列表
+  * @retval 无
+  */
+static void test_writer_build(test_out_t *out, bool cards)
+{
+    test_write(TEST_BUF_LEN, cards ? test_build_cards : test_build_status, out);
+}
+
+/**
+  * @brief  基准: 每秒输出的字节数和每个请求的堆分配次数
+  * @param  name 写法
+  * @param  build 生成函数
+  * @retval 无
+  */
+static void test_bench(const char *name, void (*build)(test_out_t *out, bool cards))
+{
+    mem_subsys_stats_t before[MEM_SUBSYS_COUNT];
+    mem_subsys_stats_t after[MEM_SUBSYS_COUNT];
+    test_out_t *out = malloc(sizeof(*out));
+    uint64_t bytes;
+    uint64_t t0;
+    double ns;
+
+    TEST_CHECK(out != NULL);
+    for (int cards = 0; cards <= 1; cards++)
+    {
+        bytes = 0;
+        mem_stats_get(before);
+        t0 = test_now_ns();
+        for (uint32_t n = 0; n < TEST_BENCH_ROUNDS; n++)
+        {
+            build(out, cards);
+            bytes += out->len;
+        }
+        ns = (double)(test_now_ns() - t0);
+        mem_stats_get(after);
+        printf("%-9s %-12s %5lu bytes %8.1f MB/s %8.2f us/request %7.1f allocs/request\n", name,
+               cards ? "/api/cards" : "/api/status", (unsigned long)out->len, (double)bytes / (ns / 1e3),
+               ns / 1e3 / TEST_BENCH_ROUNDS,
+               (double)(after[MEM_SUBSYS_OTHER].allocs - before[MEM_SUBSYS_OTHER].allocs) / TEST_BENCH_ROUNDS);
+    }
+    free(out);
+}
+
+int main(void)
+{
+    for (int i = 0; i < TEST_CARDS; i++)
+    {
+        snprintf(s_card_ids[i], sizeof(s_card_ids[i]), "%08d", 10000000 + i * 7919);
+    }
+    test_format();
+    test_float_random();
+    test_no_alloc();
+
+    test_bench("writer", test_writer_build);
+    test_bench("snprintf", test_snprintf_build);
+#ifdef TEST_HAVE_CJSON
+    test_bench("cjson", test_cjson_build);
+#else
+    printf("cjson     not found, skipped (cJSON.h / libcjson)\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/uart/link(v2 链路)的主机测试:
+ *
+ *   接收  提前到达的帧暂存，缺失的帧到达后按序号交付；重复的帧丢弃；对端用 SYN 放弃缺失的帧时
+ *         暂存的帧按序号交付；对端重新握手时丢弃暂存的帧
+ *   整体  运行参数全量帧乱序到达(重发的旧帧晚于新帧)时，运行参数通知仍按序号先后收到，
+ *         最后的工作副本是最新的一帧；开启 v2 而主控板不回复握手时，数据帧不等握手直接用 v1 帧发出
+ *
+ *   ./test_link
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "panel_uart_api.h"
+#include "wire_codec.h"
+#include "test_common.h"
+
+#define TEST_MAX_FRAMES             16              // 记录的收发帧数
+
+static uint8_t s_data[TEST_MAX_FRAMES];             // link_receive 测试: 按交付顺序记录数据内容的第一个字节
+static uint32_t s_data_count;
+
+static int32_t s_powers[TEST_MAX_FRAMES];           // 运行参数通知中的功率(按收到的顺序)
+static uint32_t s_power_count;
+
+static uint8_t s_tx_second[TEST_MAX_FRAMES];        // 面板发出的各帧的帧头第二字节
+static uint8_t s_tx_fn[TEST_MAX_FRAMES];            // 面板发出的 v1 帧的功能码
+static uint32_t s_tx_count;
+static uint32_t s_now_ms;
+
+/**
+  * @brief  收到一帧 v2 数据帧，依次交付本帧和随之可以交付的暂存帧
+  * @param  link 链路
+  * @param  ctrl 控制字节中的标志(LINK_CTRL_xxx)
+  * @param  seq 序号
+  * @param  tag 数据内容(一个字节，用于检查交付顺序)
+  * @retval 本帧是否立即交付
+  */
+static bool test_receive(uart_link_t *link, uint8_t ctrl, uint8_t seq, uint8_t tag)
+{
+    const link_rx_slot_t *held;
+    link_header_t hdr;
+    bool deliver;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.ctrl = (uint8_t)((LINK_VERSION_V2 << 4) | LINK_CTRL_DATA | ctrl);
+    hdr.seq = seq;
+    hdr.fn = 0x20;
+    hdr.len = 1;
+    deliver = link_receive(link, &hdr, &tag, s_now_ms);
+    if (deliver)
+    {
+        s_data[s_data_count++] = tag;
+    }
+    while ((held = link_rx_next(link)) != NULL)
+    {
+        TEST_CHECK(held->fn == 0x20 && held->len == 1);
+        s_data[s_data_count++] = held->data[0];
+    }
+    TEST_CHECK(s_data_count <= TEST_MAX_FRAMES);
+    return deliver;
+}
+
+/**
+  * @brief  检查交付顺序
+  * @param  expect 期望的数据内容序列
+  * @param  n 个数
+  * @retval 无
+  */
+static void test_expect(const uint8_t *expect, uint32_t n)
+{
+    TEST_CHECK(s_data_count == n);
+    TEST_CHECK(memcmp(s_data, expect, n) == 0);
+    s_data_count = 0;
+}
+
+/**
+  * @brief  接收窗口: 暂存、按序号交付、去重、SYN 放弃、重新握手
+  * @param  无
+  * @retval 无
+  */
+static void test_reorder(void)
+{
+    static const uint8_t hello[LINK_HELLO_LEN] = { LINK_VERSION_V2, 0 };
+    uart_link_t link;
+
+    link_init(&link, LINK_VERSION_V2);
+
+    /* 同步后按序到达的帧立即交付 */
+    TEST_CHECK(test_receive(&link, LINK_CTRL_SYN, 10, 10));
+    TEST_CHECK(link.version == LINK_VERSION_V2);
+    test_expect((const uint8_t[]){ 10 }, 1);
+
+    /* 11 丢失，12、13 先到: 暂存，不交付 */
+    TEST_CHECK(!test_receive(&link, 0, 12, 12));
+    TEST_CHECK(!test_receive(&link, 0, 13, 13));
+    test_expect(NULL, 0);
+    TEST_CHECK(link.rx_base == 11 && link.rx_sack == 0x03);
+    TEST_CHECK(link.nak_pending);
+
+    /* 11 重发到达: 11、12、13 按序交付 */
+    TEST_CHECK(test_receive(&link, LINK_CTRL_SYN, 11, 11));
+    test_expect((const uint8_t[]){ 11, 12, 13 }, 3);
+    TEST_CHECK(link.rx_base == 14 && link.rx_sack == 0);
+    TEST_CHECK(link.stats.rx_reordered == 2);
+
+    /* 重复的帧(已交付的和已暂存的)都不再交付 */
+    TEST_CHECK(!test_receive(&link, 0, 12, 12));
+    TEST_CHECK(!test_receive(&link, 0, 16, 16));
+    TEST_CHECK(!test_receive(&link, 0, 16, 16));
+    test_expect(NULL, 0);
+    TEST_CHECK(link.stats.rx_duplicates == 2);
+
+    /* 对端放弃了 14、15(SYN 序号为 17): 暂存的 16 先交付，再交付 17 和之后暂存的 18 */
+    TEST_CHECK(!test_receive(&link, 0, 18, 18));
+    TEST_CHECK(!test_receive(&link, LINK_CTRL_SYN, 17, 17));
+    test_expect((const uint8_t[]){ 16, 17, 18 }, 3);
+    TEST_CHECK(link.rx_base == 19 && link.rx_sack == 0);
+
+    /* SYN 指向已暂存的帧: 该帧只交付一次 */
+    TEST_CHECK(!test_receive(&link, 0, 21, 21));
+    TEST_CHECK(!test_receive(&link, LINK_CTRL_SYN, 21, 21));
+    test_expect((const uint8_t[]){ 21 }, 1);
+    TEST_CHECK(link.rx_base == 22);
+
+    /* 序号回绕 */
+    link_init(&link, LINK_VERSION_V2);
+    TEST_CHECK(test_receive(&link, LINK_CTRL_SYN, 254, 1));
+    TEST_CHECK(!test_receive(&link, 0, 0, 3));
+    TEST_CHECK(!test_receive(&link, 0, 1, 4));
+    TEST_CHECK(test_receive(&link, 0, 255, 2));
+    test_expect((const uint8_t[]){ 1, 2, 3, 4 }, 4);
+
+    /* 对端重新握手(序号从头开始): 暂存的帧丢弃 */
+    TEST_CHECK(!test_receive(&link, 0, 4, 9));
+    link_on_hello(&link, hello, sizeof(hello));
+    TEST_CHECK(test_receive(&link, LINK_CTRL_SYN, 0, 5));
+    TEST_CHECK(test_receive(&link, 0, 1, 6));
+    TEST_CHECK(!test_receive(&link, 0, 3, 8));
+    TEST_CHECK(test_receive(&link, 0, 2, 7));
+    test_expect((const uint8_t[]){ 5, 6, 7, 8 }, 4);
+}
+
+/**
+  * @brief  串口时钟
+  * @param  无
+  * @retval 模拟时间
+  */
+static uint32_t test_clock(void)
+{
+    return s_now_ms;
+}
+
+/**
+  * @brief  记录面板发出的帧
+  * @param  buf 帧数据
+  * @param  len 帧长度
+  * @retval 无
+  */
+static void test_tx(const uint8_t *buf, uint16_t len)
+{
+    TEST_CHECK(len > LENGTH && s_tx_count < TEST_MAX_FRAMES);
+    s_tx_second[s_tx_count] = buf[HEAD_SECOND];
+    s_tx_fn[s_tx_count] = buf[FUNCTION_NUM];
+    s_tx_count++;
+}
+
+/**
+  * @brief  运行参数通知
+  * @param  info 运行参数
+  * @retval 无
+  */
+static void test_on_running_info(const running_info_t *info)
+{
+    TEST_CHECK(s_power_count < TEST_MAX_FRAMES);
+    s_powers[s_power_count++] = (int32_t)info->power;
+}
+
+/**
+  * @brief  主控板发来一帧 v2 运行参数全量帧
+  * @param  ctrl 控制字节中的标志
+  * @param  seq 序号
+  * @param  power 功率
+  * @retval 无
+  */
+static void test_send_run_info(uint8_t ctrl, uint8_t seq, float power)
+{
+    uint8_t value[UART_MAX_DATA_LEN];
+    uint8_t frame[LINK_FRAME_MAX_LEN];
+    running_info_t info;
+    link_header_t hdr;
+
+    memset(&info, 0, sizeof(info));
+    info.voltage = 230.0f;
+    info.power = power;
+    info.charge_status = EVSE_CHARGING;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.ctrl = (uint8_t)((LINK_VERSION_V2 << 4) | LINK_CTRL_DATA | ctrl);
+    hdr.seq = seq;
+    hdr.fn = FN_UPDT_RUN_INFO_ALL;
+    hdr.len = running_info_encode(&info, value, sizeof(value));
+    uart_receive_buff_input(frame, link_frame_pack(frame, &hdr, value));
+    mcu_uart_service();
+    mcu_uart_tx_service();
+    s_now_ms += 10;
+}
+
+/**
+  * @brief  通过整个接收路径: 重发的旧运行参数帧不会覆盖较新的数据
+  * @param  无
+  * @retval 无
+  */
+static void test_running_info_order(void)
+{
+    mcu_uart_link_max_version_set(LINK_VERSION_V2);
+    mcu_uart_protocol_init();
+    mcu_uart_tx_backend_register(test_tx);
+    mcu_uart_clock_register(test_clock);
+    running_info_listener_register(test_on_running_info);
+    s_power_count = 0;
+
+    test_send_run_info(LINK_CTRL_SYN, 0, 1000.0f);
+    test_send_run_info(0, 2, 3000.0f);
+    test_send_run_info(0, 3, 4000.0f);
+    TEST_CHECK(mcu_uart_link_version() == LINK_VERSION_V2);
+    TEST_CHECK(s_power_count == 1);
+    test_send_run_info(LINK_CTRL_SYN, 1, 2000.0f);
+    test_send_run_info(0, 4, 5000.0f);
+
+    TEST_CHECK(s_power_count == 5);
+    for (uint32_t i = 0; i < s_power_count; i++)
+    {
+        TEST_CHECK(s_powers[i] == (int32_t)(1000 * (i + 1)));
+    }
+}
+
+/**
+  * @brief  开启 v2 而主控板(v1 固件)不回复握手: 数据帧不等握手，直接用 v1 帧发出
+  * @param  无
+  * @retval 无
+  */
+static void test_handshake_no_hold(void)
+{
+    static const uint8_t value[2] = { 0x12, 0x34 };
+    bool hello = false;
+    bool data = false;
+
+    mcu_uart_link_max_version_set(LINK_VERSION_V2);
+    mcu_uart_protocol_init();
+    mcu_uart_tx_backend_register(test_tx);
+    mcu_uart_clock_register(test_clock);
+    s_tx_count = 0;
+    s_now_ms = 1000;
+
+    TEST_CHECK(mcu_fnum_data_update(0x30, value, sizeof(value)));
+    mcu_uart_tx_service();
+    for (uint32_t i = 0; i < s_tx_count; i++)
+    {
+        TEST_CHECK(s_tx_second[i] == FRAME_SECOND);
+        hello |= (s_tx_fn[i] == FN_PROTO_VERSION);
+        data |= (s_tx_fn[i] == 0x30);
+    }
+    TEST_CHECK(hello && data);
+    TEST_CHECK(mcu_uart_link_version() == LINK_VERSION_V1);
+
+    /* 默认只用 v1: 不发握手 */
+    mcu_uart_link_max_version_set(LINK_VERSION_V1);
+    mcu_uart_protocol_init();
+    s_tx_count = 0;
+    TEST_CHECK(mcu_fnum_data_update(0x30, value, sizeof(value)));
+    mcu_uart_tx_service();
+    TEST_CHECK(s_tx_count == 1 && s_tx_fn[0] == 0x30);
+}
+
+int main(void)
+{
+    test_reorder();
+    test_running_info_order();
+    test_handshake_no_hold();
+    printf("link tests passed\n");
+    return 0;
+}
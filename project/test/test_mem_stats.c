@@ -0,0 +1,348 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/diag/mem_stats 的主机测试(链接器 --wrap 包装 malloc/calloc/realloc/free):
+ *
+ *   检查  各分配函数的次数/字节数/失败数，realloc 的各种情况(扩大、NULL、释放为 0)，free(NULL) 不计数；
+ *         作用域的嵌套和恢复、超出范围的子系统记到 other；作用域按线程区分，多个线程同时分配时计数不丢；
+ *         "热路径没有分配" 的断言写法(前后比较 mem_stats_get)确实能发现分配
+ *   基准  包装后与直接调用 __real_malloc/__real_free 的每对分配/释放耗时
+ *
+ *   ./test_mem_stats
+ */
+
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mem_stats.h"
+#include "test_common.h"
+
+#define TEST_THREADS                4               // 并发分配的线程数
+#define TEST_THREAD_ALLOCS          100000          // 每个线程的分配次数
+#define TEST_BENCH_ROUNDS           1000000         // 基准的分配/释放次数
+
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+
+/**
+ * @brief   并发线程的参数
+ */
+typedef struct test_thread{
+    pthread_t tid;
+    mem_subsys_t subsys;            // 线程内的作用域
+    mem_subsys_t seen;              // 线程开始时的作用域(应为 other)
+}test_thread_t;
+
+static mem_subsys_stats_t s_before[MEM_SUBSYS_COUNT];
+static mem_subsys_stats_t s_after[MEM_SUBSYS_COUNT];
+
+/**
+  * @brief  某个子系统在两次 mem_stats_get 之间的变化
+  * @param  subsys 子系统
+  * @param  allocs/frees/bytes/failed 期望的变化量
+  * @retval true - 与期望相同
+  */
+static bool test_delta(mem_subsys_t subsys, uint32_t allocs, uint32_t frees, uint32_t bytes, uint32_t failed)
+{
+    const mem_subsys_stats_t *b = &s_before[subsys];
+    const mem_subsys_stats_t *a = &s_after[subsys];
+
+    return a->allocs - b->allocs == allocs && a->frees - b->frees == frees && a->bytes - b->bytes == bytes &&
+           a->failed - b->failed == failed;
+}
+
+/**
+  * @brief  其他子系统没有变化
+  * @param  subsys 被测的子系统
+  * @retval true - 没有变化
+  */
+static bool test_others_unchanged(mem_subsys_t subsys)
+{
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        if (i != (int)subsys && !test_delta((mem_subsys_t)i, 0, 0, 0, 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+  * @brief  malloc/calloc/realloc/free 的计数
+  * @param  无
+  * @retval 无
+  */
+static void test_counting(void)
+{
+    volatile size_t huge = (size_t)-1 / 2;
+    void *p;
+    void *q;
+
+    /* malloc/free，free(NULL) 不计数 */
+    mem_stats_get(s_before);
+    p = malloc(100);
+    TEST_KEEP(p);
+    free(p);
+    free(NULL);
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 1, 1, 100, 0));
+    TEST_CHECK(test_others_unchanged(MEM_SUBSYS_OTHER));
+
+    /* calloc 按 n * size 计字节 */
+    mem_stats_get(s_before);
+    p = calloc(10, 24);
+    TEST_CHECK(p != NULL && ((uint8_t *)p)[239] == 0);
+    free(p);
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 1, 1, 240, 0));
+
+    /* realloc(NULL) 相当于 malloc；扩大记一次分配和一次释放；realloc(p, 0) 释放 */
+    mem_stats_get(s_before);
+    p = realloc(NULL, 16);
+    TEST_CHECK(p != NULL);
+    memset(p, 0x5A, 16);
+    q = realloc(p, 4096);
+    TEST_CHECK(q != NULL && ((uint8_t *)q)[15] == 0x5A);
+    p = realloc(q, 0);
+    free(p);
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 2, 2, 16 + 4096, 0));
+
+    /* 分配失败: 计失败数，不计分配；realloc 失败时原内存仍有效，不计释放 */
+    mem_stats_get(s_before);
+    TEST_CHECK(malloc(huge) == NULL);
+    TEST_CHECK(calloc(huge, 4) == NULL);
+    p = malloc(8);
+    TEST_KEEP(p);
+    TEST_CHECK(realloc(p, huge) == NULL);
+    free(p);
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 1, 1, 8, 3));
+
+    /* 清零 */
+    mem_stats_reset();
+    mem_stats_get(s_after);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        TEST_CHECK(s_after[i].allocs == 0 && s_after[i].frees == 0 && s_after[i].bytes == 0 && s_after[i].failed == 0);
+    }
+}
+
+/**
+  * @brief  作用域的嵌套和恢复，超出范围的子系统，名称
+  * @param  无
+  * @retval 无
+  */
+static void test_scope(void)
+{
+    mem_subsys_t outer;
+    mem_subsys_t inner;
+    void *p;
+    void *q;
+
+    mem_stats_get(s_before);
+    outer = mem_stats_scope_enter(MEM_SUBSYS_HTTP);
+    TEST_CHECK(outer == MEM_SUBSYS_OTHER);
+    p = malloc(32);
+    TEST_KEEP(p);
+    inner = mem_stats_scope_enter(MEM_SUBSYS_JSON);
+    TEST_CHECK(inner == MEM_SUBSYS_HTTP);
+    q = malloc(64);
+    TEST_KEEP(q);
+    /* 释放按释放时的作用域统计 */
+    free(p);
+    mem_stats_scope_exit(inner);
+    free(q);
+    mem_stats_scope_exit(outer);
+    p = malloc(1);
+    TEST_KEEP(p);
+    free(p);
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_HTTP, 1, 1, 32, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_JSON, 1, 1, 64, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 1, 1, 1, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_UART, 0, 0, 0, 0) && test_delta(MEM_SUBSYS_STORAGE, 0, 0, 0, 0));
+
+    /* 超出范围的子系统记到 other */
+    mem_stats_get(s_before);
+    mem_stats_alloc(MEM_SUBSYS_COUNT, 5);
+    mem_stats_free((mem_subsys_t)200);
+    mem_stats_alloc_failed(MEM_SUBSYS_COUNT);
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 1, 1, 5, 1));
+    TEST_CHECK(test_others_unchanged(MEM_SUBSYS_OTHER));
+
+    TEST_CHECK(strcmp(mem_subsys_name(MEM_SUBSYS_OTHER), "other") == 0);
+    TEST_CHECK(strcmp(mem_subsys_name(MEM_SUBSYS_HTTP), "http") == 0);
+    TEST_CHECK(strcmp(mem_subsys_name(MEM_SUBSYS_JSON), "json") == 0);
+    TEST_CHECK(strcmp(mem_subsys_name(MEM_SUBSYS_UART), "uart") == 0);
+    TEST_CHECK(strcmp(mem_subsys_name(MEM_SUBSYS_STORAGE), "storage") == 0);
+    TEST_CHECK(strcmp(mem_subsys_name(MEM_SUBSYS_COUNT), "?") == 0);
+}
+
+/**
+  * @brief  并发线程: 在自己的作用域内反复分配/释放
+  * @param  arg test_thread_t
+  * @retval NULL
+  */
+static void *test_thread_main(void *arg)
+{
+    test_thread_t *t = arg;
+    mem_subsys_t prev;
+    void *p;
+
+    prev = mem_stats_scope_enter(t->subsys);
+    t->seen = prev;
+    for (uint32_t i = 0; i < TEST_THREAD_ALLOCS; i++)
+    {
+        p = malloc(1 + (i & 63));
+        TEST_KEEP(p);
+        free(p);
+    }
+    mem_stats_scope_exit(prev);
+    return NULL;
+}
+
+/**
+  * @brief  多个线程同时分配: 作用域互不影响，计数不丢
+  * @param  无
+  * @retval 无
+  */
+static void test_threads(void)
+{
+    static const mem_subsys_t subsys[TEST_THREADS] = {
+        MEM_SUBSYS_HTTP, MEM_SUBSYS_UART, MEM_SUBSYS_STORAGE, MEM_SUBSYS_UART,
+    };
+    test_thread_t threads[TEST_THREADS];
+    uint32_t bytes = 0;
+    mem_subsys_t prev;
+
+    for (uint32_t i = 0; i < TEST_THREAD_ALLOCS; i++)
+    {
+        bytes += 1 + (i & 63);
+    }
+
+    /* 主线程处在 JSON 作用域，新线程不继承 */
+    prev = mem_stats_scope_enter(MEM_SUBSYS_JSON);
+    mem_stats_get(s_before);
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        threads[i].subsys = subsys[i];
+        TEST_CHECK(pthread_create(&threads[i].tid, NULL, test_thread_main, &threads[i]) == 0);
+    }
+    for (int i = 0; i < TEST_THREADS; i++)
+    {
+        TEST_CHECK(pthread_join(threads[i].tid, NULL) == 0);
+        TEST_CHECK(threads[i].seen == MEM_SUBSYS_OTHER);
+    }
+    mem_stats_get(s_after);
+    mem_stats_scope_exit(prev);
+
+    TEST_CHECK(test_delta(MEM_SUBSYS_HTTP, TEST_THREAD_ALLOCS, TEST_THREAD_ALLOCS, bytes, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_UART, 2 * TEST_THREAD_ALLOCS, 2 * TEST_THREAD_ALLOCS, 2 * bytes, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_STORAGE, TEST_THREAD_ALLOCS, TEST_THREAD_ALLOCS, bytes, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_JSON, 0, 0, 0, 0));
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 0, 0, 0, 0));
+}
+
+/**
+  * @brief  被断言的函数: 只有第 777 次调用申请一块临时内存
+  * @param  n 调用序号
+  * @param  out 输出
+  * @retval 无
+  */
+static void test_hot_path(uint32_t n, char *out)
+{
+    char *tmp;
+
+    if (n == 777)
+    {
+        tmp = malloc(2);
+        TEST_CHECK(tmp != NULL);
+        tmp[0] = 'x';
+        out[0] = tmp[0];
+        free(tmp);
+        return;
+    }
+    out[0] = (char)('a' + n % 26);
+}
+
+/**
+  * @brief  "热路径没有分配" 的断言写法(前后比较所有子系统的分配次数)能发现偶发的分配
+  * @note   --wrap 只替换本程序中的调用，libc 内部的分配(strdup、stdio 的缓冲区等)不计数
+  * @param  无
+  * @retval 无
+  */
+static void test_zero_alloc(void)
+{
+    char out[1];
+
+    mem_stats_get(s_before);
+    for (uint32_t n = 0; n < 1000; n++)
+    {
+        test_hot_path(n, out);
+        TEST_KEEP(out[0]);
+    }
+    mem_stats_get(s_after);
+    TEST_CHECK(test_delta(MEM_SUBSYS_OTHER, 1, 1, 2, 0));
+
+    mem_stats_get(s_before);
+    for (uint32_t n = 0; n < 777; n++)
+    {
+        test_hot_path(n, out);
+        TEST_KEEP(out[0]);
+    }
+    mem_stats_get(s_after);
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        TEST_CHECK(s_after[i].allocs == s_before[i].allocs);
+    }
+}
+
+/**
+  * @brief  包装的开销
+  * @param  无
+  * @retval 无
+  */
+static void test_bench(void)
+{
+    uint64_t t0;
+    uint64_t wrapped;
+    uint64_t real;
+    void *p;
+
+    t0 = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_ROUNDS; i++)
+    {
+        p = malloc(1 + (i & 127));
+        TEST_KEEP(p);
+        free(p);
+    }
+    wrapped = test_now_ns() - t0;
+
+    t0 = test_now_ns();
+    for (uint32_t i = 0; i < TEST_BENCH_ROUNDS; i++)
+    {
+        p = __real_malloc(1 + (i & 127));
+        TEST_KEEP(p);
+        __real_free(p);
+    }
+    real = test_now_ns() - t0;
+
+    printf("malloc+free: %.1f ns wrapped, %.1f ns direct (%u pairs)\n", (double)wrapped / TEST_BENCH_ROUNDS,
+           (double)real / TEST_BENCH_ROUNDS, TEST_BENCH_ROUNDS);
+}
+
+int main(void)
+{
+    test_counting();
+    test_scope();
+    test_threads();
+    test_zero_alloc();
+    test_bench();
+    return 0;
+}
@@ -0,0 +1,487 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/storage/persist 的主机测试，存储后端为内存中的 NVS 仿真(nvs_emu.c，分区大小与 partitions.csv 相同):
+ *
+ *   检查  CRC-32、blob 的读写和各种损坏(逐字节翻转、截断、版本不符、缓冲区不够、后端失败)；
+ *         卡片表同步后重新载入内容相同，增删改一张卡只写一页，表没有变化时不写
+ *   损坏  破坏或删除一页: 载入时只丢弃这一页上的卡，其他页不受影响，下次同步重写该页
+ *   故障  同步中途写入失败: 未写入的页保持待写入，下次同步补写；
+ *         同步中途掉电: 重新载入的每张卡都是掉电前或同步目标中的内容，之后同步再载入结果不变
+ *   磨损  1000 次单卡修改，每次都提交与每 10 次合并提交，比较写入的条目、擦除次数和估算的提交耗时；
+ *         同时给出每次重写整张表(所有页)作为对照
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "nvs_emu.h"
+#include "persist.h"
+#include "test_common.h"
+
+#define TEST_NVS_SIZE               0x6000          // partitions.csv 中 nvs 分区的大小
+#define TEST_CARDS                  1000            // 卡片表的卡片数
+#define TEST_EDITS                  1000            // 磨损测试的修改次数
+#define TEST_COALESCE               10              // 合并提交时每次提交的修改数
+#define TEST_FLASH_CYCLES           100000          // NOR 闪存扇区的擦写寿命
+
+static nvs_emu_t s_nvs;
+static persist_backend_t s_be;
+static persist_cards_t s_image;
+static persist_cards_t s_image2;
+static card_store_t s_store;
+static card_store_t s_store2;
+static card_store_t s_expect;
+
+/**
+  * @brief  两张表内容相同
+  * @param  a 表
+  * @param  b 表
+  * @retval 是否相同
+  */
+static bool test_store_equal(const card_store_t *a, const card_store_t *b)
+{
+    return a->count == b->count && memcmp(a->cards, b->cards, a->count * sizeof(card_entry_t)) == 0;
+}
+
+/**
+  * @brief  随机卡片(8 位卡号)
+  * @param  seed 随机数状态
+  * @retval 卡片
+  */
+static card_entry_t test_random_card(uint32_t *seed)
+{
+    card_entry_t card;
+
+    card.id = test_rand(seed) % 100000000u;
+    card.expire_day = (uint16_t)test_rand(seed);
+    card.flags = (test_rand(seed) % 8 == 0) ? CARD_FLAG_DISABLED : 0;
+    return card;
+}
+
+/**
+  * @brief  随机填充 n 张卡
+  * @param  store 授权卡表
+  * @param  n 卡片数
+  * @param  seed 随机数状态
+  * @retval 无
+  */
+static void test_fill(card_store_t *store, uint32_t n, uint32_t *seed)
+{
+    card_entry_t card;
+
+    card_store_init(store);
+    while (store->count < n)
+    {
+        card = test_random_card(seed);
+        card_store_add(store, &card);
+    }
+}
+
+/**
+  * @brief  重新启动: 清空仿真分区以外的状态，从分区载入
+  * @param  image 持久化镜像
+  * @param  store 授权卡表
+  * @retval 载入的卡片数
+  */
+static uint32_t test_reboot(persist_cards_t *image, card_store_t *store)
+{
+    card_store_init(store);
+    return persist_cards_load(image, &s_be, store);
+}
+
+/**
+  * @brief  CRC-32 的标准测试向量，分段计算结果相同
+  * @param  无
+  * @retval 无
+  */
+static void test_crc(void)
+{
+    const char *text = "123456789";
+
+    TEST_CHECK(persist_crc32(0, text, 9) == 0xCBF43926u);
+    TEST_CHECK(persist_crc32(persist_crc32(0, text, 4), text + 4, 5) == 0xCBF43926u);
+    TEST_CHECK(persist_crc32(0, text, 0) == 0);
+}
+
+/**
+  * @brief  blob 的读写和损坏检测
+  * @param  无
+  * @retval 无
+  */
+static void test_blob(void)
+{
+    uint8_t data[100];
+    uint8_t out[100];
+    static uint8_t big[PERSIST_BLOB_MAX_LEN + 1];
+    uint8_t saved[NVS_EMU_MAX_BLOB];
+    persist_stats_t before;
+    persist_stats_t after;
+    persist_status_t ret;
+    nvs_emu_key_t *k;
+    uint16_t saved_len;
+    size_t len;
+
+    nvs_emu_init(&s_nvs, TEST_NVS_SIZE);
+    nvs_emu_backend(&s_nvs, &s_be);
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 37);
+    }
+
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len) == PERSIST_ERR_NOT_FOUND);
+    TEST_CHECK(persist_blob_write(&s_be, "blob", 3, data, sizeof(data)) == PERSIST_OK);
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len) == PERSIST_OK);
+    TEST_CHECK(len == sizeof(data) && memcmp(out, data, len) == 0);
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 4, out, sizeof(out), &len) == PERSIST_ERR_VERSION);
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out) - 1, &len) == PERSIST_ERR_VERSION);
+    TEST_CHECK(persist_blob_write(&s_be, "big", 1, big, sizeof(big)) == PERSIST_ERR_IO);
+    TEST_CHECK(persist_blob_write(&s_be, "empty", 1, data, 0) == PERSIST_OK);
+    TEST_CHECK(persist_blob_read(&s_be, "empty", 1, out, sizeof(out), &len) == PERSIST_OK && len == 0);
+
+    /* 逐字节翻转每一位: 版本字节被改时报版本不符，保留字节不参与校验，其余都必须报损坏 */
+    k = nvs_emu_find(&s_nvs, "blob");
+    TEST_CHECK(k != NULL);
+    memcpy(saved, k->data, k->len);
+    saved_len = k->len;
+    for (uint32_t i = 0; i < saved_len; i++)
+    {
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            k->data[i] ^= (uint8_t)(1u << bit);
+            persist_stats_get(&before);
+            ret = persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len);
+            persist_stats_get(&after);
+            if (i == 3)
+            {
+                TEST_CHECK(ret == PERSIST_OK);
+            }
+            else if (i == 2)
+            {
+                TEST_CHECK(ret == PERSIST_ERR_VERSION);
+            }
+            else
+            {
+                TEST_CHECK(ret == PERSIST_ERR_CORRUPT);
+                TEST_CHECK(after.corrupt == before.corrupt + 1);
+            }
+            memcpy(k->data, saved, saved_len);
+        }
+    }
+
+    /* 截断和多出的字节 */
+    for (uint16_t n = 0; n < saved_len; n++)
+    {
+        k->len = n;
+        TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len) == PERSIST_ERR_CORRUPT);
+    }
+    k->len = saved_len + 1;
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len) == PERSIST_ERR_CORRUPT);
+    k->len = saved_len;
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len) == PERSIST_OK);
+
+    /* 后端失败 */
+    s_nvs.fail_after = 0;
+    TEST_CHECK(persist_blob_write(&s_be, "blob", 3, data, 10) == PERSIST_ERR_IO);
+    s_nvs.fail_after = -1;
+    TEST_CHECK(persist_blob_read(&s_be, "blob", 3, out, sizeof(out), &len) == PERSIST_OK && len == sizeof(data));
+}
+
+/**
+  * @brief  卡片表的同步和载入，只写有变化的页
+  * @param  无
+  * @retval 无
+  */
+static void test_cards(void)
+{
+    uint32_t seed = 0x1234u;
+    card_entry_t card;
+    uint32_t pages;
+
+    nvs_emu_init(&s_nvs, TEST_NVS_SIZE);
+    nvs_emu_backend(&s_nvs, &s_be);
+
+    /* 首次启动: 没有任何数据 */
+    TEST_CHECK(test_reboot(&s_image, &s_store) == 0);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 0);
+
+    test_fill(&s_store, TEST_CARDS, &seed);
+    pages = persist_cards_sync(&s_image, &s_be, &s_store);
+    TEST_CHECK(pages == (TEST_CARDS + PERSIST_CARDS_PER_PAGE - 1) / PERSIST_CARDS_PER_PAGE);
+    TEST_CHECK(persist_commit(&s_be));
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 0);
+
+    TEST_CHECK(test_reboot(&s_image2, &s_store2) == TEST_CARDS);
+    TEST_CHECK(test_store_equal(&s_store, &s_store2));
+    TEST_CHECK(s_image2.dirty == 0);
+    TEST_CHECK(persist_cards_sync(&s_image2, &s_be, &s_store2) == 0);
+
+    /* 增、删、改各写一页 */
+    do
+    {
+        card = test_random_card(&seed);
+    } while (card_store_add(&s_store, &card) != CARD_STORE_OK);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 1);
+    TEST_CHECK(card_store_remove(&s_store, s_store.cards[500].id) == CARD_STORE_OK);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 1);
+    s_store.cards[10].expire_day++;
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 1);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 0);
+
+    /* 删除一张卡再添加另一张: 新卡复用空出来的槽位，仍只写一页 */
+    TEST_CHECK(card_store_remove(&s_store, s_store.cards[200].id) == CARD_STORE_OK);
+    do
+    {
+        card = test_random_card(&seed);
+    } while (card_store_add(&s_store, &card) != CARD_STORE_OK);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 1);
+
+    TEST_CHECK(test_reboot(&s_image2, &s_store2) == s_store.count);
+    TEST_CHECK(test_store_equal(&s_store, &s_store2));
+
+    /* 清空 */
+    card_store_init(&s_store);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) > 0);
+    TEST_CHECK(test_reboot(&s_image2, &s_store2) == 0);
+}
+
+/**
+  * @brief  破坏或删除一页: 只丢弃这一页上的卡
+  * @param  无
+  * @retval 无
+  */
+static void test_cards_corrupt(void)
+{
+    uint32_t pages = (TEST_CARDS + PERSIST_CARDS_PER_PAGE - 1) / PERSIST_CARDS_PER_PAGE;
+    uint32_t seed = 0x5678u;
+    nvs_emu_key_t *k;
+    char key[PERSIST_KEY_LEN + 1];
+    uint32_t lost;
+
+    nvs_emu_init(&s_nvs, TEST_NVS_SIZE);
+    nvs_emu_backend(&s_nvs, &s_be);
+    test_fill(&s_store, TEST_CARDS, &seed);
+    card_store_init(&s_store2);
+    TEST_CHECK(test_reboot(&s_image, &s_store2) == 0);
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == pages);
+
+    for (uint32_t page = 0; page < pages; page++)
+    {
+        /* 这一页上的卡 */
+        card_store_copy(&s_expect, &s_store);
+        lost = 0;
+        for (uint32_t i = 0; i < PERSIST_CARDS_PER_PAGE; i++)
+        {
+            if (s_image.used[page] & (1ull << i))
+            {
+                card_store_remove(&s_expect, s_image.slots[page * PERSIST_CARDS_PER_PAGE + i].id);
+                lost++;
+            }
+        }
+        TEST_CHECK(lost > 0);
+
+        snprintf(key, sizeof(key), "cards%02u", (unsigned)page);
+        k = nvs_emu_find(&s_nvs, key);
+        TEST_CHECK(k != NULL);
+        switch (page % 3)
+        {
+            case 0:
+            k->data[PERSIST_BLOB_HEAD_LEN + test_rand(&seed) % (k->len - PERSIST_BLOB_HEAD_LEN)] ^= 0x10;
+            break;
+
+            case 1:
+            k->len -= 8;
+            break;
+
+            default:
+            nvs_emu_remove(&s_nvs, key);
+            break;
+        }
+
+        TEST_CHECK(test_reboot(&s_image2, &s_store2) == TEST_CARDS - lost);
+        TEST_CHECK(test_store_equal(&s_expect, &s_store2));
+        TEST_CHECK(s_image2.dirty == ((page % 3 == 2) ? 0 : 1u << page));
+
+        /* 写回完整的表(如重新导入)，只重写损坏的页 */
+        TEST_CHECK(persist_cards_sync(&s_image2, &s_be, &s_store) == 1);
+        TEST_CHECK(test_reboot(&s_image2, &s_store2) == TEST_CARDS);
+        TEST_CHECK(test_store_equal(&s_store, &s_store2));
+        memcpy(&s_image, &s_image2, sizeof(s_image));
+    }
+}
+
+/**
+  * @brief  同步中途写入失败和掉电
+  * @param  无
+  * @retval 无
+  */
+static void test_cards_faults(void)
+{
+    uint32_t seed = 0x9ABCu;
+    card_entry_t card;
+    uint32_t pages;
+    uint32_t written;
+    int32_t pos;
+
+    nvs_emu_init(&s_nvs, TEST_NVS_SIZE);
+    nvs_emu_backend(&s_nvs, &s_be);
+    test_fill(&s_store, TEST_CARDS, &seed);
+    TEST_CHECK(test_reboot(&s_image, &s_store2) == 0);
+
+    /* 写入失败: 写了 3 页后失败，下次同步补写其余的页 */
+    pages = (TEST_CARDS + PERSIST_CARDS_PER_PAGE - 1) / PERSIST_CARDS_PER_PAGE;
+    s_nvs.fail_after = 3;
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == 3);
+    TEST_CHECK(s_image.dirty != 0);
+    s_nvs.fail_after = -1;
+    TEST_CHECK(persist_cards_sync(&s_image, &s_be, &s_store) == pages - 3);
+    TEST_CHECK(s_image.dirty == 0);
+    TEST_CHECK(test_reboot(&s_image2, &s_store2) == TEST_CARDS);
+    TEST_CHECK(test_store_equal(&s_store, &s_store2));
+
+    /* 掉电: 大量修改后同步，写入 n 页后掉电 */
+    for (uint32_t cut = 0; cut <= pages; cut++)
+    {
+        card_store_copy(&s_expect, &s_store);
+        for (int i = 0; i < 200; i++)
+        {
+            card_store_remove(&s_store, s_store.cards[test_rand(&seed) % s_store.count].id);
+            card = test_random_card(&seed);
+            card_store_add(&s_store, &card);
+            s_store.cards[test_rand(&seed) % s_store.count].expire_day ^= 1;
+        }
+        s_nvs.cut_after = (int32_t)cut;
+        written = persist_cards_sync(&s_image, &s_be, &s_store);
+        TEST_CHECK(written > 0);
+        s_nvs.cut_after = -1;
+
+        /* 每张卡要么是掉电前的内容，要么是同步目标的内容 */
+        test_reboot(&s_image2, &s_store2);
+        for (uint32_t i = 0; i < s_store2.count; i++)
+        {
+            const card_entry_t *c = &s_store2.cards[i];
+            int32_t old_pos = card_store_index(&s_expect, c->id);
+
+            pos = card_store_index(&s_store, c->id);
+            TEST_CHECK((pos >= 0 && memcmp(&s_store.cards[pos], c, sizeof(*c)) == 0) ||
+                       (old_pos >= 0 && memcmp(&s_expect.cards[old_pos], c, sizeof(*c)) == 0));
+        }
+        if (cut >= written)
+        {
+            TEST_CHECK(test_store_equal(&s_store, &s_store2));
+        }
+
+        /* 重新载入的表同步后再载入，结果不变；然后恢复到本轮的目标 */
+        card_store_copy(&s_expect, &s_store2);
+        persist_cards_sync(&s_image2, &s_be, &s_store2);
+        TEST_CHECK(test_reboot(&s_image2, &s_store2) == s_expect.count);
+        TEST_CHECK(test_store_equal(&s_expect, &s_store2));
+        persist_cards_sync(&s_image2, &s_be, &s_store);
+        TEST_CHECK(test_reboot(&s_image, &s_store2) == s_store.count);
+        TEST_CHECK(test_store_equal(&s_store, &s_store2));
+    }
+}
+
+/**
+ * @brief   一种写入策略的磨损统计
+ */
+typedef struct test_wear{
+    uint32_t commits;
+    uint32_t pages;                 // 写入的卡片页数
+    uint64_t cpu_ns;                // 同步的 CPU 耗时(主机)
+    uint64_t max_flash_us;          // 单次提交的最长估算闪存耗时
+}test_wear_t;
+
+/**
+  * @brief  磨损: TEST_EDITS 次单卡修改(添加/删除/改有效期轮流)
+  * @param  name 策略名
+  * @param  coalesce 每次提交包含的修改数
+  * @param  whole 每次提交重写所有页(对照)
+  * @retval 无
+  */
+static void test_wear(const char *name, uint32_t coalesce, bool whole)
+{
+    uint32_t seed = 0xDEF0u;
+    test_wear_t w;
+    card_entry_t card;
+    uint64_t flash_us;
+    uint64_t t0;
+
+    memset(&w, 0, sizeof(w));
+    nvs_emu_init(&s_nvs, TEST_NVS_SIZE);
+    nvs_emu_backend(&s_nvs, &s_be);
+    test_fill(&s_store, TEST_CARDS, &seed);
+    TEST_CHECK(test_reboot(&s_image, &s_store2) == 0);
+    persist_cards_sync(&s_image, &s_be, &s_store);
+    TEST_CHECK(persist_commit(&s_be));
+    s_nvs.writes = 0;
+    s_nvs.entries_written = 0;
+    s_nvs.erases = 0;
+    s_nvs.flash_us = 0;
+    for (uint32_t i = 0; i < s_nvs.page_count; i++)
+    {
+        s_nvs.pages[i].erase_count = 0;
+    }
+
+    for (uint32_t n = 1; n <= TEST_EDITS; n++)
+    {
+        switch (n % 3)
+        {
+            case 0:
+            do
+            {
+                card = test_random_card(&seed);
+            } while (card_store_add(&s_store, &card) != CARD_STORE_OK);
+            break;
+
+            case 1:
+            card_store_remove(&s_store, s_store.cards[test_rand(&seed) % s_store.count].id);
+            break;
+
+            default:
+            s_store.cards[test_rand(&seed) % s_store.count].expire_day++;
+            break;
+        }
+        if (n % coalesce != 0)
+        {
+            continue;
+        }
+
+        flash_us = s_nvs.flash_us;
+        t0 = test_now_ns();
+        if (whole)
+        {
+            s_image.dirty = UINT32_MAX >> (32 - PERSIST_CARD_PAGES);
+        }
+        w.pages += persist_cards_sync(&s_image, &s_be, &s_store);
+        TEST_CHECK(persist_commit(&s_be));
+        w.cpu_ns += test_now_ns() - t0;
+        w.commits++;
+        flash_us = s_nvs.flash_us - flash_us;
+        w.max_flash_us = (flash_us > w.max_flash_us) ? flash_us : w.max_flash_us;
+    }
+    TEST_CHECK(s_image.dirty == 0);
+    TEST_CHECK(test_reboot(&s_image2, &s_store2) == s_store.count);
+    TEST_CHECK(test_store_equal(&s_store, &s_store2));
+
+    printf("%-10s %4lu commits %5lu pages %6lu entries %4lu erases (max %3lu/sector) "
+           "flash %6.1f ms/commit (max %5.1f) cpu %5.1f us/commit, %8.0f edits to wear out\n",
+           name, (unsigned long)w.commits, (unsigned long)w.pages, (unsigned long)s_nvs.entries_written,
+           (unsigned long)s_nvs.erases, (unsigned long)nvs_emu_max_erases(&s_nvs),
+           s_nvs.flash_us / 1e3 / w.commits, w.max_flash_us / 1e3, w.cpu_ns / 1e3 / w.commits,
+           nvs_emu_max_erases(&s_nvs) ? (double)TEST_EDITS * TEST_FLASH_CYCLES / nvs_emu_max_erases(&s_nvs) : 0.0);
+}
+
+int main(void)
+{
+    test_crc();
+    test_blob();
+    test_cards();
+    test_cards_corrupt();
+    test_cards_faults();
+    test_wear("each", 1, false);
+    test_wear("coalesced", TEST_COALESCE, false);
+    test_wear("whole", 1, true);
+    return 0;
+}
@@ -0,0 +1,231 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/uart/ring_buffer 的主机测试: 生产者线程和消费者线程同时读写，
+ * 逐字节核对数据没有丢失、重复或乱序，并检查缓冲区满时的溢出计数。
+ */
+
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "ring_buffer.h"
+#include "test_common.h"
+
+#define TEST_RING_SIZE              1024            // 与 UART_RX_BUFF_LEN 相同
+#define TEST_STREAM_BYTES           (32u << 20)     // 每项压力测试传输的字节数
+#define TEST_MAX_CHUNK              300             // 单次读写的最大字节数(大于一帧)
+
+/**
+ * @brief   一次压力测试的参数和结果
+ */
+typedef struct test_stream{
+    ring_buffer_t rb;
+    uint8_t buf[TEST_RING_SIZE];
+    bool lossy;                     // 生产者不检查剩余空间，满了就丢(溢出计数)
+    uint32_t attempted;             // 生产者: 尝试写入的字节
+    uint32_t accepted;              // 生产者: 实际写入的字节
+    uint32_t received;              // 消费者: 读出的字节
+}test_stream_t;
+
+static atomic_bool s_producer_done;
+
+/**
+  * @brief  数据流中第 i 个字节的值
+  * @param  i 位置
+  * @retval 字节
+  */
+static uint8_t test_stream_byte(uint32_t i)
+{
+    return (uint8_t)((i * 2654435761u) >> 24);
+}
+
+/**
+  * @brief  生产者线程: 以随机长度的数据块写入，写入的字节构成连续的数据流
+  * @param  arg test_stream_t
+  * @retval NULL
+  */
+static void *test_producer(void *arg)
+{
+    test_stream_t *s = arg;
+    uint8_t chunk[TEST_MAX_CHUNK];
+    uint32_t seed = 0x9E3779B9u;
+    uint32_t len;
+    uint32_t room;
+    uint32_t n;
+
+    while (s->accepted < TEST_STREAM_BYTES)
+    {
+        len = 1 + test_rand(&seed) % TEST_MAX_CHUNK;
+        if (len > TEST_STREAM_BYTES - s->accepted)
+        {
+            len = TEST_STREAM_BYTES - s->accepted;
+        }
+        if (!s->lossy)
+        {
+            room = TEST_RING_SIZE - ring_buffer_used(&s->rb);
+            if (room == 0)
+            {
+                sched_yield();
+                continue;
+            }
+            len = (len < room) ? len : room;
+        }
+        for (uint32_t i = 0; i < len; i++)
+        {
+            chunk[i] = test_stream_byte(s->accepted + i);
+        }
+        n = ring_buffer_write(&s->rb, chunk, len);
+        TEST_CHECK(n <= len);
+        TEST_CHECK(s->lossy || n == len);
+        s->attempted += len;
+        s->accepted += n;
+        if (n < len)
+        {
+            /* 缓冲区满(丢弃的字节已计入溢出)，让出 CPU 等消费者 */
+            sched_yield();
+        }
+    }
+    atomic_store(&s_producer_done, true);
+    return NULL;
+}
+
+/**
+  * @brief  消费者线程: 交替用 read 和 span+skip 读出，逐字节核对
+  * @param  arg test_stream_t
+  * @retval NULL
+  */
+static void *test_consumer(void *arg)
+{
+    test_stream_t *s = arg;
+    uint8_t chunk[TEST_MAX_CHUNK];
+    const uint8_t *span;
+    uint32_t seed = 0x12345678u;
+    uint32_t len;
+    uint32_t n;
+
+    while (!atomic_load(&s_producer_done) || ring_buffer_used(&s->rb) > 0)
+    {
+        len = 1 + test_rand(&seed) % TEST_MAX_CHUNK;
+        if (len & 1)
+        {
+            n = ring_buffer_read(&s->rb, chunk, len);
+            for (uint32_t i = 0; i < n; i++)
+            {
+                TEST_CHECK(chunk[i] == test_stream_byte(s->received + i));
+            }
+        }
+        else
+        {
+            n = ring_buffer_span(&s->rb, 0, &span);
+            n = (n < len) ? n : len;
+            for (uint32_t i = 0; i < n; i++)
+            {
+                TEST_CHECK(span[i] == test_stream_byte(s->received + i));
+            }
+            ring_buffer_skip(&s->rb, n);
+        }
+        s->received += n;
+        if (n == 0)
+        {
+            /* 缓冲区空，让出 CPU(单核机器上生产者才能运行) */
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  运行一次生产者/消费者压力测试
+  * @param  lossy 生产者是否不检查剩余空间
+  * @retval 无
+  */
+static void test_stream_run(bool lossy)
+{
+    test_stream_t *s = calloc(1, sizeof(*s));
+    pthread_t producer;
+    pthread_t consumer;
+    uint64_t t0;
+    double ms;
+
+    TEST_CHECK(s != NULL);
+    TEST_CHECK(ring_buffer_init(&s->rb, s->buf, sizeof(s->buf)));
+    s->lossy = lossy;
+    atomic_store(&s_producer_done, false);
+
+    t0 = test_now_ns();
+    pthread_create(&consumer, NULL, test_consumer, s);
+    pthread_create(&producer, NULL, test_producer, s);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    ms = (double)(test_now_ns() - t0) / 1e6;
+
+    TEST_CHECK(s->received == s->accepted);
+    TEST_CHECK(ring_buffer_overflow_count(&s->rb) == s->attempted - s->accepted);
+    if (!lossy)
+    {
+        TEST_CHECK(ring_buffer_overflow_count(&s->rb) == 0);
+    }
+    printf("%-8s %10lu bytes in %7.1f ms (%6.1f MB/s), overflow %lu\n", lossy ? "lossy" : "lossless",
+           (unsigned long)s->received, ms, s->received / ms / 1e3,
+           (unsigned long)ring_buffer_overflow_count(&s->rb));
+    free(s);
+}
+
+/**
+  * @brief  单线程: 初始化参数检查、回绕、peek 偏移和溢出计数
+  * @param  无
+  * @retval 无
+  */
+static void test_basic(void)
+{
+    ring_buffer_t rb;
+    uint8_t buf[16];
+    uint8_t data[32];
+    uint8_t out[32];
+    const uint8_t *span;
+
+    TEST_CHECK(!ring_buffer_init(&rb, buf, 12));
+    TEST_CHECK(!ring_buffer_init(&rb, NULL, 16));
+    TEST_CHECK(ring_buffer_init(&rb, buf, sizeof(buf)));
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)i;
+    }
+
+    /* 写满后多出的字节丢弃并计数 */
+    TEST_CHECK(ring_buffer_write(&rb, data, 20) == 16);
+    TEST_CHECK(ring_buffer_overflow_count(&rb) == 4);
+    TEST_CHECK(ring_buffer_used(&rb) == 16);
+    TEST_CHECK(ring_buffer_write(&rb, data, 1) == 0);
+    TEST_CHECK(ring_buffer_overflow_count(&rb) == 5);
+
+    /* peek 不移动读索引 */
+    TEST_CHECK(ring_buffer_peek(&rb, 10, out, 10) == 6);
+    TEST_CHECK(memcmp(out, data + 10, 6) == 0);
+    TEST_CHECK(ring_buffer_peek(&rb, 16, out, 1) == 0);
+    TEST_CHECK(ring_buffer_read(&rb, out, 12) == 12);
+    TEST_CHECK(memcmp(out, data, 12) == 0);
+
+    /* 回绕: 连续片段在存储区末尾截断，peek 跨过回绕点拼接 */
+    TEST_CHECK(ring_buffer_write(&rb, data + 16, 10) == 10);
+    TEST_CHECK(ring_buffer_span(&rb, 0, &span) == 4);
+    TEST_CHECK(memcmp(span, data + 12, 4) == 0);
+    TEST_CHECK(ring_buffer_span(&rb, 4, &span) == 10);
+    TEST_CHECK(ring_buffer_peek(&rb, 2, out, 8) == 8);
+    TEST_CHECK(memcmp(out, data + 14, 8) == 0);
+    TEST_CHECK(ring_buffer_read(&rb, out, 32) == 14);
+    TEST_CHECK(memcmp(out, data + 12, 14) == 0);
+    TEST_CHECK(ring_buffer_used(&rb) == 0);
+    TEST_CHECK(ring_buffer_overflow_count(&rb) == 5);
+}
+
+int main(void)
+{
+    test_basic();
+    test_stream_run(false);
+    test_stream_run(true);
+    return 0;
+}
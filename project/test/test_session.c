@@ -0,0 +1,533 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/telemetry/session 的主机测试: 按脚本生成一段串口收发记录(与 /api/diag/uart-capture 下载的 pcap
+ * 格式相同，经过 lib/uart 的记录缓冲区)，再按记录的时间戳回放进 lib/uart(接收队列、解析器、功能码表)，
+ * 与 sessions.c 一样在运行参数通知中调用 session_feed、在刷卡处理中调用 session_authorize。
+ *
+ *   检查  每次充电的开始/结束、归属的卡号(充电前刷卡、充电中补刷、拔枪作废)、结束状态、数据中断标志、
+ *         时长和电量(与生成记录时按双精度梯形法计算的结果比较)；毫秒时钟回绕；记录环形覆盖和编解码；
+ *         回放过程不申请堆内存，给出每帧 session_feed 的耗时
+ *
+ *   ./test_session                 运行脚本
+ *   ./test_session trace.pcap      另外回放一份记录(现场下载或 uart_replay -g 生成)，打印得到的充电记录
+ */
+
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <string.h>
+
+#include "panel_uart_api.h"
+#include "wire_codec.h"
+#include "session.h"
+#include "mem_stats.h"
+#include "test_common.h"
+
+#define TEST_CAPTURE_LEN            (4u << 20)      // 记录缓冲区
+#define TEST_INTERVAL_MS            1000            // 运行参数的上报周期
+#define TEST_RFID_SWIPE_LEN         6               // 卡号4 + 当天2(与 main.c 相同)
+#define TEST_DAY                    20100           // 刷卡当天
+#define TEST_MAX_SESSIONS           64              // 脚本中的最大充电次数
+/* 起始时间: 毫秒时钟在第一次充电中途回绕 */
+#define TEST_START_US               ((0x100000000ull - 2000000u) * 1000u)
+
+/**
+ * @brief   脚本的一段: 以固定状态和功率上报 seconds 秒，或者中断 seconds 秒
+ */
+typedef struct test_segment{
+    uint8_t state;                  // evse_state_t
+    uint32_t seconds;               // 时长
+    int32_t power_w;                // 功率(叠加 ±50W 的噪声)
+    uint32_t swipe;                 // 本段开始前刷卡的卡号，0 表示不刷卡
+    bool gap;                       // 本段不发送任何帧(主控板掉线)
+}test_segment_t;
+
+/**
+ * @brief   期望的充电记录
+ */
+typedef struct test_expect{
+    uint32_t card;
+    uint8_t end_state;
+    uint8_t flags;
+    double energy_mj;               // 按双精度梯形法累计
+    uint32_t start_ms;
+    uint32_t last_ms;
+}test_expect_t;
+
+static const test_segment_t s_script[] =
+{
+    /* 1. 充电前刷卡，爬升、恒功率、暂停后继续，充电完成；期间毫秒时钟回绕 */
+    { EVSE_IDLE, 20, 0, 0, false },
+    { EVSE_swipePlugReady, 5, 0, 11111111, false },
+    { EVSE_CHARGING, 10, 2000, 0, false },
+    { EVSE_CHARGING, 3600, 7000, 0, false },
+    { EVSE_CHARGE_PAUSE, 60, 0, 0, false },
+    { EVSE_CHARGING, 1800, 7000, 0, false },
+    { EVSE_CHARGE_DONE, 10, 0, 0, false },
+    /* 2. 没有刷卡就开始充电，充电中补刷，手动停止 */
+    { EVSE_IDLE, 30, 0, 0, false },
+    { EVSE_CHARGING, 300, 3500, 0, false },
+    { EVSE_CHARGING, 300, 3500, 22222222, false },
+    { EVSE_CHARGE_STOP, 5, 0, 0, false },
+    /* 3. 刷卡后拔枪(授权作废)，充电中主控板掉线 30 秒，故障结束 */
+    { EVSE_IDLE, 5, 0, 33333333, false },
+    { EVSE_plugWaitSwipe, 5, 0, 0, false },
+    { EVSE_CHARGING, 600, 11000, 0, false },
+    { EVSE_CHARGING, 30, 11000, 0, true },
+    { EVSE_CHARGING, 600, 11000, 0, false },
+    { EVSE_FAULT, 5, 0, 0, false },
+};
+
+/* 之后再有 TEST_SHORT_SESSIONS 次短充电，使记录环形覆盖 */
+#define TEST_SHORT_SESSIONS         30
+#define TEST_SHORT_CARD             40000000u
+
+static uint8_t s_capture_buf[TEST_CAPTURE_LEN];
+static uint8_t s_file[TEST_CAPTURE_LEN];
+static uint32_t s_file_len;
+static uint64_t s_gen_us;
+static uint64_t s_now_us;
+
+static test_expect_t s_expect[TEST_MAX_SESSIONS];
+static uint32_t s_expect_count;
+static bool s_expect_active;
+static uint32_t s_last_ms;
+static int32_t s_last_power;
+
+static session_engine_t s_engine;
+static session_log_t s_log;
+static uint32_t s_ended;
+static uint32_t s_feeds;
+static uint64_t s_feed_cycles;
+static uint64_t s_feed_max;
+static bool s_check;                            // 回放的是脚本生成的记录，逐条比较
+
+/**
+  * @brief  生成记录的时钟(微秒)
+  * @param  无
+  * @retval 模拟时间
+  */
+static uint64_t test_gen_clock(void)
+{
+    return s_gen_us;
+}
+
+/**
+  * @brief  回放的串口时钟(毫秒)
+  * @param  无
+  * @retval 当前记录的时间
+  */
+static uint32_t test_clock(void)
+{
+    return (uint32_t)(s_now_us / 1000u);
+}
+
+/**
+  * @brief  丢弃面板发出的帧
+  * @param  buf 帧数据
+  * @param  len 帧长度
+  * @retval 无
+  */
+static void test_tx_discard(const uint8_t *buf, uint16_t len)
+{
+    (void)buf;
+    (void)len;
+}
+
+/**
+  * @brief  与期望结果比较
+  * @param  rec 充电记录
+  * @param  index 第几次充电
+  * @retval 无
+  */
+static void test_expect_check(const session_record_t *rec, uint32_t index)
+{
+    const test_expect_t *e = &s_expect[index];
+
+    TEST_CHECK(index < s_expect_count);
+    TEST_CHECK(rec->seq == index);
+    TEST_CHECK(rec->card == e->card);
+    TEST_CHECK(rec->day == (e->card ? TEST_DAY : 0));
+    TEST_CHECK(rec->end_state == e->end_state);
+    TEST_CHECK(rec->flags == e->flags);
+    TEST_CHECK(rec->duration_s == (e->last_ms - e->start_ms) / 1000);
+    TEST_CHECK(fabs((double)rec->energy_wh - e->energy_mj / 3600000.0) <= 0.5 + 1e-6);
+}
+
+/**
+  * @brief  运行参数通知: 与 sessions_on_running_info 相同
+  * @param  info 运行参数
+  * @retval 无
+  */
+static void test_on_running_info(const running_info_t *info)
+{
+    session_record_t done;
+    uint64_t c0 = test_cycles();
+    uint64_t cycles;
+    bool ended;
+
+    ended = session_feed(&s_engine, test_clock(), info->charge_status, (int32_t)lroundf(info->power), &done);
+    cycles = test_cycles() - c0;
+    s_feed_cycles += cycles;
+    s_feed_max = (cycles > s_feed_max) ? cycles : s_feed_max;
+    s_feeds++;
+    if (ended)
+    {
+        if (s_check)
+        {
+            test_expect_check(&done, s_ended);
+        }
+        session_log_push(&s_log, &done);
+        s_ended++;
+    }
+}
+
+/**
+  * @brief  刷卡: 与 rfid_card_swipe 相同(这里每张卡都授权通过)
+  * @param  value 卡号4 + 当天2
+  * @param  len 数据内容长度
+  * @retval 无
+  */
+static void test_on_swipe(const uint8_t *value, uint8_t len)
+{
+    (void)len;
+    session_authorize(&s_engine, wire_get_u32(value), wire_get_u16(value + 4));
+}
+
+/**
+  * @brief  期望结果: 按会话的定义跟踪每一帧，电量按双精度梯形法累计
+  * @param  ms 帧时间
+  * @param  state 状态
+  * @param  power_w 功率
+  * @retval 无
+  */
+static void test_expect_feed(uint32_t ms, uint8_t state, int32_t power_w)
+{
+    bool active = (state == EVSE_CHARGING || state == EVSE_CHARGE_PAUSE);
+    test_expect_t *e = &s_expect[s_expect_count];
+    uint32_t dt = ms - s_last_ms;
+
+    if (s_expect_active)
+    {
+        if (dt > SESSION_MAX_GAP_MS)
+        {
+            e->flags |= SESSION_FLAG_GAP;
+        }
+        else
+        {
+            e->energy_mj += ((double)s_last_power + power_w) / 2.0 * dt;
+        }
+        e->last_ms = ms;
+        if (!active)
+        {
+            e->end_state = state;
+            s_expect_active = false;
+            s_expect_count++;
+            TEST_CHECK(s_expect_count < TEST_MAX_SESSIONS);
+        }
+    }
+    else if (active)
+    {
+        s_expect_active = true;
+        e->start_ms = ms;
+        e->last_ms = ms;
+    }
+    s_last_ms = ms;
+    s_last_power = power_w;
+}
+
+/**
+  * @brief  记录一帧
+  * @param  cap 记录缓冲区
+  * @param  fnum 功能码
+  * @param  value 数据内容
+  * @param  len 数据内容长度
+  * @retval 无
+  */
+static void test_gen_frame(capture_t *cap, uint8_t fnum, const uint8_t *value, uint8_t len)
+{
+    uint8_t frame[PROTOCOL_HEAD + UART_MAX_DATA_LEN + 1];
+    uint16_t frame_len = uart_frame_pack(frame, fnum, value, len);
+
+    capture_record(cap, CAPTURE_DIR_RX, frame, frame_len);
+}
+
+/**
+  * @brief  生成一段
+  * @param  cap 记录缓冲区
+  * @param  seg 脚本段
+  * @param  seed 随机数状态
+  * @retval 无
+  */
+static void test_gen_segment(capture_t *cap, const test_segment_t *seg, uint32_t *seed)
+{
+    uint8_t value[UART_MAX_DATA_LEN];
+    running_info_t info;
+    uint64_t end_us;
+
+    if (seg->swipe != 0)
+    {
+        s_gen_us += 300000;
+        wire_put_u32(value, seg->swipe);
+        wire_put_u16(value + 4, TEST_DAY);
+        test_gen_frame(cap, FN_UPDT_RFID_CARD, value, TEST_RFID_SWIPE_LEN);
+        /* 期望结果: 刷卡在会话中途时归属于当前会话(之前没有卡号) */
+        if (s_expect_active && s_expect[s_expect_count].card == 0)
+        {
+            s_expect[s_expect_count].card = seg->swipe;
+        }
+        else if (!s_expect_active)
+        {
+            s_expect[s_expect_count].card = seg->swipe;
+        }
+    }
+
+    end_us = s_gen_us + (uint64_t)seg->seconds * 1000000u;
+    if (seg->gap)
+    {
+        s_gen_us = end_us;
+        return;
+    }
+    while (s_gen_us < end_us)
+    {
+        /* 上报周期带 0~49 ms 的抖动 */
+        s_gen_us += (TEST_INTERVAL_MS + test_rand(seed) % 50) * 1000u;
+        memset(&info, 0, sizeof(info));
+        info.voltage = 230.0f;
+        info.charge_status = seg->state;
+        info.net_status = NET_STAT_CONNECTED;
+        info.power = 0.0f;
+        if (seg->power_w > 0)
+        {
+            info.power = (float)(seg->power_w + (int32_t)(test_rand(seed) % 101) - 50);
+        }
+        info.current = info.power / info.voltage;
+        test_gen_frame(cap, FN_UPDT_RUN_INFO_ALL, value, running_info_encode(&info, value, sizeof(value)));
+        test_expect_feed((uint32_t)(s_gen_us / 1000u), seg->state, (int32_t)info.power);
+        if (seg->state == EVSE_IDLE && !s_expect_active)
+        {
+            /* 拔枪，之前的授权作废 */
+            s_expect[s_expect_count].card = 0;
+        }
+    }
+}
+
+/**
+  * @brief  按脚本生成记录文件(pcap)
+  * @param  无
+  * @retval 无
+  */
+static void test_generate(void)
+{
+    static const test_segment_t short_idle = { EVSE_IDLE, 5, 0, 0, false };
+    test_segment_t seg;
+    capture_t cap;
+    uint32_t seed = 0x5E55u;
+    uint32_t pos;
+    uint32_t end;
+    uint32_t n;
+
+    memset(s_expect, 0, sizeof(s_expect));
+    s_expect_count = 0;
+    s_expect_active = false;
+    s_gen_us = TEST_START_US;
+    TEST_CHECK(capture_init(&cap, s_capture_buf, sizeof(s_capture_buf), test_gen_clock));
+
+    for (size_t i = 0; i < sizeof(s_script) / sizeof(s_script[0]); i++)
+    {
+        test_gen_segment(&cap, &s_script[i], &seed);
+    }
+    for (uint32_t i = 0; i < TEST_SHORT_SESSIONS; i++)
+    {
+        test_gen_segment(&cap, &short_idle, &seed);
+        seg = (test_segment_t){ EVSE_swipeWaitPlug, 2, 0, TEST_SHORT_CARD + i, false };
+        test_gen_segment(&cap, &seg, &seed);
+        seg = (test_segment_t){ EVSE_CHARGING, 60, 1000 + (int32_t)i * 100, 0, false };
+        test_gen_segment(&cap, &seg, &seed);
+        seg = (test_segment_t){ EVSE_CHARGE_DONE, 3, 0, 0, false };
+        test_gen_segment(&cap, &seg, &seed);
+    }
+    TEST_CHECK(atomic_load(&cap.overwritten) == 0);
+
+    s_file_len = capture_file_header(s_file);
+    capture_begin(&cap, &pos, &end);
+    while ((n = capture_read(&cap, &pos, end, s_file + s_file_len, sizeof(s_file) - s_file_len)) > 0)
+    {
+        s_file_len += n;
+    }
+}
+
+/**
+  * @brief  按记录的时间戳回放 pcap 中面板收到的数据
+  * @param  file 文件内容
+  * @param  len 文件长度
+  * @retval 回放的记录数
+  */
+static uint32_t test_replay(const uint8_t *file, uint32_t len)
+{
+    uint32_t pos = CAPTURE_FILE_HEAD_LEN;
+    uint32_t records = 0;
+    uint32_t incl;
+
+    TEST_CHECK(len >= CAPTURE_FILE_HEAD_LEN && wire_get_u32(file) == CAPTURE_PCAP_MAGIC);
+    TEST_CHECK(wire_get_u32(file + 20) == CAPTURE_LINKTYPE);
+    while (len - pos >= CAPTURE_RECORD_HEAD_LEN + 1)
+    {
+        incl = wire_get_u32(file + pos + 8);
+        TEST_CHECK(incl > 0 && incl <= len - pos - CAPTURE_RECORD_HEAD_LEN);
+        s_now_us = (uint64_t)wire_get_u32(file + pos) * 1000000u + wire_get_u32(file + pos + 4);
+        if (file[pos + CAPTURE_RECORD_HEAD_LEN] == CAPTURE_DIR_RX)
+        {
+            uart_receive_buff_input((uint8_t *)file + pos + CAPTURE_RECORD_HEAD_LEN + 1, (unsigned short)(incl - 1));
+            mcu_uart_service();
+            mcu_uart_tx_service();
+        }
+        pos += CAPTURE_RECORD_HEAD_LEN + incl;
+        records++;
+    }
+    return records;
+}
+
+/**
+  * @brief  回放脚本生成的记录，逐条比较充电记录
+  * @param  无
+  * @retval 无
+  */
+static void test_script(void)
+{
+    mem_subsys_stats_t before[MEM_SUBSYS_COUNT];
+    mem_subsys_stats_t after[MEM_SUBSYS_COUNT];
+    session_log_t decoded;
+    session_record_t rec;
+    session_record_t rec2;
+    uint8_t buf[SESSION_LOG_LEN * SESSION_RECORD_WIRE_LEN];
+    uint32_t records;
+    size_t len;
+
+    test_generate();
+    /* 第一次充电中途毫秒时钟回绕 */
+    TEST_CHECK(s_expect[0].last_ms < s_expect[0].start_ms);
+    session_init(&s_engine, 0);
+    session_log_init(&s_log);
+    s_ended = 0;
+    s_check = true;
+
+    mem_stats_get(before);
+    records = test_replay(s_file, s_file_len);
+    mem_stats_get(after);
+    s_check = false;
+    for (int i = 0; i < MEM_SUBSYS_COUNT; i++)
+    {
+        TEST_CHECK(after[i].allocs == before[i].allocs);
+    }
+
+    TEST_CHECK(s_ended == s_expect_count);
+    TEST_CHECK(s_expect_count == 3 + TEST_SHORT_SESSIONS);
+    TEST_CHECK(!session_current(&s_engine, &rec));
+    TEST_CHECK(s_log.count == SESSION_LOG_LEN);
+
+    /* 记录中保留最近 SESSION_LOG_LEN 次，session_log_get(0) 为最新 */
+    for (uint32_t i = 0; i < SESSION_LOG_LEN; i++)
+    {
+        TEST_CHECK(session_log_get(&s_log, i, &rec));
+        test_expect_check(&rec, s_expect_count - 1 - i);
+    }
+    TEST_CHECK(!session_log_get(&s_log, SESSION_LOG_LEN, &rec));
+
+    /* 编解码 */
+    len = session_log_encode(&s_log, buf, sizeof(buf));
+    TEST_CHECK(len == SESSION_LOG_LEN * SESSION_RECORD_WIRE_LEN);
+    TEST_CHECK(session_log_decode(&decoded, buf, len) == s_expect_count);
+    for (uint32_t i = 0; i < SESSION_LOG_LEN; i++)
+    {
+        TEST_CHECK(session_log_get(&s_log, i, &rec) && session_log_get(&decoded, i, &rec2));
+        TEST_CHECK(rec.seq == rec2.seq && rec.card == rec2.card && rec.day == rec2.day &&
+                   rec.end_state == rec2.end_state && rec.flags == rec2.flags &&
+                   rec.duration_s == rec2.duration_s && rec.energy_wh == rec2.energy_wh);
+    }
+    TEST_CHECK(session_log_encode(&s_log, buf, SESSION_RECORD_WIRE_LEN * 2 + 5) == SESSION_RECORD_WIRE_LEN * 2);
+
+    printf("replayed %lu records (%lu bytes): %lu running info frames, %lu sessions\n", (unsigned long)records,
+           (unsigned long)s_file_len, (unsigned long)s_feeds, (unsigned long)s_ended);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const test_expect_t *e = &s_expect[i];
+
+        printf("  session %lu: card %08lu, %5lu s, %8.3f Wh expected, end %u%s\n", (unsigned long)i,
+               (unsigned long)e->card, (unsigned long)((e->last_ms - e->start_ms) / 1000), e->energy_mj / 3600000.0,
+               e->end_state, (e->flags & SESSION_FLAG_GAP) ? ", gap" : "");
+    }
+    printf("session_feed: %.1f cycles/frame on average, %lu max\n", (double)s_feed_cycles / s_feeds,
+           (unsigned long)s_feed_max);
+}
+
+/**
+  * @brief  直接调用引擎: 实时记录、负功率、充电中刷卡不覆盖已有卡号
+  * @param  无
+  * @retval 无
+  */
+static void test_engine(void)
+{
+    session_engine_t e;
+    session_record_t rec;
+
+    session_init(&e, 100);
+    TEST_CHECK(!session_current(&e, &rec));
+    session_authorize(&e, 1, 2);
+    TEST_CHECK(!session_feed(&e, 0, EVSE_swipePlugReady, 0, &rec));
+    TEST_CHECK(!session_feed(&e, 1000, EVSE_CHARGING, 3600, &rec));
+    TEST_CHECK(!session_feed(&e, 2000, EVSE_CHARGING, 3600, &rec));
+    session_authorize(&e, 9, 9);
+    TEST_CHECK(session_current(&e, &rec));
+    TEST_CHECK(rec.seq == 100 && rec.card == 1 && rec.day == 2 && (rec.flags & SESSION_FLAG_ACTIVE));
+    TEST_CHECK(rec.duration_s == 1 && rec.energy_wh == 1);
+
+    /* 负功率按 0 处理 */
+    TEST_CHECK(!session_feed(&e, 3000, EVSE_CHARGE_PAUSE, -500, &rec));
+    TEST_CHECK(session_feed(&e, 4000, EVSE_CHARGE_DONE, 0, &rec));
+    TEST_CHECK(rec.flags == 0 && rec.end_state == EVSE_CHARGE_DONE);
+    TEST_CHECK(rec.duration_s == 3 && rec.energy_wh == 2);  // 3600*1 + 1800 + 0 = 5400 J = 1.5 Wh，四舍五入
+
+    /* 非充电状态之间切换不产生记录；下一次充电的序号递增，刚才充电中的刷卡不再归属 */
+    TEST_CHECK(!session_feed(&e, 5000, EVSE_FAULT, 0, &rec));
+    TEST_CHECK(!session_feed(&e, 6000, EVSE_CHARGING, 0, &rec));
+    TEST_CHECK(session_current(&e, &rec) && rec.seq == 101 && rec.card == 0);
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t file[TEST_CAPTURE_LEN];
+    session_record_t rec;
+    size_t len;
+    FILE *fp;
+
+    mcu_uart_protocol_init();
+    mcu_uart_tx_backend_register(test_tx_discard);
+    mcu_uart_clock_register(test_clock);
+    TEST_CHECK(mcu_fnum_handler_register(FN_UPDT_RFID_CARD, test_on_swipe, TEST_RFID_SWIPE_LEN, TEST_RFID_SWIPE_LEN));
+    running_info_listener_register(test_on_running_info);
+
+    test_engine();
+    test_script();
+
+    if (argc > 1)
+    {
+        fp = fopen(argv[1], "rb");
+        TEST_CHECK(fp != NULL);
+        len = fread(file, 1, sizeof(file), fp);
+        fclose(fp);
+        session_init(&s_engine, 0);
+        session_log_init(&s_log);
+        s_ended = 0;
+        printf("%s: %lu records, %lu sessions\n", argv[1], (unsigned long)test_replay(file, (uint32_t)len),
+               (unsigned long)s_ended);
+        for (uint32_t i = 0; session_log_get(&s_log, i, &rec); i++)
+        {
+            printf("  #%lu card %08lu day %u end %u flags %u: %lu s, %lu Wh\n", (unsigned long)rec.seq,
+                   (unsigned long)rec.card, rec.day, rec.end_state, rec.flags, (unsigned long)rec.duration_s,
+                   (unsigned long)rec.energy_wh);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/uart/snapshot 和 system.c 中实时运行参数/参数配置快照的主机测试:
+ * 两个写者线程(串口任务的两种数据)连续发布，多个读者线程(HTTP 处理函数)同时读取，
+ * 检查每一份读到的副本内部一致、版本号和数据都不回退。
+ * 作为对照，同样的读写直接作用于一个普通的 volatile 结构体(旧固件的做法)，只统计撕裂的次数。
+ */
+
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "system.h"
+#include "test_common.h"
+
+#define TEST_READERS                3               // 读者线程数
+#define TEST_RUN_MS                 400             // 每项测试的时长
+
+/**
+ * @brief   读者线程的统计
+ */
+typedef struct test_reader{
+    pthread_t thread;
+    uint32_t reads;                 // 读取次数
+    uint32_t torn;                  // 内部不一致的副本数(只统计对照组)
+}test_reader_t;
+
+static atomic_bool s_stop;
+static bool s_plain = false;        // 对照组: 读写普通的 volatile 结构体
+static volatile running_info_t s_plain_info;
+static uint32_t s_written;          // 写者发布的次数
+
+/**
+  * @brief  第 k 次发布的实时运行参数: 电压和电流由 k 的低 12 位和高 8 位组成，功率 = 电压 × 电流，
+  *         两个状态字节为 k 的低 16 位
+  * @param  k 发布序号(小于 2^20)
+  * @param  info 输出
+  * @retval 无
+  */
+static void test_info_make(uint32_t k, running_info_t *info)
+{
+    info->voltage = (float)(k & 0xFFF);
+    info->current = (float)(k >> 12);
+    info->power = info->voltage * info->current;
+    info->charge_status = (uint8_t)k;
+    info->net_status = (uint8_t)(k >> 8);
+}
+
+/**
+  * @brief  检查一份实时运行参数是否为某一次完整的发布
+  * @param  info 实时运行参数
+  * @param  k 输出: 发布序号
+  * @retval 是否一致
+  */
+static bool test_info_consistent(const running_info_t *info, uint32_t *k)
+{
+    running_info_t expect;
+
+    *k = ((uint32_t)info->current << 12) | (uint32_t)info->voltage;
+    test_info_make(*k, &expect);
+    return (expect.power == info->power) && (expect.charge_status == info->charge_status) &&
+           (expect.net_status == info->net_status);
+}
+
+/**
+  * @brief  实时运行参数写者(串口任务)
+  * @param  arg 无
+  * @retval NULL
+  */
+static void *test_info_writer(void *arg)
+{
+    running_info_t info;
+    uint32_t k = 1;
+
+    (void)arg;
+    while (!atomic_load_explicit(&s_stop, memory_order_relaxed) && k < (1u << 20))
+    {
+        test_info_make(k, &info);
+        if (s_plain)
+        {
+            s_plain_info.voltage = info.voltage;
+            s_plain_info.current = info.current;
+            if ((k & 63) == 0)
+            {
+                /* 模拟串口任务在逐字段赋值的中途被抢占(单核的主机上才会出现交错) */
+                sched_yield();
+            }
+            s_plain_info.power = info.power;
+            s_plain_info.charge_status = info.charge_status;
+            s_plain_info.net_status = info.net_status;
+        }
+        else
+        {
+            running_info_publish(&info, RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_POWER));
+        }
+        k++;
+        if ((k & 63) == 0)
+        {
+            sched_yield();
+        }
+    }
+    s_written = k - 1;
+    return NULL;
+}
+
+/**
+  * @brief  参数配置写者: 两个阈值总是相同，三个电流阈值总是相同
+  * @param  arg 无
+  * @retval NULL
+  */
+static void *test_config_writer(void *arg)
+{
+    param_config_t config;
+    uint32_t k = 1;
+
+    (void)arg;
+    while (!atomic_load_explicit(&s_stop, memory_order_relaxed))
+    {
+        config.ov_threshold = (float)k;
+        config.uv_threshold = (float)k;
+        config.leakagedc = (uint8_t)k;
+        config.leakageac = (uint8_t)k;
+        config.maxcc = (uint8_t)k;
+        param_config_publish(&config);
+        k = (k + 1) & 0xFFFFFF;
+        if ((k & 63) == 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  读者(HTTP 处理函数): 交替读取两份快照
+  * @param  arg test_reader_t
+  * @retval NULL
+  */
+static void *test_reader(void *arg)
+{
+    test_reader_t *r = arg;
+    running_info_t info;
+    param_config_t config;
+    uint32_t version;
+    uint32_t last_version = 0;
+    uint32_t last_k = 0;
+    uint32_t k;
+
+    while (!atomic_load_explicit(&s_stop, memory_order_relaxed))
+    {
+        if (s_plain)
+        {
+            info.voltage = s_plain_info.voltage;
+            info.current = s_plain_info.current;
+            info.power = s_plain_info.power;
+            info.charge_status = s_plain_info.charge_status;
+            info.net_status = s_plain_info.net_status;
+            if (!test_info_consistent(&info, &k))
+            {
+                r->torn++;
+            }
+        }
+        else
+        {
+            version = running_info_read(&info);
+            TEST_CHECK(test_info_consistent(&info, &k));
+            TEST_CHECK(version >= last_version);
+            TEST_CHECK(k >= last_k);
+            last_version = version;
+            last_k = k;
+
+            param_config_read(&config);
+            TEST_CHECK(config.ov_threshold == config.uv_threshold);
+            TEST_CHECK(config.leakagedc == config.leakageac && config.leakagedc == config.maxcc);
+            TEST_CHECK((uint8_t)(uint32_t)config.ov_threshold == config.maxcc);
+        }
+        r->reads++;
+        if ((r->reads & 255) == 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @brief  运行一次读写压力测试
+  * @param  plain 是否为对照组
+  * @retval 无
+  */
+static void test_run(bool plain)
+{
+    test_reader_t readers[TEST_READERS];
+    pthread_t info_writer;
+    pthread_t config_writer;
+    struct timespec ts = { 0, TEST_RUN_MS * 1000000L };
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+
+    memset(readers, 0, sizeof(readers));
+    s_plain = plain;
+    atomic_store(&s_stop, false);
+    pthread_create(&info_writer, NULL, test_info_writer, NULL);
+    pthread_create(&config_writer, NULL, test_config_writer, NULL);
+    for (int i = 0; i < TEST_READERS; i++)
+    {
+        pthread_create(&readers[i].thread, NULL, test_reader, &readers[i]);
+    }
+    nanosleep(&ts, NULL);
+    atomic_store(&s_stop, true);
+    pthread_join(info_writer, NULL);
+    pthread_join(config_writer, NULL);
+    for (int i = 0; i < TEST_READERS; i++)
+    {
+        pthread_join(readers[i].thread, NULL);
+        reads += readers[i].reads;
+        torn += readers[i].torn;
+    }
+    printf("%-9s %9lu reads in %d ms (%5.1f M/s), %8lu published, %lu torn\n", plain ? "volatile" : "snapshot",
+           (unsigned long)reads, TEST_RUN_MS, reads / (TEST_RUN_MS * 1e3), (unsigned long)s_written,
+           (unsigned long)torn);
+    TEST_CHECK(reads > 0 && s_written > 0);
+}
+
+/**
+  * @brief  单线程: 版本号、变化字段查询
+  * @param  无
+  * @retval 无
+  */
+static void test_changed(void)
+{
+    running_info_t info;
+    uint32_t since;
+
+    test_info_make(7, &info);
+    since = running_info_version();
+    running_info_publish(&info, RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_VOLTAGE));
+    running_info_publish(&info, RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_NET_STATUS));
+    TEST_CHECK(running_info_version() == since + 2);
+    TEST_CHECK(running_info_changed(since) ==
+               (RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_VOLTAGE) | RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_NET_STATUS)));
+    TEST_CHECK(running_info_changed(since + 1) == RUN_INFO_FIELD_BIT(RUN_INFO_FIELD_NET_STATUS));
+    TEST_CHECK(running_info_changed(since + 2) == 0);
+    memset(&info, 0, sizeof(info));
+    TEST_CHECK(running_info_read(&info) == since + 2);
+    TEST_CHECK(info.charge_status == 7);
+}
+
+int main(void)
+{
+    /* 读者检查数据不回退，压力测试的写者从 1 开始编号，先运行 */
+    test_run(false);
+    test_run(true);
+    test_changed();
+    return 0;
+}
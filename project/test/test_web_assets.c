@@ -0,0 +1,245 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * 内嵌网页资源(WEB_ASSETS_EMBEDDED)的主机测试: test/CMakeLists.txt 在构建时用 tools/web_assets.py
+ * 生成资源表(web_assets_data.c)，并在构建目录中复制一份 data/ 生成 .gz/.etag(SPIFFS 镜像的内容)。
+ *
+ *   检查  资源表按路径排序、每个资源与 data/ 中的文件对应、gzip 数据完整、ETag 与 .etag 文件一致、
+ *         web_asset_find 的查找(带查询参数、前缀、不存在的路径)
+ *   基准  内嵌资源(查找 + 从常量区分块发送)与 SPIFFS 路径(fopen + fread 分块 + fclose，同 handler_get_static)
+ *         每秒处理的请求数；主机的文件在页缓存中，目标板上 SPIFFS 的读取要慢得多，这里只是下限
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "web_assets.h"
+#include "test_common.h"
+
+#define TEST_CHUNK_LEN              1024            // 与 HTTP_STATIC_CHUNK_LEN 相同
+#define TEST_BENCH_REQUESTS         200000          // 每种方式的请求数
+
+static uint8_t s_sink[TEST_CHUNK_LEN];
+static uint64_t s_sent;
+
+/**
+  * @brief  读入文件
+  * @param  path 文件路径
+  * @param  len 输出: 文件长度
+  * @retval 文件内容(调用者释放)，文件不存在时返回 NULL
+  */
+static uint8_t *test_read_file(const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    uint8_t *buf;
+    long size;
+
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = malloc((size_t)size + 1);
+    TEST_CHECK(buf != NULL);
+    *len = fread(buf, 1, (size_t)size, fp);
+    buf[*len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+/**
+  * @brief  模拟 httpd_resp_send_chunk: 拷贝到发送缓冲区
+  * @param  data 数据
+  * @param  len 长度
+  * @retval 无
+  */
+static void test_send(const uint8_t *data, size_t len)
+{
+    memcpy(s_sink, data, len);
+    TEST_KEEP(s_sink);
+    s_sent += len;
+}
+
+/**
+  * @brief  资源表与 data/ 中的文件、生成的 .etag 文件一致
+  * @param  无
+  * @retval 无
+  */
+static void test_table(void)
+{
+    char path[256];
+    uint8_t *file;
+    uint8_t *etag;
+    size_t file_len;
+    size_t etag_len;
+    uint32_t isize;
+
+    TEST_CHECK(g_web_asset_count >= 4);
+    for (size_t i = 0; i < g_web_asset_count; i++)
+    {
+        const web_asset_t *asset = &g_web_assets[i];
+
+        if (i > 0)
+        {
+            TEST_CHECK(strcmp(g_web_assets[i - 1].path, asset->path) < 0);
+        }
+        TEST_CHECK(asset->path[0] == '/');
+        TEST_CHECK(asset->len > 0);
+
+        snprintf(path, sizeof(path), "%s%s", TEST_WEB_DATA_DIR, asset->path);
+        file = test_read_file(path, &file_len);
+        TEST_CHECK(file != NULL);
+
+        /* ETag: 原始内容的哈希，与 SPIFFS 模式下的 .etag 文件相同 */
+        snprintf(path, sizeof(path), "%s%s.etag", TEST_WEB_DATA_DIR, asset->path);
+        etag = test_read_file(path, &etag_len);
+        TEST_CHECK(etag != NULL);
+        TEST_CHECK(strlen(asset->etag) == 18 && asset->etag[0] == '"' && asset->etag[17] == '"');
+        TEST_CHECK(etag_len == 18 && memcmp(etag, asset->etag, 18) == 0);
+
+        if (asset->gzip)
+        {
+            /* gzip 头和尾部的原始长度: 精简后的内容不比原文件长 */
+            TEST_CHECK(asset->len > 18 && asset->data[0] == 0x1f && asset->data[1] == 0x8b);
+            isize = (uint32_t)asset->data[asset->len - 4] | ((uint32_t)asset->data[asset->len - 3] << 8) |
+                    ((uint32_t)asset->data[asset->len - 2] << 16) | ((uint32_t)asset->data[asset->len - 1] << 24);
+            TEST_CHECK(isize > 0 && isize <= file_len);
+            TEST_CHECK(asset->len < file_len);
+        }
+        else
+        {
+            TEST_CHECK(asset->len == file_len && memcmp(asset->data, file, file_len) == 0);
+        }
+        printf("%-20s %-24s %s %6lu -> %6lu bytes\n", asset->path, asset->type, asset->gzip ? "gz" : "  ",
+               (unsigned long)file_len, (unsigned long)asset->len);
+        free(file);
+        free(etag);
+    }
+}
+
+/**
+  * @brief  查找: 完整路径、带查询参数的 URI、前缀和更长的路径
+  * @param  无
+  * @retval 无
+  */
+static void test_find(void)
+{
+    const char *uri = "/css/style.css?v=3";
+    const web_asset_t *asset;
+
+    for (size_t i = 0; i < g_web_asset_count; i++)
+    {
+        TEST_CHECK(web_asset_find(g_web_assets[i].path, strlen(g_web_assets[i].path)) == &g_web_assets[i]);
+    }
+    asset = web_asset_find(uri, strcspn(uri, "?#"));
+    TEST_CHECK(asset != NULL && strcmp(asset->path, "/css/style.css") == 0);
+    TEST_CHECK(strcmp(web_asset_find("/index.html", 11)->type, "text/html") == 0);
+    TEST_CHECK(strcmp(web_asset_find("/favicon.ico", 12)->type, "image/x-icon") == 0);
+
+    TEST_CHECK(web_asset_find("/index.htm", 10) == NULL);
+    TEST_CHECK(web_asset_find("/index.html5", 12) == NULL);
+    TEST_CHECK(web_asset_find("/css", 4) == NULL);
+    TEST_CHECK(web_asset_find("/", 1) == NULL);
+    TEST_CHECK(web_asset_find("", 0) == NULL);
+    TEST_CHECK(web_asset_find("/zzz", 4) == NULL);
+}
+
+/**
+  * @brief  内嵌资源: 查找 + 从常量区分块发送
+  * @param  uri 请求路径
+  * @retval 无
+  */
+static void test_serve_embedded(const char *uri)
+{
+    const web_asset_t *asset = web_asset_find(uri, strcspn(uri, "?#"));
+
+    TEST_CHECK(asset != NULL);
+    for (uint32_t pos = 0; pos < asset->len; pos += TEST_CHUNK_LEN)
+    {
+        test_send(asset->data + pos, (asset->len - pos < TEST_CHUNK_LEN) ? asset->len - pos : TEST_CHUNK_LEN);
+    }
+}
+
+/**
+  * @brief  SPIFFS 路径: 与 handler_get_static 相同，优先打开 .gz，按块读取发送
+  * @param  uri 请求路径
+  * @retval 无
+  */
+static void test_serve_file(const char *uri)
+{
+    uint8_t chunk[TEST_CHUNK_LEN];
+    char path[256];
+    FILE *fp;
+    size_t len;
+
+    snprintf(path, sizeof(path), "%s%s.gz", TEST_WEB_DATA_DIR, uri);
+    fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        snprintf(path, sizeof(path), "%s%s", TEST_WEB_DATA_DIR, uri);
+        fp = fopen(path, "rb");
+    }
+    TEST_CHECK(fp != NULL);
+    while ((len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+    {
+        test_send(chunk, len);
+    }
+    fclose(fp);
+}
+
+/**
+  * @brief  基准: 按页面加载的顺序轮流请求所有资源
+  * @param  name 方式
+  * @param  serve 处理函数
+  * @retval 无
+  */
+static void test_bench(const char *name, void (*serve)(const char *uri))
+{
+    uint64_t t0;
+    double ns;
+
+    s_sent = 0;
+    t0 = test_now_ns();
+    for (uint32_t n = 0; n < TEST_BENCH_REQUESTS; n++)
+    {
+        serve(g_web_assets[n % g_web_asset_count].path);
+    }
+    ns = (double)(test_now_ns() - t0);
+    printf("%-9s %9.0f requests/s, %8.1f MB/s, %6.2f us/request\n", name, TEST_BENCH_REQUESTS / (ns / 1e9),
+           (double)s_sent / (ns / 1e3), ns / 1e3 / TEST_BENCH_REQUESTS);
+}
+
+/**
+  * @brief  基准: 只比较查找
+  * @param  无
+  * @retval 无
+  */
+static void test_bench_find(void)
+{
+    const web_asset_t *asset;
+    uint64_t c0;
+
+    c0 = test_cycles();
+    for (uint32_t n = 0; n < TEST_BENCH_REQUESTS; n++)
+    {
+        const char *path = g_web_assets[n % g_web_asset_count].path;
+
+        TEST_KEEP(path);
+        asset = web_asset_find(path, strlen(path));
+        TEST_KEEP(asset);
+    }
+    printf("%-9s %9.1f cycles/lookup\n", "find", (double)(test_cycles() - c0) / TEST_BENCH_REQUESTS);
+}
+
+int main(void)
+{
+    test_table();
+    test_find();
+    test_bench_find();
+    test_bench("embedded", test_serve_embedded);
+    test_bench("file", test_serve_file);
+    return 0;
+}
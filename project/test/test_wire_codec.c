@@ -0,0 +1,362 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * lib/uart/wire_codec 的主机测试: 三种线上布局(test/CMakeLists.txt 以不同的 PROTOCOL_WIRE_LAYOUT
+ * 各构建一次)的固定字节序列、编解码往返、增量帧，以及解码与旧固件直接转换结构体指针的耗时比较。
+ */
+
+#define _DEFAULT_SOURCE
+#include <string.h>
+
+#include "wire_codec.h"
+#include "test_common.h"
+
+#define TEST_ROUNDS                 100000          // 随机往返次数
+#define TEST_BENCH_ROUNDS           20000000        // 基准重复次数
+
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+#define TEST_LAYOUT_NAME            "fixed16"
+#elif PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_PACKED
+#define TEST_LAYOUT_NAME            "packed"
+#else
+#define TEST_LAYOUT_NAME            "legacy"
+#endif
+
+static const running_info_t s_info = {
+    .charge_status = 2,
+    .power = 7040.0f,
+    .voltage = 230.5f,
+    .current = 30.61f,
+    .net_status = 1,
+};
+
+static const param_config_t s_config = {
+    .ov_threshold = 264.5f,
+    .uv_threshold = 195.5f,
+    .leakagedc = 6,
+    .leakageac = 30,
+    .maxcc = 32,
+};
+
+#if PROTOCOL_WIRE_LAYOUT != WIRE_LAYOUT_FIXED16
+/**
+  * @brief  浮点数的位模式(小端字节序)
+  * @param  buf 输出 4 字节
+  * @param  value 浮点数
+  * @retval 无
+  */
+static void test_put_f32(uint8_t *buf, float value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    wire_put_u32(buf, bits);
+}
+#endif
+
+/**
+  * @brief  定点数按比例取整后的浮点数(FIXED16 往返后应得到的值)
+  * @param  value 浮点数
+  * @param  scale 比例
+  * @retval 浮点数
+  */
+static float test_quantize(float value, uint16_t scale)
+{
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+    return (float)(uint16_t)(value * scale + 0.5f) / scale;
+#else
+    (void)scale;
+    return value;
+#endif
+}
+
+/**
+  * @brief  固定的字节序列: 字段偏移、字节序和填充与文档一致
+  * @param  无
+  * @retval 无
+  */
+static void test_golden(void)
+{
+    uint8_t expect[RUNNING_INFO_WIRE_LEN] = { 0 };
+    uint8_t expect_cfg[PARAM_CONFIG_WIRE_LEN] = { 0 };
+    uint8_t buf[32];
+
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+    expect[0] = 2;
+    wire_put_u16(expect + 1, 7040);
+    wire_put_u16(expect + 3, 2305);
+    wire_put_u16(expect + 5, 3061);
+    expect[7] = 1;
+    wire_put_u16(expect_cfg + 0, 2645);
+    wire_put_u16(expect_cfg + 2, 1955);
+    expect_cfg[4] = 6;
+    expect_cfg[5] = 30;
+    expect_cfg[6] = 32;
+#elif PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_PACKED
+    expect[0] = 2;
+    test_put_f32(expect + 1, 7040.0f);
+    test_put_f32(expect + 5, 230.5f);
+    test_put_f32(expect + 9, 30.61f);
+    expect[13] = 1;
+    test_put_f32(expect_cfg + 0, 264.5f);
+    test_put_f32(expect_cfg + 4, 195.5f);
+    expect_cfg[8] = 6;
+    expect_cfg[9] = 30;
+    expect_cfg[10] = 32;
+#else
+    expect[0] = 2;
+    test_put_f32(expect + 4, 7040.0f);
+    test_put_f32(expect + 8, 230.5f);
+    test_put_f32(expect + 12, 30.61f);
+    expect[16] = 1;
+    test_put_f32(expect_cfg + 0, 264.5f);
+    test_put_f32(expect_cfg + 4, 195.5f);
+    expect_cfg[8] = 6;
+    expect_cfg[9] = 30;
+    expect_cfg[10] = 32;
+#endif
+
+    memset(buf, 0xA5, sizeof(buf));
+    TEST_CHECK(running_info_encode(&s_info, buf, sizeof(buf)) == RUNNING_INFO_WIRE_LEN);
+    TEST_CHECK(memcmp(buf, expect, RUNNING_INFO_WIRE_LEN) == 0);
+    TEST_CHECK(running_info_encode(&s_info, buf, RUNNING_INFO_WIRE_LEN - 1) == 0);
+
+    memset(buf, 0xA5, sizeof(buf));
+    TEST_CHECK(param_config_encode(&s_config, buf, sizeof(buf)) == PARAM_CONFIG_WIRE_LEN);
+    TEST_CHECK(memcmp(buf, expect_cfg, PARAM_CONFIG_WIRE_LEN) == 0);
+    TEST_CHECK(param_config_encode(&s_config, buf, PARAM_CONFIG_WIRE_LEN - 1) == 0);
+
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_LEGACY
+    {
+        /* 旧布局与主控板直接发送的结构体逐字节相同(静态初始化的结构体填充字节为0) */
+        running_info_t raw;
+        param_config_t raw_cfg;
+
+        memcpy(&raw, &s_info, sizeof(raw));
+        TEST_CHECK(memcmp(&raw, expect, sizeof(raw)) == 0);
+        memcpy(&raw_cfg, &s_config, sizeof(raw_cfg));
+        TEST_CHECK(memcmp(&raw_cfg, expect_cfg, sizeof(raw_cfg)) == 0);
+    }
+#endif
+}
+
+/**
+  * @brief  解码: 长度必须完全一致，填充字节的内容忽略，非对齐地址可以解码
+  * @param  无
+  * @retval 无
+  */
+static void test_decode(void)
+{
+    uint8_t buf[1 + RUNNING_INFO_WIRE_LEN + 1];
+    uint8_t *wire = buf + 1;
+    running_info_t info;
+    param_config_t config;
+
+    TEST_CHECK(running_info_encode(&s_info, wire, RUNNING_INFO_WIRE_LEN) == RUNNING_INFO_WIRE_LEN);
+    TEST_CHECK(!running_info_decode(wire, RUNNING_INFO_WIRE_LEN - 1, &info));
+    TEST_CHECK(!running_info_decode(wire, RUNNING_INFO_WIRE_LEN + 1, &info));
+    TEST_CHECK(running_info_decode(wire, RUNNING_INFO_WIRE_LEN, &info));
+    TEST_CHECK(info.charge_status == s_info.charge_status);
+    TEST_CHECK(info.power == test_quantize(s_info.power, WIRE_SCALE_POWER));
+    TEST_CHECK(info.voltage == test_quantize(s_info.voltage, WIRE_SCALE_VOLTAGE));
+    TEST_CHECK(info.current == test_quantize(s_info.current, WIRE_SCALE_CURRENT));
+    TEST_CHECK(info.net_status == s_info.net_status);
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_LEGACY
+    wire[1] = 0xFF;
+    wire[19] = 0xFF;
+    TEST_CHECK(running_info_decode(wire, RUNNING_INFO_WIRE_LEN, &info));
+    TEST_CHECK(info.power == s_info.power);
+#endif
+
+    TEST_CHECK(param_config_encode(&s_config, wire, PARAM_CONFIG_WIRE_LEN) == PARAM_CONFIG_WIRE_LEN);
+    TEST_CHECK(!param_config_decode(wire, PARAM_CONFIG_WIRE_LEN - 1, &config));
+    TEST_CHECK(param_config_decode(wire, PARAM_CONFIG_WIRE_LEN, &config));
+    TEST_CHECK(config.ov_threshold == test_quantize(s_config.ov_threshold, WIRE_SCALE_VOLTAGE));
+    TEST_CHECK(config.uv_threshold == test_quantize(s_config.uv_threshold, WIRE_SCALE_VOLTAGE));
+    TEST_CHECK(config.leakagedc == 6 && config.leakageac == 30 && config.maxcc == 32);
+
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+    {
+        /* 定点数超出范围时饱和 */
+        running_info_t big = s_info;
+
+        big.power = -5.0f;
+        big.voltage = 1e6f;
+        TEST_CHECK(running_info_encode(&big, wire, RUNNING_INFO_WIRE_LEN) == RUNNING_INFO_WIRE_LEN);
+        TEST_CHECK(running_info_decode(wire, RUNNING_INFO_WIRE_LEN, &info));
+        TEST_CHECK(info.power == 0.0f);
+        TEST_CHECK(info.voltage == 65535.0f / WIRE_SCALE_VOLTAGE);
+    }
+#endif
+}
+
+/**
+  * @brief  随机值往返: 编码再解码得到相同的值(FIXED16 为取整后的值)，再编码得到相同的字节
+  * @param  无
+  * @retval 无
+  */
+static void test_round_trip(void)
+{
+    uint8_t wire[RUNNING_INFO_WIRE_LEN];
+    uint8_t again[RUNNING_INFO_WIRE_LEN];
+    uint8_t wire_cfg[PARAM_CONFIG_WIRE_LEN];
+    running_info_t in;
+    running_info_t out;
+    param_config_t cfg_in;
+    param_config_t cfg_out;
+    uint32_t seed = 0x2468ACEu;
+
+    for (uint32_t r = 0; r < TEST_ROUNDS; r++)
+    {
+        in.charge_status = (uint8_t)test_rand(&seed);
+        in.power = (float)(test_rand(&seed) % 22000);
+        in.voltage = (float)(test_rand(&seed) % 3000) / 10.0f;
+        in.current = (float)(test_rand(&seed) % 6400) / 100.0f;
+        in.net_status = (uint8_t)test_rand(&seed);
+        TEST_CHECK(running_info_encode(&in, wire, sizeof(wire)) == RUNNING_INFO_WIRE_LEN);
+        TEST_CHECK(running_info_decode(wire, sizeof(wire), &out));
+        TEST_CHECK(out.charge_status == in.charge_status && out.net_status == in.net_status);
+        TEST_CHECK(out.power == test_quantize(in.power, WIRE_SCALE_POWER));
+        TEST_CHECK(out.voltage == test_quantize(in.voltage, WIRE_SCALE_VOLTAGE));
+        TEST_CHECK(out.current == test_quantize(in.current, WIRE_SCALE_CURRENT));
+        TEST_CHECK(running_info_encode(&out, again, sizeof(again)) == RUNNING_INFO_WIRE_LEN);
+        TEST_CHECK(memcmp(wire, again, sizeof(wire)) == 0);
+
+        cfg_in.ov_threshold = (float)(2300 + test_rand(&seed) % 700) / 10.0f;
+        cfg_in.uv_threshold = (float)(1500 + test_rand(&seed) % 800) / 10.0f;
+        cfg_in.leakagedc = (uint8_t)test_rand(&seed);
+        cfg_in.leakageac = (uint8_t)test_rand(&seed);
+        cfg_in.maxcc = (uint8_t)test_rand(&seed);
+        TEST_CHECK(param_config_encode(&cfg_in, wire_cfg, sizeof(wire_cfg)) == PARAM_CONFIG_WIRE_LEN);
+        TEST_CHECK(param_config_decode(wire_cfg, sizeof(wire_cfg), &cfg_out));
+        TEST_CHECK(cfg_out.ov_threshold == test_quantize(cfg_in.ov_threshold, WIRE_SCALE_VOLTAGE));
+        TEST_CHECK(cfg_out.uv_threshold == test_quantize(cfg_in.uv_threshold, WIRE_SCALE_VOLTAGE));
+        TEST_CHECK(cfg_out.leakagedc == cfg_in.leakagedc && cfg_out.leakageac == cfg_in.leakageac &&
+                   cfg_out.maxcc == cfg_in.maxcc);
+    }
+}
+
+/**
+  * @brief  增量帧: 只编码变化的字段，应用后与全量相同；不认识的字段跳过，长度错误整帧丢弃
+  * @param  无
+  * @retval 无
+  */
+static void test_delta(void)
+{
+    uint8_t buf[RUNNING_INFO_DELTA_MAX_LEN + 8];
+    uint8_t len;
+    uint32_t dirty;
+    running_info_t prev = s_info;
+    running_info_t next = s_info;
+    running_info_t rx = s_info;
+    param_config_t cfg_prev = s_config;
+    param_config_t cfg_next = s_config;
+    uint8_t cfg_buf[PARAM_CONFIG_DELTA_MAX_LEN];
+
+    /* 没有变化 */
+    TEST_CHECK(running_info_delta_encode(&next, &prev, buf, sizeof(buf)) == 0);
+    TEST_CHECK(running_info_diff(&next, &prev) == 0);
+
+    /* 电流和网络状态变化 */
+    next.current = 12.5f;
+    next.net_status = 0;
+    TEST_CHECK(running_info_diff(&next, &prev) ==
+               ((1u << RUN_INFO_FIELD_CURRENT) | (1u << RUN_INFO_FIELD_NET_STATUS)));
+    len = running_info_delta_encode(&next, &prev, buf, sizeof(buf));
+#if PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_FIXED16
+    TEST_CHECK(len == 1 + 2 + 1 + 1);
+#else
+    TEST_CHECK(len == 1 + 4 + 1 + 1);
+#endif
+    TEST_CHECK(WIRE_TLV_ID(buf[0]) == RUN_INFO_FIELD_CURRENT);
+    TEST_CHECK(running_info_delta_apply(buf, len, &rx, &dirty));
+    TEST_CHECK(dirty == ((1u << RUN_INFO_FIELD_CURRENT) | (1u << RUN_INFO_FIELD_NET_STATUS)));
+    TEST_CHECK(rx.current == next.current && rx.net_status == 0 && rx.power == s_info.power);
+
+    /* 对端新增的字段(ID 15)跳过 */
+    buf[len] = WIRE_TLV_HEAD(15, 3);
+    memset(buf + len + 1, 0x55, 3);
+    rx = s_info;
+    TEST_CHECK(running_info_delta_apply(buf, len + 4, &rx, &dirty));
+    TEST_CHECK(rx.current == next.current);
+
+    /* 已知字段长度不符、记录越界时整帧丢弃，结构体不变 */
+    rx = s_info;
+    buf[0] = WIRE_TLV_HEAD(RUN_INFO_FIELD_CURRENT, 3);
+    TEST_CHECK(!running_info_delta_apply(buf, len, &rx, &dirty));
+    TEST_CHECK(running_info_diff(&rx, &s_info) == 0);
+    TEST_CHECK(!running_info_delta_apply(buf, 2, &rx, &dirty));
+
+    /* 没有上次发送的值时编码全部字段 */
+    len = running_info_delta_encode(&next, NULL, buf, sizeof(buf));
+    TEST_CHECK(len == RUN_INFO_FIELD_COUNT + RUNNING_INFO_WIRE_LEN - (PROTOCOL_WIRE_LAYOUT == WIRE_LAYOUT_LEGACY ? 6 : 0));
+    TEST_CHECK(len <= RUNNING_INFO_DELTA_MAX_LEN);
+    memset(&rx, 0, sizeof(rx));
+    TEST_CHECK(running_info_delta_apply(buf, len, &rx, &dirty));
+    TEST_CHECK(running_info_diff(&rx, &next) == 0);
+
+    cfg_next.maxcc = 16;
+    len = param_config_delta_encode(&cfg_next, &cfg_prev, cfg_buf, sizeof(cfg_buf));
+    TEST_CHECK(len == 2);
+    TEST_CHECK(param_config_delta_apply(cfg_buf, len, &cfg_prev, &dirty));
+    TEST_CHECK(dirty == (1u << PARAM_FIELD_MAXCC) && cfg_prev.maxcc == 16);
+}
+
+/**
+  * @brief  解码与旧固件的结构体指针转换(g_running_info = *((running_info_t *)value))的耗时
+  * @param  无
+  * @retval 无
+  */
+static void test_bench(void)
+{
+    _Alignas(4) uint8_t frame[4 + sizeof(running_info_t)];
+    running_info_t info;
+    uint64_t c0;
+    double cast_cycles;
+    double decode_cycles;
+    double encode_cycles;
+
+    /* 帧中数据内容从第 4 字节开始(DATA_START)，结构体转换时正好对齐，是旧写法的最好情况 */
+    TEST_CHECK(running_info_encode(&s_info, frame + 4, RUNNING_INFO_WIRE_LEN) == RUNNING_INFO_WIRE_LEN);
+
+    c0 = test_cycles();
+    for (uint32_t r = 0; r < TEST_BENCH_ROUNDS; r++)
+    {
+        TEST_KEEP(frame);
+        info = *((const running_info_t *)(frame + 4));
+        TEST_KEEP(info);
+    }
+    cast_cycles = (double)(test_cycles() - c0) / TEST_BENCH_ROUNDS;
+
+    c0 = test_cycles();
+    for (uint32_t r = 0; r < TEST_BENCH_ROUNDS; r++)
+    {
+        TEST_KEEP(frame);
+        running_info_decode(frame + 4, RUNNING_INFO_WIRE_LEN, &info);
+        TEST_KEEP(info);
+    }
+    decode_cycles = (double)(test_cycles() - c0) / TEST_BENCH_ROUNDS;
+
+    c0 = test_cycles();
+    for (uint32_t r = 0; r < TEST_BENCH_ROUNDS; r++)
+    {
+        TEST_KEEP(info);
+        running_info_encode(&info, frame + 4, RUNNING_INFO_WIRE_LEN);
+        TEST_KEEP(frame);
+    }
+    encode_cycles = (double)(test_cycles() - c0) / TEST_BENCH_ROUNDS;
+
+    printf("%-8s wire %2u bytes: cast %6.1f, decode %6.1f, encode %6.1f cycles/frame\n", TEST_LAYOUT_NAME,
+           RUNNING_INFO_WIRE_LEN, cast_cycles, decode_cycles, encode_cycles);
+}
+
+int main(void)
+{
+    test_golden();
+    test_decode();
+    test_round_trip();
+    test_delta();
+    test_bench();
+    return 0;
+}
@@ -0,0 +1,182 @@
+# EVCharger Panel Project
+# Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+#
+# HTTP 负载测试：多个客户端并发循环请求一组路径，统计每个路径的 p50/p99 延迟和 503 次数。
+#
+#   python tools/http_load.py --url http://192.168.4.1            测试设备
+#   python tools/http_load.py --stub single                       测试本机桩服务器(单任务模型)
+#   python tools/http_load.py --stub async                        测试本机桩服务器(工作任务池模型)
+#
+# 桩服务器模拟固件的两种处理方式，用于在没有设备时比较：
+#   single  所有请求在一个任务中依次处理(HTTPD_DEFAULT_CONFIG)
+#   async   服务任务只分发，接口请求进高优先级队列，静态文件进低优先级队列，
+#           HTTP_ASYNC_WORKERS 个工作任务处理(第一个只处理接口)，队列满时回复 503 + Retry-After
+# 静态文件的处理时间按 SPIFFS 读取估计，接口按快照读取估计，可用参数调整。
+
+import argparse
+import http.client
+import http.server
+import queue
+import socketserver
+import threading
+import time
+import urllib.parse
+
+DEFAULT_PATHS = ["/", "/js/script.js", "/api/status", "/api/config"]
+
+# 与 src/http_async.h 一致
+ASYNC_WORKERS = 2
+ASYNC_HIGH_QUEUE_LEN = 6
+ASYNC_LOW_QUEUE_LEN = 4
+
+
+class StubServer(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+
+    def __init__(self, addr, mode, static_ms, api_ms):
+        super().__init__(addr, StubHandler)
+        self.mode = mode
+        self.static_s = static_ms / 1000.0
+        self.api_s = api_ms / 1000.0
+        # single: 一把锁串行化所有请求；async: 两个有界队列 + 工作线程
+        self.httpd_lock = threading.Lock()
+        self.lanes = [queue.Queue(ASYNC_HIGH_QUEUE_LEN), queue.Queue(ASYNC_LOW_QUEUE_LEN)]
+        self.pending = threading.Semaphore(0)
+        if mode == "async":
+            threading.Thread(target=self.high_worker, daemon=True).start()
+            for _ in range(ASYNC_WORKERS - 1):
+                threading.Thread(target=self.worker, daemon=True).start()
+
+    def high_worker(self):
+        while True:
+            job = self.lanes[0].get()
+            time.sleep(job["cost"])
+            job["done"].set()
+
+    def worker(self):
+        while True:
+            self.pending.acquire()
+            for lane in self.lanes:
+                try:
+                    job = lane.get_nowait()
+                except queue.Empty:
+                    continue
+                time.sleep(job["cost"])
+                job["done"].set()
+                break
+
+
+class StubHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    disable_nagle_algorithm = True  # 头部和正文分两次写，避免与延迟确认叠加出 40ms 的假延迟
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def do_GET(self):
+        srv = self.server
+        is_api = self.path.startswith("/api/")
+        cost = srv.api_s if is_api else srv.static_s
+
+        if srv.mode == "single":
+            with srv.httpd_lock:
+                time.sleep(cost)
+        else:
+            job = {"cost": cost, "done": threading.Event()}
+            # 服务任务本身是串行的，分发只占很短的时间
+            with srv.httpd_lock:
+                try:
+                    srv.lanes[0 if is_api else 1].put_nowait(job)
+                except queue.Full:
+                    job = None
+            if job is None:
+                self.reply(503, b"busy", {"Retry-After": "1"})
+                return
+            srv.pending.release()
+            job["done"].wait()
+        self.reply(200, b"{}" if is_api else b"x" * 512)
+
+    def reply(self, status, body, headers=None):
+        self.send_response(status)
+        for key, value in (headers or {}).items():
+            self.send_header(key, value)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+
+def percentile(values, pct):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    index = min(len(values) - 1, int(round(pct / 100.0 * (len(values) - 1))))
+    return values[index]
+
+
+def client(url, paths, deadline, results, lock):
+    parsed = urllib.parse.urlparse(url)
+    conn = http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=10)
+    i = 0
+    while time.monotonic() < deadline:
+        path = paths[i % len(paths)]
+        i += 1
+        t0 = time.monotonic()
+        try:
+            conn.request("GET", path)
+            resp = conn.getresponse()
+            resp.read()
+            status = resp.status
+        except (OSError, http.client.HTTPException):
+            conn.close()
+            conn = http.client.HTTPConnection(parsed.hostname, parsed.port or 80, timeout=10)
+            status = 0
+        elapsed_ms = (time.monotonic() - t0) * 1000.0
+        with lock:
+            results.setdefault(path, []).append((status, elapsed_ms))
+    conn.close()
+
+
+def run(url, paths, clients, duration):
+    results = {}
+    lock = threading.Lock()
+    deadline = time.monotonic() + duration
+    threads = [threading.Thread(target=client, args=(url, paths, deadline, results, lock))
+               for _ in range(clients)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    print("%-20s %7s %6s %6s %9s %9s" % ("path", "count", "503", "error", "p50(ms)", "p99(ms)"))
+    for path in paths:
+        samples = results.get(path, [])
+        ok = [ms for status, ms in samples if status == 200]
+        busy = sum(1 for status, _ in samples if status == 503)
+        errors = sum(1 for status, _ in samples if status not in (200, 503))
+        print("%-20s %7d %6d %6d %9.1f %9.1f" % (path, len(samples), busy, errors,
+                                                  percentile(ok, 50), percentile(ok, 99)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="HTTP load test for the panel web server")
+    parser.add_argument("--url", default="http://192.168.4.1", help="target base URL")
+    parser.add_argument("--stub", choices=("single", "async"), help="run against a local stub server")
+    parser.add_argument("--clients", type=int, default=5, help="concurrent clients")
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds")
+    parser.add_argument("--static-ms", type=float, default=40.0, help="stub: static file cost")
+    parser.add_argument("--api-ms", type=float, default=1.0, help="stub: API cost")
+    parser.add_argument("paths", nargs="*", default=DEFAULT_PATHS)
+    args = parser.parse_args()
+
+    url = args.url
+    if args.stub:
+        server = StubServer(("127.0.0.1", 0), args.stub, args.static_ms, args.api_ms)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        url = "http://127.0.0.1:%d" % server.server_address[1]
+        print("stub server (%s) at %s" % (args.stub, url))
+
+    run(url, args.paths, args.clients, args.duration)
+
+
+if __name__ == "__main__":
+    main()
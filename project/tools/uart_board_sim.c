@@ -0,0 +1,486 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * 模拟主控板，测量面板串口协议库(lib/uart)的端到端延迟和吞吐，作为协议改动的回归基准。
+ *
+ *   cmake -S test -B build-host && cmake --build build-host && ./build-host/uart_board_sim
+ *   gcc -std=c11 -O2 -Wall -pthread -Ilib/uart -o uart_board_sim tools/uart_board_sim.c lib/uart/[a-z]*.c
+ *
+ *   ./uart_board_sim                               默认 115200 波特，依次以 10/100/400 Hz 上报，每档 3 秒
+ *   ./uart_board_sim -r 50,200 -t 5                指定上报频率列表和每档时长
+ *   ./uart_board_sim -e 1e-4 -d 1e-4 -k 0.01       注入误码(每位)、丢字节(每字节)和错误校验和(每帧)
+ *   ./uart_board_sim -p                            经伪终端(pty，原始模式)连接，默认为 socketpair
+ *
+ * 主控板在单独的线程中运行，只用 lib/uart 中无状态的组帧和编码函数(库中的接收队列、解析器都是全局的，
+ * 归面板一侧使用)。它按设定的频率生成 FN_UPDT_RUN_INFO_ALL 帧，按波特率限速写入连接(每字节10位)，
+ * 线路忙时新帧排队等待，与真实串口一样；面板一侧在主线程中读取、解析，在运行参数的通知函数中记录到达时间。
+ * 每帧的功率为 7000 W 加上帧计数除以 SIM_TAG_COUNT 的余数，面板据此找到该帧的生成时间，
+ * 其余字段由计数推算，用来发现校验和没有查出的误码。统计:
+ *   sent       生成的帧
+ *   delivered  面板收到且内容正确的帧
+ *   lost       没有收到的帧(全部写入线路后再等 SIM_DRAIN_S 秒)
+ *   corrupt    校验通过但内容错误的帧(v1 的8位累加和没有查出的误码)
+ *   badchk     面板统计的校验失败的帧
+ *   ovf        面板接收队列溢出丢弃的字节
+ *   fps / B/s  时长内收到的帧数和数据内容字节数(每秒)
+ *   line       发送期间线路的占用率
+ *   min/p50/p99/max  从生成到面板发布快照的延迟(微秒)，包括排队、线路传输和解析
+ *
+ * 没有注入故障的档位丢帧或收到错误内容时返回非零，可以直接作为回归测试运行。
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "panel_uart_api.h"
+#include "wire_codec.h"
+
+#define SIM_MAX_RATES               16
+#define SIM_TAG_COUNT               8192            // 帧标记的个数(在途的帧不能超过)
+#define SIM_TAG_POWER               7000.0f         // 标记 0 对应的功率(W)
+#define SIM_MAX_SAMPLES             (1u << 20)      // 记录延迟的帧数
+#define SIM_DRAIN_S                 0.5             // 结束发送后继续接收，让排队的帧到达
+#define SIM_SOCK_BUF                4096
+
+/**
+ * @brief   主控板线程的参数和统计
+ */
+typedef struct sim_board{
+    int fd;
+    double rate;                    // 上报频率(Hz)
+    double start;                   // 开始时间
+    double end;                     // 最后一个字节发完的时间
+    atomic_bool done;               // 全部帧已写入线路
+    uint32_t sent;                  // 生成的帧
+    uint32_t wire_bytes;            // 写到线路上的字节(丢字节之后)
+    uint32_t rx_bytes;              // 收到的面板发出的字节
+}sim_board_t;
+
+static double s_duration = 3.0;
+static uint32_t s_baud = 115200;
+static double s_ber = 0;
+static double s_drop = 0;
+static double s_bad_sum = 0;
+static bool s_use_pty = false;
+
+/* 主控板线程写入生成时间(纳秒)，面板一侧收到后清零 */
+static atomic_uint_least64_t s_tag_ns[SIM_TAG_COUNT];
+static uint32_t s_delivered = 0;
+static uint32_t s_delivered_in_time = 0;
+static uint32_t s_corrupt = 0;
+static double *s_latency_us = NULL;
+
+/**
+  * @brief  单调时钟(秒)
+  * @param  无
+  * @retval 秒
+  */
+static double sim_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+  * @brief  睡眠到指定时间
+  * @param  t 单调时钟(秒)
+  * @retval 无
+  */
+static void sim_sleep_until(double t)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)t;
+    ts.tv_nsec = (long)((t - (double)ts.tv_sec) * 1e9);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+/**
+  * @brief  第 n 帧的运行参数
+  * @param  n 帧计数
+  * @param  info 输出
+  * @retval 无
+  * @note   功率按 1 W、电压按 0.1 V、电流按 0.25 A 取值，在所有线上格式(包括定点数)中都能精确还原
+  */
+static void sim_running_info(uint32_t n, running_info_t *info)
+{
+    uint32_t tag = n % SIM_TAG_COUNT;
+
+    info->charge_status = 2;
+    info->power = SIM_TAG_POWER + (float)tag;
+    info->voltage = (float)(2280 + tag % 50) / 10.0f;
+    info->current = 30.0f + (float)(tag % 7) * 0.25f;
+    info->net_status = 1;
+}
+
+/**
+  * @brief  按误码率翻转一个字节中的位
+  * @param  byte 字节
+  * @param  seed 随机数状态
+  * @retval 传输后的字节
+  */
+static uint8_t sim_corrupt(uint8_t byte, unsigned short seed[3])
+{
+    if (s_ber > 0)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            if (erand48(seed) < s_ber)
+            {
+                byte ^= (uint8_t)(1u << bit);
+            }
+        }
+    }
+    return byte;
+}
+
+/**
+  * @brief  读出并丢弃面板发出的数据(握手、回复)，避免面板的发送阻塞
+  * @param  board 主控板
+  * @retval 无
+  */
+static void sim_board_drain(sim_board_t *board)
+{
+    uint8_t buf[256];
+    struct pollfd pfd = { .fd = board->fd, .events = POLLIN };
+    ssize_t len;
+
+    while (poll(&pfd, 1, 0) > 0 && (len = read(board->fd, buf, sizeof(buf))) > 0)
+    {
+        board->rx_bytes += (uint32_t)len;
+    }
+}
+
+/**
+  * @brief  主控板线程: 按频率生成运行参数帧，注入故障后按波特率写入线路
+  * @param  arg sim_board_t
+  * @retval NULL
+  */
+static void *sim_board_thread(void *arg)
+{
+    sim_board_t *board = arg;
+    unsigned short seed[3] = { 0x1234, 0x5678, (unsigned short)board->rate };
+    double byte_s = 10.0 / s_baud;
+    double line_t = board->start;
+    double gen_t;
+    running_info_t info;
+    uint8_t value[RUNNING_INFO_WIRE_LEN];
+    uint8_t frame[PROTOCOL_HEAD + RUNNING_INFO_WIRE_LEN + 1];
+    uint8_t out[sizeof(frame)];
+    uint16_t len;
+    uint32_t n;
+    uint32_t i;
+    uint32_t k;
+
+    for (n = 0; (gen_t = board->start + n / board->rate) < board->start + s_duration; n++)
+    {
+        sim_sleep_until(gen_t);
+        sim_running_info(n, &info);
+        len = uart_frame_pack(frame, FN_UPDT_RUN_INFO_ALL, value, running_info_encode(&info, value, sizeof(value)));
+        if (s_bad_sum > 0 && erand48(seed) < s_bad_sum)
+        {
+            frame[len - 1] ^= 0x5A;
+        }
+        for (i = 0, k = 0; i < len; i++)
+        {
+            if (s_drop > 0 && erand48(seed) < s_drop)
+            {
+                continue;
+            }
+            out[k++] = sim_corrupt(frame[i], seed);
+        }
+
+        /* 线路空闲时从生成时刻开始发送，否则排在上一帧之后；最后一个字节发完时整帧到达面板 */
+        if (line_t < gen_t)
+        {
+            line_t = gen_t;
+        }
+        line_t += k * byte_s;
+        atomic_store_explicit(&s_tag_ns[n % SIM_TAG_COUNT], (uint64_t)(gen_t * 1e9), memory_order_release);
+        sim_sleep_until(line_t);
+        if (write(board->fd, out, k) != (ssize_t)k)
+        {
+            break;
+        }
+        board->wire_bytes += k;
+        sim_board_drain(board);
+    }
+    board->sent = n;
+    board->end = line_t;
+    atomic_store(&board->done, true);
+    return NULL;
+}
+
+/**
+  * @brief  面板: 运行参数更新通知，记录延迟并检查内容
+  * @param  info 解码后的运行参数
+  * @retval 无
+  */
+static void sim_panel_listener(const running_info_t *info)
+{
+    running_info_t expect;
+    uint64_t now = (uint64_t)(sim_now() * 1e9);
+    uint64_t gen;
+    uint32_t tag;
+
+    if (info->power < SIM_TAG_POWER || info->power >= SIM_TAG_POWER + SIM_TAG_COUNT)
+    {
+        s_corrupt++;
+        return;
+    }
+    tag = (uint32_t)(info->power - SIM_TAG_POWER);
+    sim_running_info(tag, &expect);
+    gen = atomic_exchange_explicit(&s_tag_ns[tag], 0, memory_order_acquire);
+    if (gen == 0 || running_info_diff(&expect, info) != 0)
+    {
+        s_corrupt++;
+        return;
+    }
+    if (s_delivered < SIM_MAX_SAMPLES)
+    {
+        s_latency_us[s_delivered] = (double)(now - gen) / 1000.0;
+    }
+    s_delivered++;
+}
+
+/**
+  * @brief  建立主控板与面板之间的连接
+  * @param  board_fd 输出: 主控板一端
+  * @param  panel_fd 输出: 面板一端
+  * @retval 是否成功
+  * @note   pty 设为原始模式，面板一端相当于串口设备文件
+  */
+static bool sim_connect(int *board_fd, int *panel_fd)
+{
+    int sv[2];
+    int size = SIM_SOCK_BUF;
+    struct termios tio;
+
+    if (!s_use_pty)
+    {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        {
+            return false;
+        }
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(sv[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        *board_fd = sv[0];
+        *panel_fd = sv[1];
+    }
+    else
+    {
+        *board_fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (*board_fd < 0 || grantpt(*board_fd) != 0 || unlockpt(*board_fd) != 0)
+        {
+            return false;
+        }
+        *panel_fd = open(ptsname(*board_fd), O_RDWR | O_NOCTTY);
+        if (*panel_fd < 0)
+        {
+            return false;
+        }
+        tcgetattr(*panel_fd, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(*panel_fd, TCSANOW, &tio);
+    }
+    return true;
+}
+
+/**
+  * @brief  比较两个延迟(qsort)
+  * @param  a 延迟
+  * @param  b 延迟
+  * @retval 比较结果
+  */
+static int sim_cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+  * @brief  以一个上报频率运行一次
+  * @param  rate 上报频率(Hz)
+  * @retval 是否通过(注入故障时总是通过)
+  */
+static bool sim_run(double rate)
+{
+    sim_board_t board = { .rate = rate };
+    pthread_t thread;
+    int panel_fd;
+    uint8_t chunk[256];
+    struct pollfd pfd = { .events = POLLIN };
+    link_stats_t stats;
+    uint32_t overflow;
+    uint32_t n;
+    uint32_t lost;
+    double now;
+    double end = 0;
+    bool faults = (s_ber > 0) || (s_drop > 0) || (s_bad_sum > 0);
+    ssize_t len;
+
+    if (!sim_connect(&board.fd, &panel_fd))
+    {
+        perror("connect");
+        return false;
+    }
+    for (n = 0; n < SIM_TAG_COUNT; n++)
+    {
+        atomic_store(&s_tag_ns[n], 0);
+    }
+    s_delivered = s_delivered_in_time = s_corrupt = 0;
+
+    /* 主控板一般是 v1 固件，面板只用 v1 帧，不发握手 */
+    mcu_uart_link_max_version_set(LINK_VERSION_V1);
+    mcu_uart_protocol_init();
+    uart_transmit_set_fd(panel_fd);
+    running_info_listener_register(sim_panel_listener);
+    overflow = uart_rx_overflow_count();
+
+    board.start = sim_now() + 0.01;
+    pthread_create(&thread, NULL, sim_board_thread, &board);
+    pfd.fd = panel_fd;
+    /* 上报频率超过线路容量时帧在主控板排队，发送会持续到时长之后，等全部写完再收尾 */
+    while ((now = sim_now()) < board.start + s_duration + SIM_DRAIN_S || end == 0 || now < end)
+    {
+        if (end == 0 && atomic_load(&board.done))
+        {
+            end = now + SIM_DRAIN_S;
+        }
+        if (poll(&pfd, 1, 1) > 0)
+        {
+            len = read(panel_fd, chunk, sizeof(chunk));
+            if (len > 0)
+            {
+                uart_receive_buff_input(chunk, (unsigned short)len);
+            }
+        }
+        mcu_uart_service();
+        mcu_uart_tx_service();
+        if (now < board.start + s_duration)
+        {
+            s_delivered_in_time = s_delivered;
+        }
+    }
+    pthread_join(thread, NULL);
+    running_info_listener_register(NULL);
+    mcu_uart_link_stats_get(&stats);
+    close(panel_fd);
+    close(board.fd);
+
+    lost = board.sent - s_delivered;
+    printf("%8.0f %8lu %9lu %6lu %7lu %6lu %6lu %8.1f %8.0f %5.1f%%", rate, (unsigned long)board.sent,
+           (unsigned long)s_delivered, (unsigned long)lost, (unsigned long)s_corrupt,
+           (unsigned long)stats.rx_bad_check, (unsigned long)(uart_rx_overflow_count() - overflow),
+           s_delivered_in_time / s_duration, s_delivered_in_time * (double)RUNNING_INFO_WIRE_LEN / s_duration,
+           100.0 * board.wire_bytes / (board.end - board.start) / (s_baud / 10.0));
+    n = (s_delivered < SIM_MAX_SAMPLES) ? s_delivered : SIM_MAX_SAMPLES;
+    if (n > 0)
+    {
+        qsort(s_latency_us, n, sizeof(s_latency_us[0]), sim_cmp_double);
+        printf(" %8.0f %8.0f %8.0f %8.0f\n", s_latency_us[0], s_latency_us[n / 2], s_latency_us[(n * 99) / 100],
+               s_latency_us[n - 1]);
+    }
+    else
+    {
+        printf(" %8s %8s %8s %8s\n", "-", "-", "-", "-");
+    }
+    return faults || (lost == 0 && s_corrupt == 0 && board.sent > 0);
+}
+
+int main(int argc, char *argv[])
+{
+    double rate[SIM_MAX_RATES] = { 10, 100, 400 };
+    int rate_count = 3;
+    bool pass = true;
+    char *tok;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:d:e:k:pr:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            s_baud = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            s_drop = strtod(optarg, NULL);
+            break;
+        case 'e':
+            s_ber = strtod(optarg, NULL);
+            break;
+        case 'k':
+            s_bad_sum = strtod(optarg, NULL);
+            break;
+        case 'p':
+            s_use_pty = true;
+            break;
+        case 'r':
+            rate_count = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && rate_count < SIM_MAX_RATES; tok = strtok(NULL, ","))
+            {
+                rate[rate_count++] = strtod(tok, NULL);
+            }
+            break;
+        case 't':
+            s_duration = strtod(optarg, NULL);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-d drop] [-e ber] [-k bad_sum] [-p] [-r hz,hz,...] [-t seconds]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (s_baud == 0 || s_duration <= 0)
+    {
+        fprintf(stderr, "baud and duration must be positive\n");
+        return 1;
+    }
+    for (int i = 0; i < rate_count; i++)
+    {
+        if (rate[i] <= 0)
+        {
+            fprintf(stderr, "rate must be positive\n");
+            return 1;
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    s_latency_us = malloc(SIM_MAX_SAMPLES * sizeof(*s_latency_us));
+    if (s_latency_us == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    printf("baud %lu, %s, %u-byte run info frames, %.1f s per rate, ber %g, drop %g, bad checksum %g\n",
+           (unsigned long)s_baud, s_use_pty ? "pty" : "socketpair", PROTOCOL_HEAD + RUNNING_INFO_WIRE_LEN + 1,
+           s_duration, s_ber, s_drop, s_bad_sum);
+    printf("%8s %8s %9s %6s %7s %6s %6s %8s %8s %6s %8s %8s %8s %8s\n", "rate_hz", "sent", "delivered", "lost",
+           "corrupt", "badchk", "ovf", "fps", "B/s", "line", "min_us", "p50_us", "p99_us", "max_us");
+    for (int i = 0; i < rate_count; i++)
+    {
+        pass = sim_run(rate[i]) && pass;
+    }
+    free(s_latency_us);
+    return pass ? 0 : 1;
+}
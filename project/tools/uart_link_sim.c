@@ -0,0 +1,658 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * 主控板串口链路仿真：比较 v1 帧(8位累加和)和 v2 帧(CRC-16、序号、确认、重发)在误码下的有效吞吐。
+ *
+ *   gcc -std=c11 -O2 -Wall -Ilib/uart -o uart_link_sim tools/uart_link_sim.c lib/uart/[a-z]*.c
+ *   ./uart_link_sim                                    默认 115200 波特，每个误码率运行 3 秒
+ *   ./uart_link_sim -e 0,1e-5,1e-4,5e-4 -t 5 -l 32     指定误码率列表、时长、数据内容长度
+ *
+ * 两个端点各在一个子进程中运行 lib/uart(库中的接收队列、解析器、链路都是全局的)，
+ * 父进程在两者之间转发字节：按波特率限速(每字节10位)，并按误码率随机翻转每一位。
+ * 发送端不停地发送测试帧，接收端统计:
+ *   delivered  校验通过且内容正确、第一次收到的帧
+ *   lost       发送端结束后再等 SIM_DRAIN_S 秒，计数小于收到的最大计数、却始终没有收到的帧
+ *   failed     v2 发送端重发次数用尽而放弃的帧
+ *   dup        重复收到的帧(v2 重发后确认丢失)
+ *   corrupt    校验通过但内容错误的帧(校验没有查出的误码，交给了上层)
+ *   goodput    时长内 delivered 的数据内容字节数 / 时长
+ *   eff        goodput 占线路速率(波特率/10)的比例
+ *
+ *   ./uart_link_sim -c -e 0,1e-4 -t 5                  参数配置下发的延迟
+ *
+ * -c 时一端模拟面板，不停地下发参数配置(mcu_param_config_apply，上一次结束后再下发下一次)，
+ * 另一端模拟主控板，应用后回复序号+结果，同时以 SIM_RUN_INFO_HZ 上报运行信息作为背景流量。
+ * 统计从开始下发到收到确认的时间(网页上点击保存到请求返回的时间减去 HTTP 部分):
+ *   applies    开始的下发次数
+ *   ok/rej/tmo 确认、拒绝、超时(PARAM_APPLY_TIMEOUT_MS)的次数
+ *   min/p50/p99/max  确认的延迟(毫秒)
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "panel_uart_api.h"
+#include "wire_codec.h"
+
+#define SIM_FN                      0x20            // 测试帧功能码
+#define SIM_HDR_LEN                 8               // 计数4 + 校验4
+#define SIM_SEEN_BITS               (1u << 24)      // 去重位图
+#define SIM_RELAY_QUEUE             4096            // 每个方向的转发队列(相当于驱动层缓冲区)
+#define SIM_SOCK_BUF                4096
+#define SIM_MAX_BER                 16
+#define SIM_DRAIN_S                 1.0             // 结束发送后继续运行，让重发和积压的帧到达
+#define SIM_MAX_APPLY               4096            // -c: 记录延迟的下发次数
+#define SIM_APPLY_SETTLE_S          0.3             // -c: 开始下发之前等待握手完成
+#define SIM_APPLY_GAP_S             0.02            // -c: 上一次结束到下一次下发的间隔
+#define SIM_RUN_INFO_HZ             10              // -c: 主控板上报运行信息的频率
+
+/**
+ * @brief   一次运行的结果(父子进程共享)
+ */
+typedef struct sim_result{
+    uint32_t sent;                  // 发送端: 放入发送队列的测试帧
+    uint32_t delivered;             // 接收端(包括结束发送后到达的)
+    uint32_t delivered_in_time;     // 接收端: 时长内到达的
+    uint32_t highest;               // 接收端: 收到的最大计数 + 1
+    uint32_t dup;
+    uint32_t corrupt;
+    uint32_t bad_check;             // 接收端: 校验失败的帧
+    link_stats_t tx_link;           // 发送端链路统计
+    uint8_t version;                // 发送端结束时的协议版本
+    uint32_t applies;               // -c: 开始的下发次数
+    uint32_t apply_ok;              // -c: 确认次数
+    uint32_t apply_rejected;        // -c: 拒绝次数
+    uint32_t apply_timeouts;        // -c: 超时次数
+    double apply_ms[SIM_MAX_APPLY]; // -c: 每次确认的延迟
+}sim_result_t;
+
+/**
+ * @brief   转发方向
+ */
+typedef struct sim_pipe{
+    int src;
+    int dst;
+    uint8_t queue[SIM_RELAY_QUEUE];
+    uint32_t head;
+    uint32_t count;
+    double line_t;                  // 线路空闲的时间
+    bool src_eof;
+}sim_pipe_t;
+
+static double s_duration = 3.0;
+static uint32_t s_baud = 115200;
+static uint8_t s_payload_len = 64;
+static sim_result_t *s_result = NULL;
+static uint8_t *s_seen = NULL;
+static bool s_apply_mode = false;
+static bool s_apply_busy = false;
+static double s_apply_start = 0;
+static double s_apply_next = 0;
+
+/**
+  * @brief  单调时钟(秒)
+  * @param  无
+  * @retval 秒
+  */
+static double sim_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+  * @brief  FNV-1a
+  * @param  buf 数据
+  * @param  len 长度
+  * @retval 散列值
+  */
+static uint32_t sim_fnv(const uint8_t *buf, uint32_t len)
+{
+    uint32_t h = 2166136261u;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        h = (h ^ buf[i]) * 16777619u;
+    }
+    return h;
+}
+
+/**
+  * @brief  生成第 n 个测试帧的数据内容
+  * @param  buf 输出，s_payload_len 字节
+  * @param  n 计数
+  * @retval 无
+  * @note   格式: 计数(4) + FNV(计数和填充)(4) + 填充
+  */
+static void sim_payload(uint8_t *buf, uint32_t n)
+{
+    uint32_t x = n * 2654435761u;
+
+    wire_put_u32(buf, n);
+    for (uint32_t i = SIM_HDR_LEN; i < s_payload_len; i++)
+    {
+        x = x * 1103515245u + 12345u;
+        buf[i] = (uint8_t)(x >> 16);
+    }
+    wire_put_u32(buf + 4, sim_fnv(buf, 4) ^ sim_fnv(buf + SIM_HDR_LEN, s_payload_len - SIM_HDR_LEN));
+}
+
+/**
+  * @brief  接收端: 测试帧处理函数
+  * @param  value 数据内容
+  * @param  len 数据内容长度
+  * @retval 无
+  */
+static void sim_frame_handle(const uint8_t *value, uint8_t len)
+{
+    uint8_t expect[UART_MAX_DATA_LEN];
+    uint32_t n;
+
+    if (len != s_payload_len)
+    {
+        s_result->corrupt++;
+        return;
+    }
+    n = wire_get_u32(value);
+    sim_payload(expect, n);
+    if (memcmp(expect, value, len) != 0)
+    {
+        s_result->corrupt++;
+        return;
+    }
+    n &= SIM_SEEN_BITS - 1;
+    if (s_seen[n >> 3] & (1u << (n & 7)))
+    {
+        s_result->dup++;
+        return;
+    }
+    s_seen[n >> 3] |= (uint8_t)(1u << (n & 7));
+    s_result->delivered++;
+    if (wire_get_u32(value) >= s_result->highest)
+    {
+        s_result->highest = wire_get_u32(value) + 1;
+    }
+}
+
+/**
+  * @brief  -c 面板: 下发完成回调
+  * @param  ctx 未使用
+  * @param  result 最终结果
+  * @param  status 主控板回复的结果
+  * @param  latency_ms 库统计的延迟(毫秒精度，这里用更精确的 sim_now)
+  * @retval 无
+  */
+static void sim_apply_done(void *ctx, param_apply_result_t result, uint8_t status, uint32_t latency_ms)
+{
+    double now = sim_now();
+
+    (void)ctx;
+    (void)status;
+    (void)latency_ms;
+    if (result == PARAM_APPLY_DONE_OK)
+    {
+        if (s_result->apply_ok < SIM_MAX_APPLY)
+        {
+            s_result->apply_ms[s_result->apply_ok] = (now - s_apply_start) * 1000.0;
+        }
+        s_result->apply_ok++;
+    }
+    else if (result == PARAM_APPLY_DONE_REJECTED)
+    {
+        s_result->apply_rejected++;
+    }
+    else
+    {
+        s_result->apply_timeouts++;
+    }
+    s_apply_busy = false;
+    s_apply_next = now + SIM_APPLY_GAP_S;
+}
+
+/**
+  * @brief  -c 面板: 上一次结束后开始下一次下发
+  * @param  now 当前时间
+  * @retval 无
+  * @note   在 16A/32A、230V/240V 之间交替，每次下发两个字段
+  */
+static void sim_apply_click(double now)
+{
+    param_config_t config;
+
+    if (s_apply_busy || now < s_apply_next)
+    {
+        return;
+    }
+    param_config_read(&config);
+    config.maxcc = (config.maxcc == 16) ? 32 : 16;
+    config.ov_threshold = (config.maxcc == 16) ? 230.0f : 240.0f;
+    config.uv_threshold = 180.0f;
+    s_apply_start = now;
+    if (mcu_param_config_apply(&config, sim_apply_done, NULL) == PARAM_APPLY_STARTED)
+    {
+        s_apply_busy = true;
+        s_result->applies++;
+    }
+}
+
+/**
+  * @brief  -c 主控板: 应用参数配置并回复
+  * @param  value 数据内容: 序号 + 变化字段的记录
+  * @param  len 数据内容长度
+  * @retval 无
+  */
+static void sim_config_handle(const uint8_t *value, uint8_t len)
+{
+    param_config_t config;
+    uint32_t dirty;
+    uint8_t ack[PARAM_APPLY_ACK_LEN] = { value[0], PARAM_APPLY_STATUS_OK };
+
+    param_config_read(&config);
+    if (param_config_delta_apply(value + 1, len - 1, &config, &dirty))
+    {
+        param_config_publish(&config);
+    }
+    else
+    {
+        ack[1] = 0x01;
+    }
+    mcu_fnum_data_update(FN_UPDT_PRAM_CONFIG, ack, sizeof(ack));
+}
+
+/**
+  * @brief  -c 主控板: 上报一帧运行信息
+  * @param  n 计数
+  * @retval 无
+  */
+static void sim_run_info_send(uint32_t n)
+{
+    running_info_t info = {
+        .charge_status = 2,
+        .power = 7000.0f + (float)(n % 50),
+        .voltage = 230.0f,
+        .current = 30.4f,
+        .net_status = 1,
+    };
+    uint8_t buf[RUNNING_INFO_WIRE_LEN];
+
+    mcu_fnum_data_update(FN_UPDT_RUN_INFO_ALL, buf, running_info_encode(&info, buf, sizeof(buf)));
+}
+
+/**
+  * @brief  端点进程
+  * @param  fd 与转发进程相连的套接字
+  * @param  version 最高协议版本
+  * @param  sender 是否为发送端
+  * @retval 无(退出进程)
+  */
+static void sim_endpoint(int fd, uint8_t version, bool sender)
+{
+    uint8_t chunk[256];
+    uint8_t payload[UART_MAX_DATA_LEN];
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    double start = sim_now();
+    double now = start;
+    uint32_t n = 0;
+    link_stats_t stats;
+    ssize_t len;
+
+    mcu_uart_link_max_version_set(version);
+    mcu_uart_protocol_init();
+    uart_transmit_set_fd(fd);
+    mcu_fnum_handler_register(SIM_FN, sim_frame_handle, s_payload_len, s_payload_len);
+    if (s_apply_mode && !sender)
+    {
+        mcu_fnum_handler_register(FN_UPDT_PRAM_CONFIG, sim_config_handle, 1, UART_MAX_DATA_LEN);
+    }
+    if (!sender)
+    {
+        s_seen = calloc(SIM_SEEN_BITS / 8, 1);
+    }
+
+    while ((now = sim_now()) < start + s_duration + SIM_DRAIN_S)
+    {
+        if (poll(&pfd, 1, 1) > 0)
+        {
+            len = read(fd, chunk, sizeof(chunk));
+            if (len <= 0)
+            {
+                break;
+            }
+            uart_receive_buff_input(chunk, (unsigned short)len);
+        }
+        mcu_uart_service();
+        if (now < start + s_duration)
+        {
+            s_result->delivered_in_time = s_result->delivered;
+        }
+        if (s_apply_mode && now < start + s_duration)
+        {
+            if (sender && now >= start + SIM_APPLY_SETTLE_S)
+            {
+                sim_apply_click(now);
+            }
+            else if (!sender && now >= start + (double)n / SIM_RUN_INFO_HZ)
+            {
+                sim_run_info_send(n++);
+            }
+        }
+        else if (sender && now < start + s_duration)
+        {
+            sim_payload(payload, n);
+            while (mcu_fnum_data_update(SIM_FN, payload, s_payload_len))
+            {
+                sim_payload(payload, ++n);
+            }
+        }
+        mcu_uart_tx_service();
+    }
+
+    mcu_uart_link_stats_get(&stats);
+    if (sender)
+    {
+        s_result->sent = n;
+        s_result->tx_link = stats;
+        s_result->version = mcu_uart_link_version();
+    }
+    else
+    {
+        s_result->bad_check = stats.rx_bad_check;
+    }
+    _exit(0);
+}
+
+/**
+  * @brief  按误码率翻转一个字节中的位
+  * @param  byte 字节
+  * @param  ber 误码率
+  * @retval 传输后的字节
+  */
+static uint8_t sim_corrupt(uint8_t byte, double ber)
+{
+    if (ber > 0)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            if (drand48() < ber)
+            {
+                byte ^= (uint8_t)(1u << bit);
+            }
+        }
+    }
+    return byte;
+}
+
+/**
+  * @brief  转发: 从 src 读入转发队列(加误码)
+  * @param  p 方向
+  * @param  ber 误码率
+  * @retval 无
+  */
+static void sim_relay_read(sim_pipe_t *p, double ber)
+{
+    uint8_t chunk[512];
+    uint32_t room = SIM_RELAY_QUEUE - p->count;
+    ssize_t len = read(p->src, chunk, (room < sizeof(chunk)) ? room : sizeof(chunk));
+
+    if (len <= 0)
+    {
+        p->src_eof = true;
+        return;
+    }
+    for (ssize_t i = 0; i < len; i++)
+    {
+        p->queue[(p->head + p->count) % SIM_RELAY_QUEUE] = sim_corrupt(chunk[i], ber);
+        p->count++;
+    }
+}
+
+/**
+  * @brief  转发: 按波特率把队列中的字节写到 dst
+  * @param  p 方向
+  * @param  now 当前时间
+  * @retval 无
+  */
+static void sim_relay_write(sim_pipe_t *p, double now)
+{
+    double byte_s = 10.0 / s_baud;
+    uint8_t out[512];
+    uint32_t n = 0;
+
+    if (p->count == 0)
+    {
+        p->line_t = now;
+        return;
+    }
+    while (p->count > 0 && n < sizeof(out) && p->line_t + byte_s <= now)
+    {
+        out[n++] = p->queue[p->head];
+        p->head = (p->head + 1) % SIM_RELAY_QUEUE;
+        p->count--;
+        p->line_t += byte_s;
+    }
+    if (n > 0 && p->dst >= 0 && write(p->dst, out, n) < 0)
+    {
+        p->dst = -1;                // 端点已退出，之后的数据丢弃
+    }
+}
+
+/**
+  * @brief  比较两个延迟(qsort)
+  * @param  a 延迟
+  * @param  b 延迟
+  * @retval 比较结果
+  */
+static int sim_cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+  * @brief  -c: 打印一次运行的下发延迟
+  * @param  version 协议版本
+  * @param  ber 误码率
+  * @retval 无
+  */
+static void sim_print_apply(uint8_t version, double ber)
+{
+    sim_result_t *r = &s_result[0];
+    uint32_t n = (r->apply_ok < SIM_MAX_APPLY) ? r->apply_ok : SIM_MAX_APPLY;
+
+    printf("%-8.0e v%u%s %8lu %6lu %6lu %6lu", ber, version, (r->version == version) ? " " : "*",
+           (unsigned long)r->applies, (unsigned long)r->apply_ok, (unsigned long)r->apply_rejected,
+           (unsigned long)r->apply_timeouts);
+    if (n == 0)
+    {
+        printf(" %8s %8s %8s %8s\n", "-", "-", "-", "-");
+        return;
+    }
+    qsort(r->apply_ms, n, sizeof(r->apply_ms[0]), sim_cmp_double);
+    printf(" %8.2f %8.2f %8.2f %8.2f\n", r->apply_ms[0], r->apply_ms[n / 2], r->apply_ms[(n * 99) / 100],
+           r->apply_ms[n - 1]);
+}
+
+/**
+  * @brief  运行一次仿真
+  * @param  version 协议版本
+  * @param  ber 误码率
+  * @param  seed 随机数种子
+  * @retval 无
+  */
+static void sim_run(uint8_t version, double ber, long seed)
+{
+    int sa[2];
+    int sb[2];
+    int size = SIM_SOCK_BUF;
+    pid_t pa;
+    pid_t pb;
+    sim_pipe_t *ab = calloc(1, sizeof(*ab));
+    sim_pipe_t *ba = calloc(1, sizeof(*ba));
+    double goodput;
+    uint32_t lost;
+
+    memset(s_result, 0, 2 * sizeof(*s_result));
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sa);
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sb);
+    for (int i = 0; i < 2; i++)
+    {
+        setsockopt(sa[i], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(sb[i], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+
+    if ((pa = fork()) == 0)
+    {
+        close(sa[0]);
+        close(sb[0]);
+        close(sb[1]);
+        s_result = &s_result[0];
+        sim_endpoint(sa[1], version, true);
+    }
+    if ((pb = fork()) == 0)
+    {
+        close(sb[0]);
+        close(sa[0]);
+        close(sa[1]);
+        s_result = &s_result[1];
+        sim_endpoint(sb[1], version, false);
+    }
+    close(sa[1]);
+    close(sb[1]);
+
+    srand48(seed);
+    ab->src = sa[0];
+    ab->dst = sb[0];
+    ba->src = sb[0];
+    ba->dst = sa[0];
+    ab->line_t = ba->line_t = sim_now();
+    while (!ab->src_eof || !ba->src_eof)
+    {
+        struct pollfd pfd[2] = {
+            { .fd = ab->src_eof ? -1 : ab->src, .events = (ab->count < SIM_RELAY_QUEUE) ? POLLIN : 0 },
+            { .fd = ba->src_eof ? -1 : ba->src, .events = (ba->count < SIM_RELAY_QUEUE) ? POLLIN : 0 },
+        };
+
+        if (poll(pfd, 2, 1) > 0)
+        {
+            if (pfd[0].revents & (POLLIN | POLLHUP))
+            {
+                sim_relay_read(ab, ber);
+            }
+            if (pfd[1].revents & (POLLIN | POLLHUP))
+            {
+                sim_relay_read(ba, ber);
+            }
+        }
+        sim_relay_write(ab, sim_now());
+        sim_relay_write(ba, sim_now());
+    }
+    waitpid(pa, NULL, 0);
+    waitpid(pb, NULL, 0);
+    close(sa[0]);
+    close(sb[0]);
+    free(ab);
+    free(ba);
+
+    if (s_apply_mode)
+    {
+        sim_print_apply(version, ber);
+        return;
+    }
+    goodput = (double)s_result[1].delivered_in_time * s_payload_len / s_duration;
+    lost = s_result[1].highest - s_result[1].delivered;
+    printf("%-8.0e v%u%s %8lu %9lu %6lu %6lu %6lu %7lu %6lu %8lu %9.0f %5.1f%%\n", ber, version,
+           (s_result[0].version == version) ? " " : "*", (unsigned long)s_result[0].sent,
+           (unsigned long)s_result[1].delivered, (unsigned long)lost, (unsigned long)s_result[0].tx_link.tx_failed,
+           (unsigned long)s_result[1].dup,
+           (unsigned long)s_result[1].corrupt, (unsigned long)s_result[1].bad_check,
+           (unsigned long)s_result[0].tx_link.tx_retransmits, goodput, 100.0 * goodput / (s_baud / 10.0));
+}
+
+int main(int argc, char *argv[])
+{
+    double ber[SIM_MAX_BER] = { 0, 1e-5, 1e-4, 3e-4, 1e-3 };
+    int ber_count = 5;
+    long seed = 1;
+    char *tok;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:ce:l:s:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            s_baud = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            s_apply_mode = true;
+            break;
+        case 'e':
+            ber_count = 0;
+            for (tok = strtok(optarg, ","); tok != NULL && ber_count < SIM_MAX_BER; tok = strtok(NULL, ","))
+            {
+                ber[ber_count++] = strtod(tok, NULL);
+            }
+            break;
+        case 'l':
+            s_payload_len = (uint8_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            seed = strtol(optarg, NULL, 0);
+            break;
+        case 't':
+            s_duration = strtod(optarg, NULL);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-c] [-e ber,ber,...] [-l payload_len] [-s seed] [-t seconds]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (s_payload_len < SIM_HDR_LEN || s_baud == 0 || s_duration <= 0)
+    {
+        fprintf(stderr, "payload length must be %d..255\n", SIM_HDR_LEN);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    s_result = mmap(NULL, 2 * sizeof(*s_result), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (s_result == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+
+    printf("baud %lu, payload %u bytes, %.1f s per run (* = link fell back to v1)\n", (unsigned long)s_baud,
+           s_payload_len, s_duration);
+    if (s_apply_mode)
+    {
+        printf("%-8s %-3s %8s %6s %6s %6s %8s %8s %8s %8s\n", "ber", "ver", "applies", "ok", "rej", "tmo",
+               "min_ms", "p50_ms", "p99_ms", "max_ms");
+    }
+    else
+    {
+        printf("%-8s %-3s %8s %9s %6s %6s %6s %7s %6s %8s %9s %6s\n", "ber", "ver", "sent", "delivered", "lost",
+               "failed", "dup", "corrupt", "badchk", "retrans", "goodput", "eff");
+    }
+    for (int i = 0; i < ber_count; i++)
+    {
+        sim_run(LINK_VERSION_V1, ber[i], seed + i);
+        sim_run(LINK_VERSION_V2, ber[i], seed + i);
+    }
+    return 0;
+}
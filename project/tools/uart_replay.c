@@ -0,0 +1,528 @@
+/*
+ * EVCharger Panel Project
+ * Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+ *
+ * 串口收发记录离线回放：把 /api/diag/uart-capture 下载的 pcap 文件中面板收到的数据
+ * 按原样送进 lib/uart(接收队列、解析器、功能码表)，用于复现现场问题和测量解析开销。
+ *
+ *   gcc -std=c11 -O2 -Wall -Ilib/uart -o uart_replay tools/uart_replay.c lib/uart/[a-z]*.c
+ *   ./uart_replay uart.pcap                 全速回放，统计各功能码的帧数和每字节耗时
+ *   ./uart_replay -r uart.pcap              按记录的时间间隔回放(复现解析器空闲超时等时序问题)
+ *   ./uart_replay -n 100 uart.pcap          重复回放 100 遍，用于测量吞吐
+ *   ./uart_replay -v uart.pcap              同时按十六进制打印每条记录(收发两个方向)
+ *   ./uart_replay -g trace.pcap -c 20000    生成一段充电过程的模拟记录(经过 lib/uart 的记录缓冲区)
+ *   ./uart_replay -g delta.pcap -D          同一段充电过程，运行参数改用增量帧发送
+ *
+ * 比较全量帧和增量帧: 分别生成两份记录后回放，对比线上字节率(wire)、每次更新的解析耗时和
+ * 每次更新中真正变化的字段数(状态推送、历史采样据此跳过没有变化的字段)。
+ *
+ * 回放时串口时钟取记录的时间戳，解析器的空闲超时与现场一致；面板发出的帧(回复、握手)丢弃。
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "panel_uart_api.h"
+#include "wire_codec.h"
+
+#define REPLAY_RFID_SWIPE_LEN       6               // 卡号4 + 当天2
+#define REPLAY_ALARM_REPORT_LEN     7
+#define REPLAY_GEN_CAPTURE_LEN      (4u << 20)      // -g 使用的记录缓冲区
+#define REPLAY_GEN_INTERVAL_US      100000          // -g 运行参数的上报周期
+#define REPLAY_GEN_FULL_EVERY       10              // -D 每隔多少个周期发送一次全量帧(重新同步)
+
+/**
+ * @brief   pcap 文件中的一条记录
+ */
+typedef struct replay_record{
+    uint64_t us;                    // 时间戳
+    uint8_t dir;                    // CAPTURE_DIR_xxx
+    uint32_t len;                   // 数据长度(不含方向字节)
+    uint32_t orig_len;              // 原始长度(不含方向字节)
+    const uint8_t *data;
+}replay_record_t;
+
+static uint32_t s_frames[256];
+static uint32_t s_updates = 0;                  // 运行参数更新次数(全量帧和增量帧)
+static uint32_t s_updates_clean = 0;            // 其中没有任何字段变化的次数
+static uint32_t s_dirty_fields = 0;             // 累计变化的字段数
+static uint32_t s_seen_version = 0;
+static uint32_t s_rand = 1;
+static uint64_t s_now_us = 0;
+static uint64_t s_gen_us = 0;
+
+/**
+ * @brief  回放时钟(毫秒)
+ * @param  Null
+ * @return 当前记录的时间
+ */
+static uint32_t replay_clock(void)
+{
+    return (uint32_t)(s_now_us / 1000u);
+}
+
+/**
+ * @brief  -g 模拟记录的时钟(微秒)
+ * @param  Null
+ * @return 模拟时间
+ */
+static uint64_t replay_gen_clock(void)
+{
+    return s_gen_us;
+}
+
+/**
+ * @brief  丢弃面板发出的帧
+ * @param  buf 帧数据
+ * @param  len 帧长度
+ * @return 无
+ */
+static void replay_tx_discard(const uint8_t *buf, uint16_t len)
+{
+    (void)buf;
+    (void)len;
+}
+
+/**
+ * @brief  功能码处理: 只计数
+ * @param  value 数据内容
+ * @param  len 数据内容长度
+ * @return 无
+ */
+static void replay_count_rfid(const uint8_t *value, uint8_t len)
+{
+    (void)value;
+    (void)len;
+    s_frames[FN_UPDT_RFID_CARD] ++;
+}
+
+static void replay_count_alarm(const uint8_t *value, uint8_t len)
+{
+    (void)value;
+    (void)len;
+    s_frames[FN_UPDT_ALARM_RECORD] ++;
+}
+
+static void replay_count_running_info(const running_info_t *info)
+{
+    uint32_t dirty = running_info_changed(s_seen_version);
+
+    (void)info;
+    s_seen_version = running_info_version();
+    s_updates ++;
+    if(0 == dirty) {
+        s_updates_clean ++;
+    }
+    for(; dirty != 0; dirty &= dirty - 1) {
+        s_dirty_fields ++;
+    }
+}
+
+/**
+ * @brief  当前时间
+ * @param  Null
+ * @return 秒
+ */
+static double replay_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief  读入整个文件
+ * @param  path 文件路径
+ * @param  len 输出: 文件长度
+ * @return 文件内容，失败返回 NULL
+ */
+static uint8_t *replay_load(const char *path, uint32_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    uint8_t *buf = NULL;
+    long size;
+
+    if(NULL == fp) {
+        perror(path);
+        return NULL;
+    }
+    if((0 == fseek(fp, 0, SEEK_END)) && ((size = ftell(fp)) >= 0) && (0 == fseek(fp, 0, SEEK_SET))) {
+        buf = malloc(size > 0 ? (size_t)size : 1);
+        if((NULL != buf) && (fread(buf, 1, (size_t)size, fp) != (size_t)size)) {
+            free(buf);
+            buf = NULL;
+        }
+        *len = (uint32_t)size;
+    }
+    fclose(fp);
+    if(NULL == buf) {
+        fprintf(stderr, "%s: read failed\n", path);
+    }
+    return buf;
+}
+
+/**
+ * @brief  检查 pcap 文件头
+ * @param  file 文件内容
+ * @param  len 文件长度
+ * @return 是否为收发记录
+ */
+static bool replay_check_header(const uint8_t *file, uint32_t len)
+{
+    if(len < CAPTURE_FILE_HEAD_LEN) {
+        fprintf(stderr, "file too short\n");
+        return false;
+    }
+    if(wire_get_u32(file) != CAPTURE_PCAP_MAGIC) {
+        fprintf(stderr, "not a little-endian microsecond pcap file\n");
+        return false;
+    }
+    if(wire_get_u32(file + 20) != CAPTURE_LINKTYPE) {
+        fprintf(stderr, "link type %u is not a uart capture (%u)\n",
+                (unsigned)wire_get_u32(file + 20), (unsigned)CAPTURE_LINKTYPE);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief  取下一条记录
+ * @param  file 文件内容
+ * @param  len 文件长度
+ * @param  pos 读取位置，返回时指向下一条记录
+ * @param  rec 输出
+ * @return 是否取到(文件结束或记录损坏时返回 false)
+ */
+static bool replay_next(const uint8_t *file, uint32_t len, uint32_t *pos, replay_record_t *rec)
+{
+    uint32_t incl;
+
+    if(len - *pos < CAPTURE_RECORD_HEAD_LEN + 1) {
+        return false;
+    }
+    incl = wire_get_u32(file + *pos + 8);
+    if((0 == incl) || (incl > len - *pos - CAPTURE_RECORD_HEAD_LEN)) {
+        fprintf(stderr, "truncated record at offset %u\n", (unsigned)*pos);
+        return false;
+    }
+    rec->us = (uint64_t)wire_get_u32(file + *pos) * 1000000u + wire_get_u32(file + *pos + 4);
+    rec->dir = file[*pos + CAPTURE_RECORD_HEAD_LEN];
+    rec->len = incl - 1;
+    rec->orig_len = wire_get_u32(file + *pos + 12) - 1;
+    rec->data = file + *pos + CAPTURE_RECORD_HEAD_LEN + 1;
+    *pos += CAPTURE_RECORD_HEAD_LEN + incl;
+    return true;
+}
+
+/**
+ * @brief  按十六进制打印一条记录
+ * @param  rec 记录
+ * @param  t0 第一条记录的时间
+ * @return 无
+ */
+static void replay_dump(const replay_record_t *rec, uint64_t t0)
+{
+    printf("%10.6f %s %3u%s", (double)(rec->us - t0) / 1e6,
+           (CAPTURE_DIR_RX == rec->dir) ? "rx" : "tx", (unsigned)rec->orig_len,
+           (rec->len < rec->orig_len) ? "+" : " ");
+    for(uint32_t i = 0; i < rec->len; i ++) {
+        printf(" %02x", rec->data[i]);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief  回放一遍
+ * @param  file 文件内容
+ * @param  len 文件长度
+ * @param  realtime 是否按记录的时间间隔回放
+ * @param  dump 是否打印记录
+ * @param  rx_bytes 输出: 累加送入解析器的字节数
+ * @return 记录覆盖的时长(秒)
+ */
+static double replay_run(const uint8_t *file, uint32_t len, bool realtime, bool dump, uint64_t *rx_bytes)
+{
+    replay_record_t rec;
+    uint32_t pos = CAPTURE_FILE_HEAD_LEN;
+    uint64_t t0 = 0;
+    double start = replay_now();
+    double wait;
+    struct timespec ts;
+    bool first = true;
+
+    while(replay_next(file, len, &pos, &rec)) {
+        if(first) {
+            t0 = rec.us;
+            first = false;
+        }
+        if(dump) {
+            replay_dump(&rec, t0);
+        }
+        if(realtime) {
+            wait = (double)(rec.us - t0) / 1e6 - (replay_now() - start);
+            if(wait > 0) {
+                ts.tv_sec = (time_t)wait;
+                ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+                nanosleep(&ts, NULL);
+            }
+        }
+        s_now_us = rec.us;
+        if(CAPTURE_DIR_RX != rec.dir) {
+            continue;
+        }
+        /* 接收队列只有 UART_RX_BUFF_LEN，大块数据分段送入 */
+        for(uint32_t off = 0; off < rec.len; off += UART_RX_BUFF_LEN / 2) {
+            uint32_t n = rec.len - off;
+
+            if(n > UART_RX_BUFF_LEN / 2) {
+                n = UART_RX_BUFF_LEN / 2;
+            }
+            uart_receive_buff_input((uint8_t *)rec.data + off, (unsigned short)n);
+            mcu_uart_service();
+        }
+        mcu_uart_tx_service();
+        *rx_bytes += rec.len;
+    }
+    return first ? 0 : (double)(s_now_us - t0) / 1e6;
+}
+
+/**
+ * @brief  模拟测量噪声: 以一定概率在当前值上加减一个量化步长
+ * @param  value 当前值
+ * @param  step 量化步长
+ * @param  percent 变化的概率(%)
+ * @return 新值
+ */
+static float replay_jitter(float value, float step, uint32_t percent)
+{
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    if((s_rand % 100) >= percent) {
+        return value;
+    }
+    return (s_rand & 0x10000) ? value + step : value - step;
+}
+
+/**
+ * @brief  模拟一次运行参数采样
+ * @param  i 采样序号
+ * @param  info 输入上一次采样，输出本次采样
+ * @return 周期内的位置
+ * @note   每 3000 个采样(5 分钟)一轮: 空闲 20 秒，电流 10 秒爬升到 32A，充电，完成 20 秒；
+ *         电压在 230V 附近按 0.1V 抖动，充电时电流按 0.01A 抖动，功率由二者算出并取整
+ */
+static uint32_t replay_trace_sample(uint32_t i, running_info_t *info)
+{
+    uint32_t phase = i % 3000;
+
+    info->net_status = NET_STAT_CONNECTED;
+    info->voltage = replay_jitter(info->voltage, 0.1f, 30);
+    if((info->voltage < 228.0f) || (info->voltage > 232.0f)) {
+        info->voltage = 230.0f;
+    }
+    if(phase < 200) {
+        info->charge_status = EVSE_IDLE;
+        info->current = 0;
+    } else if(phase < 2800) {
+        info->charge_status = EVSE_CHARGING;
+        info->current = (phase < 300) ? (float)(phase - 200) * 0.32f : replay_jitter(info->current, 0.01f, 40);
+    } else {
+        info->charge_status = EVSE_CHARGE_DONE;
+        info->current = 0;
+    }
+    info->power = (float)(int32_t)(info->voltage * info->current + 0.5f);
+    return phase;
+}
+
+/**
+ * @brief  生成一段充电过程的模拟记录
+ * @param  path 输出文件
+ * @param  count 运行参数采样数
+ * @param  delta 是否用增量帧发送运行参数
+ * @return 0 成功
+ * @note   每 REPLAY_GEN_INTERVAL_US 采样一次运行参数，其中穿插刷卡和告警；
+ *         全量模式每次采样发送一帧全量帧。增量模式只发送变化的字段，增量帧不比全量帧短时
+ *         改发全量帧，并且每 REPLAY_GEN_FULL_EVERY 个周期发送一次全量帧；
+ *         数据经过 capture_record/capture_read，与面板下载的文件格式相同
+ */
+static int replay_generate(const char *path, uint32_t count, bool delta)
+{
+    static uint8_t chunk[64 * 1024];
+    capture_t cap;
+    running_info_t info = { .voltage = 230.0f };
+    running_info_t sent;
+    uint32_t phase;
+    uint8_t n_value;
+    uint8_t frame[PROTOCOL_HEAD + UART_MAX_DATA_LEN + 1];
+    uint8_t value[UART_MAX_DATA_LEN];
+    uint8_t *buf = malloc(REPLAY_GEN_CAPTURE_LEN);
+    uint32_t pos;
+    uint32_t end;
+    uint32_t n;
+    uint16_t frame_len;
+    FILE *fp;
+
+    if((NULL == buf) || !capture_init(&cap, buf, REPLAY_GEN_CAPTURE_LEN, replay_gen_clock)) {
+        fprintf(stderr, "capture init failed\n");
+        free(buf);
+        return 1;
+    }
+
+    for(uint32_t i = 0; i < count; i ++) {
+        phase = replay_trace_sample(i, &info);
+        s_gen_us += REPLAY_GEN_INTERVAL_US;
+
+        n_value = 0;
+        if(delta && (0 != i % REPLAY_GEN_FULL_EVERY)) {
+            n_value = running_info_delta_encode(&info, &sent, value, sizeof(value));
+            if((n_value > 0) && (n_value < RUNNING_INFO_WIRE_LEN)) {
+                frame_len = uart_frame_pack(frame, FN_UPDT_RUN_INFO_DELTA, value, n_value);
+                capture_record(&cap, CAPTURE_DIR_RX, frame, frame_len);
+                sent = info;
+            }
+        }
+        if(!delta || (0 == i % REPLAY_GEN_FULL_EVERY) || (n_value >= RUNNING_INFO_WIRE_LEN)) {
+            frame_len = uart_frame_pack(frame, FN_UPDT_RUN_INFO_ALL, value,
+                                        running_info_encode(&info, value, sizeof(value)));
+            capture_record(&cap, CAPTURE_DIR_RX, frame, frame_len);
+            sent = info;
+        }
+
+        if(phase == 150) {
+            memset(value, 0, REPLAY_RFID_SWIPE_LEN);
+            wire_put_u32(value, 0x12345678u + i);
+            s_gen_us += 1000;
+            frame_len = uart_frame_pack(frame, FN_UPDT_RFID_CARD, value, REPLAY_RFID_SWIPE_LEN);
+            capture_record(&cap, CAPTURE_DIR_RX, frame, frame_len);
+            /* 面板的回复 */
+            s_gen_us += 2000;
+            capture_record(&cap, CAPTURE_DIR_TX, frame, frame_len);
+        }
+        if(phase == 2900) {
+            memset(value, 0, REPLAY_ALARM_REPORT_LEN);
+            s_gen_us += 1000;
+            frame_len = uart_frame_pack(frame, FN_UPDT_ALARM_RECORD, value, REPLAY_ALARM_REPORT_LEN);
+            capture_record(&cap, CAPTURE_DIR_RX, frame, frame_len);
+        }
+    }
+
+    fp = fopen(path, "wb");
+    if(NULL == fp) {
+        perror(path);
+        free(buf);
+        return 1;
+    }
+    n = capture_file_header(chunk);
+    fwrite(chunk, 1, n, fp);
+    capture_begin(&cap, &pos, &end);
+    while((n = capture_read(&cap, &pos, end, chunk, sizeof(chunk))) > 0) {
+        fwrite(chunk, 1, n, fp);
+    }
+    fclose(fp);
+    printf("%s: %u records, %u overwritten\n", path,
+           (unsigned)atomic_load(&cap.records), (unsigned)atomic_load(&cap.overwritten));
+    free(buf);
+    return 0;
+}
+
+/**
+ * @brief  打印用法
+ * @param  name 程序名
+ * @return 无
+ */
+static void replay_usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-r] [-v] [-n loops] file.pcap\n"
+                    "       %s -g file.pcap [-c samples] [-D]\n", name, name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *gen_path = NULL;
+    uint32_t gen_count = 20000;
+    uint32_t loops = 1;
+    bool realtime = false;
+    bool dump = false;
+    bool delta = false;
+    double duration = 0;
+    uint64_t rx_bytes = 0;
+    uint32_t total = 0;
+    uint32_t len = 0;
+    uint8_t *file;
+    link_stats_t stats;
+    double t;
+    int opt;
+
+    while((opt = getopt(argc, argv, "rvDn:g:c:")) != -1) {
+        switch(opt) {
+        case 'r': realtime = true; break;
+        case 'v': dump = true; break;
+        case 'D': delta = true; break;
+        case 'n': loops = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'g': gen_path = optarg; break;
+        case 'c': gen_count = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default: replay_usage(argv[0]); return 2;
+        }
+    }
+    if(NULL != gen_path) {
+        return replay_generate(gen_path, gen_count, delta);
+    }
+    if((optind >= argc) || (0 == loops)) {
+        replay_usage(argv[0]);
+        return 2;
+    }
+
+    file = replay_load(argv[optind], &len);
+    if((NULL == file) || !replay_check_header(file, len)) {
+        free(file);
+        return 1;
+    }
+
+    mcu_uart_protocol_init();
+    mcu_uart_tx_backend_register(replay_tx_discard);
+    mcu_uart_clock_register(replay_clock);
+    mcu_fnum_handler_register(FN_UPDT_RFID_CARD, replay_count_rfid, REPLAY_RFID_SWIPE_LEN, REPLAY_RFID_SWIPE_LEN);
+    mcu_fnum_handler_register(FN_UPDT_ALARM_RECORD, replay_count_alarm, REPLAY_ALARM_REPORT_LEN, REPLAY_ALARM_REPORT_LEN);
+    running_info_listener_register(replay_count_running_info);
+
+    t = replay_now();
+    for(uint32_t i = 0; i < loops; i ++) {
+        duration = replay_run(file, len, realtime, dump && (0 == i), &rx_bytes);
+    }
+    t = replay_now() - t;
+
+    mcu_uart_link_stats_get(&stats);
+    printf("fn    frames\n");
+    printf("0x%02x/0x%02x  %u (running info)\n", FN_UPDT_RUN_INFO_ALL, FN_UPDT_RUN_INFO_DELTA, (unsigned)s_updates);
+    total = s_updates;
+    for(uint32_t fn = 0; fn < 256; fn ++) {
+        if(s_frames[fn] > 0) {
+            printf("0x%02x  %u\n", (unsigned)fn, (unsigned)s_frames[fn]);
+            total += s_frames[fn];
+        }
+    }
+    printf("frames %u, bad check %u, rx overflow %u, link v%u\n", (unsigned)total,
+           (unsigned)stats.rx_bad_check, (unsigned)uart_rx_overflow_count(), (unsigned)mcu_uart_link_version());
+    if(s_updates > 0) {
+        printf("running info updates %u: %.2f changed fields/update, %u (%.1f%%) without changes\n",
+               (unsigned)s_updates, (double)s_dirty_fields / s_updates, (unsigned)s_updates_clean,
+               100.0 * s_updates_clean / s_updates);
+    }
+    if(duration > 0) {
+        printf("wire %.1f bytes/s over %.1f s of capture\n", (double)rx_bytes / loops / duration, duration);
+    }
+    if(!realtime && (rx_bytes > 0) && (t > 0)) {
+        printf("%llu bytes in %.3f s: %.1f MB/s, %.1f ns/byte, %.0f ns/frame, %.0f ns/update\n",
+               (unsigned long long)rx_bytes, t, (double)rx_bytes / t / 1e6,
+               t * 1e9 / (double)rx_bytes, (total > 0) ? t * 1e9 / total : 0.0,
+               (s_updates > 0) ? t * 1e9 / s_updates : 0.0);
+    }
+    free(file);
+    return 0;
+}
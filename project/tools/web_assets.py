@@ -0,0 +1,147 @@
+# EVCharger Panel Project
+# Copyright (c) 2025, WangQiWei, <3167914232@qq.com>
+#
+# PlatformIO 构建脚本：在生成 SPIFFS 镜像之前，为 data/ 下的网页资源生成
+#   <file>.gz    预压缩版本，服务器对支持 gzip 的客户端直接发送
+#   <file>.etag  内容哈希，服务器用于响应 If-None-Match (304)
+#
+# 定义了 WEB_ASSETS_EMBEDDED 构建标志时，还会在编译固件之前把 data/ 下的资源
+# 精简、压缩后生成 src/web_assets_data.c，作为按路径排序的常量表编译进 flash，
+# 运行时不再从 SPIFFS 读取网页。
+#
+# 也可以在命令行单独运行：
+#   python tools/web_assets.py data                         生成 .gz/.etag
+#   python tools/web_assets.py data src/web_assets_data.c   生成内嵌资源表
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+# 需要预压缩的资源(favicon 等二进制文件压缩收益很小，只生成 etag)
+GZIP_SUFFIXES = (".html", ".css", ".js")
+GENERATED_SUFFIXES = (".gz", ".etag")
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+    ".json": "application/json",
+}
+
+
+def iter_assets(data_dir):
+    for root, _, files in os.walk(data_dir):
+        for name in sorted(files):
+            if name.startswith(".") or name.endswith(GENERATED_SUFFIXES):
+                continue
+            yield os.path.join(root, name)
+
+
+def content_etag(content):
+    return '"%s"' % hashlib.sha1(content).hexdigest()[:16]
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path, "rb") as f:
+            if f.read() == content:
+                return
+    with open(path, "wb") as f:
+        f.write(content)
+
+
+def generate(data_dir):
+    for path in iter_assets(data_dir):
+        with open(path, "rb") as f:
+            content = f.read()
+        write_if_changed(path + ".etag", content_etag(content).encode("ascii"))
+        if path.endswith(GZIP_SUFFIXES):
+            # mtime=0 使压缩结果只取决于内容，镜像可重复构建
+            write_if_changed(path + ".gz", gzip.compress(content, 9, mtime=0))
+        print("web_assets: %s" % os.path.relpath(path, data_dir))
+
+
+def minify(path, content):
+    """保守的精简：只去掉注释、行首尾空白和空行，不改写代码本身"""
+    text = content.decode("utf-8")
+    if path.endswith(".css"):
+        text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    elif path.endswith(".html"):
+        text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    if path.endswith(".js"):
+        lines = (line for line in lines if not line.startswith("//"))
+    return "\n".join(line for line in lines if line).encode("utf-8")
+
+
+def c_bytes(data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("    " + " ".join("0x%02x," % b for b in data[i:i + 16]))
+    return "\n".join(rows)
+
+
+def generate_embedded(data_dir, out_path):
+    entries = []
+    for path in iter_assets(data_dir):
+        with open(path, "rb") as f:
+            content = f.read()
+        uri = "/" + os.path.relpath(path, data_dir).replace(os.sep, "/")
+        ext = os.path.splitext(path)[1]
+        gz = path.endswith(GZIP_SUFFIXES)
+        body = gzip.compress(minify(path, content), 9, mtime=0) if gz else content
+        entries.append((uri, MIME_TYPES.get(ext, "application/octet-stream"),
+                        content_etag(content), gz, body))
+    # 运行时按路径二分查找，必须与 strcmp 的顺序一致
+    entries.sort(key=lambda e: e[0].encode("utf-8"))
+
+    out = ["/* 由 tools/web_assets.py 自动生成，请勿手动修改 */",
+           "#ifdef WEB_ASSETS_EMBEDDED",
+           "",
+           '#include "web_assets.h"',
+           ""]
+    for i, (uri, _, _, _, body) in enumerate(entries):
+        out.append("/* %s */" % uri)
+        out.append("static const uint8_t s_asset_%d[%d] = {" % (i, len(body)))
+        out.append(c_bytes(body))
+        out.append("};")
+        out.append("")
+    out.append("const web_asset_t g_web_assets[] = {")
+    for i, (uri, mime, etag, gz, body) in enumerate(entries):
+        out.append('    { "%s", "%s", "\\"%s\\"", %s, s_asset_%d, %d },'
+                   % (uri, mime, etag.strip('"'), "true" if gz else "false", i, len(body)))
+    out.append("};")
+    out.append("const size_t g_web_asset_count = sizeof(g_web_assets) / sizeof(g_web_assets[0]);")
+    out.append("")
+    out.append("#endif /* WEB_ASSETS_EMBEDDED */")
+    write_if_changed(out_path, ("\n".join(out) + "\n").encode("utf-8"))
+    for uri, _, _, _, body in entries:
+        print("web_assets: embedded %s (%d bytes)" % (uri, len(body)))
+
+
+try:
+    Import("env")  # noqa: F821  (PlatformIO 注入)
+
+    def _before_buildfs(source, target, env):
+        generate(env.subst("$PROJECT_DATA_DIR"))
+
+    env.AddPreAction("$BUILD_DIR/${ESP32_FS_IMAGE_NAME}.bin", _before_buildfs)  # noqa: F821
+
+    # 内嵌模式需要在 CMake 收集源文件之前生成资源表
+    _flags = env.GetProjectOption("build_flags", "")  # noqa: F821
+    if isinstance(_flags, (list, tuple)):
+        _flags = " ".join(_flags)
+    if "WEB_ASSETS_EMBEDDED" in _flags:
+        generate_embedded(env.subst("$PROJECT_DATA_DIR"),  # noqa: F821
+                          os.path.join(env.subst("$PROJECT_SRC_DIR"), "web_assets_data.c"))  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        if len(sys.argv) > 2:
+            generate_embedded(sys.argv[1], sys.argv[2])
+        else:
+            generate(sys.argv[1] if len(sys.argv) > 1 else "data")